@@ -24,8 +24,10 @@
 
 #include <cstring>  // for memset
 #include <memory>
+#include <deque>
 #include <mutex>
 #include <utility>
+#include <vector>
 
 #include "cnrt.h"
 
@@ -71,6 +73,7 @@ class BufSurfaceWrapper {
    */
   ~BufSurfaceWrapper() {
     std::unique_lock<std::mutex> lk(mutex_);
+    FreeHostData();
     if (deleter_) {
       delete deleter_, deleter_ = nullptr;
       return;
@@ -209,6 +212,8 @@ class BufSurfaceWrapper {
    * @return Returns the pointer of the host data.
    *
    * @note For memory with type CNEDK_BUF_MEM_DEVICE, set cpu memory as faked mappedData for convenience.
+   *       The host memory is borrowed from PinnedStagingRing, and falls back to pageable memory when the ring is
+   *       exhausted. It is released when the wrapper is destructed.
    */
   void *GetHostData(uint32_t plane_idx, uint32_t batch_idx = 0);
   /**
@@ -253,12 +258,20 @@ class BufSurfaceWrapper {
 
  private:
   CnedkBufSurfaceParams *GetSurfaceParamsPriv(uint32_t batch_idx = 0) const { return &surf_->surface_list[batch_idx]; }
+  unsigned char *AllocHostData(uint32_t idx, size_t size);
+  void FreeHostData();
 
  private:
+  struct HostData {
+    unsigned char *ptr = nullptr;
+    size_t size = 0;
+    bool pinned = false;
+  };
+
   mutable std::mutex mutex_;
   CnedkBufSurface *surf_ = nullptr;
   bool owner_ = true;
-  std::unique_ptr<unsigned char[]> host_data_[128]{{nullptr}};
+  std::vector<HostData> host_data_;
 
   IBufDeleter *deleter_ = nullptr;
   CnedkBufSurface surface_;
@@ -268,6 +281,83 @@ class BufSurfaceWrapper {
 
 using BufSurfWrapperPtr = std::shared_ptr<BufSurfaceWrapper>;
 
+/**
+ * @class PinnedStagingRing
+ *
+ * @brief PinnedStagingRing is a process-wide ring of pinned host memory. BufSurfaceWrapper borrows staging
+ *        buffers from it for device-to-host readback, which avoids allocating and faulting in pageable memory for
+ *        each frame and speeds up the DMA.
+ */
+class PinnedStagingRing {
+ public:
+  /**
+   * @brief Gets the instance of PinnedStagingRing.
+   *
+   * @return Returns the reference of the instance.
+   */
+  static PinnedStagingRing &Instance();
+  /**
+   * @brief A destructor to destruct a PinnedStagingRing object.
+   *
+   * @return No return value.
+   */
+  ~PinnedStagingRing();
+  /**
+   * @brief Sets the capacity of the ring in bytes. 0 disables the ring, pageable memory will be used instead.
+   *
+   * @param[in] capacity The capacity in bytes.
+   *
+   * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+   *
+   * @note The capacity can only be changed when no staging buffer is borrowed.
+   */
+  int SetCapacity(size_t capacity);
+  /**
+   * @brief Gets the capacity of the ring in bytes.
+   *
+   * @return Returns the capacity.
+   */
+  size_t GetCapacity() const;
+  /**
+   * @brief Borrows a staging buffer from the ring. The pinned memory is allocated at the first call.
+   *
+   * @param[in] size The size of the buffer in bytes.
+   *
+   * @return Returns the pointer of the buffer if this function has run successfully.
+   *         Otherwise returns nullptr, e.g. the ring is exhausted.
+   */
+  void *Acquire(size_t size);
+  /**
+   * @brief Gives back a staging buffer borrowed by Acquire().
+   *
+   * @param[in] ptr The pointer of the buffer.
+   *
+   * @return No return value.
+   */
+  void Release(void *ptr);
+
+ private:
+  PinnedStagingRing() = default;
+  PinnedStagingRing(const PinnedStagingRing &) = delete;
+  PinnedStagingRing(PinnedStagingRing &&) = delete;
+  PinnedStagingRing &operator=(const PinnedStagingRing &) = delete;
+  PinnedStagingRing &operator=(PinnedStagingRing &&) = delete;
+
+ private:
+  struct Block {
+    size_t offset;
+    size_t size;
+    bool released;
+  };
+
+  mutable std::mutex mutex_;
+  size_t capacity_ = 64 << 20;
+  unsigned char *base_ = nullptr;
+  size_t head_ = 0;  // offset of the next allocation
+  size_t tail_ = 0;  // offset of the oldest borrowed block
+  std::deque<Block> blocks_;  // borrowed blocks in allocation order
+};
+
 /**
  * @class BufPool
  *
@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "cnedk_buf_surface.h"
+#include "cnedk_transform.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -44,6 +45,53 @@ typedef enum {
   CNEDK_VDEC_TYPE_NUM
 } CnedkVdecType;
 
+/**
+ * Specifies which frames of a video stream are decoded.
+ */
+typedef enum {
+  /** Decodes all frames. */
+  CNEDK_VDEC_MODE_ALL,
+  /** Decodes the frames which are referenced by others, the non-reference frames are dropped before they are sent
+   to the decoder. Combined with output_interval, it decodes about every Nth frame at a low cost.
+   For H.265, the sub-layer non-reference pictures are dropped as well, so this mode must not be used for the streams
+   with more than one temporal sub-layer. See CNEDK_VDEC_FRAME_NON_REF. */
+  CNEDK_VDEC_MODE_REF_ONLY,
+  /** Decodes the key frames only, the others are dropped before they are sent to the decoder. */
+  CNEDK_VDEC_MODE_KEY_ONLY,
+  /** Specifies the number of decode modes. */
+  CNEDK_VDEC_MODE_NUM
+} CnedkVdecMode;
+
+/**
+ * Specifies the types of the frames in a video stream.
+ */
+typedef enum {
+  /** The type is unknown, e.g. the packet is not in Annex B format. */
+  CNEDK_VDEC_FRAME_UNKNOWN,
+  /** A key frame, i.e. IDR, IRAP or I frame. The packets carrying parameter sets are regarded as key frames. */
+  CNEDK_VDEC_FRAME_KEY,
+  /** A frame referenced by other frames. */
+  CNEDK_VDEC_FRAME_REF,
+  /** A frame which is not referenced by other frames. For H.265, the sub-layer non-reference pictures (TRAIL_N,
+   TSA_N, STSA_N, RADL_N and RASL_N) are of this type. They are not referenced within their temporal sub-layer, but
+   may be referenced by the pictures of higher sub-layers in the streams with temporal scalability. */
+  CNEDK_VDEC_FRAME_NON_REF
+} CnedkVdecFrameType;
+
+/**
+ * Holds the spec of an extra output of the decoder, e.g. a frame of the input size of a model.
+ */
+typedef struct CnedkVdecOutputSpec {
+  /** The width of the output. */
+  uint32_t width;
+  /** The height of the output. */
+  uint32_t height;
+  /** The color format of the output. */
+  CnedkBufSurfaceColorFormat color_format;
+  /** The region of the decoded picture to output. The whole picture is used if width or height is 0. */
+  CnedkTransformRect roi;
+} CnedkVdecOutputSpec;
+
 /**
  * Holds the parameters for creating video decoder.
  */
@@ -56,7 +104,8 @@ typedef struct CnedkVdecCreateParams {
   uint32_t max_width;
   /** The max height of the frame that the decoder could handle. */
   uint32_t max_height;
-  /** The number of frame buffers that the decoder will allocated. Only valid on CE3226 platform */
+  /** The number of frame buffers that the decoder will allocated. Only valid on CE3226 platform, or on MLU370 and
+   MLU590 platforms when zero_copy is set. */
   uint32_t frame_buf_num;
   /** The color format of the frame after decoding. */
   CnedkBufSurfaceColorFormat color_format;
@@ -65,6 +114,8 @@ typedef struct CnedkVdecCreateParams {
   //  (1)  GetBufSurf
   //  (2)  decoded picture to buf_surf (csc/deepcopy)
   //  (3)  OnFrame
+  // If zero_copy is set, only (3) is performed.
+  // If output_specs is set, the extra outputs are got and filled before OnFrameOutputs is called instead of (3).
   /** The OnFrame callback function.*/
   int (*OnFrame)(CnedkBufSurface *surf, void *userdata);
   /** The OnEos callback function. */
@@ -79,6 +130,25 @@ typedef struct CnedkVdecCreateParams {
   int surf_timeout_ms;
   /** The user data. */
   void *userdata;
+  /** If set, GetBufSurf is not called and OnFrame receives a BufSurface which wraps the frame buffer of the
+   decoder, the decoded picture is not copied. The frame buffer is given back to the decoder when the BufSurface is
+   destroyed by CnedkBufSurfaceDestroy(). The decoder stalls if all frame buffers are held, and CnedkVdecDestroy()
+   waits until all of the BufSurfaces are destroyed. frame_buf_num should cover the frames held by the user, 0
+   means the decoder decides. Only valid on MLU370 and MLU590 platforms. */
+  bool zero_copy;
+  /** The specs of the extra outputs. The array is copied when the decoder is created. For each decoded picture, a
+   BufSurface of each spec is got by GetBufSurf, and all of them are filled by batched transforms. */
+  CnedkVdecOutputSpec *output_specs;
+  /** The number of the extra outputs. */
+  uint32_t num_output_specs;
+  /** The callback function called instead of OnFrame if num_output_specs is not 0. surfs[0] is the BufSurface
+   which OnFrame receives, surfs[i + 1] is the output of output_specs[i]. num_surfs is num_output_specs + 1. */
+  int (*OnFrameOutputs)(CnedkBufSurface **surfs, uint32_t num_surfs, void *userdata);
+  /** The decode mode, only valid for H264 and H265, which are in Annex B format. */
+  CnedkVdecMode mode;
+  /** Only outputs one of every output_interval decoded frames, the others are released without being copied.
+   0 or 1 means outputting all frames. */
+  uint32_t output_interval;
 } CnedkVdecCreateParams;
 
 /**
@@ -123,6 +193,182 @@ int CnedkVdecDestroy(void *vdec);
  */
 int CnedkVdecSendStream(void *vdec, const CnedkVdecStream *stream, int timeout_ms);
 
+/**
+ * @brief Gets the type of the frame in a H264 or H265 packet in Annex B format. The type of the first slice is
+ *        used. It can be used to drop frames before sending them, in the same way as the decode modes do.
+ *
+ * @param[in] type The video codec type.
+ * @param[in] bits The data of the packet.
+ * @param[in] len The length of the packet.
+ * @param[out] frame_type The type of the frame.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVdecGetFrameType(CnedkVdecType type, const uint8_t *bits, uint32_t len, CnedkVdecFrameType *frame_type);
+
+/**
+ * Holds the parameters for creating a decode service.
+ */
+typedef struct CnedkVdecServiceCreateParams {
+  /** The number of threads which send the packets to the decoders. 0 means 2. */
+  uint32_t io_thread_num;
+  /** The max number of packets queued for each stream. 0 means 32. */
+  uint32_t max_queued_packets;
+  /** The timeout in milliseconds of each attempt to send a packet to a decoder. The packet is retried later and
+   other streams are served in between. 0 means 10. */
+  int send_timeout_ms;
+} CnedkVdecServiceCreateParams;
+
+/**
+ * Holds the status of a stream of a decode service.
+ */
+typedef struct CnedkVdecServiceStreamStatus {
+  /** The number of packets queued and not sent to the decoder yet. */
+  uint32_t queued_packets;
+  /** The number of bytes queued and not sent to the decoder yet. */
+  uint64_t queued_bytes;
+  /** The number of packets sent to the decoder. */
+  uint64_t sent_packets;
+  /** The number of packets failed to be sent to the decoder, they are dropped. */
+  uint64_t failed_packets;
+  /** Whether the queue of the stream is full, CnedkVdecServiceSubmit() rejects packets until it is drained. */
+  bool backpressure;
+} CnedkVdecServiceStreamStatus;
+
+/**
+ * @brief Creates a decode service, which owns the decoders of many streams and sends the packets submitted by
+ *        CnedkVdecServiceSubmit() to the decoders by a few I/O threads.
+ *
+ * @param[out] service A pointer points to the pointer of a decode service.
+ * @param[in] params The parameters for creating the decode service.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVdecServiceCreate(void **service, CnedkVdecServiceCreateParams *params);
+/**
+ * @brief Destroys a decode service. The streams not removed are removed as CnedkVdecServiceRemoveStream() does.
+ *
+ * @param[in] service A pointer of a decode service.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVdecServiceDestroy(void *service);
+/**
+ * @brief Creates a decoder for a stream in a decode service.
+ *
+ * @param[in] service A pointer of a decode service.
+ * @param[in] stream_id The id of the stream, which must be unique in the service.
+ * @param[in] params The parameters for creating video decoder, see CnedkVdecCreate().
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVdecServiceAddStream(void *service, int stream_id, CnedkVdecCreateParams *params);
+/**
+ * @brief Removes a stream from a decode service. The queued packets are sent, then EOS is sent if it is not
+ *        submitted yet, and the decoder is destroyed.
+ *
+ * @param[in] service A pointer of a decode service.
+ * @param[in] stream_id The id of the stream.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVdecServiceRemoveStream(void *service, int stream_id);
+/**
+ * @brief Submits a packet of a stream without blocking. The data is copied.
+ *
+ * @param[in] service A pointer of a decode service.
+ * @param[in] stream_id The id of the stream.
+ * @param[in] stream The video stream, EOS if bits is nullptr.
+ *
+ * @return Returns 0 if the packet is queued. Returns -2 if the queue of the stream is full, the packet should be
+ *         submitted again later. Otherwise returns -1.
+ */
+int CnedkVdecServiceSubmit(void *service, int stream_id, const CnedkVdecStream *stream);
+/**
+ * @brief Gets the status of a stream in a decode service.
+ *
+ * @param[in] service A pointer of a decode service.
+ * @param[in] stream_id The id of the stream.
+ * @param[out] status The status of the stream.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVdecServiceGetStreamStatus(void *service, int stream_id, CnedkVdecServiceStreamStatus *status);
+
+/**
+ * Holds the parameters for creating a JPEG decode service.
+ */
+typedef struct CnedkJpegDecServiceCreateParams {
+  /** The device id. */
+  int device_id;
+  /** The color format of the decoded images, only NV12 and NV21 are supported. */
+  CnedkBufSurfaceColorFormat color_format;
+  /** The max width and height of the images. 0 means 7680 x 4320. The images are routed to the decoders of the
+   smallest size class which covers them, the classes are 1920 x 1080, 3840 x 2160 and the max size. */
+  uint32_t max_width;
+  uint32_t max_height;
+  /** The max number of decoders of each size class. A decoder is added when all of the decoders of the class are
+   busy. 0 means 4. */
+  uint32_t max_decoders;
+  /** The number of output buffers of each decoder, which are allocated in the max size of the class and reused.
+   0 means 8. */
+  uint32_t frame_buf_num;
+  /** The max number of images queued and not sent to the decoders yet. 0 means 64. */
+  uint32_t max_queued_images;
+  /** The number of threads which send the images to the decoders. 0 means 2. */
+  uint32_t io_thread_num;
+  /** The timeout in milliseconds of getting an output buffer. 0 means 5000. */
+  int surf_timeout_ms;
+  /** Called once for each submitted image. status is 0 and surf holds the decoded image on success, surf must be
+   destroyed by CnedkBufSurfaceDestroy() to give the buffer back. Otherwise surf is nullptr. */
+  int (*OnImage)(CnedkBufSurface *surf, uint64_t tag, int status, void *userdata);
+  /** The user data passed to OnImage. */
+  void *userdata;
+} CnedkJpegDecServiceCreateParams;
+
+/**
+ * @brief Gets the width and height of a JPEG image from its frame header.
+ *
+ * @param[in] data The JPEG image.
+ * @param[in] len The length of the data.
+ * @param[out] width The width of the image.
+ * @param[out] height The height of the image.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkJpegGetImageSize(const uint8_t *data, uint32_t len, uint32_t *width, uint32_t *height);
+/**
+ * @brief Creates a JPEG decode service, which decodes the images submitted by CnedkJpegDecServiceSubmit() with a
+ *        pool of JPEG decoders.
+ *
+ * @param[out] service A pointer points to the pointer of a JPEG decode service.
+ * @param[in] params The parameters for creating the JPEG decode service.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkJpegDecServiceCreate(void **service, CnedkJpegDecServiceCreateParams *params);
+/**
+ * @brief Destroys a JPEG decode service. The queued images are decoded before it returns. The BufSurfaces passed to
+ *        OnImage must be destroyed before, or by other threads during this call.
+ *
+ * @param[in] service A pointer of a JPEG decode service.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkJpegDecServiceDestroy(void *service);
+/**
+ * @brief Submits a JPEG image without blocking. The data is copied.
+ *
+ * @param[in] service A pointer of a JPEG decode service.
+ * @param[in] data The JPEG image.
+ * @param[in] len The length of the data.
+ * @param[in] tag The user tag passed to OnImage with the decoded image.
+ *
+ * @return Returns 0 if the image is queued. Returns -2 if the queue is full, the image should be submitted again
+ *         later. Otherwise returns -1, e.g. the frame header is invalid or the image is larger than the max size.
+ */
+int CnedkJpegDecServiceSubmit(void *service, const uint8_t *data, uint32_t len, uint64_t tag);
+
 #ifdef __cplusplus
 };
 #endif
@@ -75,6 +75,28 @@ typedef struct CnedkVEncFrameBits {
   CnedkVencPakageType pkt_type;  // nal-type
 } CnedkVEncFrameBits;
 
+/**
+ * Holds the descriptor of a packet in the bitstream ring.
+ */
+typedef struct CnedkVencRingPacket {
+  /** The offset of the packet from the start of the ring, see CnedkVencRingGetBuffer(). A packet never wraps around
+   the end of the ring. */
+  uint32_t offset;
+  /** The length of the packet. */
+  uint32_t len;
+  /** The presentation timestamp of the packet. */
+  uint64_t pts;
+  /** The package type of the packet. */
+  CnedkVencPakageType pkt_type;
+  /** The sequence number of the packet. */
+  uint64_t seq;
+  /** The number of packets dropped right before this packet, since the readers did not release the space of the ring
+   in time. The stream is discontinuous if it is not 0, the decoders of the stream should wait for a key frame. */
+  uint32_t dropped;
+  /** Set if the encoder has reached EOS and all of the packets have been read, the other fields are not valid. */
+  bool eos;
+} CnedkVencRingPacket;
+
 /**
  * Holds the parameters for creating video encoder.
  */
@@ -109,6 +131,19 @@ typedef struct CnedkVencCreateParams {
   int (*OnError)(int errcode, void *userdata);
   /** The user data. */
   void *userdata;
+  /** If set, CnedkVencSendFrame() takes the ownership of the BufSurface when it succeeds, and destroys it by
+   CnedkBufSurfaceDestroy() once the encoder does not need it any more. A NV12 or NV21 device BufSurface in the color
+   format and size of the encoder, whose pitch is a multiple of 64, is encoded in place without being copied. The
+   others are converted into the input buffers of the encoder by one transform. Only valid on MLU370 platform. */
+  bool zero_copy;
+  /** The size in bytes of the bitstream ring. If set, the packets are written into the ring and read by
+   CnedkVencRingRead() instead of being passed to OnFrameBits, which could be nullptr. The encoder never waits for
+   the readers, a packet is dropped if the ring has no space for it, see CnedkVencRingPacket::dropped. */
+  uint32_t ring_size;
+  /** CnedkVencSendFrame() returns -2 once the bytes held by the readers of the ring exceed ring_high_watermark,
+   until they drop to ring_low_watermark. 0 means 3/4 and 1/2 of ring_size. */
+  uint32_t ring_high_watermark;
+  uint32_t ring_low_watermark;
 } CnedkVencCreateParams;
 
 /**
@@ -121,7 +156,7 @@ typedef struct CnedkVencCreateParams {
  */
 int CnedkVencCreate(void **venc, CnedkVencCreateParams *params);
 /**
- * @brief Destroys a video encoder.
+ * @brief Destroys a video encoder. The bitstream ring is destroyed as well, the readers must stop reading before.
  *
  * @param[in] venc A pointer of a video encoder.
  *
@@ -135,9 +170,65 @@ int CnedkVencDestroy(void *venc);
  * @param[in] surf The video frame.
  * @param[in] timeout_ms The timeout in milliseconds.
  *
- * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ * @return Returns 0 if this function has run successfully. Returns -2 if the bitstream ring is above the high
+ *         watermark, the frame should be sent again later. Otherwise returns -1.
  */
 int CnedkVencSendFrame(void *venc, CnedkBufSurface *surf, int timeout_ms);
+/**
+ * @brief Gets the bitstream ring of a video encoder created with ring_size. The offsets of the packets are relative
+ *        to the returned buffer.
+ *
+ * @param[in] venc A pointer of a video encoder.
+ * @param[out] buffer The start of the ring.
+ * @param[out] size The size of the ring.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVencRingGetBuffer(void *venc, const uint8_t **buffer, uint32_t *size);
+/**
+ * @brief Adds a reader of the bitstream ring. The reader reads the packets written after it is added, so the readers
+ *        should be added before the first frame is sent. The packets are dropped if there is no reader.
+ *
+ * @param[in] venc A pointer of a video encoder.
+ * @param[out] reader The id of the reader.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVencRingAddReader(void *venc, int *reader);
+/**
+ * @brief Removes a reader of the bitstream ring, the packets held by it are released. A CnedkVencRingRead() of the
+ *        reader waiting in another thread returns -1.
+ *
+ * @param[in] venc A pointer of a video encoder.
+ * @param[in] reader The id of the reader.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVencRingRemoveReader(void *venc, int reader);
+/**
+ * @brief Reads the descriptor of the next packet in the bitstream ring. The data stays valid in the ring until the
+ *        packet is released by CnedkVencRingRelease().
+ *
+ * @param[in] venc A pointer of a video encoder.
+ * @param[in] reader The id of the reader.
+ * @param[out] packet The descriptor of the packet.
+ * @param[in] timeout_ms The timeout in milliseconds, -1 means waiting until a packet or EOS comes.
+ *
+ * @return Returns 0 if this function has run successfully. Returns -2 if no packet comes before timeout.
+ *         Otherwise returns -1.
+ */
+int CnedkVencRingRead(void *venc, int reader, CnedkVencRingPacket *packet, int timeout_ms);
+/**
+ * @brief Releases a packet read from the bitstream ring, and the packets read before it by the same reader. The
+ *        space is reused once all of the readers have released the packet.
+ *
+ * @param[in] venc A pointer of a video encoder.
+ * @param[in] reader The id of the reader.
+ * @param[in] packet The descriptor of the packet.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVencRingRelease(void *venc, int reader, const CnedkVencRingPacket *packet);
 
 #ifdef __cplusplus
 };
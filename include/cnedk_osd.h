@@ -61,12 +61,99 @@ typedef struct CnedkOsdBitmapParams {
   int h;
   /** The pitch of the bitmap. */
   uint32_t pitch;
-  /** The the bitmap */
+  /** The the bitmap. Pixels with the alpha bit cleared are transparent. */
   void *bitmap_argb1555;
   /** The bg_color of the bitmap */
   uint32_t bg_color;  // 0x00rrggbb;
 } CnedkOsdBitmapParams;
 
+/**
+ * Holds a pre-rasterized glyph.
+ */
+typedef struct CnedkOsdGlyph {
+  /** The unicode code point of the glyph. */
+  uint32_t code;
+  /** The width of the glyph bitmap. */
+  int w;
+  /** The height of the glyph bitmap. */
+  int h;
+  /** The horizontal distance from the pen position to the left of the bitmap. */
+  int bearing_x;
+  /** The vertical distance from the baseline up to the top of the bitmap. */
+  int bearing_y;
+  /** The horizontal distance from the pen position to the next one. */
+  int advance;
+  /** The alpha-8 coverage of the glyph, 255 is opaque. */
+  const uint8_t *alpha;
+  /** The pitch of the coverage in bytes. */
+  uint32_t pitch;
+} CnedkOsdGlyph;
+
+/**
+ * Holds the parameters for creating a font.
+ */
+typedef struct CnedkOsdFontCreateParams {
+  /** The glyphs of the font, they are copied into the glyph atlas of the font. */
+  CnedkOsdGlyph *glyphs;
+  /** The number of glyphs. */
+  uint32_t num_glyphs;
+  /** The distance from the top of a line to the baseline. */
+  int ascent;
+  /** The height of a line. */
+  int line_height;
+  /** The number of rendered labels cached by the font, 256 by default. */
+  uint32_t cache_size;
+} CnedkOsdFontCreateParams;
+
+/**
+ * Holds the parameters of a text label.
+ */
+typedef struct CnedkOsdTextParams {
+  /** The left top coordinate x of the label. */
+  int x;
+  /** The left top coordinate y of the label. */
+  int y;
+  /** The utf-8 text of one line. */
+  const char *text;
+  /** The color of the text. 0x00rrggbb */
+  uint32_t color;
+  /** Whether to fill the label with bg_color before drawing the text. */
+  bool draw_bg;
+  /** The background color of the label. 0x00rrggbb */
+  uint32_t bg_color;
+} CnedkOsdTextParams;
+
+/**
+ * Holds the OSD primitives of one buffer for CnedkOsdDrawBatch(). On host, filled rectangles are drawn first,
+ * then rectangles, then bitmaps.
+ */
+typedef struct CnedkOsdBatchItem {
+  /** The surface to draw on. */
+  CnedkBufSurface *surf;
+  /** The index of the buffer in the surface batch. */
+  uint32_t batch_idx;
+  /** The rectangles to draw. */
+  CnedkOsdRectParams *rects;
+  /** The number of rectangles to draw. */
+  uint32_t num_rects;
+  /** The rectangles to fill. */
+  CnedkOsdRectParams *fill_rects;
+  /** The number of rectangles to fill. */
+  uint32_t num_fill_rects;
+  /** The bitmaps to draw. */
+  CnedkOsdBitmapParams *bitmaps;
+  /** The number of bitmaps. */
+  uint32_t num_bitmaps;
+} CnedkOsdBatchItem;
+
+/*
+ * NV12/NV21 surfaces in VB memory are drawn by the hardware on CE3226. Surfaces accessible by cpu are drawn in
+ * place on host, i.e. CNEDK_BUF_MEM_SYSTEM, CNEDK_BUF_MEM_PINNED, CNEDK_BUF_MEM_UNIFIED* and CNEDK_BUF_MEM_VB*
+ * on other platforms, and CNEDK_BUF_MEM_DEVICE once the host copy is mapped by BufSurfaceWrapper::GetHostData().
+ * Only the rows touched are flushed or copied back to the device. CnedkDrawRect(), CnedkFillRect() and
+ * CnedkDrawBitmap() draw on the first buffer of the batch.
+ */
+
 /**
  * @brief Draws rectangle.
  *
@@ -97,6 +184,58 @@ int CnedkFillRect(CnedkBufSurface *surf, CnedkOsdRectParams *params, uint32_t nu
  * @return Returns 0 if this function has run successfully. Otherwise returns -1.
  */
 int CnedkDrawBitmap(CnedkBufSurface *surf, CnedkOsdBitmapParams *params, uint32_t num);
+/**
+ * @brief Draws on many buffers at once.
+ *
+ * Buffers drawn by the hardware on CE3226 are submitted with one job, the others are drawn in parallel on host cores.
+ * Items on the same buffer are merged.
+ *
+ * @param[in] items The buffers and the primitives drawn on them.
+ * @param[in] num The number of items.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkOsdDrawBatch(CnedkOsdBatchItem *items, uint32_t num);
+/**
+ * @brief Creates a font. The glyphs are packed into an atlas once, and labels are composed from it.
+ *
+ * @param[out] font A pointer to the font handle.
+ * @param[in] params The parameters for creating the font.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkOsdFontCreate(void **font, CnedkOsdFontCreateParams *params);
+/**
+ * @brief Destroys a font created by CnedkOsdFontCreate().
+ *
+ * @param[in] font The font handle.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkOsdFontDestroy(void *font);
+/**
+ * @brief Gets the size of the label of a text.
+ *
+ * @param[in] font The font handle.
+ * @param[in] text The utf-8 text.
+ * @param[out] w The width of the label.
+ * @param[out] h The height of the label, i.e. the line height of the font.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkOsdGetTextSize(void *font, const char *text, int *w, int *h);
+/**
+ * @brief Draws text labels on host. The surface must be accessible by cpu, see CnedkDrawRect(). Rendered labels
+ *        are cached by the font and reused across frames.
+ *
+ * @param[in,out] surf A pointer points to CnedkBufSurface. Draws labels on its first buffer.
+ * @param[in] font The font handle.
+ * @param[in] params The parameters for drawing labels.
+ * @param[in] num The number of labels.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkDrawText(CnedkBufSurface *surf, void *font, CnedkOsdTextParams *params, uint32_t num);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,96 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#ifndef CNEDK_TRACE_H_
+#define CNEDK_TRACE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Holds the parameters of the tracer.
+ */
+typedef struct CnedkTraceParams {
+  /** One of every sample_interval frames is traced. 1 is used if it is 0, which traces every frame. */
+  uint32_t sample_interval;
+  /** The number of spans kept per thread. The oldest spans are overwritten when it is exceeded.
+   4096 is used if it is 0. */
+  uint32_t ring_size;
+} CnedkTraceParams;
+
+/**
+ * @brief Starts tracing. The spans recorded before are discarded.
+ *
+ * Spans are kept in a ring buffer per recording thread, so recording takes no lock shared between threads.
+ *
+ * @param[in] params The parameters of the tracer.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkTraceStart(const CnedkTraceParams *params);
+/**
+ * @brief Stops tracing. The spans recorded are kept until the next start, and can still be exported.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkTraceStop(void);
+/**
+ * @brief Gets a trace id for a new frame, which is to be passed along with the frame and given to
+ *        CnedkTraceRecord() by every stage that handles it.
+ *
+ * @return Returns the trace id. Returns 0 if tracing is not started or the frame is not sampled, and the spans
+ *         recorded with trace id 0 are ignored.
+ */
+uint64_t CnedkTraceNewId(void);
+/**
+ * @brief Gets the current time of the monotonic clock used by the tracer.
+ *
+ * @return Returns the time in nanoseconds.
+ */
+uint64_t CnedkTraceNow(void);
+/**
+ * @brief Records that a stage handled a frame from begin_ns to end_ns, both taken by CnedkTraceNow().
+ *
+ * @param[in] trace_id The trace id of the frame. Nothing is recorded if it is 0.
+ * @param[in] name The name of the stage. It is copied and truncated to 31 characters.
+ * @param[in] begin_ns The time the stage began with the frame.
+ * @param[in] end_ns The time the stage was done with the frame.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkTraceRecord(uint64_t trace_id, const char *name, uint64_t begin_ns, uint64_t end_ns);
+/**
+ * @brief Writes the spans recorded to a file in Chrome trace event format (JSON), which can be opened by
+ *        chrome://tracing or Perfetto UI. Every traced frame is shown as a track of its own.
+ *
+ * @param[in] path The path of the file.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkTraceExport(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CNEDK_TRACE_H_
@@ -41,6 +41,9 @@ typedef enum {
   CNEDK_TRANSFORM_COMPUTE_MLU,
   /** Specifies that the VGU as a compute device. Only supported on CExxxx. */
   CNEDK_TRANSFORM_COMPUTE_VGU,
+  /** Specifies that the CPU is the compute device. The src and dst memory must be accessible by CPU,
+   *  e.g. CNEDK_BUF_MEM_SYSTEM. The tensor output is NHWC. */
+  CNEDK_TRANSFORM_COMPUTE_CPU,
   /** Specifies the number of compute modes. */
   CNEDK_TRANSFORM_COMPUTE_NUM
 } CnedkTransformComputeMode;
@@ -56,7 +59,11 @@ typedef enum {
   /** Specifies a transform to set the filter type. */
   CNEDK_TRANSFORM_FILTER     = 1 << 2,
   /** Specifies a transform to normalize output. */
-  CNEDK_TRANSFORM_MEAN_STD  = 1 << 3
+  CNEDK_TRANSFORM_MEAN_STD  = 1 << 3,
+  /** Specifies a transform to return once the work is submitted to the session queue, without waiting for it.
+   *  The caller synchronizes the queue of the session before using dst, see CnedkTransformGetSessionParams().
+   *  Only takes effect when the MLU is the compute device. */
+  CNEDK_TRANSFORM_ASYNC     = 1 << 4
 } CnedkTransformFlag;
 
 /**
@@ -185,6 +192,74 @@ typedef struct CnedkTransformParams {
   CnedkTransformRect *dst_rect;
 } CnedkTransformParams;
 
+/**
+ * Holds the parameters to create a transform plan.
+ */
+typedef struct CnedkTransformPlanParams {
+  /** Holds the color format of src. */
+  CnedkBufSurfaceColorFormat src_format;
+  /** Holds the color format of dst. If it is CNEDK_BUF_COLOR_FORMAT_TENSOR, dst_desc must be set. */
+  CnedkBufSurfaceColorFormat dst_format;
+  /** Holds the max batch size of src. */
+  uint32_t batch_size;
+  /** Holds the width of src. 0 means any width. */
+  uint32_t src_width;
+  /** Holds the height of src. 0 means any height. */
+  uint32_t src_height;
+  /** Holds the width of dst, ignored if dst is a tensor. 0 means any width. */
+  uint32_t dst_width;
+  /** Holds the height of dst, ignored if dst is a tensor. 0 means any height. */
+  uint32_t dst_height;
+  /** Holds the transform flags of the executions. Only CNEDK_TRANSFORM_MEAN_STD affects the plan,
+   the other flags may change between executions. */
+  uint32_t transform_flag;
+  /** Holds a pointer of tensor desc of dst. It is copied into the plan. */
+  CnedkTransformTensorDesc *dst_desc;
+} CnedkTransformPlanParams;
+
+/**
+ * Specifies the layout of a tensor.
+ */
+typedef enum {
+  /** Specifies the layout to NHWC. */
+  CNEDK_TRANSFORM_LAYOUT_NHWC,
+  /** Specifies the layout to NCHW. */
+  CNEDK_TRANSFORM_LAYOUT_NCHW,
+  /** Specifies the number of layouts. */
+  CNEDK_TRANSFORM_LAYOUT_NUM
+} CnedkTransformLayout;
+
+/**
+ * Holds a region of interest of a batched ROI transformation.
+ */
+typedef struct CnedkTransformRoi {
+  /** Holds the index of the surface in src which the region belongs to. */
+  uint32_t src_index;
+  /** Holds the region. If the width or height is 0, the region extends to the right or bottom border. */
+  CnedkTransformRect rect;
+} CnedkTransformRoi;
+
+/**
+ * Holds the parameters of a batched ROI transformation.
+ */
+typedef struct CnedkTransformRoiParams {
+  /** Holds a pointer to a list of regions. The i-th region is written to the i-th item of dst. */
+  CnedkTransformRoi *rois;
+  /** Holds the number of regions. */
+  uint32_t num_rois;
+  /** Holds a pointer of tensor desc of dst. shape.n is ignored, shape.c must match the color format. */
+  CnedkTransformTensorDesc *dst_desc;
+  /** Holds the layout of dst. */
+  CnedkTransformLayout layout;
+  /** Holds a pointer of normalize value. If it is NULL, dst is not normalized and the data type must be uint8. */
+  CnedkTransformMeanStdParams *mean_std_params;
+  /** Holds whether to keep the aspect ratio. If it is not 0, the region is scaled to fit in the center of dst, and
+   the borders are filled with pad_value. */
+  int keep_aspect_ratio;
+  /** Holds the value of the borders, as an 8-bit pixel value before normalization. */
+  uint8_t pad_value;
+} CnedkTransformRoiParams;
+
 
 /**
  * @brief  Sets user-defined session parameters.
@@ -229,6 +304,60 @@ int CnedkTransformGetSessionParams(CnedkTransformConfigParams *config_params);
  */
 int CnedkTransform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params);
 
+/**
+ * @brief Crops regions from batched input images, and resizes, converts and normalizes them into a batched tensor.
+ *
+ * Several regions may come from the same surface. All regions are processed in one batch, so this is much cheaper
+ * than calling CnedkTransform() for each region, e.g. for secondary inference on detected objects.
+ *
+ * @param[in]  src  A pointer to input batched buffers. The surfaces share the same color format.
+ *                  NV12 and NV21 are supported on MLU, RGB family color formats are also supported on CPU.
+ * @param[out] dst  A pointer to a caller-allocated tensor buffer, batch_size must not be less than num_rois.
+ *                  Items after num_rois are not touched.
+ * @param[in]  roi_params  A pointer to the parameters of the transformation.
+ *                  CNEDK_TRANSFORM_LAYOUT_NCHW is only supported on CPU.
+ *
+ * @return Returns 0 if this function run successfully, otherwise returns non-zero values.
+ */
+int CnedkTransformRoiBatch(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformRoiParams *roi_params);
+
+/**
+ * @brief Creates a transform plan.
+ *
+ * The operators are selected and the resources are preallocated once, then the plan is executed many times.
+ * Plans created with the same parameters on the same device and compute mode share the resources, so each user,
+ * e.g. each preprocessor of a model, may create its own plan cheaply. The plan uses the compute mode set by
+ * CnedkTransformSetSessionParams() when it is created.
+ *
+ * @param[out] plan    A pointer to the created plan.
+ * @param[in]  params  A pointer to the parameters of the plan.
+ *
+ * @return Returns 0 if this function run successfully, otherwise returns non-zero values.
+ */
+int CnedkTransformPlanCreate(void **plan, CnedkTransformPlanParams *params);
+
+/**
+ * @brief Executes a transform plan. The plan may be executed from any thread, on the session queue of the thread.
+ *
+ * @param[in]  plan  The plan created by CnedkTransformPlanCreate().
+ * @param[in]  src   A pointer to input batched buffers, which must match the parameters of the plan.
+ * @param[out] dst   A pointer to output batched buffers, which must match the parameters of the plan.
+ * @param[in]  transform_params  A pointer to the transform parameters. dst_desc is taken from the plan.
+ *
+ * @return Returns 0 if this function run successfully, otherwise returns non-zero values.
+ */
+int CnedkTransformPlanExecute(void *plan, CnedkBufSurface *src, CnedkBufSurface *dst,
+                              CnedkTransformParams *transform_params);
+
+/**
+ * @brief Destroys a transform plan.
+ *
+ * @param[in] plan  The plan created by CnedkTransformPlanCreate().
+ *
+ * @return Returns 0 if this function run successfully, otherwise returns non-zero values.
+ */
+int CnedkTransformPlanDestroy(void *plan);
+
 #ifdef __cplusplus
 }
 #endif
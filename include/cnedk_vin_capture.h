@@ -74,6 +74,53 @@ int CnedkVinCaptureDestroy(void *vin_capture);
  */
 int CnedkVinCapture(void *vin_capture, int timeout_ms);
 
+/**
+ * Holds the parameters of creating a vin capture group.
+ */
+typedef struct CnedkVinCaptureGroupCreateParams {
+  /** Holds the number of sensors */
+  int num_sensors;
+  /** Holds the sensor ids, num_sensors elements. Frame i of a set is captured from sensor_ids[i] */
+  int *sensor_ids;
+  /** Holds the max difference in microseconds between the timestamps of the frames in a set. 10000 is used if it
+   is 0 */
+  uint32_t sync_threshold_us;
+  /** Holds the OnFrames callback function. surf holds a synchronized frame set, surf->pts is the timestamp of the
+   latest frame of the set */
+  int (*OnFrames)(CnedkBufSurface *surf, void *userdata);
+  /** Holds the OnError callback function */
+  int (*OnError)(int errcode, void *userdata);
+  /** Holds the GetBufSurf callback function. The batch size of the BufSurface must be at least num_sensors */
+  int (*GetBufSurf)(CnedkBufSurface **surf, int timeout_ms, void *userdata);
+  /** Holds the timeout in milliseconds */
+  int surf_timeout_ms;
+  /** Holds the user data */
+  void *userdata;
+} CnedkVinCaptureGroupCreateParams;
+
+/**
+ * @brief Creates a video input capture group, which captures frames from several sensors as synchronized sets.
+ * @param[out] group A pointer points to the pointer of a video input capture group.
+ * @param[in] params The parameters for creating video input capture group.
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVinCaptureGroupCreate(void **group, CnedkVinCaptureGroupCreateParams *params);
+/**
+ * @brief Destroys a video input capture group.
+ * @param[in] group A pointer of a video input capture group.
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVinCaptureGroupDestroy(void *group);
+/**
+ * @brief Captures one frame from every sensor of the group. Frames older than the others by more than
+ *        sync_threshold_us are dropped and captured again, then the set is copied into one batched BufSurface and
+ *        passed to OnFrames.
+ * @param[in] group A pointer of a video input capture group.
+ * @param[in] timeout_ms The timeout in milliseconds for the whole set.
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVinCaptureGroupCapture(void *group, int timeout_ms);
+
 #ifdef __cplusplus
 };
 #endif
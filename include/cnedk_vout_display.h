@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "cnedk_buf_surface.h"
+#include "cnedk_transform.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,6 +38,141 @@ extern "C" {
  */
 int CnedkVoutRender(CnedkBufSurface *surf);
 
+/**
+ * Holds the parameters of the paced renderer.
+ */
+typedef struct CnedkVoutRenderParams {
+  /** The refresh rate of the display in Hz. 30 is used if it is 0. */
+  uint32_t refresh_rate;
+  /** The max number of frames waiting to be presented. The oldest frame is dropped when the queue is full.
+   2 is used if it is 0. */
+  uint32_t queue_depth;
+  /** A frame presented later than its timestamp by more than this is counted as late, and the presentation clock
+   is resynchronized to it. One refresh interval is used if it is 0. */
+  uint32_t max_late_ms;
+  /** The number of timestamp ticks per second. 1000 (milliseconds) is used if it is 0. */
+  uint32_t pts_timescale;
+} CnedkVoutRenderParams;
+
+/**
+ * Holds the statistics of the paced renderer.
+ */
+typedef struct CnedkVoutRenderStats {
+  /** The number of frames queued. */
+  uint64_t queued;
+  /** The number of frames presented. */
+  uint64_t rendered;
+  /** The number of frames released without being presented, as a newer frame was due or the queue was full. */
+  uint64_t dropped;
+  /** The number of frames which were due longer than max_late_ms ago when they were picked. */
+  uint64_t late;
+  /** The number of refreshes without a new frame, the last frame is kept on the display. */
+  uint64_t repeated;
+} CnedkVoutRenderStats;
+
+/**
+ * @brief Starts the paced renderer. A render thread presents the queued frames against a monotonic clock at the
+ *        refresh rate, according to their timestamps.
+ *
+ * @param[in] params The parameters of the renderer.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVoutRenderStart(const CnedkVoutRenderParams *params);
+/**
+ * @brief Queues a frame to the paced renderer. The presentation time of the frame is given by surf->pts.
+ *        When several frames are due at a refresh, the most recent one is presented and the others are dropped.
+ *
+ * @param[in] surf A pointer points to the video frame. The renderer takes the ownership of it, and destroys it by
+ *                 CnedkBufSurfaceDestroy() after it is replaced on the display or dropped.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1, and surf is not taken.
+ */
+int CnedkVoutRenderQueue(CnedkBufSurface *surf);
+/**
+ * @brief Gets the statistics of the paced renderer.
+ *
+ * @param[out] stats The statistics.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVoutRenderGetStats(CnedkVoutRenderStats *stats);
+/**
+ * @brief Stops the paced renderer. The frames not presented are dropped.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVoutRenderStop(void);
+
+/**
+ * Holds the parameters for creating a mosaic compositor.
+ */
+typedef struct CnedkVoutMosaicParams {
+  /** The id of device where the composite is made. */
+  int device_id;
+  /** The width of the composite. */
+  uint32_t width;
+  /** The height of the composite. */
+  uint32_t height;
+  /** The color format of the composite. Only NV12 and NV21 are supported. */
+  CnedkBufSurfaceColorFormat color_format;
+  /** The memory type of the composite, e.g. CNEDK_BUF_MEM_VB on CE3226 to be rendered on vout. */
+  CnedkBufSurfaceMemType mem_type;
+  /** The compute device used to scale the inputs into their tiles. */
+  CnedkTransformComputeMode compute_mode;
+  /** The number of inputs. */
+  uint32_t num_inputs;
+  /** The tile of each input on the composite, num_inputs rectangles. Coordinates are rounded down to even numbers.
+   If it is NULL, the inputs are laid out in a grid. */
+  CnedkTransformRect *rects;
+  /** The number of columns of the grid. Used only if rects is NULL. ceil(sqrt(num_inputs)) is used if it is 0. */
+  uint32_t grid_cols;
+  /** The rate in Hz at which composites are produced. 30 is used if it is 0. */
+  uint32_t frame_rate;
+  /** The number of composite buffers used in turn, so that a buffer is not drawn while it is being displayed.
+   2 is used if it is 0. */
+  uint32_t num_buffers;
+  /** Called with each composite. The composite is only valid during the call. If it is NULL, the composite is
+   rendered by CnedkVoutRender(). */
+  int (*OnComposite)(CnedkBufSurface *surf, void *userdata);
+  /** The user data passed to OnComposite. */
+  void *userdata;
+} CnedkVoutMosaicParams;
+
+/**
+ * @brief Creates a mosaic compositor, which tiles several input streams onto one output.
+ *
+ * The latest frame of each input is kept. At the frame rate, the tiles whose input changed since the buffer was
+ * last drawn are scaled into the composite with one batched CnedkTransform() using CNEDK_TRANSFORM_CROP_DST,
+ * the other tiles are left untouched. Nothing is produced when no input changed. A tile whose frame fails to be
+ * drawn keeps its previous picture until the input sends a new frame, the composite is produced anyway.
+ *
+ * @param[out] mosaic A pointer points to the pointer of the compositor.
+ * @param[in] params The parameters for creating the compositor.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVoutMosaicCreate(void **mosaic, CnedkVoutMosaicParams *params);
+/**
+ * @brief Destroys a mosaic compositor. The frames kept are destroyed.
+ *
+ * @param[in] mosaic A pointer of the compositor.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1.
+ */
+int CnedkVoutMosaicDestroy(void *mosaic);
+/**
+ * @brief Sends a frame of an input to a mosaic compositor, replacing the previous frame of the input.
+ *
+ * @param[in] mosaic A pointer of the compositor.
+ * @param[in] input_idx The index of the input.
+ * @param[in] surf A pointer points to the frame, batch size must be 1. The compositor takes the ownership of it,
+ *                 and destroys it by CnedkBufSurfaceDestroy() after it is replaced.
+ *
+ * @return Returns 0 if this function has run successfully. Otherwise returns -1, and surf is not taken.
+ */
+int CnedkVoutMosaicSendFrame(void *mosaic, uint32_t input_idx, CnedkBufSurface *surf);
+
 #ifdef __cplusplus
 };
 #endif
@@ -317,6 +317,8 @@ struct InferData {
   any data;
   /// user data passed to postprocessor
   any user_data;
+  /// trace id got by CnedkTraceNewId(), the time spent in each processor is recorded if it is not 0
+  uint64_t trace_id{0};
   /// private member
   RequestControl* ctrl{nullptr};
   /// private member
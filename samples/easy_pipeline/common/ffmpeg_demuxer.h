@@ -38,6 +38,8 @@ extern "C" {
 
 #include "glog/logging.h"
 
+#include "cnedk_decode.h"
+
 //---------------------------------------------------------------------------
 //! \file ffmpeg_demuxer.h
 //! \brief Provides functionality for stream demuxing
@@ -102,6 +104,7 @@ class FFmpegDemuxer {
   uint8_t                  *data_with_header_ = nullptr;
   unsigned int              frame_count_ = 0;
   const char               *fname;
+  CnedkVdecMode             filter_mode_ = CNEDK_VDEC_MODE_ALL;
 
  public:
   class DataProvider {
@@ -449,7 +452,34 @@ class FFmpegDemuxer {
   int GetFrameSize() {
     return width_ * (height_ + chroma_height_) * bpp_;
   }
+  /**
+   * Drops packets that a decoder running in the given mode would discard anyway, so they are never sent.
+   * Only takes effect on H.264 and H.265 streams.
+   */
+  void SetFrameFilter(CnedkVdecMode mode) {
+    filter_mode_ = mode;
+  }
   bool ReadFrame(uint8_t **video, int *video_bytes_num, int64_t *pts = nullptr) {
+    CnedkVdecType type;
+    if (video_codec_ == AV_CODEC_ID_H264) {
+      type = CNEDK_VDEC_TYPE_H264;
+    } else if (video_codec_ == AV_CODEC_ID_HEVC) {
+      type = CNEDK_VDEC_TYPE_H265;
+    } else {
+      return ReadNextFrame(video, video_bytes_num, pts);
+    }
+    while (ReadNextFrame(video, video_bytes_num, pts)) {
+      if (filter_mode_ == CNEDK_VDEC_MODE_ALL) return true;
+      CnedkVdecFrameType frame_type = CNEDK_VDEC_FRAME_UNKNOWN;
+      CnedkVdecGetFrameType(type, *video, *video_bytes_num, &frame_type);
+      if (frame_type == CNEDK_VDEC_FRAME_UNKNOWN || frame_type == CNEDK_VDEC_FRAME_KEY) return true;
+      if (filter_mode_ == CNEDK_VDEC_MODE_REF_ONLY && frame_type == CNEDK_VDEC_FRAME_REF) return true;
+    }
+    return false;
+  }
+
+ private:
+  bool ReadNextFrame(uint8_t **video, int *video_bytes_num, int64_t *pts) {
     if (!fmtc_) {
       return false;
     }
@@ -572,6 +602,7 @@ class FFmpegDemuxer {
     return true;
 }
 
+ public:
   static int ReadPacket(void *opaque, uint8_t *buf, int size) {
     return (reinterpret_cast<DataProvider *>(opaque))->GetData(buf, size);
   }
@@ -31,6 +31,7 @@
 
 #include "cnedk_decode.h"
 #include "cnedk_platform.h"
+#include "cnedk_trace.h"
 
 #include "easy_module.hpp"
 
@@ -55,6 +56,7 @@ int SampleDecode::Process(std::shared_ptr<EdkFrame> frame) {
     }
     packet.len = data_len;
     packet.pts = pts;
+    MarkPacket(packet);
     int retry_time = 50;
     while (retry_time--) {
       if (CnedkVdecSendStream(vdec_, &packet, 5000) < 0) {
@@ -112,8 +114,10 @@ int SampleDecode::Open() {
     LOG(ERROR) << "[EasyDK Sample] [Decode] Create demuxer failed";
     return -1;
   }
+  demuxer_->SetFrameFilter(mode_);
   fr_controller_.reset(new FrController(frame_rate_));
 
+  memset(&params_, 0, sizeof(params_));
   params_.color_format = CNEDK_BUF_COLOR_FORMAT_NV21;
   params_.device_id = dev_id_;
   switch (demuxer_->GetVideoCodec()) {
@@ -135,6 +139,8 @@ int SampleDecode::Open() {
   params_.userdata = this;
   params_.frame_buf_num = 12;  // for CE3226
   params_.surf_timeout_ms = 5000;
+  params_.mode = mode_;
+  params_.output_interval = output_interval_;
 
   params_.max_width = 3840;
   params_.max_height = 2160;
@@ -187,6 +193,25 @@ int SampleDecode::CreateSurfacePool(void** surf_pool, int width, int height) {
   return 0;
 }
 
+void SampleDecode::MarkPacket(const CnedkVdecStream& packet) {
+  CnedkVdecFrameType frame_type = CNEDK_VDEC_FRAME_KEY;
+  if (params_.type != CNEDK_VDEC_TYPE_JPEG) {
+    frame_type = CNEDK_VDEC_FRAME_UNKNOWN;
+    CnedkVdecGetFrameType(params_.type, packet.bits, packet.len, &frame_type);
+  }
+  std::unique_lock<std::mutex> lk(packets_mutex_);
+  packets_[packet.pts] = {frame_type == CNEDK_VDEC_FRAME_KEY, CnedkTraceNow()};
+}
+
+void SampleDecode::TakePacket(uint64_t pts, bool* is_key_frame, uint64_t* send_ns) {
+  std::unique_lock<std::mutex> lk(packets_mutex_);
+  auto iter = packets_.find(pts);
+  *is_key_frame = iter != packets_.end() && iter->second.is_key_frame;
+  *send_ns = iter != packets_.end() ? iter->second.send_ns : CnedkTraceNow();
+  // frames come out in pts order, the packets before this one will never be asked for
+  packets_.erase(packets_.begin(), packets_.upper_bound(pts));
+}
+
 int SampleDecode::OnError(int err_code) {
   LOG(ERROR) << "[EasyDK Sample] [Decode] OnError";
   return 0;
@@ -204,6 +229,10 @@ int SampleDecode::OnFrame(CnedkBufSurface* surf) {
     std::shared_ptr<EdkFrame> new_frame = std::make_shared<EdkFrame>();
     new_frame->stream_id = stream_id_;
     new_frame->is_eos = false;
+    uint64_t send_ns = 0;
+    TakePacket(surf->pts, &new_frame->is_key_frame, &send_ns);
+    new_frame->trace_id = CnedkTraceNewId();
+    CnedkTraceRecord(new_frame->trace_id, "decode", send_ns, CnedkTraceNow());
     new_frame->surf = std::make_shared<cnedk::BufSurfaceWrapper>(surf);
 
     new_frame->frame_idx = frame_count_++;
@@ -21,7 +21,9 @@
 #ifndef SAMPLE_DECODE_HPP_
 #define SAMPLE_DECODE_HPP_
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include "cnedk_decode.h"
@@ -35,13 +37,16 @@
 class SampleDecode : public EasyModule {
  public:
   SampleDecode(std::string name, int parallelism, int device_id, std::string filename, int stream_id,
-               int frame_rate = 30) : EasyModule(name, parallelism) {
+               int frame_rate = 30, CnedkVdecMode mode = CNEDK_VDEC_MODE_ALL, uint32_t output_interval = 0)
+      : EasyModule(name, parallelism) {
     filename_ = filename;
     stream_id_ = stream_id;
     dev_id_ = device_id;
     if (frame_rate > 0) {
       frame_rate_ = frame_rate;
     }
+    mode_ = mode;
+    output_interval_ = output_interval;
   }
 
   ~SampleDecode();
@@ -76,6 +81,8 @@ class SampleDecode : public EasyModule {
   int OnFrame(CnedkBufSurface *surf);
   int OnEos();
   int OnError(int errcode);
+  void MarkPacket(const CnedkVdecStream& packet);
+  void TakePacket(uint64_t pts, bool* is_key_frame, uint64_t* send_ns);
 
  private:
   int stream_id_;
@@ -93,8 +100,16 @@ class SampleDecode : public EasyModule {
   void* surf_pool_ = nullptr;
   int dev_id_ = 0;
   int frame_rate_ = 30;
+  CnedkVdecMode mode_ = CNEDK_VDEC_MODE_ALL;
+  uint32_t output_interval_ = 0;
 
   uint8_t* data_buffer_ = nullptr;
+  struct PacketInfo {
+    bool is_key_frame;
+    uint64_t send_ns;  // by CnedkTraceNow(), the decode span of a traced frame begins with it
+  };
+  std::mutex packets_mutex_;
+  std::map<uint64_t, PacketInfo> packets_;  // key is pts
 };
 
 #endif
@@ -19,44 +19,61 @@
  *************************************************************************/
 
 #include <memory>
+#include <queue>
 #include <string>
+#include <utility>
 
 #include "easy_pipeline.hpp"
 
 #include "glog/logging.h"
 
+#include "cnedk_trace.h"
+
+namespace {
+bool Reaches(const NodeContext* from, const NodeContext* to) {
+  if (from == to) return true;
+  for (const auto& next : from->nexts) {
+    if (Reaches(next.get(), to)) return true;
+  }
+  return false;
+}
+
+void CollectReachable(NodeContext* node, std::set<NodeContext*>* reachable) {
+  if (!reachable->insert(node).second) return;
+  for (const auto& next : node->nexts) CollectReachable(next.get(), reachable);
+}
+// a task hands the worker over to the next ready stream after this many frames, so that one busy stream can not
+// hold a worker for long
+constexpr int kMaxFramesPerTask = 8;
+}  // namespace
+
 EasyPipeline::~EasyPipeline() {
+  // release the modules blocked on a full queue, nobody will pop it anymore
+  running_ = false;
+  ShutdownQueues();
   for (size_t i = 0; i < sources_.size(); ++i) {
     if (sources_[i]->threads.size() && sources_[i]->threads[0].joinable()) {
       sources_[i]->threads[0].join();
     }
   }
+  executor_.Stop();
 
-  for (size_t i = 0; i < sources_.size(); ++i) {
-    std::shared_ptr<NodeContext> temp_node = sources_[i]->next;
-    while (temp_node) {
-      if (temp_node->threads.size()) {
-        for (std::thread& it : temp_node->threads) {
-          if (it.joinable()) it.join();
-        }
-        temp_node->threads.clear();
-        temp_node->module->Close();  // close module
-      }
-      temp_node = temp_node->next;
+  // close in topological order, a module is closed after all the modules sending frames to it
+  for (auto& temp_node : sorted_nodes_) {
+    if (temp_node->opened) {
+      temp_node->opened = false;
+      temp_node->module->Close();  // close module
     }
   }
+  sorted_nodes_.clear();
+  // nexts hold the nodes, break the links before releasing them
+  for (auto& source : sources_) source->nexts.clear();
+  for (auto& node : nodes_) node->nexts.clear();
   sources_.clear();
 
   // clear all sink module
   sinks_.clear();
 
-  // clear all frame queue
-  for (size_t i = 0; i < nodes_.size(); ++i) {
-    for (size_t j = 0; j < nodes_[i]->input_queues.size(); ++j) {
-      delete nodes_[i]->input_queues[j];
-    }
-    nodes_[i]->input_queues.clear();
-  }
   nodes_.clear();
 }
 
@@ -81,35 +98,43 @@ int EasyPipeline::AddModule(std::shared_ptr<EasyModule> module) {
 
   node = std::make_shared<NodeContext>();
   node->module = module;
-  node->input_queues.reserve(module->GetParallelism());
-  for (int i = 0; i < module->GetParallelism(); ++i) {
-    FrameQueue* frame_queue = new ThreadSafeQueue<std::shared_ptr<EdkFrame>>();
-    node->input_queues.push_back(frame_queue);
-  }
 
   node->module_name = module->GetModuleName();
   nodes_.push_back(node);   // put node to node list
   return 0;
 }
 
-int EasyPipeline::AddLink(std::string current, std::string next) {
+int EasyPipeline::AddLink(std::string current, std::string next, LinkConfig config) {
   bool source_find = false;
   std::shared_ptr<NodeContext> next_node = FindNodeByName(next);
+  if (!next_node) return -1;
+  auto link_to_next = [&](std::shared_ptr<NodeContext> current_node) {
+    if (std::find(current_node->nexts.begin(), current_node->nexts.end(), next_node) != current_node->nexts.end()) {
+      return;
+    }
+    current_node->nexts.push_back(next_node);
+    next_node->prevs.push_back(current_node.get());
+    if (std::find(next_node->upstreams.begin(), next_node->upstreams.end(), current) == next_node->upstreams.end()) {
+      next_node->upstreams.push_back(current);
+    }
+  };
 
   for (auto& source_iter : sources_) {
     if (source_iter->module_name == current) {
-      source_iter->next = next_node;
+      link_to_next(source_iter);
       source_find = true;
     }
   }
-  if (source_find) return 0;
-
-  std::shared_ptr<NodeContext> current_node = FindNodeByName(current);;
-  if (current_node && next_node) {
-    current_node->next = next_node;
-  } else {
-    return -1;
+  if (!source_find) {
+    std::shared_ptr<NodeContext> current_node = FindNodeByName(current);
+    if (!current_node) return -1;
+    if (Reaches(next_node.get(), current_node.get())) {
+      LOG(ERROR) << "[EasyDK Sample] [EasyPipeline] Link " << current << "->" << next << " makes a cycle";
+      return -1;
+    }
+    link_to_next(current_node);
   }
+  next_node->input_config = config;
   return 0;
 }
 
@@ -153,6 +178,7 @@ void EasyPipeline::WaitForStop() {
           }
         }
         for (auto& module_iter : sinks_) {
+          std::lock_guard<std::mutex> lk(module_iter->streams_mutex);
           for (const auto& map_iter : module_iter->stream_process_map) {  // other module as sink module
             if (map_iter.second == true) {
               return false;
@@ -165,45 +191,148 @@ void EasyPipeline::WaitForStop() {
     lk.unlock();
   }
   running_ = false;
+  ShutdownQueues();
+}
+
+std::vector<LinkStats> EasyPipeline::GetLinkStats() {
+  std::vector<LinkStats> link_stats;
+  for (const auto& node : nodes_) {
+    if (node->upstreams.empty()) continue;
+    std::string upstream;
+    for (const auto& name : node->upstreams) {
+      upstream += (upstream.empty() ? "" : ",") + name;
+    }
+    std::lock_guard<std::mutex> lk(node->streams_mutex);
+    for (const auto& stream : node->streams) {
+      LinkStats stats;
+      stats.name = upstream + "->" + node->module_name + "[" + std::to_string(stream.first) + "]";
+      stats.stats = stream.second->queue->GetStats();
+      link_stats.push_back(stats);
+    }
+  }
+  return link_stats;
+}
+
+void EasyPipeline::ShutdownQueues() {
+  for (const auto& node : nodes_) {
+    std::lock_guard<std::mutex> lk(node->streams_mutex);
+    for (auto& stream : node->streams) stream.second->queue->Shutdown();
+  }
 }
 
 int EasyPipeline::BuildEasyPipeline() {
   int ret;
+  if (SortNodes() != 0) return -1;
+  FindJoins();
+  executor_.Start();
+
+  // open in reverse topological order, so a module is ready before anything is sent to it
+  for (auto it = sorted_nodes_.rbegin(); it != sorted_nodes_.rend(); ++it) {
+    std::shared_ptr<NodeContext> temp_node = *it;
+    ret = temp_node->module->Open();
+    if (ret != 0) {
+      LOG(ERROR) << "[EasyDK Sample] [EasyPipeline] Open [" << temp_node->module_name << "] failed";
+      return -1;
+    }
+
+    temp_node->opened = true;
+    SetSendCallback(temp_node, false);
+    if (temp_node->nexts.empty()) {  // save all sink modules
+      sinks_.push_back(temp_node);
+    }
+  }
   for (size_t i = 0; i < sources_.size(); ++i) {
     ret = sources_[i]->module->Open();
     if (ret != 0) {
       LOG(ERROR) << "[EasyDK Sample] [EasyPipeline] Open [" << sources_[i]->module_name << "] failed";
       return -1;
     }
-    std::shared_ptr<NodeContext> temp_node = sources_[i]->next;
-
-    while (temp_node) {
-      if (temp_node->threads.size()) {
-        break;
-      } else {
-        ret = temp_node->module->Open();
-        if (ret != 0) {
-          LOG(ERROR) << "[EasyDK Sample] [EasyPipeline] Open [" << temp_node->module_name << "] failed";
-          return -1;
-        }
+  }
+  for (size_t i = 0; i < sources_.size(); ++i) {
+    SetSendCallback(sources_[i], true);
+    sources_[i]->threads.push_back(std::thread(&EasyPipeline::Taskloop, this, sources_[i]));
+  }
+  return 0;
+}
 
-        for (int j = 0; j < temp_node->module->GetParallelism(); ++j) {
-          temp_node->threads.push_back(std::thread(&EasyPipeline::Taskloop, this, temp_node, j));
-        }
-        if (temp_node->next == nullptr) {  // save all sink modules
-          sinks_.push_back(temp_node);
-        }
-        temp_node = temp_node->next;
-      }
+int EasyPipeline::SortNodes() {
+  std::set<NodeContext*> reachable;
+  std::set<NodeContext*> sources;
+  for (auto& source : sources_) {
+    CollectReachable(source.get(), &reachable);
+    sources.insert(source.get());
+  }
+
+  // Kahn's algorithm over the modules reached from sources
+  std::map<NodeContext*, int> in_degree;
+  std::queue<std::shared_ptr<NodeContext>> ready;
+  for (auto& node : nodes_) {
+    if (!reachable.count(node.get())) {
+      LOG(WARNING) << "[EasyDK Sample] [EasyPipeline] [" << node->module_name << "] is not linked to any source";
+      continue;
+    }
+    int degree = 0;
+    for (auto prev : node->prevs) {
+      if (!sources.count(prev)) ++degree;
     }
+    in_degree[node.get()] = degree;
+    if (!degree) ready.push(node);
   }
-  for (size_t i = 0; i < sources_.size(); ++i) {
-    sources_[i]->threads.push_back(std::thread(&EasyPipeline::Taskloop, this, sources_[i], 0));
+  sorted_nodes_.clear();
+  while (!ready.empty()) {
+    std::shared_ptr<NodeContext> node = ready.front();
+    ready.pop();
+    sorted_nodes_.push_back(node);
+    for (auto& next : node->nexts) {
+      if (--in_degree[next.get()] == 0) ready.push(next);
+    }
+  }
+  if (sorted_nodes_.size() != in_degree.size()) {
+    LOG(ERROR) << "[EasyDK Sample] [EasyPipeline] Modules are linked in a cycle";
+    return -1;
   }
   return 0;
 }
 
-int EasyPipeline::ProcessFrameEos(std::shared_ptr<NodeContext> node, std::shared_ptr<EdkFrame> frame) {
+void EasyPipeline::FindJoins() {
+  for (auto& source : sources_) {
+    std::set<NodeContext*> reachable;
+    CollectReachable(source.get(), &reachable);
+    for (auto& node : sorted_nodes_) {
+      if (!reachable.count(node.get())) continue;
+      int branches = std::count_if(node->prevs.begin(), node->prevs.end(),
+                                   [&reachable](NodeContext* prev) { return reachable.count(prev) != 0; });
+      if (branches > 1) {
+        node->join_branches[source.get()] = branches;
+        has_join_ = true;
+      }
+    }
+  }
+}
+
+bool EasyPipeline::JoinBranches(NodeContext* node, const std::shared_ptr<EdkFrame>& frame) {
+  if (node->join_branches.empty()) return true;
+  NodeContext* source = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(stream_sources_mutex_);
+    auto iter = stream_sources_.find(frame->stream_id);
+    if (iter != stream_sources_.end()) source = iter->second;
+  }
+  auto branches = node->join_branches.find(source);
+  if (branches == node->join_branches.end()) return true;
+
+  std::lock_guard<std::mutex> lk(node->join_mutex);
+  auto key = std::make_pair(frame->stream_id, frame->frame_idx);
+  if (++node->join_arrivals[key] < branches->second) return false;
+  // Every branch delivers the frames of a stream in order, so the earlier frames still waiting here have been
+  // dropped by some branch and will never be complete.
+  node->join_arrivals.erase(node->join_arrivals.lower_bound(std::make_pair(frame->stream_id, uint64_t(0))),
+                            node->join_arrivals.upper_bound(key));
+  return true;
+}
+
+int EasyPipeline::ProcessFrameEos(NodeContext* node, std::shared_ptr<EdkFrame> frame) {
+  std::lock_guard<std::mutex> lk(node->streams_mutex);
   if (frame->is_eos) {
     if (node->stream_process_map.find(frame->stream_id) != node->stream_process_map.end()) {
       node->stream_process_map[frame->stream_id] = false;
@@ -224,18 +353,25 @@ std::shared_ptr<NodeContext> EasyPipeline::FindNodeByName(std::string name) {
   return node_iter == nodes_.end() ? nullptr : *node_iter;
 }
 
-void EasyPipeline::Taskloop(std::shared_ptr<NodeContext> node, int num) {
-  // std::cout << node->module->GetModuleName() << ", " << node->module->GetParallelism() << std::endl;
+void EasyPipeline::SetSendCallback(std::shared_ptr<NodeContext> node_ptr, bool is_source) {
+  // the module holds the callback, so it must not hold the node, or neither would ever be released
+  NodeContext* node = node_ptr.get();
   auto send_data = [node, this](std::shared_ptr<EdkFrame> frame) -> int {
-    if (node->next) {
-      node->next->input_queues[frame->stream_id % node->next->module->GetParallelism()]->Push(frame);
+    for (auto& next : node->nexts) {  // fan-out shares the frame, nothing is copied
+      Deliver(next.get(), frame);
     }
     return 0;
   };
 
   auto source_send_data = [node, this](std::shared_ptr<EdkFrame> frame) -> int {
-    if (node->next) {
-      node->next->input_queues[frame->stream_id % node->next->module->GetParallelism()]->Push(frame);
+    // sources which know better when a frame begins (e.g. decode) set the trace id themselves
+    if (!frame->is_eos && !frame->trace_id) frame->trace_id = CnedkTraceNewId();
+    if (has_join_) {
+      std::lock_guard<std::mutex> lk(stream_sources_mutex_);
+      stream_sources_[frame->stream_id] = node;
+    }
+    for (auto& next : node->nexts) {
+      Deliver(next.get(), frame);
     }
 
     if (frame->is_eos) {   // source process
@@ -244,26 +380,120 @@ void EasyPipeline::Taskloop(std::shared_ptr<NodeContext> node, int num) {
     return 0;
   };
 
-  auto node_iter = std::find(sources_.begin(), sources_.end(), node);
-
-  if (node_iter != sources_.end()) {
+  if (is_source) {
     node->module->SetProcessDoneCallback(source_send_data);
   } else {
     node->module->SetProcessDoneCallback(send_data);
   }
+}
+
+void EasyPipeline::Taskloop(std::shared_ptr<NodeContext> node) {
+  while (running_) {
+    node->module->Process(nullptr);
+  }
+}
+
+StreamContext* EasyPipeline::GetStream(NodeContext* node, int stream_id) {
+  std::lock_guard<std::mutex> lk(node->streams_mutex);
+  std::unique_ptr<StreamContext>& stream = node->streams[stream_id];
+  if (!stream) {
+    stream.reset(new StreamContext);
+    stream->queue.reset(new FrameQueue(node->input_config));
+    if (!running_) stream->queue->Shutdown();
+  }
+  return stream.get();
+}
 
-  if (node_iter != sources_.end()) {   // source process
-    while (running_) {
-      node->module->Process(nullptr);
+void EasyPipeline::Deliver(NodeContext* node, const std::shared_ptr<EdkFrame>& frame) {
+  // A worker must not wait for room, all the workers could end up waiting for each other. The upstream tasks check
+  // CanSend() before taking a frame instead, which bounds the queue unless a module sends several frames for one.
+  bool may_block = !executor_.InWorker();
+  if (GetStream(node, frame->stream_id)->queue->Push(frame, may_block)) {
+    Schedule(node, frame->stream_id);
+  }
+}
+
+void EasyPipeline::Schedule(NodeContext* node, int stream_id) {
+  {
+    std::lock_guard<std::mutex> lk(node->streams_mutex);
+    auto iter = node->streams.find(stream_id);
+    if (iter == node->streams.end()) return;
+    StreamContext* stream = iter->second.get();
+    if (stream->scheduled || stream->blocked || !stream->queue->Size()) return;
+    stream->scheduled = true;
+    if (node->active_tasks >= node->module->GetParallelism()) {
+      node->ready_streams.push_back(stream_id);
+      return;
     }
-  } else {    // orther node process
-    while (running_) {
-      std::shared_ptr<EdkFrame> frame = nullptr;
-      if (node->input_queues[num]->WaitAndTryPop(frame, std::chrono::microseconds(200))) {
-        node->module->Process(frame);
-        ProcessFrameEos(node, frame);
-      }
+    ++node->active_tasks;
+  }
+  executor_.Submit([this, node, stream_id] { RunStream(node, stream_id); });
+}
+
+void EasyPipeline::RunStream(NodeContext* node, int stream_id) {
+  StreamContext* stream = GetStream(node, stream_id);
+  bool blocked = false;
+  for (int i = 0; i < kMaxFramesPerTask && running_; ++i) {
+    if (!CanSend(node, stream_id)) {
+      blocked = true;
+      break;
     }
+    std::shared_ptr<EdkFrame> frame = nullptr;
+    if (!stream->queue->WaitAndTryPop(frame, std::chrono::microseconds(0))) break;
+    // there is room in this queue now, the upstream modules may go on with this stream
+    for (auto prev : node->prevs) Unblock(prev, stream_id);
+    if (!JoinBranches(node, frame)) continue;  // waiting for the other branches
+    uint64_t trace_begin = frame->trace_id ? CnedkTraceNow() : 0;
+    node->module->Process(frame);
+    if (frame->trace_id) {
+      CnedkTraceRecord(frame->trace_id, node->module->GetModuleName().c_str(), trace_begin, CnedkTraceNow());
+    }
+    ProcessFrameEos(node, frame);
+  }
+
+  int next_stream_id = 0;
+  bool has_next = false;
+  {
+    std::lock_guard<std::mutex> lk(node->streams_mutex);
+    if (blocked) {
+      stream->blocked = true;
+      stream->scheduled = false;
+    } else if (stream->queue->Size()) {
+      node->ready_streams.push_back(stream_id);  // back of the line, the other streams go first
+    } else {
+      stream->scheduled = false;
+    }
+    if (!node->ready_streams.empty() && running_) {
+      next_stream_id = node->ready_streams.front();
+      node->ready_streams.pop_front();
+      has_next = true;
+    } else {
+      --node->active_tasks;
+    }
+  }
+  if (has_next) {
+    executor_.Submit([this, node, next_stream_id] { RunStream(node, next_stream_id); });
   }
+  // the downstream queue may have been popped after CanSend() and before blocked is set
+  if (blocked && CanSend(node, stream_id)) Unblock(node, stream_id);
 }
 
+bool EasyPipeline::CanSend(NodeContext* node, int stream_id) {
+  for (auto& next : node->nexts) {
+    const LinkConfig& config = next->input_config;
+    if (config.policy != OverflowPolicy::kBlock || !config.capacity) continue;
+    if (GetStream(next.get(), stream_id)->queue->Size() >= config.capacity) return false;
+  }
+  return true;
+}
+
+void EasyPipeline::Unblock(NodeContext* node, int stream_id) {
+  {
+    std::lock_guard<std::mutex> lk(node->streams_mutex);
+    auto iter = node->streams.find(stream_id);
+    // sources have no streams, they wait in FrameQueue::Push() instead
+    if (iter == node->streams.end() || !iter->second->blocked) return;
+    iter->second->blocked = false;
+  }
+  Schedule(node, stream_id);
+}
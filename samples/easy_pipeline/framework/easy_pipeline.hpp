@@ -36,39 +36,80 @@
 #include <vector>
 #include <mutex>
 #include <condition_variable>
+#include <deque>
 
 #include "easy_module.hpp"
-#include "threadsafe_queue.h"
+#include "executor.hpp"
+#include "frame_queue.hpp"
 
+struct StreamContext {
+  std::unique_ptr<FrameQueue> queue;
+  bool scheduled = false;  // waiting in ready_streams or being processed
+  bool blocked = false;    // waiting for room in a downstream queue
+};
 
-// template<typename T>
-using FrameQueue = ThreadSafeQueue<std::shared_ptr<EdkFrame>>;
 struct NodeContext {
   std::string module_name;
   std::shared_ptr<EasyModule> module;
-  std::vector<FrameQueue*> input_queues = {};
-  std::shared_ptr<NodeContext> next = nullptr;
-  std::vector<std::thread> threads;
+  // Every stream has its own input queue. Frames of a stream are processed one by one in order, while up to
+  // parallelism streams are processed at the same time.
+  LinkConfig input_config;
+  std::mutex streams_mutex;
+  std::map<int, std::unique_ptr<StreamContext>> streams;
+  std::deque<int> ready_streams;
+  int active_tasks = 0;
+  bool opened = false;
+  std::vector<std::string> upstreams = {};
+  std::vector<NodeContext*> prevs = {};
+  // fan-out, every next node gets the same frame object, so branches must not modify the same fields of it
+  std::vector<std::shared_ptr<NodeContext>> nexts = {};
+  std::vector<std::thread> threads;  // sources only, the other modules run on the executor
   std::map<int, bool> stream_process_map;
+  // fan-in, a frame is processed once it has arrived from all branches. Keyed by source, as the number of branches
+  // depends on which source the frame comes from. Empty if the node is not a join.
+  std::map<NodeContext*, int> join_branches;
+  std::mutex join_mutex;
+  std::map<std::pair<int, uint64_t>, int> join_arrivals;  // (stream id, frame idx) -> branches arrived
+};
+
+struct LinkStats {
+  std::string name;  // "upstream->module[stream id]"
+  FrameQueueStats stats;
 };
 
 
 class EasyPipeline {
  public:
-  EasyPipeline() = default;
+  // Modules other than sources share num_workers threads, 0 means one per hardware thread.
+  explicit EasyPipeline(int num_workers = 0) : executor_(num_workers) {}
   ~EasyPipeline();
   int AddSource(std::shared_ptr<EasyModule> module);
   int AddModule(std::shared_ptr<EasyModule> module);
-  int AddLink(std::string current, std::string next);
+  // Links may form a DAG. Linking a module to several nexts fans frames out, linking several modules to one next
+  // joins them. Returns -1 if the link makes a cycle.
+  // config applies to the input queues of next, which are shared by all the links into next.
+  int AddLink(std::string current, std::string next, LinkConfig config = LinkConfig());
   int Start();
   void Stop();
   void WaitForStop();
+  std::vector<LinkStats> GetLinkStats();
 
  private:
   int BuildEasyPipeline();
-  int ProcessFrameEos(std::shared_ptr<NodeContext> node, std::shared_ptr<EdkFrame> frame);
-  void Taskloop(std::shared_ptr<NodeContext> node, int num);
+  int ProcessFrameEos(NodeContext* node, std::shared_ptr<EdkFrame> frame);
+  void SetSendCallback(std::shared_ptr<NodeContext> node, bool is_source);
+  void Taskloop(std::shared_ptr<NodeContext> node);
+  StreamContext* GetStream(NodeContext* node, int stream_id);
+  void Deliver(NodeContext* node, const std::shared_ptr<EdkFrame>& frame);
+  void Schedule(NodeContext* node, int stream_id);
+  void RunStream(NodeContext* node, int stream_id);
+  bool CanSend(NodeContext* node, int stream_id);
+  void Unblock(NodeContext* node, int stream_id);
   std::shared_ptr<NodeContext> FindNodeByName(std::string name);
+  int SortNodes();
+  void FindJoins();
+  bool JoinBranches(NodeContext* node, const std::shared_ptr<EdkFrame>& frame);
+  void ShutdownQueues();
 
  private:
   std::condition_variable wakener_;
@@ -79,6 +120,11 @@ class EasyPipeline {
   std::vector<std::shared_ptr<NodeContext>> sources_{};
   std::atomic<bool> source_added_{false};
   std::vector<std::shared_ptr<NodeContext>> nodes_{};
+  std::vector<std::shared_ptr<NodeContext>> sorted_nodes_{};  // topological order, sources excluded
+  bool has_join_ = false;
+  std::mutex stream_sources_mutex_;
+  std::map<int, NodeContext*> stream_sources_;
+  Executor executor_;
 };
 
 
@@ -47,6 +47,8 @@ class EdkFrame {
   int stream_id;
   uint64_t frame_idx;
   bool is_eos;
+  bool is_key_frame = false;  // set by the source when known, used by OverflowPolicy::kKeyFramePreserving
+  uint64_t trace_id = 0;  // got by CnedkTraceNewId() from the source, 0 if the frame is not traced
   std::vector<DetectObject> objs;
   std::string track_id;
   std::map<std::string, std::string> attributes;  // add info into bbox, secondary infer classfication
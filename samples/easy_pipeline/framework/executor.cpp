@@ -0,0 +1,120 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include "executor.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+thread_local const Executor* tls_executor = nullptr;
+thread_local int tls_worker_index = -1;
+}  // namespace
+
+Executor::Executor(int num_workers) {
+  if (num_workers <= 0) num_workers = std::max(1u, std::thread::hardware_concurrency());
+  for (int i = 0; i < num_workers; ++i) {
+    workers_.emplace_back(new Worker);
+  }
+}
+
+Executor::~Executor() { Stop(); }
+
+void Executor::Start() {
+  if (running_) return;
+  running_ = true;
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    threads_.emplace_back(&Executor::Loop, this, static_cast<int>(i));
+  }
+}
+
+void Executor::Stop() {
+  if (!running_) return;
+  {
+    std::lock_guard<std::mutex> lk(idle_mutex_);
+    running_ = false;
+  }
+  idle_cond_.notify_all();
+  for (auto& thread : threads_) {
+    if (thread.joinable()) thread.join();
+  }
+  threads_.clear();
+  for (auto& worker : workers_) {
+    std::lock_guard<std::mutex> lk(worker->mutex);
+    worker->tasks.clear();
+  }
+  pending_ = 0;
+}
+
+bool Executor::InWorker() const { return tls_executor == this; }
+
+void Executor::Submit(Task task) {
+  int index = InWorker() ? tls_worker_index : static_cast<int>(next_worker_++ % workers_.size());
+  {
+    std::lock_guard<std::mutex> lk(workers_[index]->mutex);
+    workers_[index]->tasks.push_back(std::move(task));
+  }
+  {
+    // under the lock, or an idle worker could miss it between checking pending_ and going to sleep
+    std::lock_guard<std::mutex> lk(idle_mutex_);
+    ++pending_;
+  }
+  idle_cond_.notify_one();
+}
+
+bool Executor::Take(int index, Task* task) {
+  {
+    Worker* own = workers_[index].get();
+    std::lock_guard<std::mutex> lk(own->mutex);
+    if (!own->tasks.empty()) {
+      *task = std::move(own->tasks.front());
+      own->tasks.pop_front();
+      return true;
+    }
+  }
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    Worker* victim = workers_[(index + i) % workers_.size()].get();
+    std::lock_guard<std::mutex> lk(victim->mutex);
+    if (!victim->tasks.empty()) {
+      // the owner works from the head, steal from the tail to keep out of its way
+      *task = std::move(victim->tasks.back());
+      victim->tasks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void Executor::Loop(int index) {
+  tls_executor = this;
+  tls_worker_index = index;
+  while (running_) {
+    Task task;
+    if (Take(index, &task)) {
+      --pending_;
+      task();
+      continue;
+    }
+    std::unique_lock<std::mutex> lk(idle_mutex_);
+    idle_cond_.wait(lk, [this] { return !running_ || pending_ > 0; });
+  }
+  tls_executor = nullptr;
+  tls_worker_index = -1;
+}
@@ -0,0 +1,79 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#ifndef SAMPLE_EXECUTOR_HPP_
+#define SAMPLE_EXECUTOR_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed pool of workers shared by all modules. Every worker owns a task deque. It runs its own tasks in
+ * submission order and steals from the tail of the others' deques when it runs out of work, so a burst of tasks
+ * submitted by one worker spreads over the idle ones.
+ *
+ * Tasks are not ordered against each other. Ordering, e.g. serial per stream, is up to the caller.
+ */
+class Executor {
+ public:
+  using Task = std::function<void()>;
+
+  // 0 workers means one per hardware thread
+  explicit Executor(int num_workers = 0);
+  ~Executor();
+
+  void Start();
+  // Waits for the running tasks to finish. Pending tasks are discarded.
+  void Stop();
+  // Tasks submitted from a worker go to its own deque, the others are spread over the workers in turn.
+  void Submit(Task task);
+  // Whether the calling thread is a worker of this executor
+  bool InWorker() const;
+  int GetWorkerNum() const { return static_cast<int>(workers_.size()); }
+
+ private:
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  bool Take(int index, Task* task);
+  void Loop(int index);
+
+ private:
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  std::atomic<bool> running_{false};
+  std::atomic<uint32_t> next_worker_{0};
+  std::atomic<int> pending_{0};
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cond_;
+};
+
+#endif  // SAMPLE_EXECUTOR_HPP_
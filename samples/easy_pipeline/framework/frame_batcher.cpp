@@ -0,0 +1,85 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include "frame_batcher.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+FrameBatcher::FrameBatcher(size_t batch_size, uint32_t timeout_ms, FlushFunc flush)
+    : batch_size_(std::max<size_t>(batch_size, 1)), timeout_(timeout_ms), flush_(std::move(flush)) {
+  pending_.reserve(batch_size_);
+  timer_ = std::thread(&FrameBatcher::TimerLoop, this);
+}
+
+FrameBatcher::~FrameBatcher() {
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    running_ = false;
+  }
+  cond_.notify_all();
+  if (timer_.joinable()) timer_.join();
+  Flush();
+}
+
+void FrameBatcher::Add(std::shared_ptr<EdkFrame> frame) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  if (pending_.empty()) {
+    deadline_ = std::chrono::steady_clock::now() + timeout_;
+    cond_.notify_one();  // the timer waits for the first frame of a batch
+  }
+  pending_.push_back(std::move(frame));
+  if (pending_.size() < batch_size_) return;
+  lk.unlock();
+  Flush();
+}
+
+void FrameBatcher::Flush() {
+  std::lock_guard<std::mutex> flush_lk(flush_mutex_);
+  Batch batch;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (pending_.empty()) return;
+    // the frames added during the wait for flush_mutex_ go along, but no more than a batch
+    size_t num = std::min(pending_.size(), batch_size_);
+    batch.assign(pending_.begin(), pending_.begin() + num);
+    pending_.erase(pending_.begin(), pending_.begin() + num);
+    if (!pending_.empty()) deadline_ = std::chrono::steady_clock::now() + timeout_;
+  }
+  flush_(std::move(batch));
+}
+
+void FrameBatcher::TimerLoop() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  while (running_) {
+    if (pending_.empty()) {
+      cond_.wait(lk, [this] { return !running_ || !pending_.empty(); });
+      continue;
+    }
+    if (std::chrono::steady_clock::now() < deadline_) {
+      cond_.wait_until(lk, deadline_);
+      continue;
+    }
+    lk.unlock();
+    Flush();
+    lk.lock();
+  }
+}
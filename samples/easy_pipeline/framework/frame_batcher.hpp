@@ -0,0 +1,71 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#ifndef SAMPLE_FRAME_BATCHER_HPP_
+#define SAMPLE_FRAME_BATCHER_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "edk_frame.hpp"
+
+/**
+ * Groups frames, of any streams, into batches. A batch is handed to the flush function once it has batch_size
+ * frames, or once its first frame has waited for timeout_ms, whichever comes first.
+ *
+ * Batches are flushed one at a time in the order they were formed, so frames of a stream keep their order.
+ */
+class FrameBatcher {
+ public:
+  using Batch = std::vector<std::shared_ptr<EdkFrame>>;
+  using FlushFunc = std::function<void(Batch)>;
+
+  FrameBatcher(size_t batch_size, uint32_t timeout_ms, FlushFunc flush);
+  // flushes the frames left
+  ~FrameBatcher();
+
+  void Add(std::shared_ptr<EdkFrame> frame);
+  // Hands out the pending frames now, e.g. before eos is passed on.
+  void Flush();
+
+ private:
+  FrameBatcher(const FrameBatcher&) = delete;
+  FrameBatcher& operator=(const FrameBatcher&) = delete;
+  void TimerLoop();
+
+ private:
+  size_t batch_size_;
+  std::chrono::milliseconds timeout_;
+  FlushFunc flush_;
+  std::mutex flush_mutex_;  // held while a batch is being flushed, keeps batches in order
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  Batch pending_;
+  std::chrono::steady_clock::time_point deadline_;
+  bool running_ = true;
+  std::thread timer_;
+};
+
+#endif  // SAMPLE_FRAME_BATCHER_HPP_
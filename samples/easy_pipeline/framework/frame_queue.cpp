@@ -0,0 +1,120 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include "frame_queue.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+namespace {
+bool IsDroppable(const EdkFrame& frame) { return !frame.is_eos; }
+bool IsDroppableNonKey(const EdkFrame& frame) { return !frame.is_eos && !frame.is_key_frame; }
+}  // namespace
+
+void FrameQueue::SetConfig(const LinkConfig& config) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  config_ = config;
+  lk.unlock();
+  not_full_.notify_all();
+}
+
+bool FrameQueue::Push(std::shared_ptr<EdkFrame> frame, bool may_block) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  // eos is let in over capacity, otherwise the downstream modules would never know the stream is over
+  if (!shutdown_ && config_.capacity && q_.size() >= config_.capacity && !frame->is_eos) {
+    if (!MakeRoom(frame, may_block, &lk)) {
+      ++stats_.dropped;
+      return false;
+    }
+  }
+  if (shutdown_) {
+    ++stats_.dropped;
+    return false;
+  }
+  q_.push_back({std::move(frame), Clock::now()});
+  ++stats_.pushed;
+  stats_.max_depth = std::max(stats_.max_depth, q_.size());
+  lk.unlock();
+  not_empty_.notify_one();
+  return true;
+}
+
+bool FrameQueue::WaitAndTryPop(std::shared_ptr<EdkFrame>& frame, const std::chrono::microseconds rel_time) {  // NOLINT
+  std::unique_lock<std::mutex> lk(mutex_);
+  if (!not_empty_.wait_for(lk, rel_time, [this] { return !q_.empty(); })) {
+    return false;
+  }
+  frame = std::move(q_.front().frame);
+  double latency_ms = std::chrono::duration<double, std::milli>(Clock::now() - q_.front().enqueue_time).count();
+  q_.pop_front();
+  ++stats_.popped;
+  total_latency_ms_ += latency_ms;
+  stats_.max_latency_ms = std::max(stats_.max_latency_ms, latency_ms);
+  lk.unlock();
+  not_full_.notify_one();
+  return true;
+}
+
+void FrameQueue::Shutdown() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  shutdown_ = true;
+  lk.unlock();
+  not_full_.notify_all();
+}
+
+uint32_t FrameQueue::Size() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return q_.size();
+}
+
+FrameQueueStats FrameQueue::GetStats() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  FrameQueueStats stats = stats_;
+  stats.depth = q_.size();
+  stats.avg_latency_ms = stats_.popped ? total_latency_ms_ / stats_.popped : 0;
+  return stats;
+}
+
+bool FrameQueue::MakeRoom(const std::shared_ptr<EdkFrame>& frame, bool may_block, std::unique_lock<std::mutex>* lk) {
+  switch (config_.policy) {
+    case OverflowPolicy::kBlock:
+      if (!may_block) return true;
+      not_full_.wait(*lk, [this] { return shutdown_ || !config_.capacity || q_.size() < config_.capacity; });
+      return !shutdown_;
+    case OverflowPolicy::kDropOldest:
+      return DropFirst(IsDroppable);
+    case OverflowPolicy::kDropNewest:
+      return false;
+    case OverflowPolicy::kKeyFramePreserving:
+      if (DropFirst(IsDroppableNonKey)) return true;
+      // only key frames are queued, a new key frame supersedes the oldest one
+      return frame->is_key_frame && DropFirst(IsDroppable);
+  }
+  return false;
+}
+
+bool FrameQueue::DropFirst(bool (*droppable)(const EdkFrame&)) {
+  auto it = std::find_if(q_.begin(), q_.end(), [droppable](const Item& item) { return droppable(*item.frame); });
+  if (it == q_.end()) return false;
+  q_.erase(it);
+  ++stats_.dropped;
+  return true;
+}
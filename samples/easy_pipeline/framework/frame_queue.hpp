@@ -0,0 +1,102 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#ifndef SAMPLE_FRAME_QUEUE_HPP_
+#define SAMPLE_FRAME_QUEUE_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "edk_frame.hpp"
+
+/**
+ * What a full link does with one more frame. EOS frames are never dropped, whatever the policy is.
+ */
+enum class OverflowPolicy {
+  kBlock,              // the upstream module waits until there is room
+  kDropOldest,         // the oldest queued frame is dropped to make room
+  kDropNewest,         // the incoming frame is dropped
+  kKeyFramePreserving  // the oldest non-key frame is dropped, or the incoming one if it is not a key frame either
+};
+
+struct LinkConfig {
+  size_t capacity = 0;  // 0 means unbounded
+  OverflowPolicy policy = OverflowPolicy::kBlock;
+};
+
+struct FrameQueueStats {
+  size_t depth = 0;
+  size_t max_depth = 0;
+  uint64_t pushed = 0;
+  uint64_t popped = 0;
+  uint64_t dropped = 0;
+  double avg_latency_ms = 0;  // time frames have spent in the queue
+  double max_latency_ms = 0;
+};
+
+class FrameQueue {
+ public:
+  FrameQueue() = default;
+  explicit FrameQueue(const LinkConfig& config) : config_(config) {}
+  FrameQueue(const FrameQueue&) = delete;
+  FrameQueue& operator=(const FrameQueue&) = delete;
+
+  void SetConfig(const LinkConfig& config);
+
+  // Returns false if the frame is dropped, either by the overflow policy or because the queue is shut down.
+  // With may_block false, OverflowPolicy::kBlock lets the frame in over capacity instead of waiting, for callers
+  // which must not block and bound the queue themselves.
+  bool Push(std::shared_ptr<EdkFrame> frame, bool may_block = true);
+
+  bool WaitAndTryPop(std::shared_ptr<EdkFrame>& frame, const std::chrono::microseconds rel_time);  // NOLINT
+
+  // Wakes up and fails the blocked pushers, and drops all frames pushed afterwards.
+  void Shutdown();
+
+  uint32_t Size();
+
+  FrameQueueStats GetStats();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  struct Item {
+    std::shared_ptr<EdkFrame> frame;
+    Clock::time_point enqueue_time;
+  };
+
+  bool MakeRoom(const std::shared_ptr<EdkFrame>& frame, bool may_block, std::unique_lock<std::mutex>* lk);
+  bool DropFirst(bool (*droppable)(const EdkFrame&));
+
+ private:
+  LinkConfig config_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<Item> q_;
+  bool shutdown_ = false;
+  FrameQueueStats stats_;
+  double total_latency_ms_ = 0;
+};
+
+#endif  // SAMPLE_FRAME_QUEUE_HPP_
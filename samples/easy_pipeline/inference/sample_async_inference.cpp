@@ -34,15 +34,15 @@
 
 class SampleAsyncInferenceObserver : public infer_server::Observer {
  public:
-  explicit SampleAsyncInferenceObserver(std::function<void(std::shared_ptr<EdkFrame>, bool)> callback)
+  explicit SampleAsyncInferenceObserver(std::function<void(const FrameBatcher::Batch&, bool)> callback)
                           : callback_(callback) {}
   void Response(infer_server::Status status, infer_server::PackagePtr data,
                 infer_server::any user_data) noexcept override {
-    callback_(infer_server::any_cast<std::shared_ptr<EdkFrame>>(user_data), status == infer_server::Status::SUCCESS);
+    callback_(infer_server::any_cast<const FrameBatcher::Batch&>(user_data), status == infer_server::Status::SUCCESS);
   }
 
  private:
-  std::function<void(std::shared_ptr<EdkFrame>, bool)> callback_;
+  std::function<void(const FrameBatcher::Batch&, bool)> callback_;
 };
 
 int SampleAsyncInference::Open() {
@@ -52,7 +52,7 @@ int SampleAsyncInference::Open() {
   std::transform(lower_model_name.begin(), lower_model_name.end(), lower_model_name.begin(), ::tolower);
 
   infer_server::SessionDesc desc;
-  desc.strategy = infer_server::BatchStrategy::DYNAMIC;
+  desc.strategy = batch_timeout_ms_ ? infer_server::BatchStrategy::STATIC : infer_server::BatchStrategy::DYNAMIC;
   desc.engine_num = 6;
   desc.priority = 0;
   desc.show_perf = false;
@@ -83,43 +83,60 @@ int SampleAsyncInference::Open() {
   desc.postproc = infer_server::Postprocessor::Create();
   infer_server::SetPostprocHandler(desc.model->GetKey(), postproc_.get());
 
-  // set end of frame
-  auto eof_callback_ = [this](std::shared_ptr<EdkFrame> frame, bool valid) {
+  // set end of frame, postproc has written the results to the frame of each data already
+  auto eof_callback_ = [this](const FrameBatcher::Batch& frames, bool valid) {
     if (!valid) {
       return;
     }
-    Transmit(frame);
+    for (auto& frame : frames) Transmit(frame);
   };
 
   session_ = infer_server_->CreateSession(desc, std::make_shared<SampleAsyncInferenceObserver>(eof_callback_));
 
+  if (batch_timeout_ms_) {
+    batcher_.reset(new FrameBatcher(desc.model->BatchSize(), batch_timeout_ms_,
+                                    [this](FrameBatcher::Batch batch) { Request(std::move(batch)); }));
+  }
   return 0;
 }
 
 int SampleAsyncInference::Process(std::shared_ptr<EdkFrame> frame) {
   std::string stream = "stream_0";
   if (frame->is_eos) {
+    if (batcher_) batcher_->Flush();  // the frames before eos must not wait for the batch to fill up
     if (infer_server_) infer_server_->WaitTaskDone(session_, stream);
     Transmit(frame);
     return 0;
   }
 
-  infer_server::PackagePtr request = infer_server::Package::Create(1, stream);
-  infer_server::PreprocInput tmp;
+  if (batcher_) {
+    batcher_->Add(frame);
+    return 0;
+  }
+  return Request(FrameBatcher::Batch{frame});
+}
 
-  tmp.surf = frame->surf;
-  tmp.has_bbox = false;
-  request->data[0]->Set(std::move(tmp));
+int SampleAsyncInference::Request(FrameBatcher::Batch batch) {
+  std::string stream = "stream_0";
+  infer_server::PackagePtr request = infer_server::Package::Create(batch.size(), stream);
+  for (size_t i = 0; i < batch.size(); ++i) {
+    infer_server::PreprocInput tmp;
+    tmp.surf = batch[i]->surf;
+    tmp.has_bbox = false;
+    request->data[i]->Set(std::move(tmp));
+    request->data[i]->SetUserData(batch[i]);
+    request->data[i]->trace_id = batch[i]->trace_id;
+  }
 
-  request->data[0]->SetUserData(frame);
-  if (!infer_server_->Request(session_, std::move(request), frame)) {
-    LOG(ERROR) << "[EasyDK Samples] [SampleAsyncInference] Process(): Request infer_server do inference failed";
+  if (!infer_server_->Request(session_, std::move(request), std::move(batch))) {
+    LOG(ERROR) << "[EasyDK Samples] [SampleAsyncInference] Request(): Request infer_server do inference failed";
     return -1;
   }
   return 0;
 }
 
 int SampleAsyncInference::Close() {
+  batcher_.reset();  // sends the frames left
   if (infer_server_ && session_) {
     infer_server::RemovePreprocHandler(infer_server_->GetModel(session_)->GetKey());
     infer_server::RemovePostprocHandler(infer_server_->GetModel(session_)->GetKey());
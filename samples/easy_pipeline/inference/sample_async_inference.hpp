@@ -28,15 +28,20 @@
 #include "cnis/infer_server.h"
 
 #include "easy_module.hpp"
+#include "frame_batcher.hpp"
 
 
+// With batch_timeout_ms > 0, frames of all streams are grouped into packages of the model batch size, waiting at
+// most batch_timeout_ms for a package to fill up, and sent with BatchStrategy::STATIC. Otherwise every frame is a
+// request of its own, batched by the infer server with BatchStrategy::DYNAMIC.
 class SampleAsyncInference : public EasyModule {
  public:
   SampleAsyncInference(std::string name, int parallelism, int device_id, const std::string& model_path,
-                       std::string model_name) : EasyModule(name, parallelism) {
+                       std::string model_name, uint32_t batch_timeout_ms = 0) : EasyModule(name, parallelism) {
     model_path_ = model_path;
     device_id_ = device_id;
     model_name_ = model_name;
+    batch_timeout_ms_ = batch_timeout_ms;
   }
 
   ~SampleAsyncInference() = default;
@@ -47,6 +52,9 @@ class SampleAsyncInference : public EasyModule {
 
   int Close() override;
 
+ private:
+  int Request(FrameBatcher::Batch batch);
+
  private:
   std::string model_path_;
   int device_id_;
@@ -56,6 +64,8 @@ class SampleAsyncInference : public EasyModule {
   infer_server::CnPreprocTensorParams params_;
   std::unique_ptr<infer_server::InferServer> infer_server_;
   infer_server::Session_t session_;
+  uint32_t batch_timeout_ms_ = 0;
+  std::unique_ptr<FrameBatcher> batcher_;
 };
 
 #endif
@@ -88,6 +88,7 @@ int SampleSyncInference::Process(std::shared_ptr<EdkFrame> frame) {
     input->data[0]->Set(std::move(tmp));
 
     input->data[0]->SetUserData(frame);
+    input->data[0]->trace_id = frame->trace_id;
 
     infer_server::PackagePtr output = std::make_shared<infer_server::Package>();
     infer_server::Status status;
@@ -21,6 +21,7 @@
 #include "cnosd.h"
 
 #include <algorithm>
+#include <cmath>
 #include <string>
 #include <vector>
 
@@ -116,6 +117,55 @@ static vector<string> LoadLabels(const string& filename) {
   return labels;
 }
 
+// Rasterizes the printable ascii characters once, each glyph is a full cell of the line
+static void* CreateFont(int font_face, float scale, int thickness) {
+  cv::Size cell = cv::getTextSize("Ag", font_face, scale, thickness, nullptr);
+  int ascent = cell.height;
+  int line_height = static_cast<int>(std::ceil(cell.height * 1.4));
+  vector<Mat> bitmaps;
+  vector<CnedkOsdGlyph> glyphs;
+  for (char c = ' '; c <= '~'; ++c) {
+    string text(1, c);
+    cv::Size size = cv::getTextSize(text, font_face, scale, thickness, nullptr);
+    Mat bitmap = Mat::zeros(line_height, std::max(size.width, 1), CV_8UC1);
+#if OPENCV_MAJOR_VERSION > 2
+    cv::putText(bitmap, text, Point(0, ascent), font_face, scale, Scalar(255), thickness, cv::LINE_AA, false);
+#else
+    cv::putText(bitmap, text, Point(0, ascent), font_face, scale, Scalar(255), thickness, CV_AA, false);
+#endif
+    CnedkOsdGlyph glyph;
+    memset(&glyph, 0, sizeof(glyph));
+    glyph.code = c;
+    glyph.w = bitmap.cols;
+    glyph.h = bitmap.rows;
+    glyph.bearing_y = ascent;
+    glyph.advance = size.width;
+    glyph.alpha = bitmap.data;
+    glyph.pitch = bitmap.step;
+    glyphs.push_back(glyph);
+    bitmaps.push_back(bitmap);
+  }
+
+  CnedkOsdFontCreateParams params;
+  memset(&params, 0, sizeof(params));
+  params.glyphs = glyphs.data();
+  params.num_glyphs = glyphs.size();
+  params.ascent = ascent;
+  params.line_height = line_height;
+  void* font = nullptr;
+  if (CnedkOsdFontCreate(&font, &params) < 0) {
+    LOG(ERROR) << "[EasyDK Samples] [cnosd] CreateFont(): Create font failed, scale = " << scale;
+    return nullptr;
+  }
+  return font;
+}
+
+// Scalar is in BGR order
+static uint32_t ToRgb(const Scalar& color) {
+  return (static_cast<uint32_t>(color[2]) << 16) | (static_cast<uint32_t>(color[1]) << 8) |
+         static_cast<uint32_t>(color[0]);
+}
+
 CnOsd::CnOsd(const vector<string>& labels) : labels_(labels) {
   colors_ = ::GenerateColors(labels_.size());
 }
@@ -129,7 +179,30 @@ void CnOsd::LoadLabels(const std::string& fname) {
   colors_ = ::GenerateColors(labels_.size());
 }
 
-void CnOsd::set_font(int font) { font_ = font; }
+CnOsd::~CnOsd() {
+  for (auto& it : fonts_) {
+    if (it.second) CnedkOsdFontDestroy(it.second);
+  }
+}
+
+void CnOsd::set_font(int font) {
+  std::lock_guard<std::mutex> lk(fonts_mutex_);
+  font_ = font;
+  for (auto& it : fonts_) {
+    if (it.second) CnedkOsdFontDestroy(it.second);
+  }
+  fonts_.clear();
+}
+
+void* CnOsd::GetFont(float scale) {
+  std::lock_guard<std::mutex> lk(fonts_mutex_);
+  int key = static_cast<int>(std::round(scale * 100));
+  auto it = fonts_.find(key);
+  if (it != fonts_.end()) return it->second;
+  void* font = CreateFont(font_, key / 100.f, 1);
+  fonts_[key] = font;
+  return font;
+}
 
 void CnOsd::DrawId(Mat image, string text) const {
   float scale = CalScale(image.cols * image.rows);
@@ -215,3 +288,66 @@ void CnOsd::DrawLabel(Mat image, const vector<DetectObject>& objects) const {
                 text_thickness, 8, false);
   }
 }
+
+int CnOsd::DrawLabel(CnedkBufSurface* surf, const vector<DetectObject>& objects) {
+  int cols = surf->surface_list[0].width;
+  int rows = surf->surface_list[0].height;
+  if (rows * cols == 0) {
+    return 0;
+  }
+  void* font = GetFont(CalScale(cols * rows));
+  if (!font) return -1;
+
+  int box_thickness = get_box_thickness();
+  vector<CnedkOsdRectParams> boxes;
+  vector<CnedkOsdTextParams> label_params;
+  vector<string> texts;
+  texts.reserve(objects.size());
+  for (auto& object : objects) {
+    float xmin = object.bbox.x * cols;
+    float ymin = object.bbox.y * rows;
+    float xmax = (object.bbox.x + object.bbox.w) * cols;
+    float ymax = (object.bbox.y + object.bbox.h) * rows;
+
+    string text;
+    Scalar color;
+    if (labels().size() <= static_cast<size_t>(object.label)) {
+      text = "Label not found, id = " + to_string(object.label);
+      color = Scalar(0, 0, 0);
+    } else {
+      text = labels()[object.label];
+      color = colors_[object.label];
+    }
+    text += " " + FloatToString(object.score);
+    texts.push_back(text);
+
+    CnedkOsdRectParams box;
+    box.x = xmin;
+    box.y = ymin;
+    box.w = xmax - xmin;
+    box.h = ymax - ymin;
+    box.color = ToRgb(color);
+    box.line_width = box_thickness;
+    boxes.push_back(box);
+
+    int text_w = 0, text_h = 0;
+    CnedkOsdGetTextSize(font, texts.back().c_str(), &text_w, &text_h);
+    int offset = (box_thickness == 1 ? 0 : -(box_thickness + 1) / 2);
+    CnedkOsdTextParams label;
+    memset(&label, 0, sizeof(label));
+    label.x = xmin + offset;
+    label.y = ymax + offset;
+    if (label.y + text_h > rows) label.y -= text_h;
+    if (label.x + text_w > cols) label.x = cols - text_w;
+    label.text = texts.back().c_str();
+    label.color = ToRgb(Scalar(255, 255, 255) - color);
+    label.draw_bg = true;
+    label.bg_color = ToRgb(color);
+    label_params.push_back(label);
+  }
+
+  if (boxes.empty()) return 0;
+  // labels are drawn on cpu, before the boxes which may be drawn by hardware
+  if (CnedkDrawText(surf, font, label_params.data(), label_params.size()) < 0) return -1;
+  return CnedkDrawRect(surf, boxes.data(), boxes.size());
+}
@@ -27,12 +27,16 @@
 
 #include <cstring>
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "cnis/infer_server.h"
 #include "cnis/processor.h"
 
+#include "cnedk_osd.h"
+
 #include "edk_frame.hpp"
 
 using cv::Mat;
@@ -56,6 +60,9 @@ class CnOsd {
   int font_ = cv::FONT_HERSHEY_SIMPLEX;
   cv::Size bm_size_ = {1920, 1080};  // benchmark size,used to calculate scale.
   float bm_rate_ = 1.0f;             // benchmark rate, used to calculate scale.
+  std::map<int, void*> fonts_;       // glyph atlases, key is the scale in percent
+  std::mutex fonts_mutex_;
+  void* GetFont(float scale);
   inline float CalScale(uint64_t area) const {
     float c = 0.3f;
     float a = (c - bm_rate_) / std::pow(bm_size_.width * bm_size_.height, 2);
@@ -72,12 +79,18 @@ class CnOsd {
 
   explicit CnOsd(const std::string& label_fname);
 
+  ~CnOsd();
+  CnOsd(const CnOsd&) = delete;
+  CnOsd& operator=(const CnOsd&) = delete;
+
   void LoadLabels(const std::string& fname);
   inline const std::vector<std::string> labels() const { return labels_; }
 
   void DrawId(Mat image, string text) const;
   void DrawFps(Mat image, float fps) const;
   void DrawLabel(Mat image, const vector<DetectObject>& objects) const;
+  // Draws in place on a NV12/NV21 surface accessible by cpu, labels are composed from a glyph atlas
+  int DrawLabel(CnedkBufSurface* surf, const vector<DetectObject>& objects);
 
   void set_font(int font);
 
@@ -22,8 +22,6 @@
 
 #include "sample_osd.hpp"
 
-#include "libyuv.h"
-
 
 SampleOsd::~SampleOsd() {
 }
@@ -47,43 +45,14 @@ int SampleOsd::Process(std::shared_ptr<EdkFrame> frame) {
   if (!frame->is_eos) {
     cnedk::BufSurfWrapperPtr surf = frame->surf;
     CnedkBufSurfaceSyncForCpu(surf->GetBufSurface(), -1, -1);
-    uint8_t* y_plane = static_cast<uint8_t*>(surf->GetHostData(0));
-    uint8_t* uv_plane = static_cast<uint8_t*>(surf->GetHostData(1));
-
-    int width = surf->GetWidth();
-    int height = surf->GetHeight();
-    if (width <= 0 || height <= 1) {
-      LOG(ERROR) << "[EasyDK Sample] [Osd] Invalid width or height, width = " << width << ", height = " << height;
+    // device memory is copied to host here, the touched rows are copied back by the OSD functions
+    if (!surf->GetHostData(0)) {
+      LOG(ERROR) << "[EasyDK Sample] [Osd] Get host data failed";
       return -1;
     }
-    height = height & (~static_cast<int>(1));
-
-    int y_stride = surf->GetStride(0);
-    int uv_stride = surf->GetStride(1);
-    cv::Mat bgr(height, width, CV_8UC3);
-    uint8_t* dst_bgr24 = bgr.data;
-    int dst_stride = width * 3;
-
-    CnedkBufSurfaceColorFormat fmt = surf->GetColorFormat();
-    // kYvuH709Constants make it to BGR
-    if (fmt == CNEDK_BUF_COLOR_FORMAT_NV21)
-      libyuv::NV21ToRGB24Matrix(y_plane, y_stride, uv_plane, uv_stride, dst_bgr24, dst_stride,
-                                &libyuv::kYvuH709Constants, width, height);
-    else
-      libyuv::NV12ToRGB24Matrix(y_plane, y_stride, uv_plane, uv_stride, dst_bgr24, dst_stride,
-                               &libyuv::kYvuH709Constants, width, height);
-
-
-    osd_ctx_[frame->stream_id]->DrawLabel(bgr, frame->objs);
-
-    if (fmt == CNEDK_BUF_COLOR_FORMAT_NV21) {
-      libyuv::RGB24ToNV21(bgr.data, width * 3, y_plane, y_stride, uv_plane, uv_stride, width, height);
-    } else if (fmt == CNEDK_BUF_COLOR_FORMAT_NV12) {
-      libyuv::RGB24ToNV12(bgr.data, width * 3, y_plane, y_stride, uv_plane, uv_stride, width, height);
-    } else {
-      LOG(ERROR) << "[EasyDK Sample] [Osd] fmt not supported yet.";
+    if (osd_ctx_[frame->stream_id]->DrawLabel(surf->GetBufSurface(), frame->objs) < 0) {
+      LOG(ERROR) << "[EasyDK Sample] [Osd] Draw label failed";
     }
-    frame->surf->SyncHostToDevice();
   }
 
   Transmit(frame);
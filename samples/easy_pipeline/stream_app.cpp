@@ -26,6 +26,7 @@
 #include "gflags/gflags.h"
 
 #include "cnedk_platform.h"
+#include "cnedk_trace.h"
 
 #include "easy_module.hpp"
 #include "easy_pipeline.hpp"
@@ -47,6 +48,14 @@ DEFINE_bool(enable_vin, false, "enable_vin");  // not support vin enable
 DEFINE_bool(enable_vout, false, "enable_vout");  // not support vout enable
 DEFINE_int32(codec_id_start, 0, "vdec/venc first id, for CE3226 only");
 DEFINE_int32(frame_rate, 0, "framerate for stream");
+DEFINE_int32(decode_mode, 0, "0: decode all frames, 1: reference frames only, 2: key frames only");
+DEFINE_int32(output_interval, 0, "output one of every N decoded frames, 0 or 1 outputs all");
+DEFINE_int32(queue_capacity, 0, "max frames queued on each link, 0 means unbounded");
+DEFINE_int32(overflow_policy, 0, "0: block upstream, 1: drop oldest, 2: drop newest, 3: keyframe preserving");
+DEFINE_int32(batch_timeout_ms, 0, "max wait to batch frames of all streams before inference, 0 disables");
+DEFINE_int32(num_workers, 0, "threads shared by the modules, 0 means one per hardware thread");
+DEFINE_string(trace_path, "", "write per-frame latency spans to this file in chrome trace format, empty disables");
+DEFINE_int32(trace_sample_interval, 1, "trace one of every N frames");
 
 std::shared_ptr<EasyPipeline> g_easy_pipe;
 
@@ -70,6 +79,14 @@ int main(int argc, char** argv) {
   CHECK(FLAGS_codec_id_start >= 0) "[EasyDK Samples] [Detection] codec start id should be >= 0";
   CHECK(FLAGS_input_number >= 1) "[EasyDK Samples] [Detection] input number should be >= ";
   CHECK(FLAGS_frame_rate >= 1) "[EasyDK Samples] [Detection] input number should be >= ";
+  CHECK(FLAGS_decode_mode >= 0 && FLAGS_decode_mode <= 2)
+      << "[EasyDK Samples] [Detection] decode mode should be in [0, 2]";
+  CHECK(FLAGS_output_interval >= 0) << "[EasyDK Samples] [Detection] output interval should be >= 0";
+  CHECK(FLAGS_batch_timeout_ms >= 0) << "[EasyDK Samples] [Detection] batch timeout should be >= 0";
+  CHECK(FLAGS_queue_capacity >= 0) << "[EasyDK Samples] [Detection] queue capacity should be >= 0";
+  CHECK(FLAGS_overflow_policy >= 0 && FLAGS_overflow_policy <= 3)
+      << "[EasyDK Samples] [Detection] overflow policy should be in [0, 3]";
+  CHECK(FLAGS_trace_sample_interval >= 1) << "[EasyDK Samples] [Detection] trace sample interval should be >= 1";
 
   CnedkSensorParams sensor_params[4];
   memset(sensor_params, 0, sizeof(CnedkSensorParams) * 4);
@@ -106,12 +123,13 @@ int main(int argc, char** argv) {
     return -1;
   }
 
-  g_easy_pipe = std::make_shared<EasyPipeline>();
+  g_easy_pipe = std::make_shared<EasyPipeline>(FLAGS_num_workers);
 
   int ret = 0;
   for (int i = 0; i < FLAGS_input_number; ++i) {
     std::shared_ptr<EasyModule> source =
-        std::make_shared<SampleDecode>("source", 0, FLAGS_device_id, FLAGS_data_path, i, FLAGS_frame_rate);
+        std::make_shared<SampleDecode>("source", 0, FLAGS_device_id, FLAGS_data_path, i, FLAGS_frame_rate,
+                                       static_cast<CnedkVdecMode>(FLAGS_decode_mode), FLAGS_output_interval);
     ret |= g_easy_pipe->AddSource(source);
   }
 
@@ -121,7 +139,8 @@ int main(int argc, char** argv) {
   }
 
   std::shared_ptr<EasyModule> infer =
-      std::make_shared<SampleAsyncInference>("infer", 1, FLAGS_device_id, FLAGS_model_path, FLAGS_model_name);
+      std::make_shared<SampleAsyncInference>("infer", 1, FLAGS_device_id, FLAGS_model_path, FLAGS_model_name,
+                                             FLAGS_batch_timeout_ms);
   // std::shared_ptr<EasyModule> infer =
   //     std::make_shared<SampleSyncInference>("infer", 8, FLAGS_device_id, FLAGS_model_path, FLAGS_model_name);
 
@@ -137,20 +156,44 @@ int main(int argc, char** argv) {
     return -1;
   }
 
-  g_easy_pipe->AddLink("source", "infer");
-  g_easy_pipe->AddLink("infer", "osd");
-  g_easy_pipe->AddLink("osd", "encode");
+  LinkConfig link_config;
+  link_config.capacity = FLAGS_queue_capacity;
+  link_config.policy = static_cast<OverflowPolicy>(FLAGS_overflow_policy);
+  g_easy_pipe->AddLink("source", "infer", link_config);
+  g_easy_pipe->AddLink("infer", "osd", link_config);
+  g_easy_pipe->AddLink("osd", "encode", link_config);
 
   signal(SIGINT, HandleSignal);
 
+  if (!FLAGS_trace_path.empty()) {
+    CnedkTraceParams trace_params;
+    memset(&trace_params, 0, sizeof(trace_params));
+    trace_params.sample_interval = FLAGS_trace_sample_interval;
+    if (CnedkTraceStart(&trace_params) < 0) {
+      LOG(ERROR) << "[EasyDK Samples] Start tracing failed";
+      return -1;
+    }
+  }
+
   // auto start = std::chrono::high_resolution_clock::now();
   ret = g_easy_pipe->Start();
   if (ret == 0) {
     g_easy_pipe->WaitForStop();
+    for (const auto& link : g_easy_pipe->GetLinkStats()) {
+      LOG(INFO) << "[EasyDK Samples] Link " << link.name << ": pushed " << link.stats.pushed << ", dropped "
+                << link.stats.dropped << ", max depth " << link.stats.max_depth << ", avg latency "
+                << link.stats.avg_latency_ms << " ms, max latency " << link.stats.max_latency_ms << " ms";
+    }
   } else {
     LOG(ERROR) << "[EasyDK Samples] Start pipe failed";
   }
   g_easy_pipe->Stop();
+  if (!FLAGS_trace_path.empty()) {
+    CnedkTraceStop();
+    if (CnedkTraceExport(FLAGS_trace_path.c_str()) < 0) {
+      LOG(ERROR) << "[EasyDK Samples] Export trace to " << FLAGS_trace_path << " failed";
+    }
+  }
   infer.reset();
   g_easy_pipe.reset();
   g_easy_pipe = nullptr;
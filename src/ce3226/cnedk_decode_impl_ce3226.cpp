@@ -31,6 +31,7 @@ namespace cnedk {
 // IDecoder
 int DecoderCe3226::Create(CnedkVdecCreateParams *params) {
   create_params_ = *params;
+  outputs_.Init(create_params_);
   cnEnPayloadType_t type;
   switch (create_params_.type) {
     case CNEDK_VDEC_TYPE_H264:
@@ -90,6 +91,10 @@ int DecoderCe3226::SendStream(const CnedkVdecStream *stream, int timeout_ms) {
     return 0;
   }
 
+  if (!outputs_.Accept(stream)) {
+    VLOG(5) << "[EasyDK] [DecoderCe3226] SendStream(): Packet is dropped in the decode mode, pts: " << stream->pts;
+    return 0;
+  }
   cnvdecStream input_data;
   memset(&input_data, 0, sizeof(input_data));
   input_data.u32Len = stream->len;
@@ -98,7 +103,11 @@ int DecoderCe3226::SendStream(const CnedkVdecStream *stream, int timeout_ms) {
   input_data.bDisplay = CN_TRUE;
   input_data.bEndOfFrame = CN_TRUE;
   input_data.bEndOfStream = CN_FALSE;
-  if (MpsService::Instance().VDecSendStream(vdec_, &input_data, timeout_ms) < 0) {
+  int ret = MpsService::Instance().VDecSendStream(vdec_, &input_data, timeout_ms);
+  if (ret == -2) {
+    // the decoder input buffer is full, let the caller decide whether to retry
+    return -2;
+  } else if (ret < 0) {
     LOG(ERROR) << "[EasyDK] [DecoderCe3226] SendStream(): Sent packet failed";
     return -1;
   }
@@ -107,6 +116,11 @@ int DecoderCe3226::SendStream(const CnedkVdecStream *stream, int timeout_ms) {
 
 // IVDecResult
 void DecoderCe3226::OnFrame(void *handle, const cnVideoFrameInfo_t *info) {
+  if (outputs_.Skip()) {
+    MpsService::Instance().VDecReleaseFrame(handle, info);
+    return;
+  }
+
   // FIXME
   cnVideoFrameInfo_t *rectify_info = const_cast<cnVideoFrameInfo_t *>(info);
   rectify_info->stVFrame.u32Width += rectify_info->stVFrame.u32Width & 1;
@@ -138,7 +152,7 @@ void DecoderCe3226::OnFrame(void *handle, const cnVideoFrameInfo_t *info) {
   MpsService::Instance().VDecReleaseFrame(handle, info);
 
   surf->pts = rectify_info->stVFrame.u64PTS;
-  create_params_.OnFrame(surf, create_params_.userdata);
+  outputs_.Deliver(surf);
   return;
 }
 
@@ -43,6 +43,7 @@ class DecoderCe3226 : public IDecoder, public IVDecResult {
 
  private:
   CnedkVdecCreateParams create_params_;
+  FrameOutputs outputs_;
   void *vdec_ = nullptr;
 };
 
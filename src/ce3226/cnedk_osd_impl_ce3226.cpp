@@ -83,4 +83,35 @@ int DrawBitmapCe3226(CnedkBufSurface *surf, CnedkOsdBitmapParams *params, uint32
   return MpsService::Instance().OsdPutText(&info, texts);
 }
 
+int DrawBatchCe3226(CnedkOsdBatchItem *items, uint32_t num) {
+  std::vector<OsdFrameTask> tasks(num);
+  for (uint32_t i = 0; i < num; i++) {
+    CnedkOsdBatchItem &item = items[i];
+    OsdFrameTask &task = tasks[i];
+    if (item.batch_idx >= item.surf->batch_size) {
+      LOG(ERROR) << "[EasyDK] DrawBatchCe3226(): batch index " << item.batch_idx << " is out of range";
+      return -1;
+    }
+    if (BufSurfaceToVideoFrameInfo(item.surf, &task.info, item.batch_idx) < 0) {
+      LOG(ERROR) << "[EasyDK] DrawBatchCe3226(): Convert BufSurface to VideoFrameInfo failed";
+      return -1;
+    }
+    for (uint32_t j = 0; j < item.num_rects; j++) {
+      CnedkOsdRectParams &param = item.rects[j];
+      task.bboxes.push_back(std::make_tuple(Bbox(param.x, param.y, param.w, param.h), param.line_width, param.color));
+    }
+    for (uint32_t j = 0; j < item.num_fill_rects; j++) {
+      CnedkOsdRectParams &param = item.fill_rects[j];
+      task.fill_bboxes.push_back(std::make_pair(Bbox(param.x, param.y, param.w, param.h), param.color));
+    }
+    for (uint32_t j = 0; j < item.num_bitmaps; j++) {
+      CnedkOsdBitmapParams &param = item.bitmaps[j];
+      task.texts.push_back(std::make_tuple(Bbox(param.x, param.y, param.w, param.h), param.bitmap_argb1555,
+                                           param.bg_color, param.pitch));
+    }
+  }
+
+  return MpsService::Instance().OsdDrawBatch(tasks);
+}
+
 }  // namespace cnedk
@@ -30,6 +30,7 @@ namespace cnedk {
 int DrawRectCe3226(CnedkBufSurface *surf, CnedkOsdRectParams *params, uint32_t num);
 int FillRectCe3226(CnedkBufSurface *surf, CnedkOsdRectParams *params, uint32_t num);
 int DrawBitmapCe3226(CnedkBufSurface *surf, CnedkOsdBitmapParams *params, uint32_t num);
+int DrawBatchCe3226(CnedkOsdBatchItem *items, uint32_t num);
 
 }  // namespace cnedk
 
@@ -69,6 +69,17 @@ int TransformerCe3226::Transform(CnedkBufSurface *src, CnedkBufSurface *dst, Cne
   return CncvTransform(src, dst, transform_params);
 }
 
+// VGU has no batched roi interface, always use CNCV
+int TransformerCe3226::TransformRoi(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformRoiParams *roi_params) {
+  if (src->mem_type == CNEDK_BUF_MEM_SYSTEM || src->mem_type == CNEDK_BUF_MEM_PINNED ||
+      dst->mem_type == CNEDK_BUF_MEM_SYSTEM || dst->mem_type == CNEDK_BUF_MEM_PINNED) {
+    LOG(ERROR) << "[EasyDK] [TransformerCe3226] TransformRoi(): The src and dst mem_type is invalid. "
+               << "src mem_type: " << src->mem_type << ", dst_mem_type: " << dst->mem_type;
+    return -1;
+  }
+  return CncvTransformRoi(src, dst, roi_params);
+}
+
 int TransformerCe3226::TransformHw(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) {
   CnedkBufSurface *dst_tmp = dst;
   CnedkBufSurface transform_dst;
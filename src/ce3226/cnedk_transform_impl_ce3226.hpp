@@ -39,6 +39,7 @@ class TransformerCe3226 : public ITransformer {
   }
   ~TransformerCe3226() = default;
   int Transform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) override;
+  int TransformRoi(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformRoiParams *roi_params) override;
 
  private:
   int TransformHw(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params);
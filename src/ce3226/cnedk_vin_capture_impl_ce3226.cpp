@@ -20,6 +20,8 @@
 
 #include "cnedk_vin_capture_impl_ce3226.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>  // for memset
 
 #include "glog/logging.h"
@@ -27,6 +29,33 @@
 
 namespace cnedk {
 
+// the timestamps of the sensors are assumed to be close, give up if they never match
+static constexpr int kMaxSyncRounds = 8;
+
+// hardcode at the moment, NV12
+static int CopyFrame(const cnVideoFrameInfo_t &input, CnedkBufSurface *surf, int index) {
+  cnVideoFrameInfo_t output;
+  if (BufSurfaceToVideoFrameInfo(surf, &output, index) < 0) {
+    LOG(ERROR) << "[EasyDK] CopyFrame(): Convert BufSurface to VideoFrameInfo failed";
+    return -1;
+  }
+  cnrtRet_t ret = cnrtMemcpy2D(reinterpret_cast<void *>(output.stVFrame.u64PhyAddr[0]), output.stVFrame.u32Stride[0],
+                               reinterpret_cast<void *>(input.stVFrame.u64PhyAddr[0]), input.stVFrame.u32Stride[0],
+                               output.stVFrame.u32Width, output.stVFrame.u32Height, cnrtMemcpyDevToDev);
+  if (ret != cnrtSuccess) {
+    LOG(ERROR) << "[EasyDK] CopyFrame(): Copy luma plane failed, ret = " << ret;
+    return -1;
+  }
+  ret = cnrtMemcpy2D(reinterpret_cast<void *>(output.stVFrame.u64PhyAddr[1]), output.stVFrame.u32Stride[1],
+                     reinterpret_cast<void *>(input.stVFrame.u64PhyAddr[1]), input.stVFrame.u32Stride[1],
+                     output.stVFrame.u32Width, output.stVFrame.u32Height / 2, cnrtMemcpyDevToDev);
+  if (ret != cnrtSuccess) {
+    LOG(ERROR) << "[EasyDK] CopyFrame(): Copy chroma plane failed, ret = " << ret;
+    return -1;
+  }
+  return 0;
+}
+
 int VinCaptureCe3226::Create(CnedkVinCaptureCreateParams *params) {
   create_params_ = *params;
   return 0;
@@ -50,24 +79,120 @@ int VinCaptureCe3226::Capture(int timeout_ms) {
     return -1;
   }
 
-  cnVideoFrameInfo_t output;
-  if (BufSurfaceToVideoFrameInfo(surf, &output) < 0) {
-    LOG(ERROR) << "[EasyDK] [VinCaptureCe3226] Capture(): Convert BufSurface to VideoFrameInfo failed";
+  // MpsService::Instance().VguScaleCsc(&input, &output);
+  if (CopyFrame(input, surf, 0) < 0) {
+    LOG(ERROR) << "[EasyDK] [VinCaptureCe3226] Capture(): Copy frame failed";
+    MpsService::Instance().VinCaptureFrameRelease(create_params_.sensor_id, &input);
+    CnedkBufSurfaceDestroy(surf);
+    create_params_.OnError(-1, create_params_.userdata);
     return -1;
   }
-  // MpsService::Instance().VguScaleCsc(&input, &output);
-
-  // hardcode at the moment, NV12
-  cnrtMemcpy2D(reinterpret_cast<void *>(output.stVFrame.u64PhyAddr[0]), output.stVFrame.u32Stride[0],
-               reinterpret_cast<void *>(input.stVFrame.u64PhyAddr[0]), input.stVFrame.u32Stride[0],
-               output.stVFrame.u32Width, output.stVFrame.u32Height, cnrtMemcpyDevToDev);
-  cnrtMemcpy2D(reinterpret_cast<void *>(output.stVFrame.u64PhyAddr[1]), output.stVFrame.u32Stride[1],
-               reinterpret_cast<void *>(input.stVFrame.u64PhyAddr[1]), input.stVFrame.u32Stride[1],
-               output.stVFrame.u32Width, output.stVFrame.u32Height / 2, cnrtMemcpyDevToDev);
 
   MpsService::Instance().VinCaptureFrameRelease(create_params_.sensor_id, &input);
   create_params_.OnFrame(surf, create_params_.userdata);
   return 0;
 }
 
+int VinCaptureGroupCe3226::Create(CnedkVinCaptureGroupCreateParams *params) {
+  create_params_ = *params;
+  if (!create_params_.sync_threshold_us) create_params_.sync_threshold_us = 10000;
+  sensor_ids_.assign(params->sensor_ids, params->sensor_ids + params->num_sensors);
+  create_params_.sensor_ids = sensor_ids_.data();
+  frames_.resize(sensor_ids_.size());
+  captured_.assign(sensor_ids_.size(), false);
+  return 0;
+}
+
+int VinCaptureGroupCe3226::Destroy() {
+  ReleaseSet();
+  return 0;
+}
+
+void VinCaptureGroupCe3226::ReleaseSet() {
+  for (size_t i = 0; i < sensor_ids_.size(); ++i) {
+    if (captured_[i]) {
+      MpsService::Instance().VinCaptureFrameRelease(sensor_ids_[i], &frames_[i]);
+      captured_[i] = false;
+    }
+  }
+}
+
+int VinCaptureGroupCe3226::CaptureSet(int timeout_ms) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  auto remaining_ms = [&]() -> int {
+    if (timeout_ms < 0) return -1;
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    return std::max(0, static_cast<int>(left.count()));
+  };
+  // The sensors are read one after another, frames wait in their channels meanwhile, so the set is gathered in about
+  // one frame interval no matter how many sensors there are.
+  for (int round = 0; round < kMaxSyncRounds; ++round) {
+    for (size_t i = 0; i < sensor_ids_.size(); ++i) {
+      if (captured_[i]) continue;
+      if (MpsService::Instance().VinCaptureFrame(sensor_ids_[i], &frames_[i], remaining_ms()) < 0) {
+        LOG(ERROR) << "[EasyDK] [VinCaptureGroupCe3226] CaptureSet(): Capture frame failed, sensor id = "
+                   << sensor_ids_[i];
+        return -1;
+      }
+      captured_[i] = true;
+    }
+    uint64_t latest = 0;
+    for (auto &frame : frames_) latest = std::max<uint64_t>(latest, frame.stVFrame.u64PTS);
+    bool synced = true;
+    for (size_t i = 0; i < sensor_ids_.size(); ++i) {
+      if (latest - frames_[i].stVFrame.u64PTS > create_params_.sync_threshold_us) {
+        // too old to pair with the others, try the next frame of the sensor
+        MpsService::Instance().VinCaptureFrameRelease(sensor_ids_[i], &frames_[i]);
+        captured_[i] = false;
+        synced = false;
+      }
+    }
+    if (synced) return 0;
+    if (timeout_ms >= 0 && std::chrono::steady_clock::now() >= deadline) break;
+  }
+  LOG(ERROR) << "[EasyDK] [VinCaptureGroupCe3226] CaptureSet(): Frames are not synchronized";
+  return -1;
+}
+
+int VinCaptureGroupCe3226::Capture(int timeout_ms) {
+  if (CaptureSet(timeout_ms) < 0) {
+    ReleaseSet();
+    create_params_.OnError(-1, create_params_.userdata);
+    return -1;
+  }
+
+  CnedkBufSurface *surf = nullptr;
+  if (create_params_.GetBufSurf(&surf, create_params_.surf_timeout_ms, create_params_.userdata) < 0) {
+    LOG(ERROR) << "[EasyDK] [VinCaptureGroupCe3226] Capture(): Get BufSurface failed";
+    ReleaseSet();
+    create_params_.OnError(-2, create_params_.userdata);
+    return -1;
+  }
+  if (surf->batch_size < sensor_ids_.size()) {
+    LOG(ERROR) << "[EasyDK] [VinCaptureGroupCe3226] Capture(): The batch size of BufSurface is smaller than "
+               << "the number of sensors: " << surf->batch_size << " v.s. " << sensor_ids_.size();
+    ReleaseSet();
+    CnedkBufSurfaceDestroy(surf);
+    create_params_.OnError(-2, create_params_.userdata);
+    return -1;
+  }
+
+  uint64_t latest = 0;
+  for (size_t i = 0; i < sensor_ids_.size(); ++i) {
+    if (CopyFrame(frames_[i], surf, i) < 0) {
+      LOG(ERROR) << "[EasyDK] [VinCaptureGroupCe3226] Capture(): Copy frame failed, sensor id = " << sensor_ids_[i];
+      ReleaseSet();
+      CnedkBufSurfaceDestroy(surf);
+      create_params_.OnError(-1, create_params_.userdata);
+      return -1;
+    }
+    latest = std::max<uint64_t>(latest, frames_[i].stVFrame.u64PTS);
+  }
+  ReleaseSet();
+  surf->num_filled = sensor_ids_.size();
+  surf->pts = latest;
+  create_params_.OnFrames(surf, create_params_.userdata);
+  return 0;
+}
+
 }  // namespace cnedk
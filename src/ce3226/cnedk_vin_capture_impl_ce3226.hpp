@@ -21,6 +21,8 @@
 #ifndef CNEDK_VIN_CAPTURE_IMPL_CE3226_HPP_
 #define CNEDK_VIN_CAPTURE_IMPL_CE3226_HPP_
 
+#include <vector>
+
 #include "../cnedk_vin_capture_impl.hpp"
 #include "ce3226_helper.hpp"
 #include "mps_service/mps_service.hpp"
@@ -40,6 +42,27 @@ class VinCaptureCe3226 : public IVinCapture {
   CnedkVinCaptureCreateParams create_params_;
 };
 
+class VinCaptureGroupCe3226 : public IVinCaptureGroup {
+ public:
+  VinCaptureGroupCe3226() = default;
+  ~VinCaptureGroupCe3226() = default;
+
+  int Create(CnedkVinCaptureGroupCreateParams *params) override;
+  int Destroy() override;
+  int Capture(int timeout_ms) override;
+
+ private:
+  // Captures frames until the timestamps of all sensors are within the sync threshold
+  int CaptureSet(int timeout_ms);
+  void ReleaseSet();
+
+ private:
+  CnedkVinCaptureGroupCreateParams create_params_;
+  std::vector<int> sensor_ids_;
+  std::vector<cnVideoFrameInfo_t> frames_;
+  std::vector<bool> captured_;
+};
+
 }  // namespace cnedk
 
 #endif  // CNEDK_VIN_CAPTURE_IMPL_CE3226_HPP_
@@ -141,6 +141,14 @@ struct VencCreateParam {
   uint32_t bitrate;  // kbps
 };
 
+// OSD primitives of one frame, see MpsService::OsdDrawBatch()
+struct OsdFrameTask {
+  cnVideoFrameInfo_t info;
+  std::vector<std::tuple<Bbox, cnU32_t, cnU32_t>> bboxes;  // bbox, line width, color
+  std::vector<std::pair<Bbox, cnU32_t>> fill_bboxes;       // bbox, color
+  std::vector<std::tuple<Bbox, void *, cnU32_t, cnU32_t>> texts;  // bbox, argb1555, bg color, pitch
+};
+
 class MpsServiceImpl;
 class MpsService {
  public:
@@ -183,6 +191,8 @@ class MpsService {
   int OsdDrawBboxes(const cnVideoFrameInfo_t *info, const std::vector<std::tuple<Bbox, cnU32_t, cnU32_t>> &bboxes);
   int OsdFillBboxes(const cnVideoFrameInfo_t *info, const std::vector<std::pair<Bbox, cnU32_t>> &bboxes);
   int OsdPutText(const cnVideoFrameInfo_t *info, const std::vector<std::tuple<Bbox, void *, cnU32_t, cnU32_t>> &texts);
+  // draws on many frames at once, boxes are waited by g2d once and the others are done in one vgu job after them
+  int OsdDrawBatch(const std::vector<OsdFrameTask> &tasks);
 
  private:
   MpsService();
@@ -192,10 +192,18 @@ int MpsService::VguScaleCsc(const cnVideoFrameInfo_t *src, cnVideoFrameInfo_t *d
   }
   return ret;
 }
+namespace {
 
-// static std::mutex g2d_mutex;
-int MpsService::OsdDrawBboxes(const cnVideoFrameInfo_t *info,
-                              const std::vector<std::tuple<Bbox, cnU32_t, cnU32_t>> &bboxes) {
+constexpr uint32_t kMaxOsdNum = 32;
+
+bool IsNv12OrNv21(const cnVideoFrameInfo_t *info) {
+  return info->stVFrame.enPixelFormat == PIXEL_FORMAT_YUV420_8BIT_SEMI_UV ||
+         info->stVFrame.enPixelFormat == PIXEL_FORMAT_YUV420_8BIT_SEMI_VU;
+}
+
+// Submits the bboxes to g2d, the caller should wait for the commands by cng2dWaitAllDone() if block is false
+int SubmitBboxes(const cnVideoFrameInfo_t *info, const std::vector<std::tuple<Bbox, cnU32_t, cnU32_t>> &bboxes,
+                 bool block) {
   cnS32_t cn_ret = CN_SUCCESS;
 
   cng2dSurface_s dst_surface;
@@ -208,7 +216,7 @@ int MpsService::OsdDrawBboxes(const cnVideoFrameInfo_t *info,
       dst_surface.enColorFmt = CN_G2D_COLOR_FMT_NV21;
       break;
     default:
-      LOG(ERROR) << "[EasyDK] [MpsService] OsdDrawBboxes(): Unsupported pixel format, only NV12/nv21 is supported";
+      LOG(ERROR) << "[EasyDK] [MpsService] SubmitBboxes(): Unsupported pixel format, only NV12/nv21 is supported";
       return -1;
   }
   dst_surface.u32Height = info->stVFrame.u32Height;
@@ -259,70 +267,69 @@ int MpsService::OsdDrawBboxes(const cnVideoFrameInfo_t *info,
     }
   }
 
-  constexpr uint32_t kMaxOsdNum = 32;
   cng2dRect_s rect[kMaxOsdNum];
 
   for (auto &it : rects_map) {
     auto color = it.first;
     uint32_t num = 0;
+    size_t left = it.second.size();
     for (auto &v : it.second) {
-      if (num < kMaxOsdNum) rect[num++] = v;
-      if (num == kMaxOsdNum) {
-        // std::unique_lock<std::mutex> guard(g2d_mutex);
-        cn_ret = cng2dDrawRect(&dst_surface, rect, num, line_width, color);
-        if (cn_ret != CN_SUCCESS) {
-          LOG(ERROR) << "[EasyDK] [MpsService] OsdDrawBboxes(): cng2dDrawRect failed, ret = " << cn_ret;
-          return -1;
-        }
-        // Return until all commands submitted this time finish or timeout if boolBlock is CN_TRUE
-        // Return immediately if boolBlock is CN_FALSE
-        cn_ret = cng2dSubmit(0, CN_TRUE, 1000);
-        if (cn_ret != CN_SUCCESS) {
-          LOG(ERROR) << "[EasyDK] [MpsService] OsdDrawBboxes(): cng2dSubmit failed, ret = " << cn_ret;
-          return -1;
-        }
-
-        num = 0;
-      }
-    }
-
-    if (num > 0) {
+      rect[num++] = v;
+      --left;
+      if (num < kMaxOsdNum && left > 0) continue;
       // std::unique_lock<std::mutex> guard(g2d_mutex);
       cn_ret = cng2dDrawRect(&dst_surface, rect, num, line_width, color);
       if (cn_ret != CN_SUCCESS) {
-        LOG(ERROR) << "[EasyDK] [MpsService] OsdDrawBboxes(): cng2dDrawRect failed, ret = " << cn_ret;
+        LOG(ERROR) << "[EasyDK] [MpsService] SubmitBboxes(): cng2dDrawRect failed, ret = " << cn_ret;
         return -1;
       }
       // Return until all commands submitted this time finish or timeout if boolBlock is CN_TRUE
       // Return immediately if boolBlock is CN_FALSE
-      cn_ret = cng2dSubmit(0, CN_TRUE, 1000);
+      cn_ret = cng2dSubmit(0, block ? CN_TRUE : CN_FALSE, 1000);
       if (cn_ret != CN_SUCCESS) {
-        LOG(ERROR) << "[EasyDK] [MpsService] OsdDrawBboxes(): cng2dSubmit failed, ret = " << cn_ret;
+        LOG(ERROR) << "[EasyDK] [MpsService] SubmitBboxes(): cng2dSubmit failed, ret = " << cn_ret;
         return -1;
       }
+      num = 0;
     }
   }
+  return 0;
+}
 
-#if 1
-  // Return until all commands finish
-  cn_ret = cng2dWaitAllDone();
+int AddVguTask(vguHandle_t vgu_handle, const cnVideoFrameInfo_t *info, vguDrawLineArrayAttr_t *attrs) {
+  vguTaskAttr_t vgu_osd_task;
+  memset(&vgu_osd_task, 0, sizeof(vgu_osd_task));
+  memcpy(&vgu_osd_task.stImgIn, info, sizeof(cnVideoFrameInfo_t));
+  memcpy(&vgu_osd_task.stImgOut, info, sizeof(cnVideoFrameInfo_t));
+  cnS32_t cn_ret = cnvguAddDrawLineTaskArray(vgu_handle, &vgu_osd_task, attrs);
   if (cn_ret != CN_SUCCESS) {
-    LOG(ERROR) << "[EasyDK] [MpsService] OsdDrawBboxes(): cng2dWaitAllDone failed, ret = " << cn_ret;
+    LOG(ERROR) << "[EasyDK] [MpsService] AddVguTask(): cnvguAddDrawLineTaskArray failed, ret = " << cn_ret;
     return -1;
   }
-#endif
   return 0;
 }
 
-int MpsService::OsdFillBboxes(const cnVideoFrameInfo_t *info, const std::vector<std::pair<Bbox, cnU32_t>> &bboxes) {
-  cnS32_t cn_ret = CN_SUCCESS;
-  if (info->stVFrame.enPixelFormat != PIXEL_FORMAT_YUV420_8BIT_SEMI_UV ||
-      info->stVFrame.enPixelFormat != PIXEL_FORMAT_YUV420_8BIT_SEMI_VU) {
-    LOG(ERROR) << "[EasyDK] [MpsService] OsdFillBboxes(): Unsupported pixel format, only NV12/NV21 is supported";
+int AddVguTask(vguHandle_t vgu_handle, const cnVideoFrameInfo_t *info, vguOsdAttr_t *attrs, cnU32_t num) {
+  vguTaskAttr_t vgu_osd_task;
+  memset(&vgu_osd_task, 0, sizeof(vgu_osd_task));
+  memcpy(&vgu_osd_task.stImgIn, info, sizeof(cnVideoFrameInfo_t));
+  memcpy(&vgu_osd_task.stImgOut, info, sizeof(cnVideoFrameInfo_t));
+  cnS32_t cn_ret = cnvguAddOsdTaskArray(vgu_handle, &vgu_osd_task, attrs, num);
+  if (cn_ret != CN_SUCCESS) {
+    LOG(ERROR) << "[EasyDK] [MpsService] AddVguTask(): cnvguAddOsdTaskArray failed, ret = " << cn_ret;
+    return -1;
+  }
+  return 0;
+}
+
+// Adds the filled bboxes to an opened vgu job, kMaxOsdNum bboxes per task
+int AddFillTasks(vguHandle_t vgu_handle, const cnVideoFrameInfo_t *info,
+                 const std::vector<std::pair<Bbox, cnU32_t>> &bboxes) {
+  if (!IsNv12OrNv21(info)) {
+    LOG(ERROR) << "[EasyDK] [MpsService] AddFillTasks(): Unsupported pixel format, only NV12/NV21 is supported";
     return -1;
   }
 
-  constexpr uint32_t kMaxOsdNum = 32;
   vguDrawLineArrayAttr_t vgu_draw_line_attrs;
   memset(&vgu_draw_line_attrs, 0, sizeof(vguDrawLineArrayAttr_t));
 
@@ -344,81 +351,33 @@ int MpsService::OsdFillBboxes(const cnVideoFrameInfo_t *info, const std::vector<
       continue;
     }
 
-    if (vgu_draw_line_attrs.u32Num < kMaxOsdNum) {
-      vgu_draw_line_attrs.astRect[vgu_draw_line_attrs.u32Num].s32X = x1;
-      vgu_draw_line_attrs.astRect[vgu_draw_line_attrs.u32Num].s32Y = y1;
-      vgu_draw_line_attrs.astRect[vgu_draw_line_attrs.u32Num].u32Width = w;
-      vgu_draw_line_attrs.astRect[vgu_draw_line_attrs.u32Num].u32Height = h;
-      vgu_draw_line_attrs.u32Color[vgu_draw_line_attrs.u32Num] = points.second;
-      vgu_draw_line_attrs.u32Num++;
-    }
+    vgu_draw_line_attrs.astRect[vgu_draw_line_attrs.u32Num].s32X = x1;
+    vgu_draw_line_attrs.astRect[vgu_draw_line_attrs.u32Num].s32Y = y1;
+    vgu_draw_line_attrs.astRect[vgu_draw_line_attrs.u32Num].u32Width = w;
+    vgu_draw_line_attrs.astRect[vgu_draw_line_attrs.u32Num].u32Height = h;
+    vgu_draw_line_attrs.u32Color[vgu_draw_line_attrs.u32Num] = points.second;
+    vgu_draw_line_attrs.u32Num++;
 
     if (vgu_draw_line_attrs.u32Num == kMaxOsdNum) {
-      vguHandle_t vgu_handle;
-      vguTaskAttr_t vgu_osd_task;
-      memset(&vgu_osd_task, 0, sizeof(vgu_osd_task));
-      memcpy(&vgu_osd_task.stImgIn, info, sizeof(cnVideoFrameInfo_t));
-      memcpy(&vgu_osd_task.stImgOut, info, sizeof(cnVideoFrameInfo_t));
-
-      cn_ret = cnvguBeginJob(&vgu_handle);
-      if (cn_ret != CN_SUCCESS) {
-        LOG(ERROR) << "[EasyDK] [MpsService] OsdFillBboxes(): cnvguBeginJob failed, ret = " << cn_ret;
-        return -1;
-      }
-
-      cn_ret = cnvguAddDrawLineTaskArray(vgu_handle, &vgu_osd_task, &vgu_draw_line_attrs);
-      if (cn_ret != CN_SUCCESS) {
-        LOG(ERROR) << "[EasyDK] [MpsService] OsdFillBboxes(): cnvguAddDrawLineTaskArray failed, ret = " << cn_ret;
-        return -1;
-      }
-
-      cn_ret = cnvguEndJob(vgu_handle);
-      if (cn_ret != CN_SUCCESS) {
-        LOG(ERROR) << "[EasyDK] [MpsService] OsdFillBboxes(): cnvguEndJob failed, ret = " << cn_ret;
-        return -1;
-      }
+      if (AddVguTask(vgu_handle, info, &vgu_draw_line_attrs) < 0) return -1;
       vgu_draw_line_attrs.u32Num = 0;
     }
   }
 
   if (vgu_draw_line_attrs.u32Num > 0) {
-    vguHandle_t vgu_handle;
-    vguTaskAttr_t vgu_osd_task;
-    memset(&vgu_osd_task, 0, sizeof(vgu_osd_task));
-    memcpy(&vgu_osd_task.stImgIn, info, sizeof(cnVideoFrameInfo_t));
-    memcpy(&vgu_osd_task.stImgOut, info, sizeof(cnVideoFrameInfo_t));
-
-    cn_ret = cnvguBeginJob(&vgu_handle);
-    if (cn_ret != CN_SUCCESS) {
-      LOG(ERROR) << "[EasyDK] [MpsService] OsdFillBboxes(): cnvguBeginJob failed, ret = " << cn_ret;
-      return -1;
-    }
-
-    cn_ret = cnvguAddDrawLineTaskArray(vgu_handle, &vgu_osd_task, &vgu_draw_line_attrs);
-    if (cn_ret != CN_SUCCESS) {
-      LOG(ERROR) << "[EasyDK] [MpsService] OsdFillBboxes(): cnvguAddDrawLineTaskArray failed, ret = " << cn_ret;
-      return -1;
-    }
-
-    cn_ret = cnvguEndJob(vgu_handle);
-    if (cn_ret != CN_SUCCESS) {
-      LOG(ERROR) << "[EasyDK] [MpsService] OsdFillBboxes(): cnvguEndJob failed, ret = " << cn_ret;
-      return -1;
-    }
+    if (AddVguTask(vgu_handle, info, &vgu_draw_line_attrs) < 0) return -1;
   }
   return 0;
 }
 
-int MpsService::OsdPutText(const cnVideoFrameInfo_t *info,
-                           const std::vector<std::tuple<Bbox, void *, cnU32_t, cnU32_t>> &texts) {
-  if (info->stVFrame.enPixelFormat != PIXEL_FORMAT_YUV420_8BIT_SEMI_UV ||
-      info->stVFrame.enPixelFormat != PIXEL_FORMAT_YUV420_8BIT_SEMI_VU) {
-    LOG(ERROR) << "[EasyDK] [MpsService] OsdPutText(): Unsupported pixel format, only NV12/NV21 is supported";
+// Adds the texts to an opened vgu job, kMaxOsdNum texts per task
+int AddTextTasks(vguHandle_t vgu_handle, const cnVideoFrameInfo_t *info,
+                 const std::vector<std::tuple<Bbox, void *, cnU32_t, cnU32_t>> &texts) {
+  if (!IsNv12OrNv21(info)) {
+    LOG(ERROR) << "[EasyDK] [MpsService] AddTextTasks(): Unsupported pixel format, only NV12/NV21 is supported";
     return -1;
   }
 
-  cnS32_t cn_ret = CN_SUCCESS;
-  constexpr uint32_t kMaxOsdNum = 32;
   vguOsdAttr_t vgu_osd_attrs[kMaxOsdNum];
 
   Bbox dst_rect;
@@ -440,7 +399,7 @@ int MpsService::OsdPutText(const cnVideoFrameInfo_t *info,
     h -= h & 1;
     while (y1 + h >= info->stVFrame.u32Height) h -= 2;
     if (w == 0 || h == 0) {
-      LOG(WARNING) << "[EasyDK] [MpsService] OsdPutText(): rect is null";
+      LOG(WARNING) << "[EasyDK] [MpsService] AddTextTasks(): rect is null";
       continue;
     }
 
@@ -450,70 +409,113 @@ int MpsService::OsdPutText(const cnVideoFrameInfo_t *info,
     st_dst_rect.u32Width = w;
     st_dst_rect.u32Height = h;
 
-    if (idx < kMaxOsdNum) {
-      vguOsdAttr_t *st_osd_attr = &vgu_osd_attrs[idx++];
-      memset(st_osd_attr, 0, sizeof(vguOsdAttr_t));
-      st_osd_attr->enPixelFmt = PIXEL_FORMAT_ARGB1555_PACKED;
-      st_osd_attr->u32BgColor = bg_color;
-      st_osd_attr->u32FgAlpha = 128;
-      st_osd_attr->u32BgAlpha = 0;
-      st_osd_attr->u64PhyAddr = reinterpret_cast<cnU64_t>(argb1555);
-      st_osd_attr->u32Stride = pitch;
-      st_osd_attr->stRect = st_dst_rect;
-    }
+    vguOsdAttr_t *st_osd_attr = &vgu_osd_attrs[idx++];
+    memset(st_osd_attr, 0, sizeof(vguOsdAttr_t));
+    st_osd_attr->enPixelFmt = PIXEL_FORMAT_ARGB1555_PACKED;
+    st_osd_attr->u32BgColor = bg_color;
+    st_osd_attr->u32FgAlpha = 128;
+    st_osd_attr->u32BgAlpha = 0;
+    st_osd_attr->u64PhyAddr = reinterpret_cast<cnU64_t>(argb1555);
+    st_osd_attr->u32Stride = pitch;
+    st_osd_attr->stRect = st_dst_rect;
 
     if (idx == kMaxOsdNum) {
-      vguHandle_t vgu_handle;
-      vguTaskAttr_t vgu_osd_task;
-      memset(&vgu_osd_task, 0, sizeof(vgu_osd_task));
-      memcpy(&vgu_osd_task.stImgIn, info, sizeof(cnVideoFrameInfo_t));
-      memcpy(&vgu_osd_task.stImgOut, info, sizeof(cnVideoFrameInfo_t));
-
-      cn_ret = cnvguBeginJob(&vgu_handle);
-      if (cn_ret != CN_SUCCESS) {
-        LOG(ERROR) << "[EasyDK] [MpsService] OsdPutText(): cnvguBeginJob failed, ret = " << cn_ret;
-        return -1;
-      }
-      cn_ret = cnvguAddOsdTaskArray(vgu_handle, &vgu_osd_task, vgu_osd_attrs, idx);
-      if (cn_ret != CN_SUCCESS) {
-        LOG(ERROR) << "[EasyDK] [MpsService] OsdPutText(): cnvguEncnvguAddOsdTaskArraydJob failed, ret = " << cn_ret;
-        return -1;
-      }
-      cn_ret = cnvguEndJob(vgu_handle);
-      if (cn_ret != CN_SUCCESS) {
-        LOG(ERROR) << "[EasyDK] [MpsService] OsdPutText(): cnvguEndJob failed, ret = " << cn_ret;
-        return -1;
-      }
+      if (AddVguTask(vgu_handle, info, vgu_osd_attrs, idx) < 0) return -1;
       idx = 0;
     }
   }
 
   if (idx > 0) {
-    vguHandle_t vgu_handle;
-    vguTaskAttr_t vgu_osd_task;
-    memset(&vgu_osd_task, 0, sizeof(vgu_osd_task));
-    memcpy(&vgu_osd_task.stImgIn, info, sizeof(cnVideoFrameInfo_t));
-    memcpy(&vgu_osd_task.stImgOut, info, sizeof(cnVideoFrameInfo_t));
+    if (AddVguTask(vgu_handle, info, vgu_osd_attrs, idx) < 0) return -1;
+  }
+  return 0;
+}
 
-    cn_ret = cnvguBeginJob(&vgu_handle);
-    if (cn_ret != CN_SUCCESS) {
-      LOG(ERROR) << "[EasyDK] [MpsService] OsdPutText(): cnvguBeginJob failed, ret = " << cn_ret;
-      return -1;
-    }
-    cn_ret = cnvguAddOsdTaskArray(vgu_handle, &vgu_osd_task, vgu_osd_attrs, idx);
-    if (cn_ret != CN_SUCCESS) {
-      LOG(ERROR) << "[EasyDK] [MpsService] OsdPutText(): cnvguAddOsdTaskArray failed, ret = " << cn_ret;
-      cnvguEndJob(vgu_handle);
-      return -1;
+// Runs func(vgu_handle) in a vgu job, the job is canceled if func fails
+template <typename Func>
+int RunVguJob(const char *caller, Func func) {
+  vguHandle_t vgu_handle;
+  cnS32_t cn_ret = cnvguBeginJob(&vgu_handle);
+  if (cn_ret != CN_SUCCESS) {
+    LOG(ERROR) << "[EasyDK] [MpsService] " << caller << "(): cnvguBeginJob failed, ret = " << cn_ret;
+    return -1;
+  }
+  if (func(vgu_handle) < 0) {
+    cnvguCancelJob(vgu_handle);
+    return -1;
+  }
+  cn_ret = cnvguEndJob(vgu_handle);
+  if (cn_ret != CN_SUCCESS) {
+    cnvguCancelJob(vgu_handle);
+    LOG(ERROR) << "[EasyDK] [MpsService] " << caller << "(): cnvguEndJob failed, ret = " << cn_ret;
+    return -1;
+  }
+  return 0;
+}
+
+}  // namespace
+
+// static std::mutex g2d_mutex;
+int MpsService::OsdDrawBboxes(const cnVideoFrameInfo_t *info,
+                              const std::vector<std::tuple<Bbox, cnU32_t, cnU32_t>> &bboxes) {
+  if (SubmitBboxes(info, bboxes, true) < 0) return -1;
+#if 1
+  // Return until all commands finish
+  cnS32_t cn_ret = cng2dWaitAllDone();
+  if (cn_ret != CN_SUCCESS) {
+    LOG(ERROR) << "[EasyDK] [MpsService] OsdDrawBboxes(): cng2dWaitAllDone failed, ret = " << cn_ret;
+    return -1;
+  }
+#endif
+  return 0;
+}
+
+int MpsService::OsdFillBboxes(const cnVideoFrameInfo_t *info, const std::vector<std::pair<Bbox, cnU32_t>> &bboxes) {
+  if (bboxes.empty()) return 0;
+  return RunVguJob("OsdFillBboxes", [&](vguHandle_t vgu_handle) { return AddFillTasks(vgu_handle, info, bboxes); });
+}
+
+int MpsService::OsdPutText(const cnVideoFrameInfo_t *info,
+                           const std::vector<std::tuple<Bbox, void *, cnU32_t, cnU32_t>> &texts) {
+  if (texts.empty()) return 0;
+  return RunVguJob("OsdPutText", [&](vguHandle_t vgu_handle) { return AddTextTasks(vgu_handle, info, texts); });
+}
+
+int MpsService::OsdDrawBatch(const std::vector<OsdFrameTask> &tasks) {
+  // boxes of all frames are queued to g2d and waited once
+  bool g2d_submitted = false;
+  int ret = 0;
+  for (auto &task : tasks) {
+    if (task.bboxes.empty()) continue;
+    // some commands may have been submitted even if it fails
+    g2d_submitted = true;
+    if (SubmitBboxes(&task.info, task.bboxes, false) < 0) {
+      ret = -1;
+      break;
     }
-    cn_ret = cnvguEndJob(vgu_handle);
+  }
+  // g2d and vgu write the same frames, so the vgu job starts after the boxes are drawn. It is the same order as calling
+  // OsdDrawBboxes(), OsdFillBboxes() and OsdPutText() in turn.
+  if (g2d_submitted) {
+    cnS32_t cn_ret = cng2dWaitAllDone();
     if (cn_ret != CN_SUCCESS) {
-      LOG(ERROR) << "[EasyDK] [MpsService] OsdPutText(): cnvguEndJob failed, ret = " << cn_ret;
+      LOG(ERROR) << "[EasyDK] [MpsService] OsdDrawBatch(): cng2dWaitAllDone failed, ret = " << cn_ret;
       return -1;
     }
   }
-
-  return 0;
+  if (ret < 0) return -1;
+
+  // filled boxes and texts of all frames are done by one vgu job
+  bool vgu_needed = false;
+  for (auto &task : tasks) vgu_needed |= !task.fill_bboxes.empty() || !task.texts.empty();
+  if (!vgu_needed) return 0;
+  return RunVguJob("OsdDrawBatch", [&](vguHandle_t vgu_handle) {
+    for (auto &task : tasks) {
+      if (!task.fill_bboxes.empty() && AddFillTasks(vgu_handle, &task.info, task.fill_bboxes) < 0) return -1;
+      if (!task.texts.empty() && AddTextTasks(vgu_handle, &task.info, task.texts) < 0) return -1;
+    }
+    return 0;
+  });
 }
 
 }  // namespace cnedk
@@ -66,6 +66,11 @@ int MpsServiceImpl::Init(const MpsServiceConfig &config) {
     LOG(ERROR) << "[EasyDK] [MpsServiceImpl] Init(): Init Vin failed";
     goto err_exit;
   }
+
+  if (reactor_.Start() != 0) {
+    LOG(ERROR) << "[EasyDK] [MpsServiceImpl] Init(): Start fd reactor failed";
+    goto err_exit;
+  }
   return 0;
 
 err_exit:
@@ -74,6 +79,7 @@ err_exit:
 }
 
 void MpsServiceImpl::Destroy() {
+  reactor_.Stop();
   mps_vin_->Destroy();
   mps_vout_->Destroy();
   cnsampleCommSysExit();
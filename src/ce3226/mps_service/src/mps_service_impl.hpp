@@ -35,8 +35,8 @@ class MpsServiceImpl : private NonCopyable, public IVBInfo {
   MpsServiceImpl() {
     mps_vout_.reset(new MpsVout(this));
     mps_vin_.reset(new MpsVin(this));
-    mps_vdec_.reset(new MpsVdec(this));
-    mps_venc_.reset(new MpsVenc(this));
+    mps_vdec_.reset(new MpsVdec(this, &reactor_));
+    mps_venc_.reset(new MpsVenc(this, &reactor_));
   }
   ~MpsServiceImpl() { Destroy(); }
 
@@ -133,6 +133,8 @@ class MpsServiceImpl : private NonCopyable, public IVBInfo {
  private:
   MpsServiceConfig mps_config_;
   std::map<cnU64_t, int> pool_cfgs_;
+  // reaps outputs of all decoder and encoder channels, must outlive them
+  FdReactor reactor_;
   std::unique_ptr<MpsVout> mps_vout_ = nullptr;
   std::unique_ptr<MpsVin> mps_vin_ = nullptr;
   std::unique_ptr<MpsVdec> mps_vdec_ = nullptr;
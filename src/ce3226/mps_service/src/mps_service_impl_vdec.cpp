@@ -17,11 +17,7 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  *************************************************************************/
-// for select
-#include <sys/time.h>
-#include <sys/types.h>
-#include <unistd.h>
-
+#include <chrono>
 #include <mutex>
 
 #include "glog/logging.h"
@@ -150,8 +146,15 @@ void *MpsVdec::Create(IVDecResult *result, cnEnPayloadType_t type, int max_width
 
   ctx.fd_ = cnvdecGetFd(ctx.vdec_chn_);
   ctx.eos_sent_ = false;
+  ctx.eos_reported_ = false;
   ctx.error_flag_ = false;
   ctx.created_ = true;
+  if (reactor_->Add(ctx.fd_, [this, id] { OnReadable(reinterpret_cast<void *>(id)); }) != 0) {
+    LOG(ERROR) << "[EasyDK] [MpsVdec] Create(): Watch decoder fd failed";
+    ctx.created_ = false;
+    cnvdecStopRecvStream(ctx.vdec_chn_);
+    goto err_exit;
+  }
   VLOG(2) << "[EasyDK] [MpsVdec] Create(): Done";
   return reinterpret_cast<void *>(id);
 
@@ -178,6 +181,8 @@ int MpsVdec::Destroy(void *handle) {
   if (!ctx.error_flag_ && !ctx.eos_sent_) {
     SendStream(handle, nullptr, 0);
   }
+  // after this no frame callback is running or will run for the channel
+  reactor_->Remove(ctx.fd_);
 
   int codec_ret = cnvdecStopRecvStream(ctx.vdec_chn_);
   if (CN_SUCCESS != codec_ret) {
@@ -191,6 +196,7 @@ int MpsVdec::Destroy(void *handle) {
   ctx.vdec_chn_ = -1;
   ctx.fd_ = -1;
   ctx.eos_sent_ = false;
+  ctx.eos_reported_ = false;
   ctx.error_flag_ = false;
   ctx.created_ = false;
   ReturnId(id);
@@ -211,14 +217,60 @@ int MpsVdec::CheckHandleEos(void *handle) {
     return -1;
   }
   if (0 == stStatus.u32LeftPics && stStatus.u32LeftStreamFrames == 0) {
-    if (ctx.result_) {
+    if (!ctx.eos_reported_ && ctx.result_) {
       ctx.result_->OnEos();
     }
+    ctx.eos_reported_ = true;
     return 0;
   }
   return 1;
 }
 
+void MpsVdec::OnReadable(void *handle) {
+  int64_t id = reinterpret_cast<int64_t>(handle);
+  VDecCtx &ctx = vdec_ctx_[id - 1];
+  std::unique_lock<std::mutex> lk(ctx.mutex_);
+  if (!ctx.error_flag_ && !ctx.eos_reported_) {
+    cnVideoFrameInfo_t frame_info;
+    memset(&frame_info, 0, sizeof(frame_info));
+    int ret = cnvdecGetFrame(ctx.vdec_chn_, &frame_info, 0);
+    if (ret == CN_SUCCESS) {
+      if (ctx.result_) {
+        ctx.result_->OnFrame(handle, &frame_info);
+      } else {
+        cnvdecReleaseFrame(ctx.vdec_chn_, &frame_info);
+      }
+      if (ctx.eos_sent_) {
+        CheckHandleEos(handle);
+      }
+    } else {
+      ctx.error_flag_ = true;
+      LOG(ERROR) << "[EasyDK] [MpsVdec] OnReadable(): cnvdecGetFrame failed, ret = " << ret;
+      if (ctx.result_) {
+        ctx.result_->OnError(ret);
+      }
+    }
+  }
+  if (ctx.error_flag_ || ctx.eos_reported_) {
+    // nothing more will be reaped, stop watching the fd instead of spinning on it
+    reactor_->Remove(ctx.fd_);
+    ctx.eos_cond_.notify_all();
+  }
+}
+
+int MpsVdec::WaitEos(void *handle) {
+  int64_t id = reinterpret_cast<int64_t>(handle);
+  VDecCtx &ctx = vdec_ctx_[id - 1];
+  std::unique_lock<std::mutex> lk(ctx.mutex_);
+  // The last frame may have been reaped before EOS is sent, then the fd never wakes the reactor up again.
+  // So the status is also polled here.
+  while (!ctx.error_flag_ && !ctx.eos_reported_) {
+    if (CheckHandleEos(handle) <= 0) break;
+    ctx.eos_cond_.wait_for(lk, std::chrono::milliseconds(10));
+  }
+  return ctx.error_flag_ ? -1 : 0;
+}
+
 int MpsVdec::ReleaseFrame(void *handle, const cnVideoFrameInfo_t *info) {
   int64_t id = reinterpret_cast<int64_t>(handle);
   if (id <= 0 || id > kMaxMpsVdecNum) {
@@ -238,160 +290,68 @@ int MpsVdec::SendStream(void *handle, const cnvdecStream_t *pst_stream, cnS32_t
   }
 
   VDecCtx &ctx = vdec_ctx_[id - 1];
+  if (!ctx.created_) {
+    LOG(ERROR) << "[EasyDK] [MpsVdec] SendStream(): Handle is not created";
+    return -1;
+  }
   cnvdecStream_t input_data;
-  bool send_done = false;
   memset(&input_data, 0, sizeof(input_data));
   if (nullptr == pst_stream) {
     VLOG(2) << "[EasyDK] [MpsVdec] SendStream(): Send EOS";
-    if (ctx.eos_sent_) send_done = true;
-    ctx.eos_sent_ = true;
-    input_data.u32Len = 0;
-    input_data.u64PTS = 0;
-    input_data.bDisplay = CN_FALSE;
-    input_data.bEndOfFrame = CN_TRUE;
-    input_data.bEndOfStream = CN_TRUE;
-  } else {
-    if (ctx.eos_sent_) {
-      LOG(ERROR) << "[EasyDK] [MpsVdec] SendStream(): EOS has been sent, process packet failed, pts:"
-                 << pst_stream->u64PTS;
-      return -1;
-    }
-    if (ctx.error_flag_) {
-      LOG(ERROR) << "[EasyDK] [MpsVdec] SendStream(): Error occurred in decoder, process packet failed, pts:"
-                 << pst_stream->u64PTS;
-      return -1;
-    }
-    input_data = *pst_stream;
-    input_data.bDisplay = CN_TRUE;
-    input_data.bEndOfFrame = CN_TRUE;
-    input_data.bEndOfStream = CN_FALSE;
-  }
-
-  int count = 4;  // FIXME
-  while (!ctx.error_flag_) {
-    // try SendStream
-    if (!send_done) {
-      // JPEG dec didn't handle null packet
-      if (ctx.eos_sent_ && (PT_JPEG == ctx.chn_attr_.enType)) {
-        send_done = true;
-        continue;
+    // JPEG dec didn't handle null packet
+    if (!ctx.eos_sent_.exchange(true) && !ctx.error_flag_ && PT_JPEG != ctx.chn_attr_.enType) {
+      input_data.u32Len = 0;
+      input_data.u64PTS = 0;
+      input_data.bDisplay = CN_FALSE;
+      input_data.bEndOfFrame = CN_TRUE;
+      input_data.bEndOfStream = CN_TRUE;
+      int ret = CN_ERR_VDEC_BUF_FULL;
+      // the reactor keeps reaping frames meanwhile, the buffer is full only if frames are not released in time
+      for (int count = 0; count < 5 && ret == CN_ERR_VDEC_BUF_FULL; ++count) {
+        ret = cnvdecSendStream(ctx.vdec_chn_, &input_data, 1000);
       }
-      int ret = cnvdecSendStream(ctx.vdec_chn_, &input_data, 1000);
-      if (ret == CN_SUCCESS) {
-        send_done = true;
-        continue;
-      } else if (ret != CN_ERR_VDEC_BUF_FULL) {
-        LOG(ERROR) << "[EasyDK] [MpsVdec] SendStream(): Send stream failed, ret = " << ret;
+      if (ret != CN_SUCCESS) {
+        LOG(ERROR) << "[EasyDK] [MpsVdec] SendStream(): Send EOS failed, ret = " << ret;
+        std::unique_lock<std::mutex> lk(ctx.mutex_);
         ctx.error_flag_ = true;
         if (ctx.result_) {
           ctx.result_->OnError(ret);
         }
         return -1;
       }
-
-      struct timeval timeout;
-      fd_set read_fds;
-      FD_ZERO(&read_fds);
-      FD_SET(ctx.fd_, &read_fds);
-      timeout.tv_sec = 0;
-      timeout.tv_usec = 1000;
-      int value = select(ctx.fd_ + 1, &read_fds, nullptr, nullptr, &timeout);
-      if (value > 0 && FD_ISSET(ctx.fd_, &read_fds)) {
-        // get picture and process it
-        cnVideoFrameInfo_t frame_info;
-        memset(&frame_info, 0, sizeof(frame_info));
-        int ret = cnvdecGetFrame(ctx.vdec_chn_, &frame_info, 0);
-        if (ret == CN_SUCCESS) {
-          if (ctx.result_) {
-            ctx.result_->OnFrame(handle, &frame_info);
-          } else {
-            cnvdecReleaseFrame(ctx.vdec_chn_, &frame_info);
-          }
-        } else {
-          ctx.error_flag_ = true;
-          LOG(ERROR) << "[EasyDK] [MpsVdec] SendFrame(): cnvdecGetFrame failed, ret = " << ret;
-          if (ctx.result_) {
-            ctx.result_->OnError(ret);
-          }
-          return -1;
-        }
-      }
-      if (--count < 0) {
-        ctx.error_flag_ = true;
-        if (ctx.result_) {
-          ctx.result_->OnError(CN_ERROR_UNKNOWN);
-        }
-        LOG(ERROR) << "[EasyDK] [MpsVdec] SendStream(): Send stream timeout";
-        return -1;
-      }
     }
+    return WaitEos(handle);
+  }
 
-    // try getFrame:
-    //  1. polling
-    //  2. get picture and handle it
-    while (1) {
-      struct timeval timeout;
-      fd_set read_fds;
-      FD_ZERO(&read_fds);
-      FD_SET(ctx.fd_, &read_fds);
-      timeout.tv_sec = 0;
-      timeout.tv_usec = 1000;
-      int value = select(ctx.fd_ + 1, &read_fds, nullptr, nullptr, &timeout);
-      if (value < 0) {
-        LOG(ERROR) << "[EasyDK] [MpsVdec] SendStream(): select failed";
-        return -1;
-      }
-      if (value == 0) {
-        if (ctx.eos_sent_ && send_done) {
-          int value = CheckHandleEos(handle);
-          if (value < 0) {
-            return -1;
-          } else if (value == 0) {
-            return 0;
-          }
-          // going on ..
-          continue;
-        }
-        break;
-      }
-      if (!FD_ISSET(ctx.fd_, &read_fds)) {
-        LOG(ERROR) << "[EasyDK] [MpsVdec] SendStream(): FD_ISSET unexpected";
-        return -1;
-      }
-
-      // get picture and process it
-      cnVideoFrameInfo_t frame_info;
-      memset(&frame_info, 0, sizeof(frame_info));
-      int ret = cnvdecGetFrame(ctx.vdec_chn_, &frame_info, 0);
-      if (ret == CN_SUCCESS) {
-        if (ctx.result_) {
-          ctx.result_->OnFrame(handle, &frame_info);
-        } else {
-          cnvdecReleaseFrame(ctx.vdec_chn_, &frame_info);
-        }
-        if (ctx.eos_sent_ && send_done) {
-          int value = CheckHandleEos(handle);
-          if (value < 0) {
-            LOG(ERROR) << "[EasyDK] [MpsVdec] SendStream(): CheckHandleEos failed, ret = " << value;
-            return -1;
-          } else if (value == 0) {
-            return 0;
-          }
-          // going on ...
-        }
-      } else {
-        ctx.error_flag_ = true;
-        LOG(ERROR) << "[EasyDK] [MpsVdec] SendStream(): cnvdecGetFrame failed, ret = " << ret;
-        if (ctx.result_) {
-          ctx.result_->OnError(ret);
-        }
-        return -1;
-      }
-    }
+  if (ctx.eos_sent_) {
+    LOG(ERROR) << "[EasyDK] [MpsVdec] SendStream(): EOS has been sent, process packet failed, pts:"
+               << pst_stream->u64PTS;
+    return -1;
+  }
+  if (ctx.error_flag_) {
+    LOG(ERROR) << "[EasyDK] [MpsVdec] SendStream(): Error occurred in decoder, process packet failed, pts:"
+               << pst_stream->u64PTS;
+    return -1;
+  }
+  input_data = *pst_stream;
+  input_data.bDisplay = CN_TRUE;
+  input_data.bEndOfFrame = CN_TRUE;
+  input_data.bEndOfStream = CN_FALSE;
 
-    if (!ctx.eos_sent_ && send_done) {
-      break;
+  // Only submit here, decoded frames are delivered by the reactor handler threads
+  int ret = cnvdecSendStream(ctx.vdec_chn_, &input_data, milli_sec);
+  if (ret == CN_ERR_VDEC_BUF_FULL) {
+    // not an error, the caller may retry later
+    VLOG(5) << "[EasyDK] [MpsVdec] SendStream(): Stream buffer is full, pts:" << pst_stream->u64PTS;
+    return -2;
+  } else if (ret != CN_SUCCESS) {
+    LOG(ERROR) << "[EasyDK] [MpsVdec] SendStream(): Send stream failed, ret = " << ret;
+    std::unique_lock<std::mutex> lk(ctx.mutex_);
+    ctx.error_flag_ = true;
+    if (ctx.result_) {
+      ctx.result_->OnError(ret);
     }
+    return -1;
   }
   return 0;
 }
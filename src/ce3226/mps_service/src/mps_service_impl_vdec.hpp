@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -31,6 +32,7 @@
 #include "cn_buffer.h"
 #include "cn_vdec.h"
 
+#include "../../../common/fd_reactor.hpp"
 #include "../mps_service.hpp"
 #include "mps_internal/cnsample_comm.h"
 
@@ -40,7 +42,8 @@ constexpr int kMaxMpsVdecNum = 16;
 
 class MpsVdec : private NonCopyable {
  public:
-  explicit MpsVdec(IVBInfo *vb_info) : vb_info_(vb_info) {}
+  // decoded frames are reaped on the reactor handler threads, as soon as the channel fd becomes readable
+  MpsVdec(IVBInfo *vb_info, FdReactor *reactor) : vb_info_(vb_info), reactor_(reactor) {}
   ~MpsVdec() {}
 
   int Config(const MpsServiceConfig &config);
@@ -69,10 +72,14 @@ class MpsVdec : private NonCopyable {
     }
     id_q_.push(id - 1);
   }
+  // called with ctx.mutex_ held
   int CheckHandleEos(void *handle);
+  void OnReadable(void *handle);
+  int WaitEos(void *handle);
 
  private:
   IVBInfo *vb_info_ = nullptr;
+  FdReactor *reactor_ = nullptr;
   MpsServiceConfig mps_config_;
   std::mutex id_mutex_;
   std::queue<int> id_q_;
@@ -82,11 +89,13 @@ class MpsVdec : private NonCopyable {
     std::atomic<bool> eos_sent_{false};
     std::atomic<bool> error_flag_{false};
     std::atomic<bool> created_{false};
+    std::atomic<bool> eos_reported_{false};
     cnvdecChnParam_t chn_param_;
     cnvdecChnAttr_t chn_attr_;
     vdecChn_t vdec_chn_ = -1;
     int fd_ = -1;
     std::mutex mutex_;
+    std::condition_variable eos_cond_;
   } vdec_ctx_[kMaxMpsVdecNum];
 };
 
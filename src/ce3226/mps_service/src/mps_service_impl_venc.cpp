@@ -17,11 +17,7 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  *************************************************************************/
-// for select
-#include <sys/time.h>
-#include <sys/types.h>
-#include <unistd.h>
-
+#include <chrono>
 #include <mutex>
 
 #include "glog/logging.h"
@@ -208,8 +204,15 @@ void *MpsVenc::Create(IVEncResult *result, VencCreateParam *params) {
 
   ctx.fd_ = cnvencGetFd(ctx.venc_chn_);
   ctx.eos_sent_ = false;
+  ctx.eos_reported_ = false;
   ctx.error_flag_ = false;
   ctx.created_ = true;
+  if (reactor_->Add(ctx.fd_, [this, id] { OnReadable(reinterpret_cast<void *>(id)); }) != 0) {
+    LOG(ERROR) << "[EasyDK] [MpsVenc] Create(): Watch encoder fd failed";
+    ctx.created_ = false;
+    cnvencStopRecvFrame(ctx.venc_chn_);
+    goto err_exit;
+  }
   VLOG(2) << "[EasyDK] [MpsVenc] Create(): Done";
   return reinterpret_cast<void *>(id);
 
@@ -236,6 +239,8 @@ int MpsVenc::Destroy(void *handle) {
   if (!ctx.error_flag_ && !ctx.eos_sent_) {
     SendFrame(handle, nullptr, 0);
   }
+  // after this no bitstream callback is running or will run for the channel
+  reactor_->Remove(ctx.fd_);
 
   int codec_ret = cnvencStopRecvFrame(ctx.venc_chn_);
   if (CN_SUCCESS != codec_ret) {
@@ -249,6 +254,7 @@ int MpsVenc::Destroy(void *handle) {
   ctx.venc_chn_ = -1;
   ctx.fd_ = -1;
   ctx.eos_sent_ = false;
+  ctx.eos_reported_ = false;
   ctx.error_flag_ = false;
   ctx.created_ = false;
   ReturnId(id);
@@ -269,9 +275,10 @@ int MpsVenc::CheckHandleEos(void *handle) {
     return -1;
   }
   if (0 == stStatus.u32LeftPics && stStatus.u32LeftStreamFrames == 0 && stStatus.u32LeftStreamBytes == 0) {
-    if (ctx.result_) {
+    if (!ctx.eos_reported_ && ctx.result_) {
       ctx.result_->OnEos();
     }
+    ctx.eos_reported_ = true;
     return 0;
   }
   return 1;
@@ -305,108 +312,21 @@ void MpsVenc::OnFrameBits(void *handle, cnvencStream_t *pst_stream) {
   }
 }
 
-int MpsVenc::SendFrame(void *handle, const cnVideoFrameInfo_t *pst_frame, cnS32_t milli_sec) {
+void MpsVenc::OnReadable(void *handle) {
   int64_t id = reinterpret_cast<int64_t>(handle);
-  if (id <= 0 || id > kMaxMpsVecNum) {
-    LOG(ERROR) << "[EasyDK] [MpsVenc] SendFrame(): Handle is invalid";
-    return -1;
-  }
-  VLOG(5) << "[EasyDK] [MpsVenc] SendFrame(): Frame width: "<< pst_frame->stVFrame.u32Width << ", height: "
-          << pst_frame->stVFrame.u32Height << ", stride:" << pst_frame->stVFrame.u32Stride[0];
-
   VEncCtx &ctx = venc_ctx[id - 1];
-  if (!ctx.created_) {
-    LOG(INFO) << "[EasyDK] [MpsVenc] SendFrame(): Handle is not created";
-    return -1;
-  }
-
-  bool send_done = false;
-  if (nullptr == pst_frame) {
-    VLOG(2) << "[EasyDK] [MpsVenc] SendFrame(): Send EOS";
-    if (ctx.eos_sent_) send_done = true;
-    ctx.eos_sent_ = true;
-  } else {
-    if (ctx.eos_sent_) {
-      LOG(ERROR) << "[EasyDK] [MpsVenc] SendFrame(): EOS has been sent, process frameInfo failed, pts:"
-                 << pst_frame->stVFrame.u64PTS;
-      return -1;
-    }
-    if (ctx.error_flag_) {
-      LOG(ERROR) << "[EasyDK] [MpsVenc] SendFrame(): Error occurred in encoder, process frameInfo failed, pts:"
-                 << pst_frame->stVFrame.u64PTS;
-      return -1;
-    }
-  }
-
-  int count = 4;  // FIXME
-  while (!ctx.error_flag_) {
-    // try send frame_info
-    if (!send_done) {
-      if (!pst_frame) {
-        send_done = true;
-        continue;
-      }
-      int ret = cnvencSendFrame(ctx.venc_chn_, pst_frame, 1000);
-      if (ret == CN_SUCCESS) {
-        VLOG(5) << "[EasyDK] [MpsVenc] SendFrame(): cnvencSendFrame pts = " << pst_frame->stVFrame.u64PTS;
-        send_done = true;
-        continue;
-      }
-      if (--count < 0) {
-        ctx.error_flag_ = true;
-        LOG(ERROR) << "[EasyDK] [MpsVenc] SendFrame(): Send frame timeout";
-        if (ctx.result_) {
-          ctx.result_->OnError(CN_ERROR_UNKNOWN);
-        }
-        return -1;
-      }
-    }
-
-    // try get bitstream:
-    //  1. polling
-    //  2. get bitstream and handle it
-    while (1) {
-      struct timeval timeout;
-      fd_set read_fds;
-      FD_ZERO(&read_fds);
-      FD_SET(ctx.fd_, &read_fds);
-      timeout.tv_sec = 0;
-      timeout.tv_usec = 1000;
-      int value = select(ctx.fd_ + 1, &read_fds, nullptr, nullptr, &timeout);
-      if (value < 0) {
-        LOG(ERROR) << "[EasyDK] [MpsVenc] SendFrame(): select failed";
-        return -1;
-      }
-      if (value == 0) {
-        // LOGE(SOURCE) << "[" << stream_id_ << "]: " << "select timeout\n";
-        if (ctx.eos_sent_ && send_done) {
-          int value = CheckHandleEos(handle);
-          if (value < 0) {
-            return -1;
-          } else if (value == 0) {
-            return 0;
-          }
-          // going on ..
-          continue;
-        }
-        break;
-      }
-      if (!FD_ISSET(ctx.fd_, &read_fds)) {
-        LOG(ERROR) << "[EasyDK] [MpsVenc] SendFrame(): FD_ISSET unexpected";
-        return -1;
-      }
-
-      cnvencChnStatus_t stStat;
-      // get picture and process it
-      int ret = cnvencQueryStatus(ctx.venc_chn_, &stStat);
-      if (CN_SUCCESS != ret) {
-        LOG(ERROR) << "[EasyDK] [MpsVenc] SendFrame(): cnvencQueryStatus chn[" << ctx.venc_chn_ << " failed, ret = "
-                   << ret;
-        return -1;
-      }
-      if (0 == stStat.u32CurPacks) {
-        continue;
+  std::unique_lock<std::mutex> lk(ctx.mutex_);
+  if (!ctx.error_flag_ && !ctx.eos_reported_) {
+    cnvencChnStatus_t stStat;
+    int ret = cnvencQueryStatus(ctx.venc_chn_, &stStat);
+    if (CN_SUCCESS != ret) {
+      LOG(ERROR) << "[EasyDK] [MpsVenc] OnReadable(): cnvencQueryStatus chn[" << ctx.venc_chn_ << "] failed, ret = "
+                 << ret;
+      ctx.error_flag_ = true;
+      if (ctx.result_) {
+        ctx.result_->OnError(ret);
       }
+    } else if (stStat.u32CurPacks > 0) {
       cnvencStream_t stStream;
       memset(&stStream, 0, sizeof(stStream));
       bool pack_allocated_dynamically = false;
@@ -417,40 +337,91 @@ int MpsVenc::SendFrame(void *handle, const cnVideoFrameInfo_t *pst_frame, cnS32_
         pack_allocated_dynamically = true;
       }
       if (NULL == stStream.pstPacket) {
-        LOG(ERROR) << "[EasyDK] [MpsVenc] SendFrame(): Malloc stream pack failed";
-        return -1;
-      }
-      stStream.u32PacketCount = stStat.u32CurPacks;
-      ret = cnvencGetStream(ctx.venc_chn_, &stStream, 0);
-      if (ret == CN_SUCCESS) {
-        OnFrameBits(handle, &stStream);
-        cnvencReleaseStream(ctx.venc_chn_, &stStream);
-        if (pack_allocated_dynamically) free(stStream.pstPacket);
-        if (ctx.eos_sent_ && send_done) {
-          int value = CheckHandleEos(handle);
-          if (value < 0) {
-            LOG(ERROR) << "[EasyDK] [MpsVenc] SendFrame(): CheckHandleEos failed";
-            return -1;
-          } else if (value == 0) {
-            return 0;
-          }
-          // going on ...
-        }
-      } else {
-        if (pack_allocated_dynamically) free(stStream.pstPacket);
+        LOG(ERROR) << "[EasyDK] [MpsVenc] OnReadable(): Malloc stream pack failed";
         ctx.error_flag_ = true;
-        LOG(ERROR) << "[EasyDK] [MpsVenc] SendFrame(): cnvencGetStream failed, ret = " << ret;
         if (ctx.result_) {
-          ctx.result_->OnError(ret);
+          ctx.result_->OnError(CN_ERROR_UNKNOWN);
+        }
+      } else {
+        stStream.u32PacketCount = stStat.u32CurPacks;
+        ret = cnvencGetStream(ctx.venc_chn_, &stStream, 0);
+        if (ret == CN_SUCCESS) {
+          OnFrameBits(handle, &stStream);
+          cnvencReleaseStream(ctx.venc_chn_, &stStream);
+        } else {
+          ctx.error_flag_ = true;
+          LOG(ERROR) << "[EasyDK] [MpsVenc] OnReadable(): cnvencGetStream failed, ret = " << ret;
+          if (ctx.result_) {
+            ctx.result_->OnError(ret);
+          }
         }
-        return -1;
+        if (pack_allocated_dynamically) free(stStream.pstPacket);
       }
     }
-
-    if (!ctx.eos_sent_ && send_done) {
-      break;
+    if (!ctx.error_flag_ && ctx.eos_sent_) {
+      CheckHandleEos(handle);
     }
   }
+  if (ctx.error_flag_ || ctx.eos_reported_) {
+    // nothing more will be reaped, stop watching the fd instead of spinning on it
+    reactor_->Remove(ctx.fd_);
+    ctx.eos_cond_.notify_all();
+  }
+}
+
+int MpsVenc::WaitEos(void *handle) {
+  int64_t id = reinterpret_cast<int64_t>(handle);
+  VEncCtx &ctx = venc_ctx[id - 1];
+  std::unique_lock<std::mutex> lk(ctx.mutex_);
+  // The last bitstream may have been reaped before EOS is sent, then the fd never wakes the reactor up again.
+  // So the status is also polled here.
+  while (!ctx.error_flag_ && !ctx.eos_reported_) {
+    if (CheckHandleEos(handle) <= 0) break;
+    ctx.eos_cond_.wait_for(lk, std::chrono::milliseconds(10));
+  }
+  return ctx.error_flag_ ? -1 : 0;
+}
+
+int MpsVenc::SendFrame(void *handle, const cnVideoFrameInfo_t *pst_frame, cnS32_t milli_sec) {
+  int64_t id = reinterpret_cast<int64_t>(handle);
+  if (id <= 0 || id > kMaxMpsVecNum) {
+    LOG(ERROR) << "[EasyDK] [MpsVenc] SendFrame(): Handle is invalid";
+    return -1;
+  }
+
+  VEncCtx &ctx = venc_ctx[id - 1];
+  if (!ctx.created_) {
+    LOG(INFO) << "[EasyDK] [MpsVenc] SendFrame(): Handle is not created";
+    return -1;
+  }
+
+  if (nullptr == pst_frame) {
+    VLOG(2) << "[EasyDK] [MpsVenc] SendFrame(): Send EOS";
+    ctx.eos_sent_ = true;
+    return WaitEos(handle);
+  }
+
+  VLOG(5) << "[EasyDK] [MpsVenc] SendFrame(): Frame width: "<< pst_frame->stVFrame.u32Width << ", height: "
+          << pst_frame->stVFrame.u32Height << ", stride:" << pst_frame->stVFrame.u32Stride[0];
+  if (ctx.eos_sent_) {
+    LOG(ERROR) << "[EasyDK] [MpsVenc] SendFrame(): EOS has been sent, process frameInfo failed, pts:"
+               << pst_frame->stVFrame.u64PTS;
+    return -1;
+  }
+  if (ctx.error_flag_) {
+    LOG(ERROR) << "[EasyDK] [MpsVenc] SendFrame(): Error occurred in encoder, process frameInfo failed, pts:"
+               << pst_frame->stVFrame.u64PTS;
+    return -1;
+  }
+
+  // Only submit here, bitstreams are delivered by the reactor handler threads
+  int ret = cnvencSendFrame(ctx.venc_chn_, pst_frame, milli_sec);
+  if (ret != CN_SUCCESS) {
+    LOG(WARNING) << "[EasyDK] [MpsVenc] SendFrame(): cnvencSendFrame failed, ret = " << ret << ", pts:"
+                 << pst_frame->stVFrame.u64PTS;
+    return -1;
+  }
+  VLOG(5) << "[EasyDK] [MpsVenc] SendFrame(): cnvencSendFrame pts = " << pst_frame->stVFrame.u64PTS;
   return 0;
 }
 
@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -31,6 +32,7 @@
 #include "cn_buffer.h"
 #include "cn_venc.h"
 
+#include "../../../common/fd_reactor.hpp"
 #include "../mps_service.hpp"
 #include "mps_internal/cnsample_comm.h"
 
@@ -41,7 +43,8 @@ constexpr int kMaxMpsVecNum = 16;
 
 class MpsVenc : private NonCopyable {
  public:
-  explicit MpsVenc(IVBInfo *vb_info) {}
+  // bitstreams are reaped on the reactor handler threads, as soon as the channel fd becomes readable
+  MpsVenc(IVBInfo *vb_info, FdReactor *reactor) : reactor_(reactor) {}
   ~MpsVenc() {}
 
   int Config(const MpsServiceConfig &config);
@@ -68,10 +71,14 @@ class MpsVenc : private NonCopyable {
     std::unique_lock<std::mutex> lk(id_mutex_);
     id_q_.push(id - 1);
   }
+  // called with ctx.mutex_ held
   int CheckHandleEos(void *handle);
   void OnFrameBits(void *handle, cnvencStream_t *pst_stream);
+  void OnReadable(void *handle);
+  int WaitEos(void *handle);
 
  private:
+  FdReactor *reactor_ = nullptr;
   MpsServiceConfig mps_config_;
   std::mutex id_mutex_;
   std::queue<int> id_q_;
@@ -81,11 +88,13 @@ class MpsVenc : private NonCopyable {
     std::atomic<bool> eos_sent_{false};
     std::atomic<bool> error_flag_{false};
     std::atomic<bool> created_{false};
+    std::atomic<bool> eos_reported_{false};
     cnvencChnAttr_t chn_attr_;
     cnvencRecvPicParam_t chn_param_;
     vencChn_t venc_chn_ = -1;
     int fd_ = -1;
     std::mutex mutex_;
+    std::condition_variable eos_cond_;
     cnvencPack_t pack_[kMaxMpsVencPackNum];
   } venc_ctx[kMaxMpsVecNum];
 };
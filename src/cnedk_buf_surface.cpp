@@ -97,6 +97,20 @@ class BufSurfaceService {
     LOG(ERROR) << "[EasyDK] [BufSurfaceService] CreateFromPool(): surf or pool is nullptr";
     return -1;
   }
+  int CreateFromOwner(CnedkBufSurface **surf, const CnedkBufSurface &surface, IBufSurfaceOwner *owner) {
+    if (!surf || !owner) {
+      LOG(ERROR) << "[EasyDK] [BufSurfaceService] CreateFromOwner(): surf or owner is nullptr";
+      return -1;
+    }
+    *surf = AllocSurface();
+    if (!(*surf)) {
+      LOG(ERROR) << "[EasyDK] [BufSurfaceService] CreateFromOwner(): Alloc BufSurface failed";
+      return -1;
+    }
+    *(*surf) = surface;
+    (*surf)->opaque = owner;
+    return 0;
+  }
   int Create(CnedkBufSurface **surf, CnedkBufSurfaceCreateParams *params) {
     if (surf && params) {
       if (CheckParams(params) < 0) {
@@ -128,8 +142,8 @@ class BufSurfaceService {
     }
 
     if (surf->opaque) {
-      MemPool *mempool = reinterpret_cast<MemPool *>(surf->opaque);
-      int ret = mempool->Free(surf);
+      IBufSurfaceOwner *owner = reinterpret_cast<IBufSurfaceOwner *>(surf->opaque);
+      int ret = owner->Free(surf);
       FreeSurface(surf);
       if (ret) {
         LOG(ERROR) << "[EasyDK] [BufSurfaceService] Destroy(): Free BufSurface back to memory pool failed";
@@ -374,6 +388,10 @@ class BufSurfaceService {
 
 std::unique_ptr<BufSurfaceService> BufSurfaceService::instance_;
 
+int CreateSurfaceFromOwner(CnedkBufSurface **surf, const CnedkBufSurface &surface, IBufSurfaceOwner *owner) {
+  return BufSurfaceService::Instance().CreateFromOwner(surf, surface, owner);
+}
+
 }  // namespace cnedk
 
 extern "C" {
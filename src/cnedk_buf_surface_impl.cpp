@@ -85,7 +85,7 @@ int MemPool::Create(CnedkBufSurfaceCreateParams *params, uint32_t block_num) {
         LOG(ERROR) << "[EasyDK] [MemPool] Create(): Memory allocator alloc BufSurface failed";
         return -1;
       }
-      surf.opaque = reinterpret_cast<void *>(this);
+      surf.opaque = static_cast<IBufSurfaceOwner *>(this);
       cache_.push(surf);
     }
   }
@@ -142,7 +142,7 @@ int MemPool::Alloc(CnedkBufSurface *surf) {
       VLOG(4) << "[EasyDK] [MemPool] Alloc(): Memory allocator alloc BufSurface failed";
       return -1;
     }
-    surf->opaque = reinterpret_cast<void *>(this);
+    surf->opaque = static_cast<IBufSurfaceOwner *>(this);
     return 0;
   }
 
@@ -41,7 +41,17 @@ class IMemAllcator {
 
 IMemAllcator *CreateMemAllocator(CnedkBufSurfaceMemType mem_type, uint32_t block_num);
 
-class MemPool {
+// Owns the memory of BufSurfaces. CnedkBufSurfaceDestroy() gives a BufSurface back to the owner stored in opaque.
+class IBufSurfaceOwner {
+ public:
+  virtual ~IBufSurfaceOwner() {}
+  virtual int Free(CnedkBufSurface *surf) = 0;
+};
+
+// Creates a BufSurface for `surface` whose memory is owned by `owner`, e.g. a frame buffer of a decoder
+int CreateSurfaceFromOwner(CnedkBufSurface **surf, const CnedkBufSurface &surface, IBufSurfaceOwner *owner);
+
+class MemPool : public IBufSurfaceOwner {
  public:
   MemPool() = default;
   ~MemPool() {
@@ -50,7 +60,7 @@ class MemPool {
   int Create(CnedkBufSurfaceCreateParams *params, uint32_t block_num);
   int Destroy();
   int Alloc(CnedkBufSurface *surf);
-  int Free(CnedkBufSurface *surf);
+  int Free(CnedkBufSurface *surf) override;
 
  private:
   std::mutex mutex_;
@@ -23,6 +23,8 @@
 
 #include <algorithm>
 #include <memory>
+#include <new>
+#include <string>
 #include <thread>
 
 #include "glog/logging.h"
@@ -156,26 +158,27 @@ void *BufSurfaceWrapper::GetHostData(uint32_t plane_idx, uint32_t batch_idx) {
   if (surf_->mem_type == CNEDK_BUF_MEM_DEVICE) {
     if (surf_->is_contiguous) {
       size_t total_size = surf_->batch_size * params->data_size;
-      host_data_[0].reset(new unsigned char[(total_size + 63) / 64 * 64]);
-      CALL_CNRT_FUNC(cnrtMemcpy(host_data_[0].get(), surf_->surface_list[0].data_ptr, total_size,
-                                cnrtMemcpyDevToHost),
+      unsigned char *host_data = AllocHostData(0, total_size);
+      if (!host_data) return nullptr;
+      CALL_CNRT_FUNC(cnrtMemcpy(host_data, surf_->surface_list[0].data_ptr, total_size, cnrtMemcpyDevToHost),
                      "[BufSurfaceWrapper] GetHostData(): data is contiguous, copy data D2H failed");
       for (size_t i = 0; i < surf_->batch_size; i++) {
-        GetSurfaceParamsPriv(i)->mapped_data_ptr = host_data_[0].get() + i * params->data_size;
+        GetSurfaceParamsPriv(i)->mapped_data_ptr = host_data + i * params->data_size;
       }
       addr = static_cast<unsigned char *>(params->mapped_data_ptr);
       return static_cast<void *>(addr + params->plane_params.offset[plane_idx]);
     } else {
-      if (batch_idx >= 128) {
-        LOG(ERROR) << "[EasyDK] [BufSurfaceWrapper] GetHostData(): batch index should not be greater than 128";
+      if (batch_idx >= surf_->batch_size) {
+        LOG(ERROR) << "[EasyDK] [BufSurfaceWrapper] GetHostData(): batch index should be less than batch size "
+                   << surf_->batch_size;
         return nullptr;
       }
-      host_data_[batch_idx].reset(new unsigned char[(GetSurfaceParamsPriv(batch_idx)->data_size + 63) / 64 * 64]);
-      CALL_CNRT_FUNC(cnrtMemcpy(host_data_[batch_idx].get(), GetSurfaceParamsPriv(batch_idx)->data_ptr,
-                                GetSurfaceParamsPriv(batch_idx)->data_size, cnrtMemcpyDevToHost),
+      unsigned char *host_data = AllocHostData(batch_idx, params->data_size);
+      if (!host_data) return nullptr;
+      CALL_CNRT_FUNC(cnrtMemcpy(host_data, params->data_ptr, params->data_size, cnrtMemcpyDevToHost),
                      "[BufSurfaceWrapper] GetHostData(): copy data D2H failed, batch_idx = " +
                      std::to_string(batch_idx));
-      GetSurfaceParamsPriv(batch_idx)->mapped_data_ptr = host_data_[batch_idx].get();
+      params->mapped_data_ptr = host_data;
       addr = static_cast<unsigned char *>(params->mapped_data_ptr);
       return static_cast<void *>(addr + params->plane_params.offset[plane_idx]);
     }
@@ -186,9 +189,10 @@ void *BufSurfaceWrapper::GetHostData(uint32_t plane_idx, uint32_t batch_idx) {
 
 void BufSurfaceWrapper::SyncHostToDevice(uint32_t plane_idx, uint32_t batch_idx) {
   cnrtSetDevice(GetDeviceId());
+  std::unique_lock<std::mutex> lk(mutex_);
   if (surf_->mem_type == CNEDK_BUF_MEM_DEVICE) {
-    if (batch_idx >= 0 && batch_idx < 128 && host_data_[batch_idx]) {
-      CALL_CNRT_FUNC(cnrtMemcpy(surf_->surface_list[batch_idx].data_ptr, host_data_[batch_idx].get(),
+    if (batch_idx < host_data_.size() && host_data_[batch_idx].ptr) {
+      CALL_CNRT_FUNC(cnrtMemcpy(surf_->surface_list[batch_idx].data_ptr, host_data_[batch_idx].ptr,
                                 surf_->surface_list[batch_idx].data_size, cnrtMemcpyHostToDev),
                      "[BufSurfaceWrapper] SyncHostToDevice(): copy data H2D failed, batch_idx = " +
                      std::to_string(batch_idx));
@@ -197,25 +201,21 @@ void BufSurfaceWrapper::SyncHostToDevice(uint32_t plane_idx, uint32_t batch_idx)
 
     if (batch_idx == (uint32_t)(-1)) {
       if (surf_->is_contiguous) {
-        if (!host_data_[0]) {
+        if (host_data_.empty() || !host_data_[0].ptr) {
           LOG(ERROR) << "[EasyDK] [BufSurfaceWrapper] SyncHostToDevice(): Host data is null";
           return;
         }
         size_t total_size = surf_->batch_size * GetSurfaceParamsPriv(0)->data_size;
-        CALL_CNRT_FUNC(cnrtMemcpy(surf_->surface_list[0].data_ptr, host_data_[0].get(),
+        CALL_CNRT_FUNC(cnrtMemcpy(surf_->surface_list[0].data_ptr, host_data_[0].ptr,
                                   total_size, cnrtMemcpyHostToDev),
                        "[BufSurfaceWrapper] SyncHostToDevice(): data is contiguous, copy data H2D failed");
       } else {
-        if (surf_->batch_size >= 128) {
-          LOG(ERROR) << "[EasyDK] [BufSurfaceWrapper] SyncHostToDevice: batch size should not be greater than 128,"
-                     << " which is: " << surf_->batch_size;
-          return;
-        }
-        for (uint32_t i = 0; i < surf_->batch_size; i++) {
-          CALL_CNRT_FUNC(cnrtMemcpy(surf_->surface_list[i].data_ptr, host_data_[i].get(),
+        for (uint32_t i = 0; i < surf_->batch_size && i < host_data_.size(); i++) {
+          if (!host_data_[i].ptr) continue;
+          CALL_CNRT_FUNC(cnrtMemcpy(surf_->surface_list[i].data_ptr, host_data_[i].ptr,
                                     surf_->surface_list[i].data_size, cnrtMemcpyHostToDev),
                          "[BufSurfaceWrapper] SyncHostToDevice(): copy data H2D failed, batch_idx = " +
-                         std::to_string(batch_idx));
+                         std::to_string(i));
         }
       }
     }
@@ -223,6 +223,152 @@ void BufSurfaceWrapper::SyncHostToDevice(uint32_t plane_idx, uint32_t batch_idx)
   }
   CnedkBufSurfaceSyncForDevice(surf_, batch_idx, plane_idx);
 }
+
+unsigned char *BufSurfaceWrapper::AllocHostData(uint32_t idx, size_t size) {
+  if (host_data_.size() <= idx) host_data_.resize(idx + 1);
+  HostData &host_data = host_data_[idx];
+  // reuse the staging buffer borrowed by the previous call
+  if (host_data.ptr && host_data.size >= size) return host_data.ptr;
+
+  if (host_data.ptr) {
+    if (host_data.pinned) {
+      PinnedStagingRing::Instance().Release(host_data.ptr);
+    } else {
+      delete[] host_data.ptr;
+    }
+    host_data.ptr = nullptr;
+  }
+
+  size = (size + 63) / 64 * 64;
+  host_data.ptr = static_cast<unsigned char *>(PinnedStagingRing::Instance().Acquire(size));
+  host_data.pinned = (host_data.ptr != nullptr);
+  if (!host_data.ptr) {
+    VLOG(4) << "[EasyDK] [BufSurfaceWrapper] AllocHostData(): Pinned staging ring is exhausted, use pageable memory";
+    host_data.ptr = new (std::nothrow) unsigned char[size];
+    if (!host_data.ptr) {
+      LOG(ERROR) << "[EasyDK] [BufSurfaceWrapper] AllocHostData(): Alloc host memory failed, size = " << size;
+      return nullptr;
+    }
+  }
+  host_data.size = size;
+  return host_data.ptr;
+}
+
+void BufSurfaceWrapper::FreeHostData() {
+  for (auto &host_data : host_data_) {
+    if (!host_data.ptr) continue;
+    if (host_data.pinned) {
+      PinnedStagingRing::Instance().Release(host_data.ptr);
+    } else {
+      delete[] host_data.ptr;
+    }
+  }
+  host_data_.clear();
+  if (surf_ && surf_->mem_type == CNEDK_BUF_MEM_DEVICE) {
+    // the faked mapped data is not valid any more
+    for (uint32_t i = 0; i < surf_->batch_size; i++) surf_->surface_list[i].mapped_data_ptr = nullptr;
+  }
+}
+
+//
+// PinnedStagingRing
+//
+PinnedStagingRing &PinnedStagingRing::Instance() {
+  static PinnedStagingRing instance;
+  return instance;
+}
+
+PinnedStagingRing::~PinnedStagingRing() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  if (!blocks_.empty()) {
+    LOG(WARNING) << "[EasyDK] [PinnedStagingRing] ~PinnedStagingRing(): " << blocks_.size()
+                 << " staging buffers are not released";
+    return;
+  }
+  if (base_) cnrtFreeHost(base_), base_ = nullptr;
+}
+
+int PinnedStagingRing::SetCapacity(size_t capacity) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  if (!blocks_.empty()) {
+    LOG(ERROR) << "[EasyDK] [PinnedStagingRing] SetCapacity(): Staging buffers are in use";
+    return -1;
+  }
+  if (base_) {
+    CNRT_SAFECALL(cnrtFreeHost(base_), "[PinnedStagingRing] SetCapacity(): free pinned memory failed", -1);
+    base_ = nullptr;
+  }
+  capacity_ = capacity;
+  head_ = tail_ = 0;
+  return 0;
+}
+
+size_t PinnedStagingRing::GetCapacity() const {
+  std::unique_lock<std::mutex> lk(mutex_);
+  return capacity_;
+}
+
+void *PinnedStagingRing::Acquire(size_t size) {
+  if (!size) return nullptr;
+  size = (size + 63) / 64 * 64;
+  std::unique_lock<std::mutex> lk(mutex_);
+  if (size > capacity_) return nullptr;
+  if (!base_) {
+    void *base = nullptr;
+    CNRT_SAFECALL(cnrtHostMalloc(&base, capacity_), "[PinnedStagingRing] Acquire(): alloc pinned memory failed",
+                  nullptr);
+    base_ = static_cast<unsigned char *>(base);
+  }
+
+  size_t offset;
+  if (blocks_.empty()) {
+    head_ = tail_ = 0;
+    offset = 0;
+  } else if (head_ > tail_) {
+    // free space is [head_, capacity_) and [0, tail_)
+    if (capacity_ - head_ >= size) {
+      offset = head_;
+    } else if (tail_ >= size) {
+      offset = 0;
+    } else {
+      return nullptr;
+    }
+  } else {
+    // wrapped, free space is [head_, tail_)
+    if (tail_ - head_ >= size) {
+      offset = head_;
+    } else {
+      return nullptr;
+    }
+  }
+  blocks_.push_back({offset, size, false});
+  head_ = offset + size;
+  return base_ + offset;
+}
+
+void PinnedStagingRing::Release(void *ptr) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  unsigned char *ptr8 = static_cast<unsigned char *>(ptr);
+  if (!base_ || ptr8 < base_ || ptr8 >= base_ + capacity_) {
+    LOG(ERROR) << "[EasyDK] [PinnedStagingRing] Release(): The buffer is not borrowed from the ring";
+    return;
+  }
+  size_t offset = ptr8 - base_;
+  for (auto &block : blocks_) {
+    if (block.offset == offset && !block.released) {
+      block.released = true;
+      break;
+    }
+  }
+  // the space is reclaimed in allocation order
+  while (!blocks_.empty() && blocks_.front().released) blocks_.pop_front();
+  if (blocks_.empty()) {
+    head_ = tail_ = 0;
+  } else {
+    tail_ = blocks_.front().offset;
+  }
+}
+
 //
 // BufPool
 //
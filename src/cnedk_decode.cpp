@@ -23,12 +23,14 @@
 #include <cstring>  // for memset
 #include <memory>  // for unique_ptr
 #include <mutex>   // for call_once
+#include <vector>
 
 #include "glog/logging.h"
 #include "cnrt.h"
 
 #include "cnedk_decode_impl.hpp"
 #include "cnedk_platform.h"
+#include "cnedk_transform.h"
 #include "common/utils.hpp"
 
 #ifdef PLATFORM_CE3226
@@ -75,6 +77,180 @@ IDecoder *CreateDecoder() {
   return nullptr;
 }
 
+void FrameOutputs::Init(const CnedkVdecCreateParams &params) {
+  params_ = params;
+  specs_.clear();
+  if (params.output_specs && params.num_output_specs) {
+    specs_.assign(params.output_specs, params.output_specs + params.num_output_specs);
+  }
+  params_.output_specs = specs_.data();
+  frame_count_ = 0;
+}
+
+bool FrameOutputs::Accept(const CnedkVdecStream *stream) const {
+  if (params_.mode == CNEDK_VDEC_MODE_ALL || !stream || !stream->bits) return true;
+  CnedkVdecFrameType frame_type;
+  if (CnedkVdecGetFrameType(params_.type, stream->bits, stream->len, &frame_type) < 0) return true;
+  switch (frame_type) {
+    case CNEDK_VDEC_FRAME_NON_REF:
+      return false;
+    case CNEDK_VDEC_FRAME_REF:
+      return params_.mode != CNEDK_VDEC_MODE_KEY_ONLY;
+    default:
+      return true;
+  }
+}
+
+static bool IsYuv420sp(CnedkBufSurfaceColorFormat fmt) {
+  return fmt == CNEDK_BUF_COLOR_FORMAT_NV12 || fmt == CNEDK_BUF_COLOR_FORMAT_NV21;
+}
+
+int FrameOutputs::Deliver(CnedkBufSurface *surf) {
+  if (specs_.empty()) return params_.OnFrame(surf, params_.userdata);
+
+  std::vector<CnedkBufSurface *> surfs(specs_.size() + 1, nullptr);
+  surfs[0] = surf;
+  auto release = [&surfs]() {
+    for (auto &out : surfs) {
+      if (out) CnedkBufSurfaceDestroy(out), out = nullptr;
+    }
+  };
+  for (size_t i = 0; i < specs_.size(); ++i) {
+    if (params_.GetBufSurf(&surfs[i + 1], specs_[i].width, specs_[i].height, specs_[i].color_format,
+                           params_.surf_timeout_ms, params_.userdata) < 0) {
+      LOG(ERROR) << "[EasyDK] [FrameOutputs] Deliver(): Get BufSurface of output " << i << " failed";
+      release();
+      params_.OnError(-1, params_.userdata);
+      return -1;
+    }
+    surfs[i + 1]->pts = surf->pts;
+  }
+
+  // one batched transform for the yuv outputs and one for the rgb family outputs, all read the same picture
+  std::vector<CnedkBufSurfaceParams> src_params;
+  std::vector<CnedkBufSurfaceParams> dst_params;
+  std::vector<CnedkTransformRect> src_rects;
+  for (int yuv = 0; yuv < 2; ++yuv) {
+    src_params.clear();
+    dst_params.clear();
+    src_rects.clear();
+    // the descriptor of the batch, taken from its first output, the other group may use another pool
+    CnedkBufSurface *first_dst = nullptr;
+    for (size_t i = 0; i < specs_.size(); ++i) {
+      if (IsYuv420sp(specs_[i].color_format) != static_cast<bool>(yuv)) continue;
+      if (!first_dst) first_dst = surfs[i + 1];
+      src_params.push_back(surf->surface_list[0]);
+      dst_params.push_back(surfs[i + 1]->surface_list[0]);
+      src_rects.push_back(specs_[i].roi);
+    }
+    if (src_params.empty()) continue;
+
+    CnedkBufSurface transform_src;
+    CnedkBufSurface transform_dst;
+    memset(&transform_src, 0, sizeof(transform_src));
+    memset(&transform_dst, 0, sizeof(transform_dst));
+    transform_src.mem_type = surf->mem_type;
+    transform_src.device_id = surf->device_id;
+    transform_src.batch_size = transform_src.num_filled = src_params.size();
+    transform_src.surface_list = src_params.data();
+    transform_dst.mem_type = first_dst->mem_type;
+    transform_dst.device_id = first_dst->device_id;
+    transform_dst.batch_size = transform_dst.num_filled = dst_params.size();
+    transform_dst.surface_list = dst_params.data();
+
+    CnedkTransformParams trans_params;
+    memset(&trans_params, 0, sizeof(trans_params));
+    trans_params.transform_flag = CNEDK_TRANSFORM_CROP_SRC;
+    trans_params.src_rect = src_rects.data();
+    if (CnedkTransform(&transform_src, &transform_dst, &trans_params) < 0) {
+      LOG(ERROR) << "[EasyDK] [FrameOutputs] Deliver(): Transform of the outputs failed";
+      release();
+      params_.OnError(-1, params_.userdata);
+      return -1;
+    }
+  }
+  return params_.OnFrameOutputs(surfs.data(), surfs.size(), params_.userdata);
+}
+
+// Reads the Exp-Golomb codes of a slice header, skipping the emulation prevention bytes
+class SliceHeaderReader {
+ public:
+  SliceHeaderReader(const uint8_t *data, size_t len) : data_(data), len_(len) {}
+  bool ReadUe(uint32_t *value) {
+    int zeros = 0;
+    uint32_t bit;
+    while (ReadBit(&bit) && !bit) {
+      if (++zeros > 31) return false;
+    }
+    if (pos_ > len_ * 8) return false;
+    uint32_t suffix = 0;
+    for (int i = 0; i < zeros; ++i) {
+      if (!ReadBit(&bit)) return false;
+      suffix = (suffix << 1) | bit;
+    }
+    *value = (1u << zeros) - 1 + suffix;
+    return true;
+  }
+
+ private:
+  bool ReadBit(uint32_t *bit) {
+    size_t byte = pos_ / 8;
+    // pos_ is past the end once a read failed, data_[byte] must not be touched before the bound is checked
+    if (byte >= len_) {
+      pos_ = len_ * 8 + 1;
+      return false;
+    }
+    if (pos_ % 8 == 0 && byte >= 2 && data_[byte] == 3 && data_[byte - 1] == 0 && data_[byte - 2] == 0) {
+      pos_ += 8;
+      byte++;
+      if (byte >= len_) {
+        pos_ = len_ * 8 + 1;
+        return false;
+      }
+    }
+    *bit = (data_[byte] >> (7 - pos_ % 8)) & 1;
+    pos_++;
+    return true;
+  }
+
+  const uint8_t *data_;
+  size_t len_;
+  size_t pos_ = 0;
+};
+
+static CnedkVdecFrameType GetNalFrameType(CnedkVdecType type, const uint8_t *nal, size_t len, bool *is_vcl,
+                                          bool *is_param) {
+  *is_vcl = *is_param = false;
+  if (type == CNEDK_VDEC_TYPE_H264) {
+    uint8_t nal_type = nal[0] & 0x1f;
+    uint8_t ref_idc = (nal[0] >> 5) & 0x3;
+    *is_param = nal_type == 7 || nal_type == 8;
+    if (nal_type == 5) {
+      *is_vcl = true;
+      return CNEDK_VDEC_FRAME_KEY;
+    }
+    if (nal_type != 1) return CNEDK_VDEC_FRAME_UNKNOWN;
+    *is_vcl = true;
+    // first_mb_in_slice, slice_type
+    SliceHeaderReader reader(nal + 1, len - 1);
+    uint32_t first_mb, slice_type;
+    if (reader.ReadUe(&first_mb) && reader.ReadUe(&slice_type) && (slice_type % 5 == 2 || slice_type % 5 == 4)) {
+      return CNEDK_VDEC_FRAME_KEY;
+    }
+    return ref_idc ? CNEDK_VDEC_FRAME_REF : CNEDK_VDEC_FRAME_NON_REF;
+  }
+  if (len < 2) return CNEDK_VDEC_FRAME_UNKNOWN;
+  uint8_t nal_type = (nal[0] >> 1) & 0x3f;
+  *is_param = nal_type >= 32 && nal_type <= 34;
+  if (nal_type >= 32) return CNEDK_VDEC_FRAME_UNKNOWN;
+  *is_vcl = true;
+  if (nal_type >= 16 && nal_type <= 23) return CNEDK_VDEC_FRAME_KEY;
+  // TRAIL_N, TSA_N, STSA_N, RADL_N, RASL_N and the reserved ones are sub-layer non-reference pictures. They are
+  // unreferenced only if there are no higher temporal sub-layers, which holds for the usual single layer streams.
+  if (nal_type <= 14 && nal_type % 2 == 0) return CNEDK_VDEC_FRAME_NON_REF;
+  return CNEDK_VDEC_FRAME_REF;
+}
+
 class DecodeService {
  public:
   static DecodeService &Instance() {
@@ -126,6 +302,14 @@ class DecodeService {
     return decoder_->SendStream(stream, timeout_ms);
   }
 
+  int TrySendStream(void *vdec, const CnedkVdecStream *stream, int timeout_ms) {
+    if (!vdec || !stream) {
+      LOG(ERROR) << "[EasyDK] [DecodeService] TrySendStream(): Decoder or stream pointer is invalid";
+      return -1;
+    }
+    return static_cast<IDecoder *>(vdec)->TrySendStream(stream, timeout_ms);
+  }
+
  private:
   int CheckParams(CnedkVdecCreateParams *params) {
     if (params->type <= CNEDK_VDEC_TYPE_INVALID || params->type >= CNEDK_VDEC_TYPE_NUM) {
@@ -138,13 +322,31 @@ class DecodeService {
       return -1;
     }
 
-    if (params->OnEos == nullptr || params->OnFrame == nullptr || params->OnError == nullptr ||
-        params->GetBufSurf == nullptr) {
+    if (params->OnEos == nullptr || (params->OnFrame == nullptr && !params->num_output_specs) ||
+        params->OnError == nullptr || (params->GetBufSurf == nullptr && !params->zero_copy)) {
       LOG(ERROR) << "[EasyDK] [DecodeService] CheckParams(): OnEos, OnFrame, OnError or GetBufSurf function pointer"
                  << " is invalid";
       return -1;
     }
 
+    if (params->mode < CNEDK_VDEC_MODE_ALL || params->mode >= CNEDK_VDEC_MODE_NUM) {
+      LOG(ERROR) << "[EasyDK] [DecodeService] CheckParams(): Unsupported decode mode: " << params->mode;
+      return -1;
+    }
+
+    if (params->num_output_specs) {
+      if (!params->output_specs || !params->OnFrameOutputs || !params->GetBufSurf) {
+        LOG(ERROR) << "[EasyDK] [DecodeService] CheckParams(): output_specs, OnFrameOutputs or GetBufSurf is invalid";
+        return -1;
+      }
+      for (uint32_t i = 0; i < params->num_output_specs; ++i) {
+        if (!params->output_specs[i].width || !params->output_specs[i].height) {
+          LOG(ERROR) << "[EasyDK] [DecodeService] CheckParams(): The size of output " << i << " is invalid";
+          return -1;
+        }
+      }
+    }
+
     int dev_id = -1;
     CNRT_SAFECALL(cnrtGetDevice(&dev_id), "[DecodeService] CheckParams(): failed", -1);
     if (params->device_id != dev_id) {
@@ -170,10 +372,51 @@ class DecodeService {
 
 std::unique_ptr<DecodeService> DecodeService::instance_;
 
+int VdecTrySendStream(void *vdec, const CnedkVdecStream *stream, int timeout_ms) {
+  return DecodeService::Instance().TrySendStream(vdec, stream, timeout_ms);
+}
+
 }  // namespace cnedk
 
 extern "C" {
 
+int CnedkVdecGetFrameType(CnedkVdecType type, const uint8_t *bits, uint32_t len, CnedkVdecFrameType *frame_type) {
+  if (!bits || !frame_type) {
+    LOG(ERROR) << "[EasyDK] CnedkVdecGetFrameType(): bits or frame_type pointer is invalid";
+    return -1;
+  }
+  if (type != CNEDK_VDEC_TYPE_H264 && type != CNEDK_VDEC_TYPE_H265) {
+    LOG(ERROR) << "[EasyDK] CnedkVdecGetFrameType(): Unsupported codec type: " << type;
+    return -1;
+  }
+  *frame_type = CNEDK_VDEC_FRAME_UNKNOWN;
+  bool has_param = false;
+  // walk through the NAL units after the start codes
+  uint32_t i = 0;
+  while (i + 3 < len) {
+    if (bits[i] != 0 || bits[i + 1] != 0 || bits[i + 2] != 1) {
+      ++i;
+      continue;
+    }
+    uint32_t start = i + 3;
+    uint32_t end = start;
+    while (end + 2 < len && !(bits[end] == 0 && bits[end + 1] == 0 && (bits[end + 2] == 1 || bits[end + 2] == 0))) {
+      ++end;
+    }
+    if (end + 2 >= len) end = len;
+    bool is_vcl, is_param;
+    CnedkVdecFrameType nal_frame_type = cnedk::GetNalFrameType(type, bits + start, end - start, &is_vcl, &is_param);
+    has_param |= is_param;
+    if (is_vcl) {
+      *frame_type = nal_frame_type;
+      break;
+    }
+    i = end;
+  }
+  if (has_param) *frame_type = CNEDK_VDEC_FRAME_KEY;
+  return 0;
+}
+
 int CnedkVdecCreate(void **vdec, CnedkVdecCreateParams *params) {
   return cnedk::DecodeService::Instance().Create(vdec, params);
 }
@@ -21,20 +21,46 @@
 #ifndef CNEDK_DECODE_IMPL_HPP_
 #define CNEDK_DECODE_IMPL_HPP_
 
+#include <vector>
+
 #include "cnedk_decode.h"
 
 namespace cnedk {
 
+// Delivers the decoded pictures to the user, with the extra outputs of CnedkVdecCreateParams::output_specs
+class FrameOutputs {
+ public:
+  void Init(const CnedkVdecCreateParams &params);
+  // Returns true if the packet should be sent to the decoder in the decode mode
+  bool Accept(const CnedkVdecStream *stream) const;
+  // Returns true if the next decoded picture is not output because of output_interval
+  bool Skip() { return params_.output_interval > 1 && (frame_count_++ % params_.output_interval) != 0; }
+  // Fills the extra outputs from surf and calls OnFrameOutputs, or calls OnFrame if there are no extra outputs
+  int Deliver(CnedkBufSurface *surf);
+
+ private:
+  CnedkVdecCreateParams params_;
+  std::vector<CnedkVdecOutputSpec> specs_;
+  uint64_t frame_count_ = 0;
+};
+
 class IDecoder {
  public:
   virtual ~IDecoder() {}
   virtual int Create(CnedkVdecCreateParams *params) = 0;
   virtual int Destroy() = 0;
   virtual int SendStream(const CnedkVdecStream *stream, int timeout_ms) = 0;
+  // Sends the packet without retrying, returns -2 at once if the decoder is full. No error is logged for a full
+  // decoder, the caller is expected to send the packet again later.
+  virtual int TrySendStream(const CnedkVdecStream *stream, int timeout_ms) { return SendStream(stream, timeout_ms); }
 };
 
 IDecoder *CreateDecoder();
 
+// The same as CnedkVdecSendStream() but with IDecoder::TrySendStream(), for the decode services that schedule the
+// packets of many decoders
+int VdecTrySendStream(void *vdec, const CnedkVdecStream *stream, int timeout_ms);
+
 }  // namespace cnedk
 
 #endif  // CNEDK_DECODE_IMPL_HPP_
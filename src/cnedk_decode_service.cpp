@@ -0,0 +1,328 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include <condition_variable>
+#include <cstring>  // for memset
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "glog/logging.h"
+#include "cnrt.h"
+
+#include "cnedk_decode.h"
+#include "cnedk_decode_impl.hpp"
+#include "common/utils.hpp"
+
+namespace cnedk {
+
+// Owns the decoders of many streams. The packets are queued per stream and sent by a few I/O threads, a stream is
+// served by one thread at a time to keep the order of its packets. A send which times out is retried after the other
+// ready streams, so a full decoder does not block the others.
+class VdecService {
+ public:
+  explicit VdecService(const CnedkVdecServiceCreateParams &params) {
+    uint32_t io_thread_num = params.io_thread_num ? params.io_thread_num : 2;
+    max_queued_packets_ = params.max_queued_packets ? params.max_queued_packets : 32;
+    send_timeout_ms_ = params.send_timeout_ms > 0 ? params.send_timeout_ms : 10;
+    running_ = true;
+    for (uint32_t i = 0; i < io_thread_num; ++i) {
+      threads_.emplace_back(&VdecService::Loop, this);
+    }
+  }
+
+  ~VdecService() {
+    std::vector<int> ids;
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      for (auto &it : streams_) ids.push_back(it.first);
+    }
+    for (int id : ids) RemoveStream(id);
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      running_ = false;
+    }
+    cond_.notify_all();
+    for (auto &thread : threads_) {
+      if (thread.joinable()) thread.join();
+    }
+  }
+
+  int AddStream(int stream_id, CnedkVdecCreateParams *params) {
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      if (streams_.count(stream_id)) {
+        LOG(ERROR) << "[EasyDK] [VdecService] AddStream(): Stream " << stream_id << " exists";
+        return -1;
+      }
+    }
+    void *vdec = nullptr;
+    if (CnedkVdecCreate(&vdec, params) < 0) {
+      LOG(ERROR) << "[EasyDK] [VdecService] AddStream(): Create decoder failed, stream id: " << stream_id;
+      return -1;
+    }
+    std::shared_ptr<Stream> stream = std::make_shared<Stream>();
+    stream->id = stream_id;
+    stream->device_id = params->device_id;
+    stream->vdec = vdec;
+
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (!streams_.emplace(stream_id, stream).second) {
+      lk.unlock();
+      CnedkVdecDestroy(vdec);
+      LOG(ERROR) << "[EasyDK] [VdecService] AddStream(): Stream " << stream_id << " exists";
+      return -1;
+    }
+    return 0;
+  }
+
+  int RemoveStream(int stream_id) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end()) {
+      LOG(ERROR) << "[EasyDK] [VdecService] RemoveStream(): Stream " << stream_id << " is not found";
+      return -1;
+    }
+    std::shared_ptr<Stream> stream = it->second;
+    if (stream->removing) {
+      LOG(ERROR) << "[EasyDK] [VdecService] RemoveStream(): Stream " << stream_id << " is being removed";
+      return -1;
+    }
+    stream->removing = true;
+    if (!stream->eos_submitted) {
+      stream->eos_submitted = true;
+      stream->packets.emplace_back();
+      stream->packets.back().eos = true;
+      Schedule(stream);
+    }
+    stream->drained.wait(lk, [&stream] { return stream->packets.empty() && !stream->scheduled; });
+    streams_.erase(stream_id);
+    lk.unlock();
+
+    // waits for the eos from the decoder
+    if (CnedkVdecDestroy(stream->vdec) < 0) {
+      LOG(ERROR) << "[EasyDK] [VdecService] RemoveStream(): Destroy decoder failed, stream id: " << stream_id;
+      return -1;
+    }
+    return 0;
+  }
+
+  int Submit(int stream_id, const CnedkVdecStream *packet) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end()) {
+      LOG(ERROR) << "[EasyDK] [VdecService] Submit(): Stream " << stream_id << " is not found";
+      return -1;
+    }
+    Stream *stream = it->second.get();
+    if (stream->eos_submitted) {
+      LOG(ERROR) << "[EasyDK] [VdecService] Submit(): EOS of stream " << stream_id << " has been submitted";
+      return -1;
+    }
+    if (stream->packets.size() >= max_queued_packets_) {
+      VLOG(4) << "[EasyDK] [VdecService] Submit(): The queue of stream " << stream_id << " is full";
+      return -2;
+    }
+    lk.unlock();
+
+    // copy the data out of the lock
+    Packet pkt;
+    pkt.eos = !packet->bits;
+    if (!pkt.eos) pkt.data.assign(packet->bits, packet->bits + packet->len);
+    pkt.flags = packet->flags;
+    pkt.pts = packet->pts;
+
+    lk.lock();
+    it = streams_.find(stream_id);
+    if (it == streams_.end() || it->second->eos_submitted) {
+      LOG(ERROR) << "[EasyDK] [VdecService] Submit(): Stream " << stream_id << " is removed";
+      return -1;
+    }
+    stream = it->second.get();
+    stream->eos_submitted = pkt.eos;
+    stream->queued_bytes += pkt.data.size();
+    stream->packets.push_back(std::move(pkt));
+    Schedule(it->second);
+    return 0;
+  }
+
+  int GetStreamStatus(int stream_id, CnedkVdecServiceStreamStatus *status) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end()) {
+      LOG(ERROR) << "[EasyDK] [VdecService] GetStreamStatus(): Stream " << stream_id << " is not found";
+      return -1;
+    }
+    const Stream &stream = *it->second;
+    memset(status, 0, sizeof(*status));
+    status->queued_packets = stream.packets.size();
+    status->queued_bytes = stream.queued_bytes;
+    status->sent_packets = stream.sent_packets;
+    status->failed_packets = stream.failed_packets;
+    status->backpressure = stream.packets.size() >= max_queued_packets_;
+    return 0;
+  }
+
+ private:
+  struct Packet {
+    std::vector<uint8_t> data;
+    uint32_t flags = 0;
+    uint64_t pts = 0;
+    bool eos = false;
+  };
+
+  struct Stream {
+    int id = -1;
+    int device_id = 0;
+    void *vdec = nullptr;
+    std::deque<Packet> packets;
+    uint64_t queued_bytes = 0;
+    uint64_t sent_packets = 0;
+    uint64_t failed_packets = 0;
+    bool scheduled = false;  // in ready_ or being sent by an I/O thread
+    bool eos_submitted = false;
+    bool removing = false;
+    std::condition_variable drained;
+  };
+
+  // must be called with mutex_ locked
+  void Schedule(const std::shared_ptr<Stream> &stream) {
+    if (stream->scheduled) return;
+    stream->scheduled = true;
+    ready_.push_back(stream);
+    cond_.notify_one();
+  }
+
+  void Loop() {
+    int device_id = -1;
+    std::unique_lock<std::mutex> lk(mutex_);
+    while (true) {
+      cond_.wait(lk, [this] { return !running_ || !ready_.empty(); });
+      if (ready_.empty()) break;
+      std::shared_ptr<Stream> stream = ready_.front();
+      ready_.pop_front();
+      // only this thread pops the packets of the stream, the reference is stable while others push back
+      Packet &pkt = stream->packets.front();
+      lk.unlock();
+
+      if (device_id != stream->device_id) {
+        CALL_CNRT_FUNC(cnrtSetDevice(stream->device_id), "[VdecService] Loop(): set device failed");
+        device_id = stream->device_id;
+      }
+      CnedkVdecStream packet;
+      memset(&packet, 0, sizeof(packet));
+      packet.bits = pkt.eos ? nullptr : pkt.data.data();
+      packet.len = pkt.data.size();
+      packet.flags = pkt.flags;
+      packet.pts = pkt.pts;
+      int ret = VdecTrySendStream(stream->vdec, &packet, send_timeout_ms_);
+
+      lk.lock();
+      if (ret == -2) {
+        // the decoder is full, serve the other streams first
+        ready_.push_back(stream);
+        continue;
+      }
+      if (ret == 0) {
+        ++stream->sent_packets;
+      } else {
+        ++stream->failed_packets;
+        LOG(ERROR) << "[EasyDK] [VdecService] Loop(): Send packet failed, stream id: " << stream->id
+                   << ", ret = " << ret;
+      }
+      stream->queued_bytes -= pkt.data.size();
+      stream->packets.pop_front();
+      if (!stream->packets.empty()) {
+        ready_.push_back(stream);
+      } else {
+        stream->scheduled = false;
+        stream->drained.notify_all();
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::map<int, std::shared_ptr<Stream>> streams_;
+  std::deque<std::shared_ptr<Stream>> ready_;
+  std::vector<std::thread> threads_;
+  uint32_t max_queued_packets_ = 32;
+  int send_timeout_ms_ = 10;
+  bool running_ = false;
+};  // class VdecService
+
+}  // namespace cnedk
+
+extern "C" {
+
+int CnedkVdecServiceCreate(void **service, CnedkVdecServiceCreateParams *params) {
+  if (!service || !params) {
+    LOG(ERROR) << "[EasyDK] CnedkVdecServiceCreate(): service or params pointer is invalid";
+    return -1;
+  }
+  *service = new cnedk::VdecService(*params);
+  return 0;
+}
+
+int CnedkVdecServiceDestroy(void *service) {
+  if (!service) {
+    LOG(ERROR) << "[EasyDK] CnedkVdecServiceDestroy(): service pointer is invalid";
+    return -1;
+  }
+  delete static_cast<cnedk::VdecService *>(service);
+  return 0;
+}
+
+int CnedkVdecServiceAddStream(void *service, int stream_id, CnedkVdecCreateParams *params) {
+  if (!service || !params) {
+    LOG(ERROR) << "[EasyDK] CnedkVdecServiceAddStream(): service or params pointer is invalid";
+    return -1;
+  }
+  return static_cast<cnedk::VdecService *>(service)->AddStream(stream_id, params);
+}
+
+int CnedkVdecServiceRemoveStream(void *service, int stream_id) {
+  if (!service) {
+    LOG(ERROR) << "[EasyDK] CnedkVdecServiceRemoveStream(): service pointer is invalid";
+    return -1;
+  }
+  return static_cast<cnedk::VdecService *>(service)->RemoveStream(stream_id);
+}
+
+int CnedkVdecServiceSubmit(void *service, int stream_id, const CnedkVdecStream *stream) {
+  if (!service || !stream) {
+    LOG(ERROR) << "[EasyDK] CnedkVdecServiceSubmit(): service or stream pointer is invalid";
+    return -1;
+  }
+  return static_cast<cnedk::VdecService *>(service)->Submit(stream_id, stream);
+}
+
+int CnedkVdecServiceGetStreamStatus(void *service, int stream_id, CnedkVdecServiceStreamStatus *status) {
+  if (!service || !status) {
+    LOG(ERROR) << "[EasyDK] CnedkVdecServiceGetStreamStatus(): service or status pointer is invalid";
+    return -1;
+  }
+  return static_cast<cnedk::VdecService *>(service)->GetStreamStatus(stream_id, status);
+}
+
+};  // extern "C"
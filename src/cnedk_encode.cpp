@@ -20,9 +20,13 @@
 
 #include "cnedk_encode.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>  // for memset
+#include <map>
 #include <memory>  // for unique_ptr
 #include <mutex>   // for call_once
+#include <string>
 
 #include "glog/logging.h"
 #include "cnrt.h"
@@ -75,6 +79,165 @@ IEncoder *CreateEncoder() {
   return nullptr;
 }
 
+int BitstreamRing::Init(uint32_t size, uint32_t high_watermark, uint32_t low_watermark) {
+  high_watermark_ = high_watermark ? high_watermark : size / 4 * 3;
+  low_watermark_ = low_watermark ? low_watermark : size / 2;
+  if (high_watermark_ > size || low_watermark_ > high_watermark_) {
+    LOG(ERROR) << "[EasyDK] [BitstreamRing] Init(): Invalid watermarks, high: " << high_watermark_
+               << ", low: " << low_watermark_ << ", size: " << size;
+    return -1;
+  }
+  buffer_.resize(size);
+  return 0;
+}
+
+uint64_t BitstreamRing::Tail() const {
+  uint64_t tail = head_;
+  for (auto &it : readers_) tail = std::min(tail, it.second.released);
+  return tail;
+}
+
+void BitstreamRing::Trim() {
+  uint64_t tail = Tail();
+  uint64_t next_seq = first_seq_ + entries_.size();
+  for (auto &it : readers_) next_seq = std::min(next_seq, it.second.next_seq);
+  while (!entries_.empty() && entries_.front().end <= tail && first_seq_ < next_seq) {
+    entries_.pop_front();
+    ++first_seq_;
+  }
+}
+
+uint8_t *BitstreamRing::Reserve(uint32_t len) {
+  uint64_t size = buffer_.size();
+  std::unique_lock<std::mutex> lk(mutex_);
+  // a packet never wraps around, the tail of the ring is skipped if the packet does not fit in
+  uint64_t start = head_;
+  if (start % size + len > size) start += size - start % size;
+  uint64_t end = start + len;
+  if (len > size || end - Tail() > size) {
+    ++dropped_;
+    LOG(WARNING) << "[EasyDK] [BitstreamRing] Reserve(): No space for the packet, dropped, len: " << len;
+    return nullptr;
+  }
+  reserved_start_ = start;
+  reserved_end_ = end;
+  // the space is not touched by the readers until it is committed
+  return buffer_.data() + start % size;
+}
+
+void BitstreamRing::Commit(const CnedkVEncFrameBits &bits) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  Entry entry;
+  memset(&entry.packet, 0, sizeof(entry.packet));
+  entry.packet.offset = reserved_start_ % buffer_.size();
+  entry.packet.len = reserved_end_ - reserved_start_;
+  entry.packet.pts = bits.pts;
+  entry.packet.pkt_type = bits.pkt_type;
+  entry.packet.seq = first_seq_ + entries_.size();
+  entry.packet.dropped = dropped_;
+  entry.end = reserved_end_;
+  entries_.push_back(entry);
+  head_ = reserved_end_;
+  dropped_ = 0;
+  Trim();
+  data_cond_.notify_all();
+}
+
+void BitstreamRing::Cancel() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  ++dropped_;
+}
+
+int BitstreamRing::Write(const CnedkVEncFrameBits &bits) {
+  uint8_t *dst = Reserve(bits.len);
+  if (!dst) return -1;
+  memcpy(dst, bits.bits, bits.len);
+  Commit(bits);
+  return 0;
+}
+
+void BitstreamRing::SetEos() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  eos_ = true;
+  data_cond_.notify_all();
+}
+
+bool BitstreamRing::AboveWatermark() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  uint64_t used = head_ - Tail();
+  if (used > high_watermark_) {
+    above_watermark_ = true;
+  } else if (used <= low_watermark_) {
+    above_watermark_ = false;
+  }
+  return above_watermark_;
+}
+
+int BitstreamRing::AddReader(int *reader) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  *reader = next_reader_id_++;
+  readers_[*reader] = {first_seq_ + entries_.size(), head_};
+  return 0;
+}
+
+int BitstreamRing::RemoveReader(int reader) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  if (!readers_.erase(reader)) {
+    LOG(ERROR) << "[EasyDK] [BitstreamRing] RemoveReader(): Reader " << reader << " is not found";
+    return -1;
+  }
+  Trim();
+  // wakes up the Read() of the removed reader
+  data_cond_.notify_all();
+  return 0;
+}
+
+int BitstreamRing::Read(int reader, CnedkVencRingPacket *packet, int timeout_ms) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  // the reader may be removed by another thread while waiting, so it is looked up after each wakeup
+  auto ready = [&] {
+    auto it = readers_.find(reader);
+    return eos_ || it == readers_.end() || it->second.next_seq < first_seq_ + entries_.size();
+  };
+  if (timeout_ms < 0) {
+    data_cond_.wait(lk, ready);
+  } else if (!data_cond_.wait_for(lk, std::chrono::milliseconds(timeout_ms), ready)) {
+    return -2;
+  }
+  auto it = readers_.find(reader);
+  if (it == readers_.end()) {
+    LOG(ERROR) << "[EasyDK] [BitstreamRing] Read(): Reader " << reader << " is not found";
+    return -1;
+  }
+  if (it->second.next_seq == first_seq_ + entries_.size()) {
+    memset(packet, 0, sizeof(*packet));
+    packet->dropped = dropped_;
+    packet->eos = true;
+    return 0;
+  }
+  *packet = entries_[it->second.next_seq - first_seq_].packet;
+  ++it->second.next_seq;
+  return 0;
+}
+
+int BitstreamRing::Release(int reader, const CnedkVencRingPacket *packet) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  auto it = readers_.find(reader);
+  if (it == readers_.end()) {
+    LOG(ERROR) << "[EasyDK] [BitstreamRing] Release(): Reader " << reader << " is not found";
+    return -1;
+  }
+  // the packets before first_seq_ have been released by all of the readers
+  if (packet->seq < first_seq_) return 0;
+  if (packet->seq >= it->second.next_seq) {
+    LOG(ERROR) << "[EasyDK] [BitstreamRing] Release(): Packet " << packet->seq << " is not held by reader " << reader;
+    return -1;
+  }
+  it->second.released = std::max(it->second.released, entries_[packet->seq - first_seq_].end);
+  Trim();
+  return 0;
+}
+
 class EncodeService {
  public:
   static EncodeService &Instance() {
@@ -92,16 +255,36 @@ class EncodeService {
       LOG(ERROR) << "[EasyDK] [EncodeService] Create(): Parameters are invalid";
       return -1;
     }
+    std::shared_ptr<RingContext> ring_ctx;
+    CnedkVencCreateParams create_params = *params;
+    if (params->ring_size) {
+      // the packets are written into the ring by the callbacks below, which forward the others to the user
+      ring_ctx = std::make_shared<RingContext>();
+      ring_ctx->params = *params;
+      if (ring_ctx->ring.Init(params->ring_size, params->ring_high_watermark, params->ring_low_watermark) < 0) {
+        LOG(ERROR) << "[EasyDK] [EncodeService] Create(): Create bitstream ring failed";
+        return -1;
+      }
+      create_params.OnFrameBits = RingOnFrameBits;
+      create_params.OnEos = RingOnEos;
+      create_params.OnError = RingOnError;
+      create_params.userdata = ring_ctx.get();
+    }
     IEncoder *encoder_ = CreateEncoder();
     if (!encoder_) {
       LOG(ERROR) << "[EasyDK] [EncodeService] Create(): new encoder failed";
       return -1;
     }
-    if (encoder_->Create(params) < 0) {
+    if (ring_ctx) encoder_->SetBitstreamRing(&ring_ctx->ring);
+    if (encoder_->Create(&create_params) < 0) {
       LOG(ERROR) << "[EasyDK] [EncodeService] Create(): Create encoder failed";
       delete encoder_;
       return -1;
     }
+    if (ring_ctx) {
+      std::unique_lock<std::mutex> lk(rings_mutex_);
+      rings_[encoder_] = ring_ctx;
+    }
     *venc = encoder_;
     return 0;
   }
@@ -114,6 +297,8 @@ class EncodeService {
     IEncoder *encoder_ = static_cast<IEncoder *>(venc);
     encoder_->Destroy();
     delete encoder_;
+    std::unique_lock<std::mutex> lk(rings_mutex_);
+    rings_.erase(venc);
     return 0;
   }
 
@@ -123,9 +308,26 @@ class EncodeService {
       return -1;
     }
     IEncoder *encoder_ = static_cast<IEncoder *>(venc);
+    if (surf) {
+      std::shared_ptr<RingContext> ring_ctx = GetRing(venc);
+      if (ring_ctx && ring_ctx->ring.AboveWatermark()) {
+        VLOG(4) << "[EasyDK] [EncodeService] SendFrame(): Bitstream ring is above the high watermark";
+        return -2;
+      }
+    }
     return encoder_->SendFrame(surf, timeout_ms);
   }
 
+  BitstreamRing *GetRing(void *venc, const char *func) {
+    std::shared_ptr<RingContext> ring_ctx = GetRing(venc);
+    if (!ring_ctx) {
+      LOG(ERROR) << "[EasyDK] [EncodeService] " << func << "(): The encoder is not created with a bitstream ring";
+      return nullptr;
+    }
+    // the context lives until the encoder is destroyed
+    return &ring_ctx->ring;
+  }
+
  private:
   int CheckParams(CnedkVencCreateParams *params) {
     if (params->type <= CNEDK_VENC_TYPE_INVALID || params->type >= CNEDK_VENC_TYPE_NUM) {
@@ -133,7 +335,8 @@ class EncodeService {
       return -1;
     }
 
-    if (params->OnEos == nullptr || params->OnFrameBits == nullptr || params->OnError == nullptr) {
+    if (params->OnEos == nullptr || (params->OnFrameBits == nullptr && !params->ring_size) ||
+        params->OnError == nullptr) {
       LOG(ERROR) << "[EasyDK] [EncodeService] CheckParams(): OnEos, OnFrameBits or OnError function pointer is invalid";
       return -1;
     }
@@ -146,10 +349,46 @@ class EncodeService {
       return -1;
     }
 
+    if (params->zero_copy) {
+      CnedkPlatformInfo info;
+      if (CnedkPlatformGetInfo(dev_id, &info) < 0 || std::string(info.name) != "MLU370") {
+        LOG(ERROR) << "[EasyDK] [EncodeService] CheckParams(): zero_copy is only supported on MLU370 platform";
+        return -1;
+      }
+    }
+
     // TODO(gaoyujia)
     return 0;
   }
 
+ private:
+  struct RingContext {
+    BitstreamRing ring;
+    CnedkVencCreateParams params;  // the parameters from the user
+  };
+
+  std::shared_ptr<RingContext> GetRing(void *venc) {
+    std::unique_lock<std::mutex> lk(rings_mutex_);
+    auto it = rings_.find(venc);
+    return it == rings_.end() ? nullptr : it->second;
+  }
+
+  static int RingOnFrameBits(CnedkVEncFrameBits *framebits, void *userdata) {
+    return static_cast<RingContext *>(userdata)->ring.Write(*framebits);
+  }
+  static int RingOnEos(void *userdata) {
+    RingContext *ctx = static_cast<RingContext *>(userdata);
+    ctx->ring.SetEos();
+    return ctx->params.OnEos(ctx->params.userdata);
+  }
+  static int RingOnError(int errcode, void *userdata) {
+    RingContext *ctx = static_cast<RingContext *>(userdata);
+    return ctx->params.OnError(errcode, ctx->params.userdata);
+  }
+
+  std::mutex rings_mutex_;
+  std::map<void *, std::shared_ptr<RingContext>> rings_;
+
  private:
   EncodeService(const EncodeService &) = delete;
   EncodeService(EncodeService &&) = delete;
@@ -174,4 +413,43 @@ int CnedkVencDestroy(void *venc) { return cnedk::EncodeService::Instance().Destr
 int CnedkVencSendFrame(void *venc, CnedkBufSurface *surf, int timeout_ms) {
   return cnedk::EncodeService::Instance().SendFrame(venc, surf, timeout_ms);
 }
+int CnedkVencRingGetBuffer(void *venc, const uint8_t **buffer, uint32_t *size) {
+  if (!buffer || !size) {
+    LOG(ERROR) << "[EasyDK] CnedkVencRingGetBuffer(): buffer or size pointer is invalid";
+    return -1;
+  }
+  cnedk::BitstreamRing *ring = cnedk::EncodeService::Instance().GetRing(venc, "CnedkVencRingGetBuffer");
+  if (!ring) return -1;
+  *buffer = ring->Buffer();
+  *size = ring->Size();
+  return 0;
+}
+int CnedkVencRingAddReader(void *venc, int *reader) {
+  if (!reader) {
+    LOG(ERROR) << "[EasyDK] CnedkVencRingAddReader(): reader pointer is invalid";
+    return -1;
+  }
+  cnedk::BitstreamRing *ring = cnedk::EncodeService::Instance().GetRing(venc, "CnedkVencRingAddReader");
+  return ring ? ring->AddReader(reader) : -1;
+}
+int CnedkVencRingRemoveReader(void *venc, int reader) {
+  cnedk::BitstreamRing *ring = cnedk::EncodeService::Instance().GetRing(venc, "CnedkVencRingRemoveReader");
+  return ring ? ring->RemoveReader(reader) : -1;
+}
+int CnedkVencRingRead(void *venc, int reader, CnedkVencRingPacket *packet, int timeout_ms) {
+  if (!packet) {
+    LOG(ERROR) << "[EasyDK] CnedkVencRingRead(): packet pointer is invalid";
+    return -1;
+  }
+  cnedk::BitstreamRing *ring = cnedk::EncodeService::Instance().GetRing(venc, "CnedkVencRingRead");
+  return ring ? ring->Read(reader, packet, timeout_ms) : -1;
+}
+int CnedkVencRingRelease(void *venc, int reader, const CnedkVencRingPacket *packet) {
+  if (!packet) {
+    LOG(ERROR) << "[EasyDK] CnedkVencRingRelease(): packet pointer is invalid";
+    return -1;
+  }
+  cnedk::BitstreamRing *ring = cnedk::EncodeService::Instance().GetRing(venc, "CnedkVencRingRelease");
+  return ring ? ring->Release(reader, packet) : -1;
+}
 };
@@ -21,20 +21,90 @@
 #ifndef CNEDK_ENCODE_IMPL_HPP_
 #define CNEDK_ENCODE_IMPL_HPP_
 
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
 #include "cnedk_encode.h"
 
 namespace cnedk {
 
+class BitstreamRing;
+
 class IEncoder {
  public:
   virtual ~IEncoder() {}
   virtual int Create(CnedkVencCreateParams *params) = 0;
   virtual int Destroy() = 0;
   virtual int SendFrame(CnedkBufSurface *surf, int timeout_ms) = 0;
+  // Sets the bitstream ring the encoder may copy the packets into directly. The packets which are not copied into the
+  // ring are passed to OnFrameBits, which writes them into the ring.
+  void SetBitstreamRing(BitstreamRing *ring) { ring_ = ring; }
+
+ protected:
+  BitstreamRing *ring_ = nullptr;
 };
 
 IEncoder *CreateEncoder();
 
+// The bitstream ring of an encoder. The packets are written contiguously by the callback thread of the encoder, and
+// read by several readers at their own pace. The space of a packet is reused after all of the readers release it.
+// The writer never waits for the readers, a packet is dropped if its space is still held, and the number of dropped
+// packets is reported with the next packet.
+class BitstreamRing {
+ public:
+  int Init(uint32_t size, uint32_t high_watermark, uint32_t low_watermark);
+  const uint8_t *Buffer() const { return buffer_.data(); }
+  uint32_t Size() const { return buffer_.size(); }
+  // Reserves the space of the next packet to be filled without the lock held, there is only one writer. Returns
+  // nullptr and counts the packet as dropped if there is no space. The packet is published by Commit().
+  uint8_t *Reserve(uint32_t len);
+  // Publishes the reserved packet with the information of bits, bits.bits is not used
+  void Commit(const CnedkVEncFrameBits &bits);
+  // Gives up the reserved space, e.g. if the packet cannot be copied into it. The packet is counted as dropped.
+  void Cancel();
+  // Reserve(), copy and Commit()
+  int Write(const CnedkVEncFrameBits &bits);
+  void SetEos();
+  // whether the bytes held by the readers are above the high watermark, until they drop to the low watermark
+  bool AboveWatermark();
+  int AddReader(int *reader);
+  int RemoveReader(int reader);
+  int Read(int reader, CnedkVencRingPacket *packet, int timeout_ms);
+  int Release(int reader, const CnedkVencRingPacket *packet);
+
+ private:
+  struct Entry {
+    CnedkVencRingPacket packet;
+    uint64_t end;  // the logical end position, including the padding before the packet
+  };
+  struct Reader {
+    uint64_t next_seq;
+    uint64_t released;  // the logical position released up to
+  };
+  // the logical position before which the space is free, must be called with mutex_ locked
+  uint64_t Tail() const;
+  void Trim();
+
+  std::vector<uint8_t> buffer_;
+  uint64_t high_watermark_ = 0;
+  uint64_t low_watermark_ = 0;
+  bool above_watermark_ = false;
+  std::deque<Entry> entries_;
+  uint64_t first_seq_ = 0;
+  uint64_t head_ = 0;  // the logical write position, the physical offset is head_ % size
+  uint64_t reserved_start_ = 0;
+  uint64_t reserved_end_ = 0;
+  uint32_t dropped_ = 0;  // the packets dropped since the last packet written
+  std::map<int, Reader> readers_;
+  int next_reader_id_ = 0;
+  bool eos_ = false;
+  std::mutex mutex_;
+  std::condition_variable data_cond_;
+};
+
 }  // namespace cnedk
 
 #endif  // CNEDK_ENCODE_IMPL_HPP_
@@ -0,0 +1,520 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>  // for memset
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+#include "cnrt.h"
+
+#include "cnedk_decode.h"
+#include "cnedk_decode_impl.hpp"
+#include "common/utils.hpp"
+
+namespace cnedk {
+
+// the size classes below the max size, the images are routed to the smallest one which covers them
+static constexpr uint32_t kJpegSizeClasses[][2] = {{1920, 1080}, {3840, 2160}};
+// a decoder is added to a size class when each decoder of the class has this number of images in flight
+static constexpr uint32_t kJpegDecoderBusyImages = 2;
+
+int ParseJpegSize(const uint8_t *data, uint32_t len, uint32_t *width, uint32_t *height) {
+  if (len < 4 || data[0] != 0xFF || data[1] != 0xD8) return -1;
+  uint32_t i = 2;
+  while (i + 4 <= len) {
+    if (data[i] != 0xFF) return -1;
+    uint8_t marker = data[i + 1];
+    if (marker == 0xFF) {  // fill byte
+      ++i;
+      continue;
+    }
+    i += 2;
+    // markers without a segment
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) continue;
+    // the frame header must come before the first scan
+    if (marker == 0xD9 || marker == 0xDA) return -1;
+    uint32_t seg_len = (data[i] << 8) | data[i + 1];
+    if (seg_len < 2 || i + seg_len > len) return -1;
+    // SOF0 ~ SOF15, except DHT, JPG and DAC
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+      if (seg_len < 7) return -1;
+      *height = (data[i + 3] << 8) | data[i + 4];
+      *width = (data[i + 5] << 8) | data[i + 6];
+      return (*width && *height) ? 0 : -1;
+    }
+    i += seg_len;
+  }
+  return -1;
+}
+
+// Decodes JPEG images with pools of decoders, one pool for each size class. The images are queued per class and
+// sent by a few I/O threads to the least loaded decoder of the class, a decoder is added when all of them are busy.
+// The output buffers are allocated in the size of the class and reused: the frame buffers of the decoders are
+// handed out directly on MLU370 and MLU590, and a BufSurface pool is shared by the decoders of a class on CE3226.
+class JpegDecService {
+ public:
+  explicit JpegDecService(const CnedkJpegDecServiceCreateParams &params) : params_(params) {
+    if (!params_.max_width || !params_.max_height) {
+      params_.max_width = 7680;
+      params_.max_height = 4320;
+    }
+    if (!params_.max_decoders) params_.max_decoders = 4;
+    if (!params_.frame_buf_num) params_.frame_buf_num = 8;
+    if (!params_.max_queued_images) params_.max_queued_images = 64;
+    if (!params_.io_thread_num) params_.io_thread_num = 2;
+    if (params_.surf_timeout_ms <= 0) params_.surf_timeout_ms = 5000;
+  }
+
+  ~JpegDecService() {
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      running_ = false;
+    }
+    cond_.notify_all();
+    for (auto &thread : threads_) {
+      if (thread.joinable()) thread.join();
+    }
+    // the remaining frames are output before the decoders are destroyed
+    for (auto &size_class : classes_) {
+      for (auto &decoder : size_class->decoders) {
+        if (decoder->vdec) CnedkVdecDestroy(decoder->vdec);
+        FailImages(&decoder->in_flight);
+      }
+      size_class->decoders.clear();
+      if (size_class->pool) CnedkBufPoolDestroy(size_class->pool);
+    }
+  }
+
+  int Init() {
+    if (params_.color_format != CNEDK_BUF_COLOR_FORMAT_NV12 && params_.color_format != CNEDK_BUF_COLOR_FORMAT_NV21) {
+      LOG(ERROR) << "[EasyDK] [JpegDecService] Init(): Unsupported color format: " << params_.color_format;
+      return -1;
+    }
+    if (!params_.OnImage) {
+      LOG(ERROR) << "[EasyDK] [JpegDecService] Init(): OnImage function pointer is invalid";
+      return -1;
+    }
+    CALL_CNRT_FUNC(cnrtSetDevice(params_.device_id), "[JpegDecService] Init(): set device failed");
+    use_pool_ = IsEdgePlatform(params_.device_id);
+
+    for (auto &size : kJpegSizeClasses) {
+      if (size[0] < params_.max_width && size[1] < params_.max_height) AddSizeClass(size[0], size[1]);
+    }
+    AddSizeClass(params_.max_width, params_.max_height);
+    if (use_pool_) {
+      for (auto &size_class : classes_) {
+        CnedkBufSurfaceCreateParams create_params;
+        memset(&create_params, 0, sizeof(create_params));
+        create_params.mem_type = CNEDK_BUF_MEM_VB_CACHED;
+        create_params.device_id = params_.device_id;
+        create_params.width = size_class->width;
+        create_params.height = size_class->height;
+        create_params.color_format = params_.color_format;
+        create_params.batch_size = 1;
+        if (CnedkBufPoolCreate(&size_class->pool, &create_params, params_.frame_buf_num) < 0) {
+          LOG(ERROR) << "[EasyDK] [JpegDecService] Init(): Create pool failed, size: " << size_class->width << " x "
+                     << size_class->height;
+          return -1;
+        }
+      }
+    }
+
+    running_ = true;
+    for (uint32_t i = 0; i < params_.io_thread_num; ++i) {
+      threads_.emplace_back(&JpegDecService::Loop, this);
+    }
+    return 0;
+  }
+
+  int Submit(const uint8_t *data, uint32_t len, uint64_t tag) {
+    uint32_t width = 0, height = 0;
+    if (ParseJpegSize(data, len, &width, &height) < 0) {
+      LOG(ERROR) << "[EasyDK] [JpegDecService] Submit(): Parse JPEG frame header failed, tag: " << tag;
+      return -1;
+    }
+    auto it = std::find_if(classes_.begin(), classes_.end(), [&](const std::unique_ptr<SizeClass> &size_class) {
+      return width <= size_class->width && height <= size_class->height;
+    });
+    if (it == classes_.end()) {
+      LOG(ERROR) << "[EasyDK] [JpegDecService] Submit(): Image size " << width << " x " << height
+                 << " exceeds the max size, tag: " << tag;
+      return -1;
+    }
+    SizeClass *size_class = it->get();
+
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (queued_images_ >= params_.max_queued_images) {
+      VLOG(4) << "[EasyDK] [JpegDecService] Submit(): The queue is full";
+      return -2;
+    }
+    ++queued_images_;
+    lk.unlock();
+
+    // copy the data out of the lock
+    Image image;
+    image.data.assign(data, data + len);
+    image.tag = tag;
+
+    lk.lock();
+    if (!size_class->max_decoders) {
+      --queued_images_;
+      LOG(ERROR) << "[EasyDK] [JpegDecService] Submit(): No decoder could be created for the image, tag: " << tag;
+      return -1;
+    }
+    image.seq = next_seq_++;
+    size_class->images.push_back(std::move(image));
+    cond_.notify_one();
+    return 0;
+  }
+
+ private:
+  struct Image {
+    std::vector<uint8_t> data;
+    uint64_t tag = 0;
+    uint64_t seq = 0;
+  };
+
+  struct SizeClass;
+
+  struct Decoder {
+    JpegDecService *service = nullptr;
+    SizeClass *size_class = nullptr;
+    void *vdec = nullptr;
+    // the sequence numbers and tags of the images sent and not output, in decoding order
+    std::deque<std::pair<uint64_t, uint64_t>> in_flight;
+    bool busy = false;  // being created or sent to by an I/O thread
+    bool broken = false;
+  };
+
+  struct SizeClass {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t max_decoders = 0;
+    void *pool = nullptr;
+    std::deque<Image> images;
+    std::vector<std::unique_ptr<Decoder>> decoders;
+  };
+
+  void AddSizeClass(uint32_t width, uint32_t height) {
+    classes_.emplace_back(new SizeClass);
+    classes_.back()->width = width;
+    classes_.back()->height = height;
+    classes_.back()->max_decoders = params_.max_decoders;
+  }
+
+  // Picks a size class with queued images and the decoder to send to, which is nullptr if a decoder should be added.
+  // Must be called with mutex_ locked.
+  bool Pick(SizeClass **picked_class, Decoder **picked_decoder) {
+    for (size_t n = 0; n < classes_.size(); ++n) {
+      SizeClass *size_class = classes_[(next_class_ + n) % classes_.size()].get();
+      if (size_class->images.empty()) continue;
+      Decoder *least_loaded = nullptr;
+      for (auto &decoder : size_class->decoders) {
+        if (decoder->busy || decoder->broken) continue;
+        if (!least_loaded || decoder->in_flight.size() < least_loaded->in_flight.size()) {
+          least_loaded = decoder.get();
+        }
+      }
+      bool can_grow = size_class->decoders.size() < size_class->max_decoders;
+      if (!least_loaded && !can_grow) continue;
+      if (least_loaded && least_loaded->in_flight.size() >= kJpegDecoderBusyImages && can_grow) {
+        least_loaded = nullptr;
+      }
+      next_class_ = (next_class_ + n + 1) % classes_.size();
+      *picked_class = size_class;
+      *picked_decoder = least_loaded;
+      return true;
+    }
+    return false;
+  }
+
+  void Loop() {
+    CALL_CNRT_FUNC(cnrtSetDevice(params_.device_id), "[JpegDecService] Loop(): set device failed");
+    std::unique_lock<std::mutex> lk(mutex_);
+    while (true) {
+      RetireBrokenDecoders(&lk);
+      SizeClass *size_class = nullptr;
+      Decoder *decoder = nullptr;
+      if (!Pick(&size_class, &decoder)) {
+        if (!running_ && !queued_images_) break;
+        cond_.wait(lk);
+        continue;
+      }
+
+      if (!decoder) {
+        size_class->decoders.emplace_back(new Decoder);
+        decoder = size_class->decoders.back().get();
+        decoder->service = this;
+        decoder->size_class = size_class;
+        decoder->busy = true;
+        lk.unlock();
+        int ret = CreateDecoder(decoder);
+        lk.lock();
+        decoder->busy = false;
+        if (ret < 0) {
+          // stop growing, and the pending images of the class fail if it has no decoder at all
+          decoder->broken = true;
+          size_class->max_decoders = size_class->decoders.size() - 1;
+          if (!size_class->max_decoders) {
+            std::deque<Image> images;
+            images.swap(size_class->images);
+            queued_images_ -= images.size();
+            lk.unlock();
+            for (auto &image : images) params_.OnImage(nullptr, image.tag, -1, params_.userdata);
+            lk.lock();
+          }
+        }
+        cond_.notify_all();
+        continue;
+      }
+
+      Image image = std::move(size_class->images.front());
+      size_class->images.pop_front();
+      decoder->busy = true;
+      decoder->in_flight.emplace_back(image.seq, image.tag);
+      lk.unlock();
+
+      CnedkVdecStream packet;
+      memset(&packet, 0, sizeof(packet));
+      packet.bits = image.data.data();
+      packet.len = image.data.size();
+      packet.pts = image.seq;
+      int ret = VdecTrySendStream(decoder->vdec, &packet, 100);
+
+      lk.lock();
+      decoder->busy = false;
+      if (ret == 0) {
+        --queued_images_;
+        cond_.notify_all();
+        continue;
+      }
+      auto it = std::find_if(decoder->in_flight.begin(), decoder->in_flight.end(),
+                             [&image](const std::pair<uint64_t, uint64_t> &item) { return item.first == image.seq; });
+      if (it != decoder->in_flight.end()) decoder->in_flight.erase(it);
+      if (ret == -2) {
+        // the decoder is full, the image is sent again, maybe to another decoder
+        size_class->images.push_front(std::move(image));
+        cond_.notify_all();
+        continue;
+      }
+      // -3 means the image is corrupt, the decoder is still usable
+      if (ret != -3) decoder->broken = true;
+      --queued_images_;
+      cond_.notify_all();
+      lk.unlock();
+      LOG(ERROR) << "[EasyDK] [JpegDecService] Loop(): Send image failed, tag: " << image.tag << ", ret = " << ret;
+      params_.OnImage(nullptr, image.tag, ret, params_.userdata);
+      lk.lock();
+    }
+  }
+
+  int CreateDecoder(Decoder *decoder) {
+    CnedkVdecCreateParams create_params;
+    memset(&create_params, 0, sizeof(create_params));
+    create_params.device_id = params_.device_id;
+    create_params.type = CNEDK_VDEC_TYPE_JPEG;
+    create_params.color_format = params_.color_format;
+    create_params.max_width = decoder->size_class->width;
+    create_params.max_height = decoder->size_class->height;
+    create_params.frame_buf_num = params_.frame_buf_num;
+    create_params.surf_timeout_ms = params_.surf_timeout_ms;
+    create_params.zero_copy = !use_pool_;
+    create_params.GetBufSurf = use_pool_ ? GetBufSurf_ : nullptr;
+    create_params.OnFrame = OnFrame_;
+    create_params.OnEos = OnEos_;
+    create_params.OnError = OnError_;
+    create_params.userdata = decoder;
+    if (CnedkVdecCreate(&decoder->vdec, &create_params) < 0) {
+      LOG(ERROR) << "[EasyDK] [JpegDecService] CreateDecoder(): Create decoder failed, size: "
+                 << decoder->size_class->width << " x " << decoder->size_class->height;
+      decoder->vdec = nullptr;
+      return -1;
+    }
+    VLOG(2) << "[EasyDK] [JpegDecService] CreateDecoder(): Decoder added, size: " << decoder->size_class->width
+            << " x " << decoder->size_class->height;
+    return 0;
+  }
+
+  // Destroys the broken decoders which are not busy, the images in flight fail. Must be called with mutex_ locked.
+  void RetireBrokenDecoders(std::unique_lock<std::mutex> *lk) {
+    std::vector<std::unique_ptr<Decoder>> retired;
+    for (auto &size_class : classes_) {
+      auto &decoders = size_class->decoders;
+      auto it = std::stable_partition(decoders.begin(), decoders.end(), [](const std::unique_ptr<Decoder> &decoder) {
+        return !decoder->broken || decoder->busy;
+      });
+      std::move(it, decoders.end(), std::back_inserter(retired));
+      decoders.erase(it, decoders.end());
+    }
+    if (retired.empty()) return;
+    lk->unlock();
+    for (auto &decoder : retired) {
+      if (decoder->vdec) CnedkVdecDestroy(decoder->vdec);
+      // no more callbacks from the decoder
+      FailImages(&decoder->in_flight);
+    }
+    lk->lock();
+  }
+
+  void FailImages(std::deque<std::pair<uint64_t, uint64_t>> *images) {
+    for (auto &item : *images) params_.OnImage(nullptr, item.second, -1, params_.userdata);
+    images->clear();
+  }
+
+  int GetBufSurf(Decoder *decoder, CnedkBufSurface **surf, int width, int height, int timeout_ms) {
+    auto start = std::chrono::steady_clock::now();
+    while (CnedkBufSurfaceCreateFromPool(surf, decoder->size_class->pool) < 0) {
+      if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(timeout_ms)) {
+        LOG(ERROR) << "[EasyDK] [JpegDecService] GetBufSurf(): Get BufSurface from pool timeout";
+        return -1;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // the buffer is in the size of the class, the pitches and offsets are kept
+    CnedkBufSurfaceParams &params = (*surf)->surface_list[0];
+    params.width = width;
+    params.height = height;
+    params.plane_params.width[0] = params.plane_params.width[1] = width;
+    params.plane_params.height[0] = height;
+    params.plane_params.height[1] = height / 2;
+    return 0;
+  }
+
+  int OnFrame(Decoder *decoder, CnedkBufSurface *surf) {
+    std::vector<uint64_t> lost;
+    bool found = false;
+    uint64_t tag = 0;
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      // the images are output in decoding order, the ones sent before this frame are dropped by the decoder
+      auto &in_flight = decoder->in_flight;
+      auto it = std::find_if(in_flight.begin(), in_flight.end(),
+                             [surf](const std::pair<uint64_t, uint64_t> &item) { return item.first == surf->pts; });
+      if (it != in_flight.end()) {
+        found = true;
+        tag = it->second;
+        for (auto lost_it = in_flight.begin(); lost_it != it; ++lost_it) lost.push_back(lost_it->second);
+        in_flight.erase(in_flight.begin(), it + 1);
+      }
+    }
+    cond_.notify_all();
+    for (uint64_t lost_tag : lost) {
+      LOG(ERROR) << "[EasyDK] [JpegDecService] OnFrame(): Image is not decoded, tag: " << lost_tag;
+      params_.OnImage(nullptr, lost_tag, -1, params_.userdata);
+    }
+    if (!found) {
+      LOG(ERROR) << "[EasyDK] [JpegDecService] OnFrame(): Unknown frame, pts: " << surf->pts;
+      CnedkBufSurfaceDestroy(surf);
+      return -1;
+    }
+    return params_.OnImage(surf, tag, 0, params_.userdata);
+  }
+
+  void OnError(Decoder *decoder, int errcode) {
+    // -3 is returned by VdecTrySendStream() as well and handled there
+    if (errcode == -3) return;
+    LOG(ERROR) << "[EasyDK] [JpegDecService] OnError(): Decoder error, it will be replaced, errcode: " << errcode;
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      decoder->broken = true;
+    }
+    cond_.notify_all();
+  }
+
+  static int GetBufSurf_(CnedkBufSurface **surf, int width, int height, CnedkBufSurfaceColorFormat fmt,
+                         int timeout_ms, void *userdata) {
+    Decoder *decoder = static_cast<Decoder *>(userdata);
+    return decoder->service->GetBufSurf(decoder, surf, width, height, timeout_ms);
+  }
+  static int OnFrame_(CnedkBufSurface *surf, void *userdata) {
+    Decoder *decoder = static_cast<Decoder *>(userdata);
+    return decoder->service->OnFrame(decoder, surf);
+  }
+  static int OnEos_(void *userdata) { return 0; }
+  static int OnError_(int errcode, void *userdata) {
+    Decoder *decoder = static_cast<Decoder *>(userdata);
+    decoder->service->OnError(decoder, errcode);
+    return 0;
+  }
+
+  CnedkJpegDecServiceCreateParams params_;
+  bool use_pool_ = false;
+  std::vector<std::unique_ptr<SizeClass>> classes_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::vector<std::thread> threads_;
+  uint32_t queued_images_ = 0;
+  uint64_t next_seq_ = 0;
+  size_t next_class_ = 0;
+  bool running_ = false;
+};  // class JpegDecService
+
+}  // namespace cnedk
+
+extern "C" {
+
+int CnedkJpegGetImageSize(const uint8_t *data, uint32_t len, uint32_t *width, uint32_t *height) {
+  if (!data || !width || !height) {
+    LOG(ERROR) << "[EasyDK] CnedkJpegGetImageSize(): data, width or height pointer is invalid";
+    return -1;
+  }
+  return cnedk::ParseJpegSize(data, len, width, height);
+}
+
+int CnedkJpegDecServiceCreate(void **service, CnedkJpegDecServiceCreateParams *params) {
+  if (!service || !params) {
+    LOG(ERROR) << "[EasyDK] CnedkJpegDecServiceCreate(): service or params pointer is invalid";
+    return -1;
+  }
+  std::unique_ptr<cnedk::JpegDecService> jpeg_service(new cnedk::JpegDecService(*params));
+  if (jpeg_service->Init() < 0) {
+    LOG(ERROR) << "[EasyDK] CnedkJpegDecServiceCreate(): Create JPEG decode service failed";
+    return -1;
+  }
+  *service = jpeg_service.release();
+  return 0;
+}
+
+int CnedkJpegDecServiceDestroy(void *service) {
+  if (!service) {
+    LOG(ERROR) << "[EasyDK] CnedkJpegDecServiceDestroy(): service pointer is invalid";
+    return -1;
+  }
+  delete static_cast<cnedk::JpegDecService *>(service);
+  return 0;
+}
+
+int CnedkJpegDecServiceSubmit(void *service, const uint8_t *data, uint32_t len, uint64_t tag) {
+  if (!service || !data) {
+    LOG(ERROR) << "[EasyDK] CnedkJpegDecServiceSubmit(): service or data pointer is invalid";
+    return -1;
+  }
+  return static_cast<cnedk::JpegDecService *>(service)->Submit(data, len, tag);
+}
+
+};  // extern "C"
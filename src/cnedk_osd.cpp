@@ -20,8 +20,13 @@
 
 #include "cnedk_osd.h"
 
+#include <memory>
+#include <vector>
+
 #include "glog/logging.h"
 #include "common/utils.hpp"
+#include "cnedk_osd_cpu.hpp"
+#include "cnedk_osd_font.hpp"
 
 #ifdef PLATFORM_CE3226
 #include "ce3226/cnedk_osd_impl_ce3226.hpp"
@@ -32,38 +37,137 @@ extern "C" {
 #endif
 
 int CnedkDrawRect(CnedkBufSurface *surf, CnedkOsdRectParams *params, uint32_t num) {
-  if (surf->mem_type != CNEDK_BUF_MEM_VB && surf->mem_type != CNEDK_BUF_MEM_VB_CACHED) {
-    LOG(ERROR) << "[EasyDK] CnedkDrawRect(): Unsupported memory type: " << surf->mem_type;
+  if (!surf || (!params && num)) {
+    LOG(ERROR) << "[EasyDK] CnedkDrawRect(): surf or params is nullptr";
     return -1;
   }
 #ifdef PLATFORM_CE3226
-  return cnedk::DrawRectCe3226(surf, params, num);
+  if (surf->mem_type == CNEDK_BUF_MEM_VB || surf->mem_type == CNEDK_BUF_MEM_VB_CACHED) {
+    return cnedk::DrawRectCe3226(surf, params, num);
+  }
 #endif
+  if (cnedk::OsdCpuSupported(surf)) {
+    return cnedk::DrawRectCpu(surf, params, num);
+  }
+  LOG(ERROR) << "[EasyDK] CnedkDrawRect(): Unsupported memory type: " << surf->mem_type;
   return -1;
 }
 
 int CnedkFillRect(CnedkBufSurface *surf, CnedkOsdRectParams *params, uint32_t num) {
-  if (surf->mem_type != CNEDK_BUF_MEM_VB && surf->mem_type != CNEDK_BUF_MEM_VB_CACHED) {
-    LOG(ERROR) << "[EasyDK] CnedkFillRect(): Unsupported memory type: " << surf->mem_type;
+  if (!surf || (!params && num)) {
+    LOG(ERROR) << "[EasyDK] CnedkFillRect(): surf or params is nullptr";
     return -1;
   }
 #ifdef PLATFORM_CE3226
-  return cnedk::FillRectCe3226(surf, params, num);
+  if (surf->mem_type == CNEDK_BUF_MEM_VB || surf->mem_type == CNEDK_BUF_MEM_VB_CACHED) {
+    return cnedk::FillRectCe3226(surf, params, num);
+  }
 #endif
+  if (cnedk::OsdCpuSupported(surf)) {
+    return cnedk::FillRectCpu(surf, params, num);
+  }
+  LOG(ERROR) << "[EasyDK] CnedkFillRect(): Unsupported memory type: " << surf->mem_type;
   return -1;
 }
 
 int CnedkDrawBitmap(CnedkBufSurface *surf, CnedkOsdBitmapParams *params, uint32_t num) {
-  if (surf->mem_type != CNEDK_BUF_MEM_VB && surf->mem_type != CNEDK_BUF_MEM_VB_CACHED) {
-    LOG(ERROR) << "[EasyDK] CnedkDrawBitmap(): Unsupported memory type: " << surf->mem_type;
+  if (!surf || (!params && num)) {
+    LOG(ERROR) << "[EasyDK] CnedkDrawBitmap(): surf or params is nullptr";
     return -1;
   }
 #ifdef PLATFORM_CE3226
-  return cnedk::DrawBitmapCe3226(surf, params, num);
+  if (surf->mem_type == CNEDK_BUF_MEM_VB || surf->mem_type == CNEDK_BUF_MEM_VB_CACHED) {
+    return cnedk::DrawBitmapCe3226(surf, params, num);
+  }
 #endif
+  if (cnedk::OsdCpuSupported(surf)) {
+    return cnedk::DrawBitmapCpu(surf, params, num);
+  }
+  LOG(ERROR) << "[EasyDK] CnedkDrawBitmap(): Unsupported memory type: " << surf->mem_type;
   return -1;
 }
 
+int CnedkOsdDrawBatch(CnedkOsdBatchItem *items, uint32_t num) {
+  if (!items && num) {
+    LOG(ERROR) << "[EasyDK] CnedkOsdDrawBatch(): items is nullptr";
+    return -1;
+  }
+  std::vector<CnedkOsdBatchItem> cpu_items;
+#ifdef PLATFORM_CE3226
+  std::vector<CnedkOsdBatchItem> vb_items;
+#endif
+  for (uint32_t i = 0; i < num; i++) {
+    CnedkOsdBatchItem &item = items[i];
+    if (!item.surf || (!item.rects && item.num_rects) || (!item.fill_rects && item.num_fill_rects) ||
+        (!item.bitmaps && item.num_bitmaps)) {
+      LOG(ERROR) << "[EasyDK] CnedkOsdDrawBatch(): surf or params of item " << i << " is nullptr";
+      return -1;
+    }
+#ifdef PLATFORM_CE3226
+    if (item.surf->mem_type == CNEDK_BUF_MEM_VB || item.surf->mem_type == CNEDK_BUF_MEM_VB_CACHED) {
+      vb_items.push_back(item);
+      continue;
+    }
+#endif
+    if (!cnedk::OsdCpuSupported(item.surf)) {
+      LOG(ERROR) << "[EasyDK] CnedkOsdDrawBatch(): Unsupported memory type: " << item.surf->mem_type;
+      return -1;
+    }
+    cpu_items.push_back(item);
+  }
+
+  int ret = 0;
+#ifdef PLATFORM_CE3226
+  if (!vb_items.empty() && cnedk::DrawBatchCe3226(vb_items.data(), vb_items.size()) < 0) ret = -1;
+#endif
+  if (!cpu_items.empty() && cnedk::DrawBatchCpu(cpu_items.data(), cpu_items.size()) < 0) ret = -1;
+  return ret;
+}
+
+int CnedkOsdFontCreate(void **font, CnedkOsdFontCreateParams *params) {
+  if (!font || !params) {
+    LOG(ERROR) << "[EasyDK] CnedkOsdFontCreate(): font or params pointer is invalid";
+    return -1;
+  }
+  std::unique_ptr<cnedk::OsdFont> osd_font(new cnedk::OsdFont(*params));
+  if (osd_font->Init() < 0) {
+    LOG(ERROR) << "[EasyDK] CnedkOsdFontCreate(): Create font failed";
+    return -1;
+  }
+  *font = osd_font.release();
+  return 0;
+}
+
+int CnedkOsdFontDestroy(void *font) {
+  if (!font) {
+    LOG(ERROR) << "[EasyDK] CnedkOsdFontDestroy(): font pointer is invalid";
+    return -1;
+  }
+  delete static_cast<cnedk::OsdFont *>(font);
+  return 0;
+}
+
+int CnedkOsdGetTextSize(void *font, const char *text, int *w, int *h) {
+  if (!font || !text || !w || !h) {
+    LOG(ERROR) << "[EasyDK] CnedkOsdGetTextSize(): font, text, w or h pointer is invalid";
+    return -1;
+  }
+  static_cast<cnedk::OsdFont *>(font)->GetTextSize(text, w, h);
+  return 0;
+}
+
+int CnedkDrawText(CnedkBufSurface *surf, void *font, CnedkOsdTextParams *params, uint32_t num) {
+  if (!surf || !font || (!params && num)) {
+    LOG(ERROR) << "[EasyDK] CnedkDrawText(): surf, font or params is nullptr";
+    return -1;
+  }
+  if (!cnedk::OsdCpuSupported(surf)) {
+    LOG(ERROR) << "[EasyDK] CnedkDrawText(): Unsupported memory type: " << surf->mem_type;
+    return -1;
+  }
+  return cnedk::DrawTextCpu(surf, static_cast<cnedk::OsdFont *>(font), params, num);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,234 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include "cnedk_trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace cnedk {
+
+namespace {
+constexpr uint32_t kDefaultRingSize = 4096;
+constexpr size_t kMaxNameLen = 32;
+}  // namespace
+
+class Tracer {
+ public:
+  static Tracer &Instance() {
+    static std::once_flag s_flag;
+    std::call_once(s_flag, [&] { instance_.reset(new Tracer); });
+    return *instance_;
+  }
+
+  int Start(const CnedkTraceParams *params) {
+    if (!params) {
+      LOG(ERROR) << "[EasyDK] [Tracer] Start(): params is nullptr";
+      return -1;
+    }
+    std::unique_lock<std::mutex> lk(rings_mutex_);
+    rings_.clear();
+    ring_size_ = params->ring_size ? params->ring_size : kDefaultRingSize;
+    interval_ = params->sample_interval ? params->sample_interval : 1;
+    frame_count_ = 0;
+    // rings of the last run are dropped by the recording threads the next time they record
+    ++generation_;
+    enabled_ = true;
+    return 0;
+  }
+
+  int Stop() {
+    enabled_ = false;
+    return 0;
+  }
+
+  uint64_t NewId() {
+    if (!enabled_) return 0;
+    uint64_t count = frame_count_.fetch_add(1);
+    if (count % interval_ != 0) return 0;
+    return count + 1;
+  }
+
+  int Record(uint64_t trace_id, const char *name, uint64_t begin_ns, uint64_t end_ns) {
+    if (!name) {
+      LOG(ERROR) << "[EasyDK] [Tracer] Record(): name is nullptr";
+      return -1;
+    }
+    if (!trace_id || !enabled_) return 0;
+    Ring *ring = GetRing();
+    // only contended by Export()
+    std::unique_lock<std::mutex> lk(ring->mutex);
+    Span &span = ring->spans[ring->written % ring->spans.size()];
+    span.trace_id = trace_id;
+    span.begin_ns = begin_ns;
+    span.end_ns = end_ns;
+    strncpy(span.name, name, kMaxNameLen - 1);
+    span.name[kMaxNameLen - 1] = '\0';
+    ++ring->written;
+    return 0;
+  }
+
+  int Export(const char *path) {
+    if (!path) {
+      LOG(ERROR) << "[EasyDK] [Tracer] Export(): path is nullptr";
+      return -1;
+    }
+    std::vector<std::pair<size_t, Span>> spans;
+    {
+      std::unique_lock<std::mutex> lk(rings_mutex_);
+      for (size_t tid = 0; tid < rings_.size(); ++tid) {
+        Ring *ring = rings_[tid].get();
+        std::unique_lock<std::mutex> ring_lk(ring->mutex);
+        uint64_t size = ring->spans.size();
+        uint64_t first = ring->written > size ? ring->written - size : 0;
+        for (uint64_t i = first; i < ring->written; ++i) {
+          spans.emplace_back(tid, ring->spans[i % size]);
+        }
+      }
+    }
+    FILE *file = fopen(path, "w");
+    if (!file) {
+      LOG(ERROR) << "[EasyDK] [Tracer] Export(): Open " << path << " failed, " << strerror(errno);
+      return -1;
+    }
+    uint64_t epoch = UINT64_MAX;
+    for (auto &it : spans) epoch = std::min(epoch, it.second.begin_ns);
+    fprintf(file, "{\"traceEvents\":[");
+    bool first = true;
+    for (auto &it : spans) {
+      const Span &span = it.second;
+      std::string name = Escape(span.name);
+      // async events, so that the spans of a frame are shown on one track whichever thread recorded them
+      fprintf(file,
+              "%s\n{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"b\",\"id\":\"0x%" PRIx64
+              "\",\"pid\":0,\"tid\":%zu,\"ts\":%.3f},"
+              "\n{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"e\",\"id\":\"0x%" PRIx64
+              "\",\"pid\":0,\"tid\":%zu,\"ts\":%.3f}",
+              first ? "" : ",", name.c_str(), span.trace_id, it.first, (span.begin_ns - epoch) / 1e3, name.c_str(),
+              span.trace_id, it.first, (std::max(span.end_ns, span.begin_ns) - epoch) / 1e3);
+      first = false;
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    if (fclose(file) != 0) {
+      LOG(ERROR) << "[EasyDK] [Tracer] Export(): Write " << path << " failed, " << strerror(errno);
+      return -1;
+    }
+    return 0;
+  }
+
+ private:
+  Tracer(const Tracer &) = delete;
+  Tracer(Tracer &&) = delete;
+  Tracer &operator=(const Tracer &) = delete;
+  Tracer &operator=(Tracer &&) = delete;
+  Tracer() = default;
+
+  struct Span {
+    uint64_t trace_id;
+    uint64_t begin_ns;
+    uint64_t end_ns;
+    char name[kMaxNameLen];
+  };
+
+  struct Ring {
+    std::mutex mutex;
+    std::vector<Span> spans;
+    uint64_t written = 0;
+  };
+
+  Ring *GetRing() {
+    struct LocalRing {
+      std::shared_ptr<Ring> ring;
+      uint64_t generation = 0;
+    };
+    thread_local LocalRing local;
+    uint64_t generation = generation_;
+    if (!local.ring || local.generation != generation) {
+      std::unique_lock<std::mutex> lk(rings_mutex_);
+      local.ring = std::make_shared<Ring>();
+      local.ring->spans.resize(ring_size_);
+      local.generation = generation_;
+      rings_.push_back(local.ring);
+    }
+    return local.ring.get();
+  }
+
+  static std::string Escape(const char *str) {
+    std::string ret;
+    for (; *str; ++str) {
+      if (*str == '"' || *str == '\\') {
+        ret += '\\';
+        ret += *str;
+      } else if (static_cast<unsigned char>(*str) < 0x20) {
+        ret += ' ';
+      } else {
+        ret += *str;
+      }
+    }
+    return ret;
+  }
+
+ private:
+  std::atomic<bool> enabled_{false};
+  std::atomic<uint32_t> interval_{1};
+  std::atomic<uint64_t> frame_count_{0};
+  std::atomic<uint64_t> generation_{0};
+  std::mutex rings_mutex_;
+  uint32_t ring_size_ = kDefaultRingSize;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  static std::unique_ptr<Tracer> instance_;
+};
+
+std::unique_ptr<Tracer> Tracer::instance_;
+
+}  // namespace cnedk
+
+extern "C" {
+
+int CnedkTraceStart(const CnedkTraceParams *params) { return cnedk::Tracer::Instance().Start(params); }
+
+int CnedkTraceStop(void) { return cnedk::Tracer::Instance().Stop(); }
+
+uint64_t CnedkTraceNewId(void) { return cnedk::Tracer::Instance().NewId(); }
+
+uint64_t CnedkTraceNow(void) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+int CnedkTraceRecord(uint64_t trace_id, const char *name, uint64_t begin_ns, uint64_t end_ns) {
+  return cnedk::Tracer::Instance().Record(trace_id, name, begin_ns, end_ns);
+}
+
+int CnedkTraceExport(const char *path) { return cnedk::Tracer::Instance().Export(path); }
+
+}  // extern "C"
@@ -21,9 +21,11 @@
 #include "cnedk_transform.h"
 
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "cnrt.h"
 
@@ -42,6 +44,8 @@
 #include "mlu590/cnedk_transform_impl_mlu590.hpp"
 #endif
 
+#include "transform_cpu/cnedk_transform_cpu.hpp"
+
 #include "common/utils.hpp"
 
 namespace cnedk {
@@ -78,6 +82,47 @@ ITransformer *CreateTransformer() {
   return nullptr;
 }
 
+int ITransformPlan::Execute(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) {
+  if (!src || !dst || !transform_params || !src->surface_list || !dst->surface_list) {
+    LOG(ERROR) << "[EasyDK] [ITransformPlan] Execute(): src, dst BufSurface or parameters pointer is invalid";
+    return -1;
+  }
+  if (src->batch_size > params_.batch_size) {
+    LOG(ERROR) << "[EasyDK] [ITransformPlan] Execute(): The batch size of src exceeds the plan: " << src->batch_size
+               << " v.s. " << params_.batch_size;
+    return -1;
+  }
+  if ((transform_params->transform_flag & CNEDK_TRANSFORM_MEAN_STD) !=
+      (params_.transform_flag & CNEDK_TRANSFORM_MEAN_STD)) {
+    LOG(ERROR) << "[EasyDK] [ITransformPlan] Execute(): CNEDK_TRANSFORM_MEAN_STD does not match the plan";
+    return -1;
+  }
+  for (uint32_t i = 0; i < src->batch_size; ++i) {
+    const CnedkBufSurfaceParams &params = src->surface_list[i];
+    if (params.color_format != params_.src_format || (params_.src_width && params.width != params_.src_width) ||
+        (params_.src_height && params.height != params_.src_height)) {
+      LOG(ERROR) << "[EasyDK] [ITransformPlan] Execute(): src " << i << " does not match the plan";
+      return -1;
+    }
+  }
+  for (uint32_t i = 0; i < dst->batch_size; ++i) {
+    const CnedkBufSurfaceParams &params = dst->surface_list[i];
+    if (params.color_format != params_.dst_format) {
+      LOG(ERROR) << "[EasyDK] [ITransformPlan] Execute(): dst " << i << " does not match the plan";
+      return -1;
+    }
+    if (params_.dst_format == CNEDK_BUF_COLOR_FORMAT_TENSOR) continue;
+    if ((params_.dst_width && params.width != params_.dst_width) ||
+        (params_.dst_height && params.height != params_.dst_height)) {
+      LOG(ERROR) << "[EasyDK] [ITransformPlan] Execute(): dst " << i << " does not match the plan";
+      return -1;
+    }
+  }
+  CnedkTransformParams run_params = *transform_params;
+  run_params.dst_desc = params_.dst_desc;
+  return Run(src, dst, &run_params);
+}
+
 class TransformService {
  public:
   static TransformService &Instance() {
@@ -92,7 +137,7 @@ class TransformService {
       LOG(ERROR) << "[EasyDK] [TransformService] SetSessionParams(): Parameters pointer is invalid";
       return -1;
     }
-    return transformer_->SetSessionParams(config_params);
+    return GetTransformer()->SetSessionParams(config_params);
   }
 
   int GetSessionParams(CnedkTransformConfigParams *config_params) {
@@ -100,7 +145,7 @@ class TransformService {
       LOG(ERROR) << "[EasyDK] [TransformService] GetSessionParams(): Parameters pointer is invalid";
       return -1;
     }
-    return transformer_->GetSessionParams(config_params);
+    return GetTransformer()->GetSessionParams(config_params);
   }
 
   int Transform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) {
@@ -108,7 +153,102 @@ class TransformService {
       LOG(ERROR) << "[EasyDK] [TransformService] Transform(): src, dst BufSurface or parameters pointer is invalid";
       return -1;
     }
-    return transformer_->Transform(src, dst, transform_params);
+    if (ITransformer::GetComputeMode() == CNEDK_TRANSFORM_COMPUTE_CPU) {
+      return cpu_transformer_->Transform(src, dst, transform_params);
+    }
+    return GetTransformer()->Transform(src, dst, transform_params);
+  }
+
+  int TransformRoi(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformRoiParams *roi_params) {
+    if (!dst || !src || !roi_params) {
+      LOG(ERROR) << "[EasyDK] [TransformService] TransformRoi(): src, dst BufSurface or parameters pointer is invalid";
+      return -1;
+    }
+    if (!roi_params->rois || !roi_params->num_rois || !roi_params->dst_desc) {
+      LOG(ERROR) << "[EasyDK] [TransformService] TransformRoi(): rois or dst_desc is not set";
+      return -1;
+    }
+    if (roi_params->num_rois > dst->batch_size) {
+      LOG(ERROR) << "[EasyDK] [TransformService] TransformRoi(): The number of rois exceeds batch size: "
+                 << roi_params->num_rois << " v.s. " << dst->batch_size;
+      return -1;
+    }
+    for (uint32_t i = 0; i < roi_params->num_rois; ++i) {
+      if (roi_params->rois[i].src_index >= src->batch_size) {
+        LOG(ERROR) << "[EasyDK] [TransformService] TransformRoi(): src_index of roi " << i << " is out of range";
+        return -1;
+      }
+    }
+    if (ITransformer::GetComputeMode() == CNEDK_TRANSFORM_COMPUTE_CPU) {
+      return cpu_transformer_->TransformRoi(src, dst, roi_params);
+    }
+    return GetTransformer()->TransformRoi(src, dst, roi_params);
+  }
+
+  int CreatePlan(void **plan, CnedkTransformPlanParams *params) {
+    if (!plan || !params) {
+      LOG(ERROR) << "[EasyDK] [TransformService] CreatePlan(): plan or parameters pointer is invalid";
+      return -1;
+    }
+    if (!params->batch_size) {
+      LOG(ERROR) << "[EasyDK] [TransformService] CreatePlan(): batch_size is 0";
+      return -1;
+    }
+    if (params->dst_format == CNEDK_BUF_COLOR_FORMAT_TENSOR && !params->dst_desc) {
+      LOG(ERROR) << "[EasyDK] [TransformService] CreatePlan(): dst_desc is needed when dst is tensor";
+      return -1;
+    }
+    int dev_id = 0;
+    CNRT_SAFECALL(cnrtGetDevice(&dev_id), "[TransformService] CreatePlan(): get device failed", -1);
+    CnedkTransformComputeMode mode = ITransformer::GetComputeMode();
+
+    // plans of the same parameters on the same device and compute mode are shared
+    std::vector<uint32_t> key = {static_cast<uint32_t>(dev_id), static_cast<uint32_t>(mode),
+                                 static_cast<uint32_t>(params->src_format), static_cast<uint32_t>(params->dst_format),
+                                 params->batch_size, params->src_width, params->src_height, params->dst_width,
+                                 params->dst_height, params->transform_flag & CNEDK_TRANSFORM_MEAN_STD};
+    if (params->dst_desc) {
+      const CnedkTransformTensorDesc &desc = *params->dst_desc;
+      key.insert(key.end(), {static_cast<uint32_t>(desc.color_format), static_cast<uint32_t>(desc.data_type),
+                             desc.shape.n, desc.shape.c, desc.shape.h, desc.shape.w});
+    }
+
+    std::unique_lock<std::mutex> lk(plan_mutex_);
+    std::shared_ptr<ITransformPlan> shared = plans_[key].lock();
+    if (!shared) {
+      ITransformer *transformer = mode == CNEDK_TRANSFORM_COMPUTE_CPU ? cpu_transformer_.get() : GetTransformer();
+      ITransformPlan *created = transformer->CreatePlan(*params);
+      if (!created) {
+        plans_.erase(key);
+        LOG(ERROR) << "[EasyDK] [TransformService] CreatePlan(): The parameters are not supported";
+        return -1;
+      }
+      shared.reset(created);
+      plans_[key] = shared;
+    }
+    // drop the entries of destroyed plans
+    for (auto it = plans_.begin(); it != plans_.end();) {
+      it = it->second.expired() ? plans_.erase(it) : std::next(it);
+    }
+    *plan = new TransformPlanHandle{shared};
+    return 0;
+  }
+
+  int ExecutePlan(void *plan, CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) {
+    if (!plan) {
+      LOG(ERROR) << "[EasyDK] [TransformService] ExecutePlan(): plan is invalid";
+      return -1;
+    }
+    return static_cast<TransformPlanHandle *>(plan)->plan->Execute(src, dst, transform_params);
+  }
+
+  int DestroyPlan(void *plan) {
+    if (!plan) {
+      LOG(ERROR) << "[EasyDK] [TransformService] DestroyPlan(): plan is invalid";
+      return -1;
+    }
+    delete static_cast<TransformPlanHandle *>(plan);
+    return 0;
   }
 
  private:
@@ -116,10 +256,23 @@ class TransformService {
   TransformService(TransformService &&) = delete;
   TransformService &operator=(const TransformService &) = delete;
   TransformService &operator=(TransformService &&) = delete;
-  TransformService() { transformer_.reset(CreateTransformer()); }
+  TransformService() {
+    transformer_.reset(CreateTransformer());
+    cpu_transformer_.reset(new TransformerCpu());
+  }
+
+  // falls back to cpu if there is no transformer for the platform
+  ITransformer *GetTransformer() { return transformer_ ? transformer_.get() : cpu_transformer_.get(); }
+
+  struct TransformPlanHandle {
+    std::shared_ptr<ITransformPlan> plan;
+  };
 
  private:
   std::unique_ptr<ITransformer> transformer_ = nullptr;
+  std::unique_ptr<ITransformer> cpu_transformer_ = nullptr;
+  std::mutex plan_mutex_;
+  std::map<std::vector<uint32_t>, std::weak_ptr<ITransformPlan>> plans_;
   static std::unique_ptr<TransformService> instance_;
 };
 
@@ -141,4 +294,21 @@ int CnedkTransform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformPar
   return cnedk::TransformService::Instance().Transform(src, dst, transform_params);
 }
 
+int CnedkTransformRoiBatch(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformRoiParams *roi_params) {
+  return cnedk::TransformService::Instance().TransformRoi(src, dst, roi_params);
+}
+
+int CnedkTransformPlanCreate(void **plan, CnedkTransformPlanParams *params) {
+  return cnedk::TransformService::Instance().CreatePlan(plan, params);
+}
+
+int CnedkTransformPlanExecute(void *plan, CnedkBufSurface *src, CnedkBufSurface *dst,
+                              CnedkTransformParams *transform_params) {
+  return cnedk::TransformService::Instance().ExecutePlan(plan, src, dst, transform_params);
+}
+
+int CnedkTransformPlanDestroy(void *plan) {
+  return cnedk::TransformService::Instance().DestroyPlan(plan);
+}
+
 };  // extern "C"
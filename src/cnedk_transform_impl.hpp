@@ -30,6 +30,28 @@
 
 namespace cnedk {
 
+// A transform compiled for fixed formats, shapes and flags, shared by the callers that create plans with the same
+// parameters. Execute() may be called from any thread.
+class ITransformPlan {
+ public:
+  explicit ITransformPlan(const CnedkTransformPlanParams &params) : params_(params) {
+    if (params.dst_desc) {
+      dst_desc_ = *params.dst_desc;
+      params_.dst_desc = &dst_desc_;
+    }
+  }
+  virtual ~ITransformPlan() {}
+
+  // Checks that src and dst match the plan before running it
+  int Execute(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params);
+
+ protected:
+  virtual int Run(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) = 0;
+
+  CnedkTransformPlanParams params_;
+  CnedkTransformTensorDesc dst_desc_;
+};
+
 class ITransformer {
  public:
   virtual ~ITransformer() {}
@@ -56,10 +78,55 @@ class ITransformer {
 
   virtual int Transform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) = 0;
 
+  // Creates a plan, returns nullptr if the parameters are not supported
+  virtual ITransformPlan *CreatePlan(const CnedkTransformPlanParams &params);
+
+  virtual int TransformRoi(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformRoiParams *roi_params) {
+    LOG(ERROR) << "[EasyDK] [ITransformer] TransformRoi(): Not supported by the compute device";
+    return -1;
+  }
+
+  static CnedkTransformComputeMode GetComputeMode() { return config_params_.compute_mode; }
+
  protected:
   static thread_local CnedkTransformConfigParams config_params_;
 };
 
+// Plan which checks the parameters once and forwards to the transformer
+class TransformerPlan : public ITransformPlan {
+ public:
+  TransformerPlan(ITransformer *transformer, const CnedkTransformPlanParams &params)
+      : ITransformPlan(params), transformer_(transformer) {}
+
+ protected:
+  int Run(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) override {
+    return transformer_->Transform(src, dst, transform_params);
+  }
+
+ private:
+  ITransformer *transformer_;
+};
+
+inline ITransformPlan *ITransformer::CreatePlan(const CnedkTransformPlanParams &params) {
+  return new TransformerPlan(this, params);
+}
+
+// Gets the rectangle in a dst_w x dst_h image which keeps the aspect ratio of src_w x src_h and is centered.
+// The rectangle is aligned to 2 for YUV420sp.
+inline CnedkTransformRect GetLetterboxRect(uint32_t src_w, uint32_t src_h, uint32_t dst_w, uint32_t dst_h) {
+  CnedkTransformRect rect;
+  if (static_cast<uint64_t>(src_w) * dst_h > static_cast<uint64_t>(src_h) * dst_w) {
+    rect.width = dst_w;
+    rect.height = std::max<uint32_t>(static_cast<uint64_t>(src_h) * dst_w / src_w, 2) & ~1u;
+  } else {
+    rect.width = std::max<uint32_t>(static_cast<uint64_t>(src_w) * dst_h / src_h, 2) & ~1u;
+    rect.height = dst_h;
+  }
+  rect.left = ((dst_w - rect.width) / 2) & ~1u;
+  rect.top = ((dst_h - rect.height) / 2) & ~1u;
+  return rect;
+}
+
 ITransformer *CreateTransformer();
 
 }  // namespace cnedk
@@ -58,6 +58,24 @@ IVinCapture *CreateVinCapture() {
   return nullptr;
 }
 
+IVinCaptureGroup *CreateVinCaptureGroup() {
+  int dev_id = -1;
+  CNRT_SAFECALL(cnrtGetDevice(&dev_id), "CreateVinCaptureGroup(): failed", nullptr);
+
+  CnedkPlatformInfo info;
+  if (CnedkPlatformGetInfo(dev_id, &info) < 0) {
+    LOG(ERROR) << "[EasyDK] CreateVinCaptureGroup(): Get platform information failed";
+    return nullptr;
+  }
+
+#ifdef PLATFORM_CE3226
+  if (info.support_unified_addr) {
+    return new VinCaptureGroupCe3226();
+  }
+#endif
+  return nullptr;
+}
+
 class VinCaptureService {
  public:
   static VinCaptureService &Instance() {
@@ -109,6 +127,49 @@ class VinCaptureService {
     return capture_->Capture(timeout_ms);
   }
 
+  int CreateGroup(void **group, CnedkVinCaptureGroupCreateParams *params) {
+    if (!group || !params) {
+      LOG(ERROR) << "[EasyDK] [VinCaptureService] CreateGroup(): group or params pointer is invalid";
+      return -1;
+    }
+    if (CheckParams(params) < 0) {
+      LOG(ERROR) << "[EasyDK] [VinCaptureService] CreateGroup(): Parameters are invalid";
+      return -1;
+    }
+    IVinCaptureGroup *group_ = CreateVinCaptureGroup();
+    if (!group_) {
+      LOG(ERROR) << "[EasyDK] [VinCaptureService] CreateGroup(): new vin capture group failed";
+      return -1;
+    }
+    if (group_->Create(params) < 0) {
+      LOG(ERROR) << "[EasyDK] [VinCaptureService] CreateGroup(): Create vin capture group failed";
+      delete group_;
+      return -1;
+    }
+    *group = group_;
+    return 0;
+  }
+
+  int DestroyGroup(void *group) {
+    if (!group) {
+      LOG(ERROR) << "[EasyDK] [VinCaptureService] DestroyGroup(): group pointer is invalid";
+      return -1;
+    }
+    IVinCaptureGroup *group_ = static_cast<IVinCaptureGroup *>(group);
+    group_->Destroy();
+    delete group_;
+    return 0;
+  }
+
+  int CaptureGroup(void *group, int timeout_ms) {
+    if (!group) {
+      LOG(ERROR) << "[EasyDK] [VinCaptureService] CaptureGroup(): group pointer is invalid";
+      return -1;
+    }
+    IVinCaptureGroup *group_ = static_cast<IVinCaptureGroup *>(group);
+    return group_->Capture(timeout_ms);
+  }
+
  private:
   int CheckParams(CnedkVinCaptureCreateParams *params) {
     if (params->OnFrame == nullptr || params->OnError == nullptr || params->GetBufSurf == nullptr) {
@@ -121,6 +182,27 @@ class VinCaptureService {
     return 0;
   }
 
+  int CheckParams(CnedkVinCaptureGroupCreateParams *params) {
+    if (params->OnFrames == nullptr || params->OnError == nullptr || params->GetBufSurf == nullptr) {
+      LOG(ERROR) << "[EasyDK] [VinCaptureService] CheckParams(): OnFrames, OnError or GetBufSurf function pointer"
+                 << " is invalid";
+      return -1;
+    }
+    if (params->num_sensors <= 0 || params->sensor_ids == nullptr) {
+      LOG(ERROR) << "[EasyDK] [VinCaptureService] CheckParams(): num_sensors or sensor_ids is invalid";
+      return -1;
+    }
+    for (int i = 0; i < params->num_sensors; ++i) {
+      for (int j = 0; j < i; ++j) {
+        if (params->sensor_ids[i] == params->sensor_ids[j]) {
+          LOG(ERROR) << "[EasyDK] [VinCaptureService] CheckParams(): Duplicated sensor id " << params->sensor_ids[i];
+          return -1;
+        }
+      }
+    }
+    return 0;
+  }
+
  private:
   VinCaptureService(const VinCaptureService &) = delete;
   VinCaptureService(VinCaptureService &&) = delete;
@@ -145,4 +227,11 @@ int CnedkVinCaptureDestroy(void *vin_capture) { return cnedk::VinCaptureService:
 int CnedkVinCapture(void *vin_capture, int timeout_ms) {
   return cnedk::VinCaptureService::Instance().Capture(vin_capture, timeout_ms);
 }
+int CnedkVinCaptureGroupCreate(void **group, CnedkVinCaptureGroupCreateParams *params) {
+  return cnedk::VinCaptureService::Instance().CreateGroup(group, params);
+}
+int CnedkVinCaptureGroupDestroy(void *group) { return cnedk::VinCaptureService::Instance().DestroyGroup(group); }
+int CnedkVinCaptureGroupCapture(void *group, int timeout_ms) {
+  return cnedk::VinCaptureService::Instance().CaptureGroup(group, timeout_ms);
+}
 };
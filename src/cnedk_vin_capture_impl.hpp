@@ -35,6 +35,16 @@ class IVinCapture {
 
 IVinCapture *CreateVinCapture();
 
+class IVinCaptureGroup {
+ public:
+  virtual ~IVinCaptureGroup() {}
+  virtual int Create(CnedkVinCaptureGroupCreateParams *params) = 0;
+  virtual int Destroy() = 0;
+  virtual int Capture(int timeout_ms) = 0;
+};
+
+IVinCaptureGroup *CreateVinCaptureGroup();
+
 }  // namespace cnedk
 
 #endif  // CNEDK_VIN_CAPTURE_IMPL_HPP_
@@ -29,6 +29,8 @@
 
 #include "cnedk_platform.h"
 #include "cnedk_vout_display_impl.hpp"
+#include "cnedk_vout_mosaic.hpp"
+#include "common/frame_presenter.hpp"
 #include "common/utils.hpp"
 
 #ifdef PLATFORM_CE3226
@@ -65,7 +67,64 @@ class VoutDisplayService {
     return *instance_;
   }
 
-  int Render(CnedkBufSurface *surf) { return vout_->Render(surf); }
+  int Render(CnedkBufSurface *surf) {
+    if (!vout_) {
+      LOG(ERROR) << "[EasyDK] [VoutDisplayService] Render(): Vout is not supported on this platform";
+      return -1;
+    }
+    return vout_->Render(surf);
+  }
+
+  int RenderStart(const CnedkVoutRenderParams *params) {
+    if (!params) {
+      LOG(ERROR) << "[EasyDK] [VoutDisplayService] RenderStart(): params is nullptr";
+      return -1;
+    }
+    if (!vout_) {
+      LOG(ERROR) << "[EasyDK] [VoutDisplayService] RenderStart(): Vout is not supported on this platform";
+      return -1;
+    }
+    std::unique_lock<std::mutex> lk(presenter_mutex_);
+    if (presenter_) {
+      LOG(ERROR) << "[EasyDK] [VoutDisplayService] RenderStart(): Paced renderer is already started";
+      return -1;
+    }
+    std::unique_ptr<FramePresenter> presenter(new FramePresenter(
+        [this](CnedkBufSurface *surf) { return vout_->Render(surf); },
+        [](CnedkBufSurface *surf) { CnedkBufSurfaceDestroy(surf); }));
+    if (presenter->Start(*params) < 0) return -1;
+    presenter_ = std::move(presenter);
+    return 0;
+  }
+
+  int RenderQueue(CnedkBufSurface *surf) {
+    std::unique_lock<std::mutex> lk(presenter_mutex_);
+    if (!presenter_) {
+      LOG(ERROR) << "[EasyDK] [VoutDisplayService] RenderQueue(): Paced renderer is not started";
+      return -1;
+    }
+    return presenter_->Queue(surf);
+  }
+
+  int RenderGetStats(CnedkVoutRenderStats *stats) {
+    if (!stats) {
+      LOG(ERROR) << "[EasyDK] [VoutDisplayService] RenderGetStats(): stats is nullptr";
+      return -1;
+    }
+    std::unique_lock<std::mutex> lk(presenter_mutex_);
+    if (!presenter_) {
+      LOG(ERROR) << "[EasyDK] [VoutDisplayService] RenderGetStats(): Paced renderer is not started";
+      return -1;
+    }
+    presenter_->GetStats(stats);
+    return 0;
+  }
+
+  int RenderStop() {
+    std::unique_lock<std::mutex> lk(presenter_mutex_);
+    presenter_.reset();
+    return 0;
+  }
 
  private:
   VoutDisplayService(const VoutDisplayService &) = delete;
@@ -76,6 +135,8 @@ class VoutDisplayService {
 
  private:
   std::unique_ptr<IVoutDisplay> vout_ = nullptr;
+  std::mutex presenter_mutex_;
+  std::unique_ptr<FramePresenter> presenter_ = nullptr;
   static std::unique_ptr<VoutDisplayService> instance_;
 };
 
@@ -86,4 +147,46 @@ std::unique_ptr<VoutDisplayService> VoutDisplayService::instance_;
 extern "C" {
 
 int CnedkVoutRender(CnedkBufSurface *surf) { return cnedk::VoutDisplayService::Instance().Render(surf); }
+
+int CnedkVoutRenderStart(const CnedkVoutRenderParams *params) {
+  return cnedk::VoutDisplayService::Instance().RenderStart(params);
+}
+
+int CnedkVoutRenderQueue(CnedkBufSurface *surf) { return cnedk::VoutDisplayService::Instance().RenderQueue(surf); }
+
+int CnedkVoutRenderGetStats(CnedkVoutRenderStats *stats) {
+  return cnedk::VoutDisplayService::Instance().RenderGetStats(stats);
+}
+
+int CnedkVoutRenderStop(void) { return cnedk::VoutDisplayService::Instance().RenderStop(); }
+int CnedkVoutMosaicCreate(void **mosaic, CnedkVoutMosaicParams *params) {
+  if (!mosaic || !params) {
+    LOG(ERROR) << "[EasyDK] CnedkVoutMosaicCreate(): mosaic or params pointer is invalid";
+    return -1;
+  }
+  std::unique_ptr<cnedk::VoutMosaic> vout_mosaic(new cnedk::VoutMosaic(*params));
+  if (vout_mosaic->Init() < 0) {
+    LOG(ERROR) << "[EasyDK] CnedkVoutMosaicCreate(): Create mosaic compositor failed";
+    return -1;
+  }
+  *mosaic = vout_mosaic.release();
+  return 0;
+}
+
+int CnedkVoutMosaicDestroy(void *mosaic) {
+  if (!mosaic) {
+    LOG(ERROR) << "[EasyDK] CnedkVoutMosaicDestroy(): mosaic pointer is invalid";
+    return -1;
+  }
+  delete static_cast<cnedk::VoutMosaic *>(mosaic);
+  return 0;
+}
+
+int CnedkVoutMosaicSendFrame(void *mosaic, uint32_t input_idx, CnedkBufSurface *surf) {
+  if (!mosaic) {
+    LOG(ERROR) << "[EasyDK] CnedkVoutMosaicSendFrame(): mosaic pointer is invalid";
+    return -1;
+  }
+  return static_cast<cnedk::VoutMosaic *>(mosaic)->SendFrame(input_idx, surf);
+}
 };
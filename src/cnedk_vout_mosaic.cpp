@@ -0,0 +1,258 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include "cnedk_vout_mosaic.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace cnedk {
+
+VoutMosaic::VoutMosaic(const CnedkVoutMosaicParams &params) : params_(params) {
+  if (params.rects && params.num_inputs) {
+    rects_.assign(params.rects, params.rects + params.num_inputs);
+  }
+  params_.rects = nullptr;
+  if (!params_.frame_rate) params_.frame_rate = 30;
+  if (!params_.num_buffers) params_.num_buffers = 2;
+}
+
+VoutMosaic::~VoutMosaic() {
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    running_ = false;
+  }
+  cond_.notify_all();
+  if (thread_.joinable()) thread_.join();
+  for (auto &buf : buffers_) {
+    if (buf.surf) CnedkBufSurfaceDestroy(buf.surf);
+  }
+}
+
+int VoutMosaic::InitLayout() {
+  uint32_t num = params_.num_inputs;
+  if (rects_.empty()) {
+    uint32_t cols = params_.grid_cols ? params_.grid_cols : static_cast<uint32_t>(std::ceil(std::sqrt(num)));
+    uint32_t rows = (num + cols - 1) / cols;
+    uint32_t tile_w = (params_.width / cols) & ~1u;
+    uint32_t tile_h = (params_.height / rows) & ~1u;
+    if (!tile_w || !tile_h) {
+      LOG(ERROR) << "[EasyDK] [VoutMosaic] InitLayout(): The composite is too small for " << num << " inputs";
+      return -1;
+    }
+    rects_.resize(num);
+    for (uint32_t i = 0; i < num; ++i) {
+      rects_[i].left = i % cols * tile_w;
+      rects_[i].top = i / cols * tile_h;
+      rects_[i].width = tile_w;
+      rects_[i].height = tile_h;
+    }
+    return 0;
+  }
+  // YUV420 tiles start and end on even coordinates
+  for (auto &rect : rects_) {
+    rect.left &= ~1u;
+    rect.top &= ~1u;
+    rect.width &= ~1u;
+    rect.height &= ~1u;
+    if (!rect.width || !rect.height || rect.left + rect.width > params_.width ||
+        rect.top + rect.height > params_.height) {
+      LOG(ERROR) << "[EasyDK] [VoutMosaic] InitLayout(): Tile (" << rect.left << ", " << rect.top << ", "
+                 << rect.width << ", " << rect.height << ") is out of the composite";
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int VoutMosaic::Init() {
+  if (!params_.num_inputs || !params_.width || !params_.height) {
+    LOG(ERROR) << "[EasyDK] [VoutMosaic] Init(): num_inputs, width and height must be greater than 0";
+    return -1;
+  }
+  if (params_.color_format != CNEDK_BUF_COLOR_FORMAT_NV12 && params_.color_format != CNEDK_BUF_COLOR_FORMAT_NV21) {
+    LOG(ERROR) << "[EasyDK] [VoutMosaic] Init(): Unsupported color format: " << params_.color_format;
+    return -1;
+  }
+  if (InitLayout() < 0) return -1;
+
+  CnedkBufSurfaceCreateParams create_params;
+  memset(&create_params, 0, sizeof(create_params));
+  create_params.mem_type = params_.mem_type;
+  create_params.device_id = params_.device_id;
+  create_params.width = params_.width;
+  create_params.height = params_.height;
+  create_params.color_format = params_.color_format;
+  create_params.batch_size = 1;
+  buffers_.resize(params_.num_buffers);
+  for (auto &buf : buffers_) {
+    if (CnedkBufSurfaceCreate(&buf.surf, &create_params) < 0) {
+      LOG(ERROR) << "[EasyDK] [VoutMosaic] Init(): Create composite buffer failed";
+      return -1;
+    }
+    buf.surf->num_filled = 1;
+    // black background for the area without tiles
+    CnedkBufSurfaceMemSet(buf.surf, 0, 0, 16);
+    CnedkBufSurfaceMemSet(buf.surf, 0, 1, 128);
+    buf.drawn.assign(params_.num_inputs, 0);
+  }
+  inputs_.resize(params_.num_inputs);
+  tile_errors_.assign(params_.num_inputs, 0);
+
+  running_ = true;
+  thread_ = std::thread(&VoutMosaic::Loop, this);
+  return 0;
+}
+
+int VoutMosaic::SendFrame(uint32_t input_idx, CnedkBufSurface *surf) {
+  if (input_idx >= params_.num_inputs) {
+    LOG(ERROR) << "[EasyDK] [VoutMosaic] SendFrame(): Input index " << input_idx << " is out of range";
+    return -1;
+  }
+  if (!surf || surf->batch_size != 1) {
+    LOG(ERROR) << "[EasyDK] [VoutMosaic] SendFrame(): surf is nullptr or its batch size is not 1";
+    return -1;
+  }
+  // the frame may still be drawn by the compositor when it is replaced, the last owner destroys it
+  std::shared_ptr<CnedkBufSurface> frame(surf, [](CnedkBufSurface *s) { CnedkBufSurfaceDestroy(s); });
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    inputs_[input_idx].surf.swap(frame);
+    ++inputs_[input_idx].version;
+    dirty_ = true;
+  }
+  return 0;
+}
+
+int VoutMosaic::DrawTiles(Buffer *buf, const std::vector<CnedkBufSurface *> &frames,
+                          const std::vector<uint32_t> &tiles) {
+  size_t num = frames.size();
+  std::vector<CnedkBufSurfaceParams> src_params(num);
+  std::vector<CnedkBufSurfaceParams> dst_params(num, buf->surf->surface_list[0]);
+  std::vector<CnedkTransformRect> dst_rects(num);
+  for (size_t j = 0; j < num; ++j) {
+    src_params[j] = frames[j]->surface_list[0];
+    dst_rects[j] = rects_[tiles[j]];
+  }
+  // batch views of the inputs and of the tiles, every tile refers to the same composite buffer
+  CnedkBufSurface src_view;
+  memset(&src_view, 0, sizeof(src_view));
+  src_view.mem_type = frames[0]->mem_type;
+  src_view.device_id = frames[0]->device_id;
+  src_view.batch_size = src_view.num_filled = num;
+  src_view.surface_list = src_params.data();
+  CnedkBufSurface dst_view = *buf->surf;
+  dst_view.batch_size = dst_view.num_filled = num;
+  dst_view.is_contiguous = false;
+  dst_view.surface_list = dst_params.data();
+
+  CnedkTransformParams transform_params;
+  memset(&transform_params, 0, sizeof(transform_params));
+  transform_params.transform_flag = CNEDK_TRANSFORM_CROP_DST;
+  transform_params.dst_rect = dst_rects.data();
+  return CnedkTransform(&src_view, &dst_view, &transform_params);
+}
+
+int VoutMosaic::Composite(Buffer *buf) {
+  std::vector<uint32_t> tiles;
+  std::vector<std::shared_ptr<CnedkBufSurface>> frames;
+  std::vector<uint64_t> versions;
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    for (uint32_t i = 0; i < params_.num_inputs; ++i) {
+      if (inputs_[i].surf && inputs_[i].version != buf->drawn[i]) {
+        tiles.push_back(i);
+        frames.push_back(inputs_[i].surf);
+        versions.push_back(inputs_[i].version);
+      }
+    }
+  }
+
+  // one batched transform per memory type of the inputs, normally there is only one
+  std::map<CnedkBufSurfaceMemType, std::vector<size_t>> groups;
+  for (size_t k = 0; k < tiles.size(); ++k) groups[frames[k]->mem_type].push_back(k);
+
+  int failed = 0;
+  for (auto &group : groups) {
+    std::vector<CnedkBufSurface *> group_frames;
+    std::vector<uint32_t> group_tiles;
+    for (size_t k : group.second) {
+      group_frames.push_back(frames[k].get());
+      group_tiles.push_back(tiles[k]);
+    }
+    bool batch_ok = DrawTiles(buf, group_frames, group_tiles) == 0;
+    for (size_t k : group.second) {
+      // one bad input must not hold back the others, find it by drawing the tiles of the failed batch one by one
+      if (!batch_ok && (group.second.size() == 1 || DrawTiles(buf, {frames[k].get()}, {tiles[k]}) < 0)) {
+        ++failed;
+        ++tile_errors_[tiles[k]];
+        LOG(ERROR) << "[EasyDK] [VoutMosaic] Composite(): Draw tile " << tiles[k] << " failed, "
+                   << tile_errors_[tiles[k]] << " failures so far";
+      }
+      // a failed tile keeps its previous picture until the input sends a new frame, instead of being retried forever
+      buf->drawn[tiles[k]] = versions[k];
+    }
+  }
+  return failed;
+}
+
+void VoutMosaic::Loop() {
+  CnedkTransformConfigParams config;
+  memset(&config, 0, sizeof(config));
+  config.compute_mode = params_.compute_mode;
+  config.device_id = params_.device_id;
+  if (CnedkTransformSetSessionParams(&config) < 0) {
+    LOG(ERROR) << "[EasyDK] [VoutMosaic] Loop(): Set transform session parameters failed";
+  }
+
+  auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(1.0 / params_.frame_rate));
+  auto next = std::chrono::steady_clock::now();
+  while (running_) {
+    next += interval;
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      cond_.wait_until(lk, next, [this] { return !running_; });
+      if (!running_) break;
+      if (!dirty_) continue;
+      dirty_ = false;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now - next > interval) next = now;
+
+    Buffer &buf = buffers_[cur_];
+    // the tiles which failed to draw are logged and counted, the composite is shown anyway
+    Composite(&buf);
+    int ret = params_.OnComposite ? params_.OnComposite(buf.surf, params_.userdata) : CnedkVoutRender(buf.surf);
+    if (ret < 0) {
+      LOG(WARNING) << "[EasyDK] [VoutMosaic] Loop(): Output composite failed";
+    }
+    cur_ = (cur_ + 1) % buffers_.size();
+  }
+}
+
+}  // namespace cnedk
@@ -0,0 +1,82 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#ifndef CNEDK_VOUT_MOSAIC_HPP_
+#define CNEDK_VOUT_MOSAIC_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cnedk_vout_display.h"
+
+namespace cnedk {
+
+// Tiles the latest frames of several inputs onto one output at a fixed rate. Each composite buffer remembers which
+// frame version every tile was drawn from, so only the tiles changed since the buffer was last used are redrawn.
+class VoutMosaic {
+ public:
+  explicit VoutMosaic(const CnedkVoutMosaicParams &params);
+  ~VoutMosaic();
+
+  int Init();
+  int SendFrame(uint32_t input_idx, CnedkBufSurface *surf);
+
+ private:
+  VoutMosaic(const VoutMosaic &) = delete;
+  VoutMosaic &operator=(const VoutMosaic &) = delete;
+
+  struct Input {
+    std::shared_ptr<CnedkBufSurface> surf;
+    uint64_t version = 0;
+  };
+  struct Buffer {
+    CnedkBufSurface *surf = nullptr;
+    std::vector<uint64_t> drawn;  // version of the frame drawn in each tile
+  };
+
+  int InitLayout();
+  void Loop();
+  // Returns the number of tiles which failed to draw. They keep their previous picture, the others are drawn anyway.
+  int Composite(Buffer *buf);
+  int DrawTiles(Buffer *buf, const std::vector<CnedkBufSurface *> &frames, const std::vector<uint32_t> &tiles);
+
+ private:
+  CnedkVoutMosaicParams params_;
+  std::vector<CnedkTransformRect> rects_;
+  std::vector<Buffer> buffers_;
+  size_t cur_ = 0;
+  std::vector<uint64_t> tile_errors_;  // draw failures of each tile, only touched by the compositor thread
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::vector<Input> inputs_;
+  bool dirty_ = false;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+};
+
+}  // namespace cnedk
+
+#endif  // CNEDK_VOUT_MOSAIC_HPP_
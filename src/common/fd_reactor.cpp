@@ -0,0 +1,233 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include "fd_reactor.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace cnedk {
+
+namespace {
+constexpr int kMaxEvents = 32;
+// the reactor and the descriptor whose handler the calling thread is running
+thread_local const FdReactor *tls_reactor = nullptr;
+thread_local int tls_fd = -1;
+}  // namespace
+
+FdReactor::~FdReactor() { Stop(); }
+
+int FdReactor::Start(int handler_thread_num) {
+  if (running_) return 0;
+  if (handler_thread_num <= 0) {
+    LOG(ERROR) << "[EasyDK] [FdReactor] Start(): The number of handler threads is invalid: " << handler_thread_num;
+    return -1;
+  }
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0) {
+    LOG(ERROR) << "[EasyDK] [FdReactor] Start(): epoll_create1 failed, " << strerror(errno);
+    return -1;
+  }
+  wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeup_fd_ < 0) {
+    LOG(ERROR) << "[EasyDK] [FdReactor] Start(): eventfd failed, " << strerror(errno);
+    close(epoll_fd_);
+    epoll_fd_ = -1;
+    return -1;
+  }
+  epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = wakeup_fd_;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &ev) != 0) {
+    LOG(ERROR) << "[EasyDK] [FdReactor] Start(): Add wakeup fd failed, " << strerror(errno);
+    close(wakeup_fd_);
+    close(epoll_fd_);
+    wakeup_fd_ = epoll_fd_ = -1;
+    return -1;
+  }
+  running_ = true;
+  thread_ = std::thread(&FdReactor::Loop, this);
+  for (int i = 0; i < handler_thread_num; ++i) {
+    handler_threads_.emplace_back(&FdReactor::HandlerLoop, this);
+  }
+  return 0;
+}
+
+void FdReactor::Stop() {
+  if (!running_) return;
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    running_ = false;
+  }
+  ready_cond_.notify_all();
+  uint64_t one = 1;
+  if (write(wakeup_fd_, &one, sizeof(one)) != sizeof(one)) {
+    LOG(WARNING) << "[EasyDK] [FdReactor] Stop(): Wake up reactor failed, " << strerror(errno);
+  }
+  if (thread_.joinable()) thread_.join();
+  for (auto &thread : handler_threads_) thread.join();
+  handler_threads_.clear();
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (!handlers_.empty()) {
+      LOG(WARNING) << "[EasyDK] [FdReactor] Stop(): " << handlers_.size() << " fd(s) are still registered";
+      handlers_.clear();
+    }
+    ready_.clear();
+  }
+  close(wakeup_fd_);
+  close(epoll_fd_);
+  wakeup_fd_ = epoll_fd_ = -1;
+}
+
+int FdReactor::Add(int fd, Handler handler) {
+  if (fd < 0 || !handler) {
+    LOG(ERROR) << "[EasyDK] [FdReactor] Add(): fd or handler is invalid";
+    return -1;
+  }
+  std::unique_lock<std::mutex> lk(mutex_);
+  if (!running_) {
+    LOG(ERROR) << "[EasyDK] [FdReactor] Add(): Reactor is not started";
+    return -1;
+  }
+  if (handlers_.count(fd)) {
+    LOG(ERROR) << "[EasyDK] [FdReactor] Add(): fd " << fd << " is already registered";
+    return -1;
+  }
+  handlers_[fd] = std::make_shared<Handler>(std::move(handler));
+  // one-shot, the descriptor is armed again after its handler returns
+  epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN | EPOLLONESHOT;
+  ev.data.fd = fd;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+    LOG(ERROR) << "[EasyDK] [FdReactor] Add(): epoll_ctl failed, fd = " << fd << ", " << strerror(errno);
+    handlers_.erase(fd);
+    return -1;
+  }
+  return 0;
+}
+
+int FdReactor::Remove(int fd) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  int ret = -1;
+  auto it = handlers_.find(fd);
+  if (it != handlers_.end()) {
+    handlers_.erase(it);
+    ready_.erase(std::remove(ready_.begin(), ready_.end(), fd), ready_.end());
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr) != 0) {
+      LOG(WARNING) << "[EasyDK] [FdReactor] Remove(): epoll_ctl failed, fd = " << fd << ", " << strerror(errno);
+    }
+    ret = 0;
+  }
+  // the handler may have removed itself and still be running
+  if (tls_reactor != this || tls_fd != fd) {
+    cond_.wait(lk, [&] { return !dispatching_.count(fd); });
+  }
+  return ret;
+}
+
+bool FdReactor::InReactorThread() const { return tls_reactor == this; }
+
+void FdReactor::Loop() {
+  tls_reactor = this;
+  epoll_event events[kMaxEvents];
+  while (running_) {
+    int num = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+    if (num < 0) {
+      if (errno == EINTR) continue;
+      LOG(ERROR) << "[EasyDK] [FdReactor] Loop(): epoll_wait failed, " << strerror(errno);
+      break;
+    }
+    bool ready = false;
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      for (int i = 0; i < num && running_; ++i) {
+        int fd = events[i].data.fd;
+        if (fd == wakeup_fd_) {
+          uint64_t value;
+          while (read(wakeup_fd_, &value, sizeof(value)) > 0) {}
+          continue;
+        }
+        auto it = handlers_.find(fd);
+        // removed after the event was reported
+        if (it == handlers_.end()) continue;
+        if ((events[i].events & (EPOLLERR | EPOLLHUP)) && !(events[i].events & EPOLLIN)) {
+          // nothing to read will ever come, stop watching it instead of spinning on it
+          LOG(ERROR) << "[EasyDK] [FdReactor] Loop(): fd " << fd << " is hung up or in error, removed";
+          handlers_.erase(it);
+          epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+          continue;
+        }
+        ready_.push_back(fd);
+        ready = true;
+      }
+    }
+    if (ready) ready_cond_.notify_all();
+  }
+  tls_reactor = nullptr;
+}
+
+void FdReactor::HandlerLoop() {
+  tls_reactor = this;
+  std::unique_lock<std::mutex> lk(mutex_);
+  while (true) {
+    ready_cond_.wait(lk, [this] { return !running_ || !ready_.empty(); });
+    if (!running_) break;
+    int fd = ready_.front();
+    ready_.pop_front();
+    auto it = handlers_.find(fd);
+    if (it == handlers_.end()) continue;
+    std::shared_ptr<Handler> handler = it->second;
+    dispatching_.insert(fd);
+    lk.unlock();
+    tls_fd = fd;
+    (*handler)();
+    tls_fd = -1;
+    lk.lock();
+    dispatching_.erase(fd);
+    // arms the descriptor again unless the handler is removed, or replaced by Remove() and Add() meanwhile
+    it = handlers_.find(fd);
+    if (it != handlers_.end() && it->second == handler) {
+      epoll_event ev;
+      memset(&ev, 0, sizeof(ev));
+      ev.events = EPOLLIN | EPOLLONESHOT;
+      ev.data.fd = fd;
+      if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) != 0) {
+        LOG(ERROR) << "[EasyDK] [FdReactor] HandlerLoop(): Rearm fd " << fd << " failed, " << strerror(errno);
+      }
+    }
+    cond_.notify_all();
+  }
+  tls_reactor = nullptr;
+}
+
+}  // namespace cnedk
@@ -0,0 +1,86 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#ifndef EASYDK_COMMON_FD_REACTOR_HPP_
+#define EASYDK_COMMON_FD_REACTOR_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace cnedk {
+
+/**
+ * @brief Waits on a set of file descriptors with epoll in a single thread, and calls the handler of a descriptor
+ *        each time it becomes readable.
+ *
+ * Handlers run on a few handler threads, so a handler which blocks in a user callback only holds up its own
+ * descriptor. A descriptor is not watched while its handler is running, so the handler of a descriptor never runs
+ * concurrently with itself, and it is called again after it returns as long as the descriptor stays readable.
+ */
+class FdReactor {
+ public:
+  using Handler = std::function<void()>;
+
+  FdReactor() = default;
+  ~FdReactor();
+
+  // Starts the epoll thread and handler_thread_num handler threads
+  int Start(int handler_thread_num = 4);
+  void Stop();
+  // Registers fd. Returns -1 if the reactor is not started or fd is already registered.
+  int Add(int fd, Handler handler);
+  // Unregisters fd. When called outside the handler of fd, it returns after the running handler of fd (if any)
+  // has finished, even if fd has been unregistered by the handler itself, so the resources used by the handler can be
+  // released safely afterwards. Returns -1 if fd is not registered.
+  int Remove(int fd);
+  // Whether the calling thread is the epoll thread or a handler thread of the reactor
+  bool InReactorThread() const;
+
+ private:
+  FdReactor(const FdReactor &) = delete;
+  FdReactor &operator=(const FdReactor &) = delete;
+  void Loop();
+  void HandlerLoop();
+
+ private:
+  int epoll_fd_ = -1;
+  int wakeup_fd_ = -1;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+  std::vector<std::thread> handler_threads_;
+  std::mutex mutex_;
+  std::condition_variable cond_;        // notified when a handler finishes
+  std::condition_variable ready_cond_;  // notified when a descriptor is ready or the reactor stops
+  std::map<int, std::shared_ptr<Handler>> handlers_;
+  std::deque<int> ready_;     // the readable descriptors waiting for a handler thread
+  std::set<int> dispatching_;  // the descriptors whose handlers are running
+};
+
+}  // namespace cnedk
+
+#endif  // EASYDK_COMMON_FD_REACTOR_HPP_
@@ -0,0 +1,158 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include "frame_presenter.hpp"
+
+#include <cstring>
+
+#include "glog/logging.h"
+
+namespace cnedk {
+
+namespace {
+// a frame due further than this in the future means the timestamps jumped, e.g. the stream is looped
+constexpr std::chrono::seconds kMaxAhead(1);
+}  // namespace
+
+int FramePresenter::Start(const CnedkVoutRenderParams &params) {
+  if (running_) {
+    LOG(ERROR) << "[EasyDK] [FramePresenter] Start(): Already started";
+    return -1;
+  }
+  uint32_t refresh_rate = params.refresh_rate ? params.refresh_rate : 30;
+  interval_ = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / refresh_rate));
+  max_late_ = params.max_late_ms ? std::chrono::duration_cast<Clock::duration>(
+                                       std::chrono::milliseconds(params.max_late_ms))
+                                 : interval_;
+  queue_depth_ = params.queue_depth ? params.queue_depth : 2;
+  pts_timescale_ = params.pts_timescale ? params.pts_timescale : 1000;
+  memset(&stats_, 0, sizeof(stats_));
+  anchored_ = false;
+  running_ = true;
+  thread_ = std::thread(&FramePresenter::Loop, this);
+  return 0;
+}
+
+void FramePresenter::Stop() {
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (!running_) return;
+    running_ = false;
+  }
+  cond_.notify_all();
+  if (thread_.joinable()) thread_.join();
+  std::unique_lock<std::mutex> lk(mutex_);
+  for (auto surf : queue_) {
+    release_(surf);
+    ++stats_.dropped;
+  }
+  queue_.clear();
+  if (showing_) {
+    release_(showing_);
+    showing_ = nullptr;
+  }
+}
+
+int FramePresenter::Queue(CnedkBufSurface *surf) {
+  if (!surf) {
+    LOG(ERROR) << "[EasyDK] [FramePresenter] Queue(): surf is nullptr";
+    return -1;
+  }
+  std::unique_lock<std::mutex> lk(mutex_);
+  if (!running_) {
+    LOG(ERROR) << "[EasyDK] [FramePresenter] Queue(): Not started";
+    return -1;
+  }
+  ++stats_.queued;
+  // the display falls behind, the most recent frame wins
+  while (queue_.size() >= queue_depth_) {
+    release_(queue_.front());
+    queue_.pop_front();
+    ++stats_.dropped;
+  }
+  queue_.push_back(surf);
+  return 0;
+}
+
+void FramePresenter::GetStats(CnedkVoutRenderStats *stats) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  *stats = stats_;
+}
+
+FramePresenter::Clock::time_point FramePresenter::DueTime(uint64_t pts) const {
+  double offset = static_cast<double>(static_cast<int64_t>(pts - base_pts_)) / pts_timescale_;
+  return base_time_ + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(offset));
+}
+
+CnedkBufSurface *FramePresenter::Pick(Clock::time_point now) {
+  CnedkBufSurface *pick = nullptr;
+  // a frame due within half an interval is shown at this refresh rather than the next one
+  Clock::time_point deadline = now + interval_ / 2;
+  while (!queue_.empty()) {
+    CnedkBufSurface *surf = queue_.front();
+    if (!anchored_ || DueTime(surf->pts) - now > kMaxAhead) Anchor(surf->pts, now);
+    Clock::time_point due = DueTime(surf->pts);
+    if (due > deadline) break;
+    queue_.pop_front();
+    if (now - due > max_late_) ++stats_.late;
+    if (pick) {
+      release_(pick);
+      ++stats_.dropped;
+    }
+    pick = surf;
+  }
+  // keep presenting at the pace of the stream from here, instead of keeping the delay
+  if (pick && now - DueTime(pick->pts) > max_late_) Anchor(pick->pts, now);
+  return pick;
+}
+
+void FramePresenter::Loop() {
+  Clock::time_point next = Clock::now();
+  while (running_) {
+    next += interval_;
+    CnedkBufSurface *pick = nullptr;
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      cond_.wait_until(lk, next, [this] { return !running_; });
+      if (!running_) break;
+      Clock::time_point now = Clock::now();
+      // presenting took longer than a refresh, skip the missed ticks
+      if (now - next > interval_) next = now;
+      pick = Pick(now);
+      if (!pick) {
+        if (showing_) ++stats_.repeated;
+        continue;
+      }
+    }
+    if (present_(pick) != 0) {
+      LOG(WARNING) << "[EasyDK] [FramePresenter] Loop(): Present frame failed, pts = " << pick->pts;
+    }
+    CnedkBufSurface *prev = nullptr;
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      ++stats_.rendered;
+      prev = showing_;
+      showing_ = pick;
+    }
+    if (prev) release_(prev);
+  }
+}
+
+}  // namespace cnedk
@@ -0,0 +1,96 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#ifndef EASYDK_COMMON_FRAME_PRESENTER_HPP_
+#define EASYDK_COMMON_FRAME_PRESENTER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "cnedk_vout_display.h"
+
+namespace cnedk {
+
+/**
+ * @brief Presents queued frames on a render thread at a fixed refresh rate, paced by the frame timestamps.
+ *
+ * The first frame anchors the timestamps to a monotonic clock. At each refresh the most recent due frame is
+ * presented and the older due ones are dropped. A frame which is too late, or too far in the future (the stream
+ * jumped), resynchronizes the clock to itself, so the latency does not pile up. The presented frame is held until
+ * it is replaced on the display.
+ */
+class FramePresenter {
+ public:
+  using PresentFunc = std::function<int(CnedkBufSurface *)>;
+  using ReleaseFunc = std::function<void(CnedkBufSurface *)>;
+
+  FramePresenter(PresentFunc present, ReleaseFunc release)
+      : present_(std::move(present)), release_(std::move(release)) {}
+  ~FramePresenter() { Stop(); }
+
+  int Start(const CnedkVoutRenderParams &params);
+  void Stop();
+  // Takes the ownership of surf on success
+  int Queue(CnedkBufSurface *surf);
+  void GetStats(CnedkVoutRenderStats *stats);
+
+ private:
+  FramePresenter(const FramePresenter &) = delete;
+  FramePresenter &operator=(const FramePresenter &) = delete;
+
+  using Clock = std::chrono::steady_clock;
+  void Loop();
+  // called with mutex_ held
+  CnedkBufSurface *Pick(Clock::time_point now);
+  Clock::time_point DueTime(uint64_t pts) const;
+  void Anchor(uint64_t pts, Clock::time_point now) {
+    base_pts_ = pts;
+    base_time_ = now;
+    anchored_ = true;
+  }
+
+ private:
+  PresentFunc present_;
+  ReleaseFunc release_;
+  Clock::duration interval_;
+  Clock::duration max_late_;
+  uint32_t queue_depth_ = 2;
+  uint32_t pts_timescale_ = 1000;
+
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<CnedkBufSurface *> queue_;
+  CnedkBufSurface *showing_ = nullptr;
+  CnedkVoutRenderStats stats_;
+  bool anchored_ = false;
+  uint64_t base_pts_ = 0;
+  Clock::time_point base_time_;
+};
+
+}  // namespace cnedk
+
+#endif  // EASYDK_COMMON_FRAME_PRESENTER_HPP_
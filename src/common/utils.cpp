@@ -20,7 +20,15 @@
 
 #include "utils.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "glog/logging.h"
 
@@ -70,4 +78,92 @@ bool IsCloudPlatform(const std::string& platform_name) {
   return false;
 }
 
+namespace {
+
+// Workers kept for the process lifetime, so ParallelFor() costs no thread creation per call
+class ParallelForPool {
+ public:
+  static ParallelForPool &Instance() {
+    // never destroyed, the workers may still be used by static destructors of other modules
+    static ParallelForPool *instance = new ParallelForPool;
+    return *instance;
+  }
+
+  uint32_t GetWorkerNum() const { return static_cast<uint32_t>(workers_.size()); }
+
+  void Run(uint32_t n, const std::function<void(uint32_t)> &func) {
+    auto job = std::make_shared<Job>(n, &func);
+    {
+      std::lock_guard<std::mutex> lk(mutex_);
+      jobs_.push_back(job);
+    }
+    cond_.notify_all();
+    // the caller takes part, so nested or concurrent calls finish even if all the workers are busy
+    Work(job.get());
+    std::unique_lock<std::mutex> lk(job->mutex);
+    job->cond.wait(lk, [&] { return job->done == n; });
+  }
+
+ private:
+  struct Job {
+    Job(uint32_t n, const std::function<void(uint32_t)> *func) : n(n), func(func) {}
+    const uint32_t n;
+    const std::function<void(uint32_t)> *func;
+    std::atomic<uint32_t> next{0};
+    uint32_t done = 0;  // guarded by mutex
+    std::mutex mutex;
+    std::condition_variable cond;
+  };
+
+  ParallelForPool() {
+    uint32_t num = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+    for (uint32_t i = 0; i < num; ++i) {
+      workers_.emplace_back([this] { Loop(); });
+      workers_.back().detach();
+    }
+  }
+
+  void Loop() {
+    while (true) {
+      std::shared_ptr<Job> job;
+      {
+        std::unique_lock<std::mutex> lk(mutex_);
+        cond_.wait(lk, [this] { return !jobs_.empty(); });
+        job = jobs_.front();
+        if (job->next >= job->n) {  // all taken, nothing left for workers
+          jobs_.pop_front();
+          continue;
+        }
+      }
+      Work(job.get());
+    }
+  }
+
+  static void Work(Job *job) {
+    uint32_t i;
+    while ((i = job->next.fetch_add(1)) < job->n) {
+      (*job->func)(i);
+      std::lock_guard<std::mutex> lk(job->mutex);
+      if (++job->done == job->n) job->cond.notify_all();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<std::shared_ptr<Job>> jobs_;
+};
+
+}  // namespace
+
+void ParallelFor(uint32_t n, const std::function<void(uint32_t)>& func) {
+  if (n == 0) return;
+  ParallelForPool &pool = ParallelForPool::Instance();
+  if (n == 1 || pool.GetWorkerNum() == 0) {
+    for (uint32_t i = 0; i < n; ++i) func(i);
+    return;
+  }
+  pool.Run(n, func);
+}
+
 }  // namespace cnedk
@@ -21,6 +21,8 @@
 #ifndef EASYDK_COMMON_UTILS_HPP_
 #define EASYDK_COMMON_UTILS_HPP_
 
+#include <cstdint>
+#include <functional>
 #include <string>
 
 #include "cn_api.h"
@@ -59,6 +61,10 @@ bool IsEdgePlatform(const std::string& platform_name);
 bool IsCloudPlatform(int device_id);
 bool IsCloudPlatform(const std::string& platform_name);
 
+// Runs func(i) for i in [0, n) on a pool of hardware_concurrency - 1 persistent workers, the caller thread takes
+// part in the work. Returns after all the calls have finished.
+void ParallelFor(uint32_t n, const std::function<void(uint32_t)>& func);
+
 }  // namespace cnedk
 
 #endif  // EASYDK_COMMON_UTILS_HPP_
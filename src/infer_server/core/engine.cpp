@@ -27,6 +27,7 @@
 #include <utility>
 #include <vector>
 
+#include "cnedk_trace.h"
 #include "profile.h"
 #include "request_ctrl.h"
 #include "session.h"
@@ -42,9 +43,18 @@ void TaskNode::Execute(PackagePtr pack) {
 #ifdef CNIS_RECORD_PERF
   auto start = Clock::Now();
 #endif
+  bool traced = false;
+  for (auto& it : pack->data) traced = traced || it->trace_id;
+  uint64_t trace_begin = traced ? CnedkTraceNow() : 0;
   s = processor_->Process(pack);
   lk.unlock();
   const std::string& type_name = processor_->TypeName();
+  if (traced) {
+    uint64_t trace_end = CnedkTraceNow();
+    for (auto& it : pack->data) {
+      if (it->trace_id) CnedkTraceRecord(it->trace_id, type_name.c_str(), trace_begin, trace_end);
+    }
+  }
 #ifdef CNIS_RECORD_PERF
   auto end = Clock::Now();
   pack->perf[type_name] = Clock::Duration(start, end);
@@ -0,0 +1,469 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#ifndef INFER_SERVER_UTIL_LOCKFREE_QUEUE_H_
+#define INFER_SERVER_UTIL_LOCKFREE_QUEUE_H_
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace infer_server {
+
+namespace detail {
+constexpr size_t kCacheLineSize = 64;
+
+inline size_t RoundUpPowerOfTwo(size_t n) {
+  size_t ret = 2;  // the sequence check of MpscQueue needs at least two slots
+  while (ret < n) ret <<= 1;
+  return ret;
+}
+}  // namespace detail
+
+/**
+ * @brief Blocks threads until a condition may have changed, with no lock on the notifying side
+ *
+ * A waiter calls PrepareWait(), checks the condition, then either CancelWait() or Wait() with the key got.
+ * A notifier changes the condition, then calls Notify(). Waiters sleep in futex, so they take no CPU while idle,
+ * and only the first Notify() after they begin to wait makes a system call.
+ */
+class EventCount {
+ public:
+  /// type of the key taken before waiting
+  using Key = uint32_t;
+
+  /**
+   * @brief Announces that the calling thread is going to wait
+   *
+   * @return Key Key to be passed to Wait()
+   */
+  Key PrepareWait() noexcept { return state_.fetch_or(kWaiting, std::memory_order_acq_rel) | kWaiting; }
+
+  /**
+   * @brief Cancels the wait announced by PrepareWait(), used when the condition turns out to be met
+   *
+   * @note The waiting flag is left set, which costs at most one needless wakeup.
+   */
+  void CancelWait() noexcept {}
+
+  /**
+   * @brief Blocks until Notify() is called after the PrepareWait() which returned `key`
+   *
+   * @param key Key got by PrepareWait()
+   */
+  void Wait(Key key) noexcept {
+    while (state_.load(std::memory_order_acquire) == key) {
+      FutexWait(key, nullptr);
+    }
+  }
+
+  /**
+   * @brief Blocks until Notify() is called after the PrepareWait() which returned `key`, or `rel_time` passed
+   *
+   * @param key Key got by PrepareWait()
+   * @param rel_time Maximum duration to block for
+   * @retval true Notified
+   * @retval false Timeout
+   */
+  bool WaitFor(Key key, const std::chrono::microseconds rel_time) noexcept {
+    auto deadline = std::chrono::steady_clock::now() + rel_time;
+    while (state_.load(std::memory_order_acquire) == key) {
+      auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now());
+      if (left.count() <= 0) return false;
+      timespec ts;
+      ts.tv_sec = left.count() / 1000000000;
+      ts.tv_nsec = left.count() % 1000000000;
+      FutexWait(key, &ts);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Wakes up all the waiting threads
+   */
+  void Notify() noexcept {
+    // Read-modify-write on the same word as PrepareWait(), so either the waiter sees the changed condition,
+    // or we see the waiting flag
+    uint32_t state = state_.fetch_add(0, std::memory_order_acq_rel);
+    while (state & kWaiting) {
+      // next epoch with the flag cleared, the notifiers after us skip the system call until somebody waits again
+      if (state_.compare_exchange_weak(state, (state + kEpochStep) & ~kWaiting, std::memory_order_acq_rel,
+                                       std::memory_order_relaxed)) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+        return;
+      }
+    }
+  }
+
+ private:
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex works on a plain 32-bit word");
+  static constexpr uint32_t kWaiting = 1;
+  static constexpr uint32_t kEpochStep = 2;
+
+  void FutexWait(Key key, const timespec* timeout) noexcept {
+    // returns at once if state_ is no longer key, spurious wakeups are handled by the callers
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state_), FUTEX_WAIT_PRIVATE, key, timeout, nullptr, 0);
+  }
+
+  // epoch in the upper bits, whether anybody waits in the lowest bit
+  std::atomic<uint32_t> state_{0};
+};  // class EventCount
+
+namespace detail {
+// pops with `pop`, waits on `event` for the pushes while it fails, until `rel_time` passed
+template <typename Pop>
+bool WaitAndPop(EventCount* event, const std::chrono::microseconds rel_time, Pop&& pop) {
+  if (pop()) return true;
+  auto deadline = std::chrono::steady_clock::now() + rel_time;
+  while (true) {
+    EventCount::Key key = event->PrepareWait();
+    if (pop()) {
+      event->CancelWait();
+      return true;
+    }
+    auto left = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now());
+    if (left.count() <= 0) {
+      event->CancelWait();
+      return false;
+    }
+    event->WaitFor(key, left);
+  }
+}
+}  // namespace detail
+
+/**
+ * @brief Bounded lock-free ring queue for exactly one producer thread and one consumer thread
+ *
+ * Has the same Push/TryPop/WaitAndTryPop interface as ThreadSafeQueue. Push() blocks while the queue is full,
+ * TryPush() fails instead. A popped slot keeps the moved-from element until it is pushed over.
+ *
+ * @tparam T Type of stored elements, which should be default constructible and move assignable
+ */
+template <typename T>
+class SpscQueue {
+ public:
+  /// type of elements
+  using value_type = T;
+  /// type of size
+  using size_type = size_t;
+
+  /**
+   * @brief Construct a new SPSC queue
+   *
+   * @param capacity Minimum number of elements the queue holds, rounded up to a power of two (at least 2)
+   */
+  explicit SpscQueue(size_t capacity)
+      : mask_(detail::RoundUpPowerOfTwo(capacity) - 1), buffer_(mask_ + 1) {}
+
+  /**
+   * @brief Try to push an element to the end of the queue
+   *
+   * @param new_value the value of the element to push
+   * @retval true Succeed
+   * @retval false Fail, the queue is full
+   */
+  bool TryPush(const T& new_value) { return Enqueue(new_value); }
+  /// @overload
+  bool TryPush(T&& new_value) { return Enqueue(std::move(new_value)); }
+
+  /**
+   * @brief Pushes the given element value to the end of the queue, wait if the queue is full
+   *
+   * @param new_value the value of the element to push
+   */
+  void Push(const T& new_value) { BlockingPush(new_value); }
+  /// @overload
+  void Push(T&& new_value) { BlockingPush(std::move(new_value)); }
+
+  /**
+   * @brief Try to pop an element from queue
+   *
+   * @param value An element
+   * @retval true Succeed
+   * @retval false Fail, no element stored in queue
+   */
+  bool TryPop(T& value) {  // NOLINT
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) return false;
+    }
+    value = std::move(buffer_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    not_full_.Notify();
+    return true;
+  }
+
+  /**
+   * @brief Try to pop an element from queue, wait for `rel_time` if queue is empty
+   *
+   * @param value An element
+   * @param rel_time Maximum duration to block for
+   * @retval true Succeed
+   * @retval false Timeout
+   */
+  bool WaitAndTryPop(T& value, const std::chrono::microseconds rel_time) {  // NOLINT
+    return detail::WaitAndPop(&not_empty_, rel_time, [&] { return TryPop(value); });
+  }
+
+  /**
+   * @brief Checks if the queue has no elements
+   *
+   * @retval true If the queue is empty
+   * @retval false Otherwise
+   */
+  bool Empty() const { return Size() == 0; }
+
+  /**
+   * @brief Returns the number of elements in the queue, which may be out of date once returned
+   *
+   * @return size_type The number of elements in the queue
+   */
+  size_type Size() const {
+    size_t head = head_.load(std::memory_order_acquire);
+    return tail_.load(std::memory_order_acquire) - head;
+  }
+
+  /**
+   * @brief Returns the maximum number of elements the queue holds
+   *
+   * @return size_type The capacity
+   */
+  size_type Capacity() const { return mask_ + 1; }
+
+ private:
+  SpscQueue(const SpscQueue& other) = delete;
+  SpscQueue& operator=(const SpscQueue& other) = delete;
+
+  template <typename U>
+  bool Enqueue(U&& new_value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ > mask_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ > mask_) return false;
+    }
+    buffer_[tail & mask_] = std::forward<U>(new_value);
+    tail_.store(tail + 1, std::memory_order_release);
+    not_empty_.Notify();
+    return true;
+  }
+
+  template <typename U>
+  void BlockingPush(U&& new_value) {
+    // the value is only moved from once a slot is got, so trying again is fine
+    while (true) {
+      if (Enqueue(std::forward<U>(new_value))) return;
+      EventCount::Key key = not_full_.PrepareWait();
+      if (Enqueue(std::forward<U>(new_value))) {
+        not_full_.CancelWait();
+        return;
+      }
+      not_full_.Wait(key);
+    }
+  }
+
+  const size_t mask_;
+  std::vector<T> buffer_;
+  // consumer side
+  alignas(detail::kCacheLineSize) std::atomic<size_t> head_{0};
+  size_t tail_cache_ = 0;
+  // producer side
+  alignas(detail::kCacheLineSize) std::atomic<size_t> tail_{0};
+  size_t head_cache_ = 0;
+  alignas(detail::kCacheLineSize) EventCount not_empty_;
+  EventCount not_full_;
+};  // class SpscQueue
+
+/**
+ * @brief Bounded lock-free ring queue for any number of producer threads and one consumer thread
+ *
+ * Has the same Push/TryPop/WaitAndTryPop interface as ThreadSafeQueue. Push() blocks while the queue is full,
+ * TryPush() fails instead. Elements of one producer are popped in the order they are pushed.
+ * A popped slot keeps the moved-from element until it is pushed over.
+ *
+ * @note A producer preempted in the middle of a push holds up the elements pushed after it, until it resumes.
+ * @tparam T Type of stored elements, which should be default constructible and move assignable
+ */
+template <typename T>
+class MpscQueue {
+ public:
+  /// type of elements
+  using value_type = T;
+  /// type of size
+  using size_type = size_t;
+
+  /**
+   * @brief Construct a new MPSC queue
+   *
+   * @param capacity Minimum number of elements the queue holds, rounded up to a power of two (at least 2)
+   */
+  explicit MpscQueue(size_t capacity)
+      : mask_(detail::RoundUpPowerOfTwo(capacity) - 1), cells_(new Cell[mask_ + 1]) {
+    for (size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Try to push an element to the end of the queue
+   *
+   * @param new_value the value of the element to push
+   * @retval true Succeed
+   * @retval false Fail, the queue is full
+   */
+  bool TryPush(const T& new_value) { return Enqueue(new_value); }
+  /// @overload
+  bool TryPush(T&& new_value) { return Enqueue(std::move(new_value)); }
+
+  /**
+   * @brief Pushes the given element value to the end of the queue, wait if the queue is full
+   *
+   * @param new_value the value of the element to push
+   */
+  void Push(const T& new_value) { BlockingPush(new_value); }
+  /// @overload
+  void Push(T&& new_value) { BlockingPush(std::move(new_value)); }
+
+  /**
+   * @brief Try to pop an element from queue. Only the consumer thread may call it.
+   *
+   * @param value An element
+   * @retval true Succeed
+   * @retval false Fail, no element stored in queue
+   */
+  bool TryPop(T& value) {  // NOLINT
+    size_t head = head_.load(std::memory_order_relaxed);
+    Cell& cell = cells_[head & mask_];
+    if (cell.sequence.load(std::memory_order_acquire) != head + 1) return false;
+    value = std::move(cell.data);
+    // the slot is free for the push one lap later
+    cell.sequence.store(head + mask_ + 1, std::memory_order_release);
+    head_.store(head + 1, std::memory_order_release);
+    not_full_.Notify();
+    return true;
+  }
+
+  /**
+   * @brief Try to pop an element from queue, wait for `rel_time` if queue is empty.
+   *        Only the consumer thread may call it.
+   *
+   * @param value An element
+   * @param rel_time Maximum duration to block for
+   * @retval true Succeed
+   * @retval false Timeout
+   */
+  bool WaitAndTryPop(T& value, const std::chrono::microseconds rel_time) {  // NOLINT
+    return detail::WaitAndPop(&not_empty_, rel_time, [&] { return TryPop(value); });
+  }
+
+  /**
+   * @brief Checks if the queue has no elements
+   *
+   * @retval true If the queue is empty
+   * @retval false Otherwise
+   */
+  bool Empty() const { return Size() == 0; }
+
+  /**
+   * @brief Returns the number of elements in the queue, including those being pushed, which may be out of date
+   *        once returned
+   *
+   * @return size_type The number of elements in the queue
+   */
+  size_type Size() const {
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  /**
+   * @brief Returns the maximum number of elements the queue holds
+   *
+   * @return size_type The capacity
+   */
+  size_type Capacity() const { return mask_ + 1; }
+
+ private:
+  MpscQueue(const MpscQueue& other) = delete;
+  MpscQueue& operator=(const MpscQueue& other) = delete;
+
+  struct Cell {
+    // equals the position a push may take the slot at, or the position + 1 once the element is ready to pop
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  template <typename U>
+  bool Enqueue(U&& new_value) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        return false;  // not popped yet one lap ago
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = std::forward<U>(new_value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    not_empty_.Notify();
+    return true;
+  }
+
+  template <typename U>
+  void BlockingPush(U&& new_value) {
+    // the value is only moved from once a slot is got, so trying again is fine
+    while (true) {
+      if (Enqueue(std::forward<U>(new_value))) return;
+      EventCount::Key key = not_full_.PrepareWait();
+      if (Enqueue(std::forward<U>(new_value))) {
+        not_full_.CancelWait();
+        return;
+      }
+      not_full_.Wait(key);
+    }
+  }
+
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  alignas(detail::kCacheLineSize) std::atomic<size_t> head_{0};
+  alignas(detail::kCacheLineSize) std::atomic<size_t> tail_{0};
+  alignas(detail::kCacheLineSize) EventCount not_empty_;
+  EventCount not_full_;
+};  // class MpscQueue
+
+}  // namespace infer_server
+
+#endif  // INFER_SERVER_UTIL_LOCKFREE_QUEUE_H_
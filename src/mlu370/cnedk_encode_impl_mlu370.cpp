@@ -89,6 +89,29 @@ static void PrintCreateAttr(cncodecEncParam_t *p_attr) {
   printf("%-32s%u\n", "OutputStreamBufSize", p_attr->stream_buf_size);
 }
 
+// wraps the input buffer of the encoder as the destination of transforms
+static void CodecFrameToSurface(const cncodecFrame_t &frame, CnedkBufSurfaceColorFormat color_format, int device_id,
+                                CnedkBufSurfaceParams *params, CnedkBufSurface *surf) {
+  memset(surf, 0, sizeof(CnedkBufSurface));
+  memset(params, 0, sizeof(CnedkBufSurfaceParams));
+  params->data_ptr = reinterpret_cast<void *>(frame.plane[0].dev_addr);
+  params->plane_params.num_planes = 2;
+  params->plane_params.offset[0] = 0;
+  params->plane_params.offset[1] = frame.plane[1].dev_addr - frame.plane[0].dev_addr;
+  params->pitch = (frame.width + CNCODEC_STRIDE_ALIGNMENT - 1) / CNCODEC_STRIDE_ALIGNMENT * CNCODEC_STRIDE_ALIGNMENT;
+  params->width = frame.width;
+  params->height = frame.height;
+  params->plane_params.pitch[0] = params->pitch;
+  params->plane_params.pitch[1] = params->pitch;
+  params->color_format = color_format;
+
+  surf->batch_size = 1;
+  surf->num_filled = 1;
+  surf->surface_list = params;
+  surf->device_id = device_id;
+  surf->mem_type = CNEDK_BUF_MEM_DEVICE;
+}
+
 bool EncoderMlu370::FmtCast(cncodecPixelFormat_t *dst_fmt, CnedkBufSurfaceColorFormat src_fmt) {
   switch (src_fmt) {
     case CNEDK_BUF_COLOR_FORMAT_NV12:
@@ -167,7 +190,8 @@ int EncoderMlu370::Create(CnedkVencCreateParams *params) {
   cn_param.frame_rate_den = 100;
   cn_param.input_stride_align = 64;
   cn_param.input_buf_num = input_buffer_count_;
-  cn_param.input_buf_source = CNCODEC_BUF_SOURCE_LIB;
+  // in zero-copy mode, the input buffers are allocated by the encoder itself or imported from BufSurfaces
+  cn_param.input_buf_source = params->zero_copy ? CNCODEC_BUF_SOURCE_USER : CNCODEC_BUF_SOURCE_LIB;
   cn_param.stream_buf_size = 0;
   cn_param.user_context = reinterpret_cast<void *>(this);
 
@@ -209,6 +233,27 @@ int EncoderMlu370::Create(CnedkVencCreateParams *params) {
 
   created_ = true;
 
+  if (params->zero_copy) {
+    // the input buffers for the frames which can not be imported
+    size_t pitch = (width_ + CNCODEC_STRIDE_ALIGNMENT - 1) / CNCODEC_STRIDE_ALIGNMENT * CNCODEC_STRIDE_ALIGNMENT;
+    size_t frame_size = pitch * height_ * 3 / 2;
+    CNRT_SAFECALL(cnrtMalloc(&input_mem_, frame_size * input_buffer_count_),
+                  "[EncoderMlu370] Create(): malloc input buffers failed.", -1);
+    for (uint32_t i = 0; i < input_buffer_count_; ++i) {
+      cncodecFrame_t frame;
+      memset(&frame, 0, sizeof(frame));
+      frame.width = width_;
+      frame.height = height_;
+      FmtCast(&frame.pixel_format, color_format_);
+      frame.plane_num = 2;
+      frame.plane[0].dev_addr = reinterpret_cast<u64_t>(input_mem_) + i * frame_size;
+      frame.plane[0].stride = pitch;
+      frame.plane[1].dev_addr = frame.plane[0].dev_addr + pitch * height_;
+      frame.plane[1].stride = pitch;
+      cnframe_queue_.push(frame);
+    }
+  }
+
   return 0;
 }
 
@@ -235,6 +280,13 @@ int EncoderMlu370::Destroy() {
 
   instance_ = 0;
 
+  ReleaseInputFrames();
+  if (input_mem_) {
+    std::queue<cncodecFrame_t>().swap(cnframe_queue_);
+    cnrtFree(input_mem_);
+    input_mem_ = nullptr;
+  }
+
   if (src_bgr_mlu_) {
     cnrtFree(src_bgr_mlu_);
     src_bgr_mlu_ = nullptr;
@@ -249,8 +301,19 @@ int EncoderMlu370::Destroy() {
   return 0;
 }
 
-int EncoderMlu370::RequestFrame(cncodecFrame_t *frame) {
+int EncoderMlu370::RequestFrame(cncodecFrame_t *frame, int timeout_ms) {
   std::unique_lock<std::mutex> lk(cnframe_queue_mutex_);
+  if (create_params_.zero_copy) {
+    // the input buffers are given back when the frames are encoded
+    if (!cnframe_queue_cond_.wait_for(lk, std::chrono::milliseconds(timeout_ms),
+                                      [this] { return !cnframe_queue_.empty(); })) {
+      LOG(ERROR) << "[EasyDK] [EncoderMlu370] RequestFrame(): Wait for available input buffer timeout";
+      return -1;
+    }
+    *frame = cnframe_queue_.front();
+    cnframe_queue_.pop();
+    return 0;
+  }
   if (cnframe_queue_.size()) {
     *frame = cnframe_queue_.front();
     cnframe_queue_.pop();
@@ -263,7 +326,7 @@ int EncoderMlu370::RequestFrame(cncodecFrame_t *frame) {
   frame->height = height_;
   FmtCast(&frame->pixel_format, color_format_);
 
-  int ecode = cncodecEncWaitAvailInputBuf(instance_, frame, 10000);
+  int ecode = cncodecEncWaitAvailInputBuf(instance_, frame, timeout_ms);
   if (CNCODEC_ERROR_TIMEOUT == ecode) {
     LOG(ERROR) << "[EasyDK] [EncoderMlu370] RequestFrame(): cncodecEncWaitAvailInputBuf timeout";
     return -1;
@@ -289,7 +352,7 @@ int EncoderMlu370::SendFrame(CnedkBufSurface *surf, int timeout_ms) {
       return 0;
     }
 
-    while (cnframe_queue_.size()) {  // free cache codec buffer
+    while (!create_params_.zero_copy && cnframe_queue_.size()) {  // free cache codec buffer
       cncodecFrame_t cn_frame;
       cn_frame = cnframe_queue_.front();
       cnframe_queue_.pop();
@@ -327,9 +390,13 @@ int EncoderMlu370::SendFrame(CnedkBufSurface *surf, int timeout_ms) {
 
   int timeout = timeout_ms < 0 ? 0x7fffffff : timeout_ms;  // TODO(hqw): temp fix for cncodec bug
 
+  if (create_params_.zero_copy) {
+    return SendFrameZeroCopy(surf, timeout);
+  }
+
   // 1. get cn_frame
   cncodecFrame_t cn_frame;
-  ret = RequestFrame(&cn_frame);
+  ret = RequestFrame(&cn_frame, timeout);
   if (ret < 0) {
     LOG(ERROR) << "[EasyDK] [EncoderMlu370] SendFrame(): Request frame failed, ret = " << ret;
     return ret;
@@ -338,31 +405,7 @@ int EncoderMlu370::SendFrame(CnedkBufSurface *surf, int timeout_ms) {
   {
     CnedkBufSurface transform_dst;
     CnedkBufSurfaceParams dst_param;
-    memset(&transform_dst, 0, sizeof(CnedkBufSurface));
-    memset(&dst_param, 0, sizeof(CnedkBufSurfaceParams));
-
-    {  // prepare transform output
-      transform_dst.batch_size = 1;
-      transform_dst.num_filled = 1;
-
-      dst_param.data_ptr = reinterpret_cast<void *>(cn_frame.plane[0].dev_addr);
-      dst_param.plane_params.num_planes = 2;
-      dst_param.plane_params.offset[0] = 0;
-      dst_param.plane_params.offset[1] = cn_frame.plane[1].dev_addr - cn_frame.plane[0].dev_addr;
-
-      dst_param.pitch =
-          (cn_frame.width + CNCODEC_STRIDE_ALIGNMENT - 1) / CNCODEC_STRIDE_ALIGNMENT * CNCODEC_STRIDE_ALIGNMENT;
-      dst_param.width = cn_frame.width;
-      dst_param.height = cn_frame.height;
-      dst_param.plane_params.num_planes = 2;
-      dst_param.plane_params.pitch[0] = dst_param.pitch;
-      dst_param.plane_params.pitch[1] = dst_param.pitch;
-      dst_param.color_format = color_format_;
-
-      transform_dst.surface_list = &dst_param;
-      transform_dst.device_id = mlu_device_id_;
-      transform_dst.mem_type = CNEDK_BUF_MEM_DEVICE;
-    }
+    CodecFrameToSurface(cn_frame, color_format_, mlu_device_id_, &dst_param, &transform_dst);
     ret = Transform(*surf, &transform_dst);
     if (ret < 0) {
       std::unique_lock<std::mutex> lk(cnframe_queue_mutex_);
@@ -402,6 +445,114 @@ int EncoderMlu370::SendFrame(CnedkBufSurface *surf, int timeout_ms) {
   return 0;
 }
 
+bool EncoderMlu370::CanImport(const CnedkBufSurface &surf) {
+  const CnedkBufSurfaceParams &params = surf.surface_list[0];
+  return surf.mem_type == CNEDK_BUF_MEM_DEVICE && params.color_format == color_format_ &&
+         params.width == width_ && params.height == height_ &&
+         params.plane_params.pitch[0] % CNCODEC_STRIDE_ALIGNMENT == 0 &&
+         params.plane_params.pitch[1] == params.plane_params.pitch[0];
+}
+
+int EncoderMlu370::SendFrameZeroCopy(CnedkBufSurface *surf, int timeout_ms) {
+  InputFrame input;
+  memset(&input.codec_frame, 0, sizeof(input.codec_frame));
+  input.surf = nullptr;
+  const CnedkBufSurfaceParams &params = surf->surface_list[0];
+  if (CanImport(*surf)) {
+    // the encoder reads the BufSurface directly, it is held until the frame is encoded
+    input.surf = surf;
+    input.codec_frame.width = width_;
+    input.codec_frame.height = height_;
+    FmtCast(&input.codec_frame.pixel_format, color_format_);
+    input.codec_frame.plane_num = 2;
+    for (int i = 0; i < 2; ++i) {
+      input.codec_frame.plane[i].dev_addr = reinterpret_cast<u64_t>(params.data_ptr) + params.plane_params.offset[i];
+      input.codec_frame.plane[i].stride = params.plane_params.pitch[i];
+    }
+  } else {
+    // convert into one of the input buffers directly
+    if (RequestFrame(&input.codec_frame, timeout_ms) < 0) {
+      LOG(ERROR) << "[EasyDK] [EncoderMlu370] SendFrameZeroCopy(): Request frame failed";
+      return -1;
+    }
+    CnedkBufSurface transform_dst;
+    CnedkBufSurfaceParams dst_param;
+    CodecFrameToSurface(input.codec_frame, color_format_, mlu_device_id_, &dst_param, &transform_dst);
+    if (Transform(*surf, &transform_dst) < 0) {
+      std::unique_lock<std::mutex> lk(cnframe_queue_mutex_);
+      cnframe_queue_.push(input.codec_frame);
+      cnframe_queue_cond_.notify_one();
+      LOG(ERROR) << "[EasyDK] [EncoderMlu370] SendFrameZeroCopy(): Transform frame failed";
+      return -1;
+    }
+  }
+  input.pts = surf->pts;
+
+  // recorded before sending, the bitstream may come before cncodecEncSendFrame returns
+  std::list<InputFrame>::iterator it;
+  {
+    std::unique_lock<std::mutex> lk(cnframe_queue_mutex_);
+    input.codec_frame.pts = input_seq_++;
+    it = encoding_frames_.insert(encoding_frames_.end(), input);
+  }
+  cncodecEncPicAttr_t frame_attr;
+  memset(&frame_attr, 0, sizeof(cncodecEncPicAttr_t));
+  if (codec_type_ == CNEDK_VENC_TYPE_JPEG) {
+    frame_attr.jpg_pic_attr.jpeg_param.quality = jpeg_quality_;
+  }
+  i32_t cnret = cncodecEncSendFrame(instance_, &input.codec_frame, &frame_attr, timeout_ms);
+  if (CNCODEC_SUCCESS != cnret) {
+    LOG(ERROR) << "[EasyDK] [EncoderMlu370] SendFrameZeroCopy(): cncodecEncSendFrame failed, ret = " << cnret;
+    // the BufSurface is still owned by the caller
+    std::unique_lock<std::mutex> lk(cnframe_queue_mutex_);
+    encoding_frames_.erase(it);
+    if (!input.surf) {
+      cnframe_queue_.push(input.codec_frame);
+      cnframe_queue_cond_.notify_one();
+    }
+    return CNCODEC_ERROR_TIMEOUT == cnret ? -2 : -1;
+  }
+  frame_count_++;
+  if (!input.surf) {
+    // converted, the BufSurface is not needed any more
+    CnedkBufSurfaceDestroy(surf);
+  }
+  return 0;
+}
+
+bool EncoderMlu370::FindInputFrame(uint64_t seq, bool release, uint64_t *pts) {
+  std::unique_lock<std::mutex> lk(cnframe_queue_mutex_);
+  auto it = std::find_if(encoding_frames_.begin(), encoding_frames_.end(),
+                         [seq](const InputFrame &frame) { return frame.codec_frame.pts == seq; });
+  if (it == encoding_frames_.end()) return false;
+  *pts = it->pts;
+  if (!release) return true;
+  InputFrame input = *it;
+  encoding_frames_.erase(it);
+  if (!input.surf) {
+    cnframe_queue_.push(input.codec_frame);
+    cnframe_queue_cond_.notify_one();
+    return true;
+  }
+  lk.unlock();
+  CnedkBufSurfaceDestroy(input.surf);
+  return true;
+}
+
+void EncoderMlu370::ReleaseInputFrames() {
+  std::unique_lock<std::mutex> lk(cnframe_queue_mutex_);
+  std::list<InputFrame> frames;
+  frames.swap(encoding_frames_);
+  for (auto &input : frames) {
+    if (!input.surf) cnframe_queue_.push(input.codec_frame);
+  }
+  cnframe_queue_cond_.notify_all();
+  lk.unlock();
+  for (auto &input : frames) {
+    if (input.surf) CnedkBufSurfaceDestroy(input.surf);
+  }
+}
+
 int EncoderMlu370::Transform(const CnedkBufSurface &src, CnedkBufSurface *dst) {
   // case 1: bgr(cpu) -> bgr(device) -> yuv(the same resolution with bgr) -> yuv (dst resolution)
   // case 2: bgr(cpu) -> bgr(device) -> yuv (dst resolution)
@@ -587,6 +738,39 @@ void EncoderMlu370::OnFrameBits(void *_packet) {
       cnFrameBits.pkt_type = CNEDK_VENC_PACKAGE_TYPE_FRAME;
     }
 
+    uint64_t pts = stream->pts;
+    if (create_params_.zero_copy) {
+      // the input frame has been encoded, the parameter sets come before the bitstream of the frame
+      bool release = cnFrameBits.pkt_type != CNEDK_VENC_PACKAGE_TYPE_SPS_PPS;
+      if (!FindInputFrame(stream->pts, release, &pts)) {
+        LOG(WARNING) << "[EasyDK] [EncoderMlu370] OnFrameBits(): Unknown input frame, sequence number: "
+                     << stream->pts;
+      }
+    }
+
+    if (ring_ && first_frame_ && cnFrameBits.pkt_type != CNEDK_VENC_PACKAGE_TYPE_SPS_PPS) {
+      first_frame_ = false;
+      if (head_pkg_.bits) {
+        create_params_.OnFrameBits(&head_pkg_, create_params_.userdata);
+        delete[] head_pkg_.bits;
+      }
+    }
+    // copied into the bitstream ring directly, the parameter sets held for the first frame are copied to host first
+    if (ring_ && !(first_frame_ && cnFrameBits.pkt_type == CNEDK_VENC_PACKAGE_TYPE_SPS_PPS)) {
+      cnFrameBits.len = stream->data_len;
+      cnFrameBits.pts = pts;
+      uint8_t *dst = ring_->Reserve(stream->data_len);
+      if (!dst) return;
+      if (cnrtMemcpy(dst, reinterpret_cast<void *>(stream->mem_addr + stream->data_offset), stream->data_len,
+                     CNRT_MEM_TRANS_DIR_DEV2HOST) != cnrtSuccess) {
+        ring_->Cancel();
+        LOG(ERROR) << "[EasyDK] [EncoderMlu370] OnFrameBits(): Copy bitstream into the ring failed, D2H";
+        return;
+      }
+      ring_->Commit(cnFrameBits);
+      return;
+    }
+
     // std::unique_ptr<uint8_t> packet_data {new (std::nothrow) uint8_t[stream->data_len]};
     uint8_t *packet_data = nullptr;
     try {
@@ -608,7 +792,7 @@ void EncoderMlu370::OnFrameBits(void *_packet) {
 
     cnFrameBits.bits = packet_data;
     cnFrameBits.len = stream->data_len;
-    cnFrameBits.pts = stream->pts;
+    cnFrameBits.pts = pts;
 
     if (first_frame_ && cnFrameBits.pkt_type == CNEDK_VENC_PACKAGE_TYPE_SPS_PPS) {
       head_pkg_ = cnFrameBits;
@@ -632,6 +816,7 @@ void EncoderMlu370::OnFrameBits(void *_packet) {
 }
 
 void EncoderMlu370::OnEos() {
+  ReleaseInputFrames();
   eos_promise_->set_value();
   create_params_.OnEos(create_params_.userdata);
 }
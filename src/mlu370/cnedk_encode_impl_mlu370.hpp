@@ -22,6 +22,7 @@
 #define CNEDK_ENCODE_IMPL_MLU370_HPP_
 
 #include <atomic>
+#include <condition_variable>
 #include <future>
 #include <list>
 #include <map>
@@ -51,15 +52,34 @@ class EncoderMlu370 : public IEncoder {
   void OnError(int errcode);
 
  private:
-  int RequestFrame(cncodecFrame_t* frame);
+  int RequestFrame(cncodecFrame_t* frame, int timeout_ms);
+  int SendFrameZeroCopy(CnedkBufSurface* surf, int timeout_ms);
+  bool CanImport(const CnedkBufSurface& surf);
+  // Finds the input frame by the sequence number sent as its codec pts and gets the pts of the BufSurface. The frame
+  // is released if `release` is true. Returns false if the frame is not found.
+  bool FindInputFrame(uint64_t seq, bool release, uint64_t* pts);
+  void ReleaseInputFrames();
   int Transform(const CnedkBufSurface& src, CnedkBufSurface* dst);
   bool FmtCast(cncodecPixelFormat_t* dst_fmt, CnedkBufSurfaceColorFormat src_fmt);
 
  private:
   CnedkVencCreateParams create_params_;
   void* venc_ = nullptr;
-  std::queue<cncodecFrame_t> cnframe_queue_;
+  std::queue<cncodecFrame_t> cnframe_queue_;  // the free input buffers in zero-copy mode
   std::mutex cnframe_queue_mutex_;
+  std::condition_variable cnframe_queue_cond_;
+
+  // zero-copy mode, the frames sent and not encoded yet, surf is the imported BufSurface or nullptr if the frame is
+  // one of the input buffers allocated by the encoder. The pts of the codec frame is a sequence number rather than the
+  // pts of the BufSurface, which may be repeated or zero, so the bitstream is matched to its input frame exactly.
+  struct InputFrame {
+    cncodecFrame_t codec_frame;
+    CnedkBufSurface* surf;
+    uint64_t pts;
+  };
+  std::list<InputFrame> encoding_frames_;
+  uint64_t input_seq_ = 0;
+  void* input_mem_ = nullptr;
 
   std::atomic<bool> created_{false};
   std::atomic<bool> eos_sent_{false};  // flag for cndec-eos has been sent to decoder
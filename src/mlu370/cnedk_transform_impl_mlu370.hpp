@@ -40,6 +40,8 @@ class TransformerMlu370 : public ITransformer {
   }
   ~TransformerMlu370() = default;
   int Transform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) override;
+  int TransformRoi(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformRoiParams *roi_params) override;
+  ITransformPlan *CreatePlan(const CnedkTransformPlanParams &params) override;
 
  private:
   CnedkTransformConfigParams params_;
@@ -30,9 +30,17 @@
 #include "../common/utils.hpp"
 
 static constexpr int DECODE_MAX_TRY_SEND_TIME = 3;
+// the frame buffers added for the frames held by the user in zero-copy mode, if frame_buf_num is not set
+static constexpr uint32_t DECODE_ZERO_COPY_EXTRA_BUF_NUM = 4;
 
 namespace cnedk {
 
+// A frame buffer of the decoder wrapped by a zero-copy BufSurface, surface_list of the BufSurface points to params
+struct ZeroCopyFrame {
+  CnedkBufSurfaceParams params;
+  cncodecFrame_t codec_frame;
+};
+
 static i32_t DecoderEventCallback(cncodecEventType_t type, void *ctx, void *output) {
   auto decoder = reinterpret_cast<DecoderMlu590 *>(ctx);
   switch (type) {
@@ -61,6 +69,7 @@ static i32_t DecoderEventCallback(cncodecEventType_t type, void *ctx, void *outp
 // IDecoder
 int DecoderMlu590::Create(CnedkVdecCreateParams *params) {
   create_params_ = *params;
+  outputs_.Init(create_params_);
 
   memset(&create_info_, 0, sizeof(create_info_));
   memset(&codec_params_, 0, sizeof(codec_params_));
@@ -108,7 +117,7 @@ int DecoderMlu590::Create(CnedkVdecCreateParams *params) {
   created_ = true;
 
   if (create_params_.type == CNEDK_VDEC_TYPE_JPEG) {
-    codec_params_.output_buf_num = 2;
+    codec_params_.output_buf_num = GetOutputBufNum(1);
   }
 
   codec_params_.color_space = CNCODEC_COLOR_SPACE_BT_709;
@@ -163,6 +172,14 @@ int DecoderMlu590::Destroy() {
 }
 
 int DecoderMlu590::SendStream(const CnedkVdecStream *stream, int timeout_ms) {
+  return DoSendStream(stream, timeout_ms, DECODE_MAX_TRY_SEND_TIME);
+}
+
+int DecoderMlu590::TrySendStream(const CnedkVdecStream *stream, int timeout_ms) {
+  return DoSendStream(stream, timeout_ms, 1);
+}
+
+int DecoderMlu590::DoSendStream(const CnedkVdecStream *stream, int timeout_ms, int max_try) {
   if (!created_) {
     LOG(ERROR) << "[EasyDK] [DecoderMlu590] SendStream(): Decoder is not created";
     return -1;
@@ -190,13 +207,17 @@ int DecoderMlu590::SendStream(const CnedkVdecStream *stream, int timeout_ms) {
                  << stream->pts;
       return -1;
     }
+    if (!outputs_.Accept(stream)) {
+      VLOG(5) << "[EasyDK] [DecoderMlu590] SendStream(): Packet is dropped in the decode mode, pts: " << stream->pts;
+      return 0;
+    }
     cncodecStream_t codec_input;
     memset(&codec_input, 0, sizeof(codec_input));
     codec_input.mem_type = CNCODEC_MEM_TYPE_HOST;
     codec_input.mem_addr = reinterpret_cast<u64_t>(stream->bits);
     codec_input.data_len = stream->len;
     codec_input.pts = stream->pts;
-    int max_try_send_time = DECODE_MAX_TRY_SEND_TIME;
+    int max_try_send_time = max_try;
     while (max_try_send_time--) {
       int codec_ret = cncodecDecSendStream(instance_, &codec_input, timeout_ms);
       switch (codec_ret) {
@@ -206,16 +227,21 @@ int DecoderMlu590::SendStream(const CnedkVdecStream *stream, int timeout_ms) {
         case CNCODEC_ERROR_NOT_SUPPORTED:
           return -3;
         case CNCODEC_ERROR_TIMEOUT:
-          LOG(INFO) << "[EasyDK] [DecoderMlu590] SendStream(): cncodecDecSendStream timeout happened, retry feed data,"
-                    << " remaining times: " << max_try_send_time;
+          if (max_try_send_time > 0) {
+            LOG(INFO) << "[EasyDK] [DecoderMlu590] SendStream(): cncodecDecSendStream timeout happened, retry feed"
+                      << " data, remaining times: " << max_try_send_time;
+          }
           continue;
         default:
           LOG(ERROR) << "[EasyDK] [DecoderMlu590] SendStream(): cncodecDecSendStream failed, ret = " << codec_ret;
           return -1;
       }  // switch send stream ret
     }    // while timeout
-    LOG(INFO) << "[EasyDK] [DecoderMlu590] SendStream(): cncodecDecSendStream timeout happened,"
-              << " retry times: " << DECODE_MAX_TRY_SEND_TIME;
+    // a single try is made by the callers that handle the full decoder themselves, it is not an error for them
+    if (max_try > 1) {
+      LOG(INFO) << "[EasyDK] [DecoderMlu590] SendStream(): cncodecDecSendStream timeout happened,"
+                 << " retry times: " << max_try;
+    }
     return -2;
   }
   return 0;
@@ -232,10 +258,18 @@ int DecoderMlu590::SetDecParams() {
 
 // IVDecResult
 void DecoderMlu590::OnFrame(cncodecFrame_t *codec_frame) {
+  // the codec buffer is released after the callback returns
+  if (outputs_.Skip()) return;
+
   // FIXME
   codec_frame->width += codec_frame->width & 1;
   codec_frame->height -= codec_frame->height & 1;
 
+  if (create_params_.zero_copy) {
+    OnZeroCopyFrame(codec_frame);
+    return;
+  }
+
   CnedkBufSurface *surf = nullptr;
   if (create_params_.GetBufSurf(&surf, codec_frame->width, codec_frame->height, GetSurfFmt(codec_frame->pixel_format),
                                 create_params_.surf_timeout_ms, create_params_.userdata) < 0) {
@@ -318,7 +352,82 @@ void DecoderMlu590::OnFrame(cncodecFrame_t *codec_frame) {
 
   surf->pts = codec_frame->pts;
 
-  create_params_.OnFrame(surf, create_params_.userdata);
+  outputs_.Deliver(surf);
+}
+
+uint32_t DecoderMlu590::GetOutputBufNum(uint32_t min_buf_num) {
+  if (!create_params_.zero_copy) return min_buf_num + 1;
+  if (create_params_.frame_buf_num) return std::max(min_buf_num + 1, create_params_.frame_buf_num);
+  return min_buf_num + 1 + DECODE_ZERO_COPY_EXTRA_BUF_NUM;
+}
+
+void DecoderMlu590::OnZeroCopyFrame(cncodecFrame_t *codec_frame) {
+  if (codec_frame->pixel_format != CNCODEC_PIX_FMT_NV12 && codec_frame->pixel_format != CNCODEC_PIX_FMT_NV21) {
+    LOG(ERROR) << "[EasyDK] [DecoderMlu590] OnZeroCopyFrame(): Unsupported pixel format: "
+               << static_cast<int>(codec_frame->pixel_format);
+    OnError(-1);
+    return;
+  }
+  // hold the frame buffer until the BufSurface is destroyed
+  int codec_ret = cncodecDecFrameRef(instance_, codec_frame);
+  if (CNCODEC_SUCCESS != codec_ret) {
+    LOG(ERROR) << "[EasyDK] [DecoderMlu590] OnZeroCopyFrame(): cncodecDecFrameRef failed, ret = " << codec_ret;
+    OnError(-1);
+    return;
+  }
+  ++cndec_buf_ref_count_;
+
+  ZeroCopyFrame *frame = new ZeroCopyFrame;
+  frame->codec_frame = *codec_frame;
+  CnedkBufSurfaceParams &params = frame->params;
+  memset(&params, 0, sizeof(params));
+  params.width = codec_frame->width;
+  params.height = codec_frame->height;
+  params.pitch = codec_frame->plane[0].stride;
+  params.color_format = GetSurfFmt(codec_frame->pixel_format);
+  params.data_ptr = reinterpret_cast<void *>(codec_frame->plane[0].dev_addr);
+  params.plane_params.num_planes = 2;
+  params.plane_params.width[0] = params.plane_params.width[1] = codec_frame->width;
+  params.plane_params.height[0] = codec_frame->height;
+  params.plane_params.height[1] = codec_frame->height / 2;
+  params.plane_params.pitch[0] = codec_frame->plane[0].stride;
+  params.plane_params.pitch[1] = codec_frame->plane[1].stride;
+  params.plane_params.offset[0] = 0;
+  params.plane_params.offset[1] = codec_frame->plane[1].dev_addr - codec_frame->plane[0].dev_addr;
+  params.plane_params.psize[0] = codec_frame->plane[0].stride * codec_frame->height;
+  params.plane_params.psize[1] = codec_frame->plane[1].stride * codec_frame->height / 2;
+  params.plane_params.bytes_per_pix[0] = params.plane_params.bytes_per_pix[1] = 1;
+  params.data_size = params.plane_params.offset[1] + params.plane_params.psize[1];
+
+  CnedkBufSurface surface;
+  memset(&surface, 0, sizeof(surface));
+  surface.mem_type = CNEDK_BUF_MEM_DEVICE;
+  surface.device_id = create_params_.device_id;
+  surface.batch_size = 1;
+  surface.num_filled = 1;
+  surface.surface_list = &frame->params;
+  surface.pts = codec_frame->pts;
+
+  CnedkBufSurface *surf = nullptr;
+  if (CreateSurfaceFromOwner(&surf, surface, this) < 0) {
+    LOG(ERROR) << "[EasyDK] [DecoderMlu590] OnZeroCopyFrame(): Create BufSurface failed";
+    Free(&surface);
+    OnError(-1);
+    return;
+  }
+  outputs_.Deliver(surf);
+}
+
+int DecoderMlu590::Free(CnedkBufSurface *surf) {
+  ZeroCopyFrame *frame = reinterpret_cast<ZeroCopyFrame *>(surf->surface_list);
+  int codec_ret = cncodecDecFrameUnref(instance_, &frame->codec_frame);
+  delete frame;
+  --cndec_buf_ref_count_;
+  if (CNCODEC_SUCCESS != codec_ret) {
+    LOG(ERROR) << "[EasyDK] [DecoderMlu590] Free(): cncodecDecFrameUnref failed, ret = " << codec_ret;
+    return -1;
+  }
+  return 0;
 }
 
 void DecoderMlu590::OnEos() {
@@ -359,7 +468,7 @@ void DecoderMlu590::ReceiveSequence(cncodecDecSequenceInfo_t *seq_info) {
       codec_params_.max_height = seq_info->coded_height;
     }
 
-    codec_params_.output_buf_num = seq_info->min_output_buf_num + 1;
+    codec_params_.output_buf_num = GetOutputBufNum(seq_info->min_output_buf_num);
     if (!SetDecParams()) {
       LOG(ERROR) << "[EasyDK] [DecoderMlu590] ReceiveSequence(): Set decoder params failed";
       error_flag_ = true;
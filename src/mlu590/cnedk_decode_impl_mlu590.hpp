@@ -29,11 +29,12 @@
 #include "cncodec_v3_common.h"
 #include "cncodec_v3_dec.h"
 
+#include "../cnedk_buf_surface_impl.h"
 #include "../cnedk_decode_impl.hpp"
 
 namespace cnedk {
 
-class DecoderMlu590 : public IDecoder {
+class DecoderMlu590 : public IDecoder, public IBufSurfaceOwner {
  public:
   DecoderMlu590() = default;
   ~DecoderMlu590() = default;
@@ -41,6 +42,7 @@ class DecoderMlu590 : public IDecoder {
   int Create(CnedkVdecCreateParams *params) override;
   int Destroy() override;
   int SendStream(const CnedkVdecStream *stream, int timeout_ms) override;
+  int TrySendStream(const CnedkVdecStream *stream, int timeout_ms) override;
   CnedkBufSurfaceColorFormat GetSurfFmt(cncodecPixelFormat_t format) {
     static std::map<cncodecPixelFormat_t, CnedkBufSurfaceColorFormat> color_map{
         {CNCODEC_PIX_FMT_NV12, CNEDK_BUF_COLOR_FORMAT_NV12},
@@ -49,6 +51,9 @@ class DecoderMlu590 : public IDecoder {
     return color_map[format];
   }
 
+  // IBufSurfaceOwner, gives the frame buffer wrapped by a zero-copy BufSurface back to the decoder
+  int Free(CnedkBufSurface *surf) override;
+
   // IVDecResult
   void OnFrame(cncodecFrame_t *codec_frame);
   void OnEos();
@@ -63,8 +68,12 @@ class DecoderMlu590 : public IDecoder {
   void HandleUnknownEvent(cncodecEventType_t type);
 
  private:
+  // Tries to send the packet max_try times, -2 is returned if the decoder is still full
+  int DoSendStream(const CnedkVdecStream *stream, int timeout_ms, int max_try);
   int SetDecParams();
   void ResetFlags();
+  uint32_t GetOutputBufNum(uint32_t min_buf_num);
+  void OnZeroCopyFrame(cncodecFrame_t *codec_frame);
 
  private:
   std::atomic<int> cndec_buf_ref_count_{0};
@@ -74,6 +83,7 @@ class DecoderMlu590 : public IDecoder {
   std::unique_ptr<std::promise<void>> eos_promise_;
 
   CnedkVdecCreateParams create_params_;
+  FrameOutputs outputs_;
   cncodecDecCreateInfo_t create_info_;
   cncodecDecParams_t codec_params_;
   cncodecHandle_t instance_ = 0;
@@ -522,6 +522,22 @@ void EncoderMlu590::OnFrameBits(void *_packet) {
 
     cnFrameBits.pkt_type = CNEDK_VENC_PACKAGE_TYPE_KEY_FRAME;
 
+    // copied into the bitstream ring directly
+    if (ring_) {
+      cnFrameBits.len = stream->data_len;
+      cnFrameBits.pts = stream->pts;
+      uint8_t *dst = ring_->Reserve(stream->data_len);
+      if (!dst) return;
+      if (cnrtMemcpy(dst, reinterpret_cast<void *>(stream->mem_addr + stream->data_offset), stream->data_len,
+                     CNRT_MEM_TRANS_DIR_DEV2HOST) != cnrtSuccess) {
+        ring_->Cancel();
+        LOG(ERROR) << "[EasyDK] [EncoderMlu590] OnFrameBits(): Copy bitstream into the ring failed, D2H";
+        return;
+      }
+      ring_->Commit(cnFrameBits);
+      return;
+    }
+
     // std::unique_ptr<uint8_t> packet_data {new (std::nothrow) uint8_t[stream->data_len]};
     uint8_t *packet_data = nullptr;
     try {
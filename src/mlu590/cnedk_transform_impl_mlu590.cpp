@@ -59,4 +59,30 @@ int TransformerMlu590::Transform(CnedkBufSurface *src, CnedkBufSurface *dst, Cne
   return CncvTransform(src, dst, transform_params);
 }
 
+int TransformerMlu590::TransformRoi(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformRoiParams *roi_params) {
+  if (config_params_.compute_mode != CNEDK_TRANSFORM_COMPUTE_MLU &&
+      config_params_.compute_mode != CNEDK_TRANSFORM_COMPUTE_DEFAULT) {
+    LOG(ERROR) << "[EasyDK] [TransformerMlu590] TransformRoi(): Unsupported compute mode: "
+               << config_params_.compute_mode;
+    return -1;
+  }
+
+  if (src->mem_type != CNEDK_BUF_MEM_DEVICE || dst->mem_type != CNEDK_BUF_MEM_DEVICE) {
+    LOG(ERROR) << "[EasyDK] [TransformerMlu590] TransformRoi(): The src and dst mem_type must be CNEDK_BUF_MEM_DEVICE";
+    return -1;
+  }
+
+  return CncvTransformRoi(src, dst, roi_params);
+}
+
+ITransformPlan *TransformerMlu590::CreatePlan(const CnedkTransformPlanParams &params) {
+  if (config_params_.compute_mode != CNEDK_TRANSFORM_COMPUTE_MLU &&
+      config_params_.compute_mode != CNEDK_TRANSFORM_COMPUTE_DEFAULT) {
+    LOG(ERROR) << "[EasyDK] [TransformerMlu590] CreatePlan(): Unsupported compute mode: "
+               << config_params_.compute_mode;
+    return nullptr;
+  }
+  return CreateCncvTransformPlan(params);
+}
+
 }  // namespace cnedk
@@ -40,6 +40,8 @@ class TransformerMlu590 : public ITransformer {
   }
   ~TransformerMlu590() = default;
   int Transform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) override;
+  int TransformRoi(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformRoiParams *roi_params) override;
+  ITransformPlan *CreatePlan(const CnedkTransformPlanParams &params) override;
 
  private:
   CnedkTransformConfigParams params_;
@@ -0,0 +1,414 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include "cnedk_osd_cpu.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "cnrt.h"
+#include "glog/logging.h"
+
+#include "../common/utils.hpp"
+#include "cnedk_osd_font.hpp"
+
+namespace cnedk {
+
+namespace {
+
+struct Yuv {
+  uint8_t y, u, v;
+};
+
+// BT.601, limited range
+Yuv RgbToYuv(int r, int g, int b) {
+  Yuv yuv;
+  yuv.y = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+  yuv.u = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+  yuv.v = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+  return yuv;
+}
+
+Yuv ColorToYuv(uint32_t color) {  // 0x00rrggbb
+  return RgbToYuv((color >> 16) & 0xff, (color >> 8) & 0xff, color & 0xff);
+}
+
+Yuv Argb1555ToYuv(uint16_t pix) {
+  int r = (pix >> 10) & 0x1f, g = (pix >> 5) & 0x1f, b = pix & 0x1f;
+  return RgbToYuv((r << 3) | (r >> 2), (g << 3) | (g >> 2), (b << 3) | (b >> 2));
+}
+
+struct HostFrame {
+  uint8_t *y_plane = nullptr;
+  uint8_t *uv_plane = nullptr;
+  int y_pitch = 0;
+  int uv_pitch = 0;
+  int width = 0;   // even
+  int height = 0;  // even
+  bool nv21 = false;
+  // luma rows touched by drawing, [dirty_top, dirty_bottom), always even
+  int dirty_top = INT_MAX;
+  int dirty_bottom = 0;
+
+  void MarkDirty(int top, int bottom) {
+    dirty_top = std::min(dirty_top, top);
+    dirty_bottom = std::max(dirty_bottom, bottom);
+  }
+};
+
+void *GetHostPtr(CnedkBufSurface *surf, uint32_t batch_idx) {
+  CnedkBufSurfaceParams *params = &surf->surface_list[batch_idx];
+  switch (surf->mem_type) {
+    case CNEDK_BUF_MEM_SYSTEM:
+    case CNEDK_BUF_MEM_PINNED:
+      return params->data_ptr;
+    case CNEDK_BUF_MEM_UNIFIED:
+    case CNEDK_BUF_MEM_UNIFIED_CACHED:
+    case CNEDK_BUF_MEM_VB:
+    case CNEDK_BUF_MEM_VB_CACHED:
+    case CNEDK_BUF_MEM_DEVICE:  // valid only if the host copy is mapped by BufSurfaceWrapper
+      return params->mapped_data_ptr;
+    default:
+      return nullptr;
+  }
+}
+
+int InitHostFrame(CnedkBufSurface *surf, uint32_t batch_idx, HostFrame *frame, const char *func) {
+  if (batch_idx >= surf->batch_size) {
+    LOG(ERROR) << "[EasyDK] " << func << "(): batch index " << batch_idx << " is out of range";
+    return -1;
+  }
+  CnedkBufSurfaceParams *params = &surf->surface_list[batch_idx];
+  if (params->color_format != CNEDK_BUF_COLOR_FORMAT_NV12 && params->color_format != CNEDK_BUF_COLOR_FORMAT_NV21) {
+    LOG(ERROR) << "[EasyDK] " << func << "(): Unsupported color format: " << params->color_format
+               << ", only NV12/NV21 is supported";
+    return -1;
+  }
+  if (params->plane_params.num_planes != 2) {
+    LOG(ERROR) << "[EasyDK] " << func << "(): Invalid plane number: " << params->plane_params.num_planes;
+    return -1;
+  }
+  uint8_t *host = static_cast<uint8_t *>(GetHostPtr(surf, batch_idx));
+  if (!host) {
+    LOG(ERROR) << "[EasyDK] " << func << "(): The surface is not mapped to cpu, mem_type: " << surf->mem_type;
+    return -1;
+  }
+  frame->y_plane = host + params->plane_params.offset[0];
+  frame->uv_plane = host + params->plane_params.offset[1];
+  frame->y_pitch = params->plane_params.pitch[0];
+  frame->uv_pitch = params->plane_params.pitch[1];
+  frame->width = static_cast<int>(params->width) & ~1;
+  frame->height = static_cast<int>(params->height) & ~1;
+  frame->nv21 = params->color_format == CNEDK_BUF_COLOR_FORMAT_NV21;
+  return 0;
+}
+
+// Clips the rectangle to the frame and aligns it to the 2x2 chroma blocks. Returns false if nothing is left.
+bool ClipRect(const HostFrame &frame, int x, int y, int w, int h, int *x0, int *y0, int *x1, int *y1) {
+  if (w <= 0 || h <= 0) return false;
+  *x0 = std::max(x, 0) & ~1;
+  *y0 = std::max(y, 0) & ~1;
+  *x1 = std::min((x + w + 1) & ~1, frame.width);
+  *y1 = std::min((y + h + 1) & ~1, frame.height);
+  return *x1 > *x0 && *y1 > *y0;
+}
+
+// Fills pairs of interleaved chroma bytes, c0 is the first byte in memory
+void FillUvRow(uint8_t *dst, uint8_t c0, uint8_t c1, int pairs) {
+  int i = 0;
+#if defined(__SSE2__)
+  __m128i v = _mm_set1_epi16(static_cast<int16_t>(c0 | (c1 << 8)));
+  for (; i + 8 <= pairs; i += 8) _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i), v);
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  uint8x16_t v = vreinterpretq_u8_u16(vdupq_n_u16(static_cast<uint16_t>(c0 | (c1 << 8))));
+  for (; i + 8 <= pairs; i += 8) vst1q_u8(dst + 2 * i, v);
+#endif
+  for (; i < pairs; ++i) {
+    dst[2 * i] = c0;
+    dst[2 * i + 1] = c1;
+  }
+}
+
+void FillRegion(HostFrame *frame, int x, int y, int w, int h, const Yuv &yuv) {
+  int x0, y0, x1, y1;
+  if (!ClipRect(*frame, x, y, w, h, &x0, &y0, &x1, &y1)) return;
+  for (int row = y0; row < y1; ++row) {
+    memset(frame->y_plane + row * frame->y_pitch + x0, yuv.y, x1 - x0);
+  }
+  uint8_t c0 = frame->nv21 ? yuv.v : yuv.u;
+  uint8_t c1 = frame->nv21 ? yuv.u : yuv.v;
+  for (int row = y0 / 2; row < y1 / 2; ++row) {
+    FillUvRow(frame->uv_plane + row * frame->uv_pitch + x0, c0, c1, (x1 - x0) / 2);
+  }
+  frame->MarkDirty(y0, y1);
+}
+
+void DrawBox(HostFrame *frame, const CnedkOsdRectParams &param) {
+  int lw = std::max(static_cast<int>(param.line_width), 1);
+  Yuv yuv = ColorToYuv(param.color);
+  if (2 * lw >= param.w || 2 * lw >= param.h) {
+    FillRegion(frame, param.x, param.y, param.w, param.h, yuv);
+    return;
+  }
+  FillRegion(frame, param.x, param.y, param.w, lw, yuv);
+  FillRegion(frame, param.x, param.y + param.h - lw, param.w, lw, yuv);
+  FillRegion(frame, param.x, param.y + lw, lw, param.h - 2 * lw, yuv);
+  FillRegion(frame, param.x + param.w - lw, param.y + lw, lw, param.h - 2 * lw, yuv);
+}
+
+// Pixels with the alpha bit set are drawn opaquely, the others are left untouched. The chroma of a 2x2 block is
+// the average of its opaque pixels.
+void DrawBitmap(HostFrame *frame, const CnedkOsdBitmapParams &param) {
+  if (!param.bitmap_argb1555 || param.w <= 0 || param.h <= 0) {
+    LOG(WARNING) << "[EasyDK] DrawBitmapCpu(): bitmap is null";
+    return;
+  }
+  uint32_t pitch = param.pitch ? param.pitch : static_cast<uint32_t>(param.w) * 2;
+  if (pitch < static_cast<uint32_t>(param.w) * 2) {
+    LOG(WARNING) << "[EasyDK] DrawBitmapCpu(): pitch " << pitch << " is less than the bitmap width " << param.w;
+    return;
+  }
+  int x0, y0, x1, y1;
+  if (!ClipRect(*frame, param.x, param.y, param.w, param.h, &x0, &y0, &x1, &y1)) return;
+  const uint8_t *bitmap = static_cast<const uint8_t *>(param.bitmap_argb1555);
+  // pixels of the aligned region outside the bitmap
+  int bx0 = std::max(param.x, x0), bx1 = std::min(param.x + param.w, x1);
+  int by0 = std::max(param.y, y0), by1 = std::min(param.y + param.h, y1);
+  if (bx1 <= bx0 || by1 <= by0) return;
+
+  uint16_t last_pix = 0;
+  Yuv last_yuv = Argb1555ToYuv(0);
+  auto to_yuv = [&](uint16_t pix) {
+    if (pix != last_pix) {
+      last_pix = pix;
+      last_yuv = Argb1555ToYuv(pix);
+    }
+    return last_yuv;
+  };
+
+  for (int row = y0; row < y1; row += 2) {
+    uint8_t *uv = frame->uv_plane + (row / 2) * frame->uv_pitch;
+    for (int col = x0; col < x1; col += 2) {
+      int u_sum = 0, v_sum = 0, count = 0;
+      for (int dy = row; dy < row + 2; ++dy) {
+        if (dy < by0 || dy >= by1) continue;
+        const uint16_t *src = reinterpret_cast<const uint16_t *>(bitmap + (dy - param.y) * pitch);
+        uint8_t *luma = frame->y_plane + dy * frame->y_pitch;
+        for (int dx = col; dx < col + 2; ++dx) {
+          if (dx < bx0 || dx >= bx1) continue;
+          uint16_t pix = src[dx - param.x];
+          if (!(pix & 0x8000)) continue;
+          Yuv yuv = to_yuv(pix);
+          luma[dx] = yuv.y;
+          u_sum += yuv.u;
+          v_sum += yuv.v;
+          ++count;
+        }
+      }
+      if (!count) continue;
+      uint8_t u = static_cast<uint8_t>((u_sum + count / 2) / count);
+      uint8_t v = static_cast<uint8_t>((v_sum + count / 2) / count);
+      uv[col] = frame->nv21 ? v : u;
+      uv[col + 1] = frame->nv21 ? u : v;
+    }
+  }
+  frame->MarkDirty(y0, y1);
+}
+
+// dst = (dst * (255 - a) + value * a) / 255, rounded
+inline uint8_t Blend(uint8_t dst, uint8_t value, uint8_t a) {
+  uint32_t t = dst * (255u - a) + value * a + 128;
+  return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+
+void BlendRow(uint8_t *dst, const uint8_t *alpha, uint8_t value, int n) {
+  int i = 0;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i k255 = _mm_set1_epi16(255);
+  const __m128i k128 = _mm_set1_epi16(128);
+  const __m128i v = _mm_set1_epi16(value);
+  for (; i + 16 <= n; i += 16) {
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(alpha + i));
+    __m128i res[2];
+    for (int k = 0; k < 2; ++k) {
+      __m128i d16 = k ? _mm_unpackhi_epi8(d, zero) : _mm_unpacklo_epi8(d, zero);
+      __m128i a16 = k ? _mm_unpackhi_epi8(a, zero) : _mm_unpacklo_epi8(a, zero);
+      __m128i t = _mm_add_epi16(_mm_mullo_epi16(d16, _mm_sub_epi16(k255, a16)), _mm_mullo_epi16(v, a16));
+      t = _mm_add_epi16(t, k128);
+      res[k] = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(res[0], res[1]));
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  const uint8x8_t v = vdup_n_u8(value);
+  const uint16x8_t k128 = vdupq_n_u16(128);
+  for (; i + 8 <= n; i += 8) {
+    uint8x8_t d = vld1_u8(dst + i);
+    uint8x8_t a = vld1_u8(alpha + i);
+    uint16x8_t t = vmlal_u8(vmull_u8(d, vmvn_u8(a)), v, a);
+    t = vaddq_u16(t, k128);
+    vst1_u8(dst + i, vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8));
+  }
+#endif
+  for (; i < n; ++i) dst[i] = Blend(dst[i], value, alpha[i]);
+}
+
+void BlendLabel(HostFrame *frame, const OsdLabel &label, int x, int y, const Yuv &yuv) {
+  int x0 = std::max(x, 0), x1 = std::min(x + label.w, frame->width);
+  int y0 = std::max(y, 0), y1 = std::min(y + label.h, frame->height);
+  if (x1 <= x0 || y1 <= y0) return;
+  for (int row = y0; row < y1; ++row) {
+    BlendRow(frame->y_plane + row * frame->y_pitch + x0, &label.alpha[(row - y) * label.w + x0 - x], yuv.y,
+             x1 - x0);
+  }
+  // chroma is blended with the average alpha of each 2x2 block, pixels out of the label are transparent
+  uint8_t c0 = frame->nv21 ? yuv.v : yuv.u;
+  uint8_t c1 = frame->nv21 ? yuv.u : yuv.v;
+  for (int row = y0 & ~1; row < y1; row += 2) {
+    uint8_t *uv = frame->uv_plane + (row / 2) * frame->uv_pitch;
+    for (int col = x0 & ~1; col < x1; col += 2) {
+      int sum = 0;
+      for (int dy = std::max(row, y0); dy < std::min(row + 2, y1); ++dy) {
+        const uint8_t *a = label.alpha.data() + (dy - y) * label.w;
+        for (int dx = std::max(col, x0); dx < std::min(col + 2, x1); ++dx) sum += a[dx - x];
+      }
+      if (!sum) continue;
+      uint8_t alpha = static_cast<uint8_t>((sum + 2) / 4);
+      uv[col] = Blend(uv[col], c0, alpha);
+      uv[col + 1] = Blend(uv[col + 1], c1, alpha);
+    }
+  }
+  frame->MarkDirty(y0 & ~1, std::min((y1 + 1) & ~1, frame->height));
+}
+
+// Writes the dirty rows back to the device. Memory which is coherent with cpu needs nothing to do.
+int SyncDirtyRows(CnedkBufSurface *surf, uint32_t batch_idx, const HostFrame &frame) {
+  if (frame.dirty_bottom <= frame.dirty_top) return 0;
+  if (surf->mem_type != CNEDK_BUF_MEM_DEVICE && surf->mem_type != CNEDK_BUF_MEM_UNIFIED_CACHED &&
+      surf->mem_type != CNEDK_BUF_MEM_VB_CACHED) {
+    return 0;
+  }
+  CnedkBufSurfaceParams *params = &surf->surface_list[batch_idx];
+  const int rows[2][2] = {{frame.dirty_top, frame.dirty_bottom}, {frame.dirty_top / 2, frame.dirty_bottom / 2}};
+  if (surf->mem_type == CNEDK_BUF_MEM_DEVICE) {
+    CNRT_SAFECALL(cnrtSetDevice(surf->device_id), "SyncDirtyRows(): failed", -1);
+  }
+  for (int i = 0; i < 2; ++i) {
+    size_t offset = params->plane_params.offset[i] + static_cast<size_t>(rows[i][0]) * params->plane_params.pitch[i];
+    size_t size = static_cast<size_t>(rows[i][1] - rows[i][0]) * params->plane_params.pitch[i];
+    void *dev = static_cast<uint8_t *>(params->data_ptr) + offset;
+    void *host = static_cast<uint8_t *>(params->mapped_data_ptr) + offset;
+    if (surf->mem_type == CNEDK_BUF_MEM_DEVICE) {
+      CNRT_SAFECALL(cnrtMemcpy(dev, host, size, cnrtMemcpyHostToDev), "SyncDirtyRows(): copy data H2D failed", -1);
+    } else {
+      CNRT_SAFECALL(cnrtMcacheOperation(dev, host, size, CNRT_FLUSH_CACHE), "SyncDirtyRows(): flush cache failed",
+                    -1);
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+bool OsdCpuSupported(CnedkBufSurface *surf) {
+  return surf && surf->batch_size > 0 && surf->surface_list && GetHostPtr(surf, 0);
+}
+
+int DrawRectCpu(CnedkBufSurface *surf, CnedkOsdRectParams *params, uint32_t num) {
+  HostFrame frame;
+  if (InitHostFrame(surf, 0, &frame, "DrawRectCpu") < 0) return -1;
+  for (uint32_t i = 0; i < num; i++) DrawBox(&frame, params[i]);
+  return SyncDirtyRows(surf, 0, frame);
+}
+
+int FillRectCpu(CnedkBufSurface *surf, CnedkOsdRectParams *params, uint32_t num) {
+  HostFrame frame;
+  if (InitHostFrame(surf, 0, &frame, "FillRectCpu") < 0) return -1;
+  for (uint32_t i = 0; i < num; i++) {
+    FillRegion(&frame, params[i].x, params[i].y, params[i].w, params[i].h, ColorToYuv(params[i].color));
+  }
+  return SyncDirtyRows(surf, 0, frame);
+}
+
+int DrawBitmapCpu(CnedkBufSurface *surf, CnedkOsdBitmapParams *params, uint32_t num) {
+  HostFrame frame;
+  if (InitHostFrame(surf, 0, &frame, "DrawBitmapCpu") < 0) return -1;
+  for (uint32_t i = 0; i < num; i++) DrawBitmap(&frame, params[i]);
+  return SyncDirtyRows(surf, 0, frame);
+}
+
+int DrawBatchCpu(CnedkOsdBatchItem *items, uint32_t num) {
+  // items on the same buffer are drawn by one thread and synchronized once
+  std::map<std::pair<CnedkBufSurface *, uint32_t>, std::vector<CnedkOsdBatchItem *>> frames_map;
+  for (uint32_t i = 0; i < num; i++) frames_map[std::make_pair(items[i].surf, items[i].batch_idx)].push_back(&items[i]);
+  std::vector<std::vector<CnedkOsdBatchItem *>> frames;
+  frames.reserve(frames_map.size());
+  for (auto &it : frames_map) frames.push_back(std::move(it.second));
+
+  std::atomic<int> ret(0);
+  ParallelFor(frames.size(), [&](uint32_t i) {
+    CnedkBufSurface *surf = frames[i][0]->surf;
+    uint32_t batch_idx = frames[i][0]->batch_idx;
+    HostFrame frame;
+    if (InitHostFrame(surf, batch_idx, &frame, "DrawBatchCpu") < 0) {
+      ret = -1;
+      return;
+    }
+    for (CnedkOsdBatchItem *item : frames[i]) {
+      for (uint32_t j = 0; j < item->num_fill_rects; j++) {
+        const CnedkOsdRectParams &param = item->fill_rects[j];
+        FillRegion(&frame, param.x, param.y, param.w, param.h, ColorToYuv(param.color));
+      }
+      for (uint32_t j = 0; j < item->num_rects; j++) DrawBox(&frame, item->rects[j]);
+      for (uint32_t j = 0; j < item->num_bitmaps; j++) DrawBitmap(&frame, item->bitmaps[j]);
+    }
+    if (SyncDirtyRows(surf, batch_idx, frame) < 0) ret = -1;
+  });
+  return ret;
+}
+
+int DrawTextCpu(CnedkBufSurface *surf, OsdFont *font, CnedkOsdTextParams *params, uint32_t num) {
+  HostFrame frame;
+  if (InitHostFrame(surf, 0, &frame, "DrawTextCpu") < 0) return -1;
+  for (uint32_t i = 0; i < num; i++) {
+    CnedkOsdTextParams &param = params[i];
+    if (!param.text) continue;
+    std::shared_ptr<const OsdLabel> label = font->GetLabel(param.text);
+    if (param.draw_bg) FillRegion(&frame, param.x, param.y, label->w, label->h, ColorToYuv(param.bg_color));
+    BlendLabel(&frame, *label, param.x, param.y, ColorToYuv(param.color));
+  }
+  return SyncDirtyRows(surf, 0, frame);
+}
+
+}  // namespace cnedk
@@ -0,0 +1,46 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#ifndef CNEDK_OSD_CPU_HPP_
+#define CNEDK_OSD_CPU_HPP_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cnedk_osd.h"
+
+namespace cnedk {
+
+class OsdFont;
+
+// Draws on NV12/NV21 frames in place through the cpu mapped pointer, valid for CNEDK_BUF_MEM_SYSTEM,
+// CNEDK_BUF_MEM_PINNED, CNEDK_BUF_MEM_UNIFIED*, CNEDK_BUF_MEM_VB* and CNEDK_BUF_MEM_DEVICE with a host copy
+// mapped by BufSurfaceWrapper::GetHostData(). Only the rows touched are synchronized back to the device.
+bool OsdCpuSupported(CnedkBufSurface *surf);
+int DrawRectCpu(CnedkBufSurface *surf, CnedkOsdRectParams *params, uint32_t num);
+int FillRectCpu(CnedkBufSurface *surf, CnedkOsdRectParams *params, uint32_t num);
+int DrawBitmapCpu(CnedkBufSurface *surf, CnedkOsdBitmapParams *params, uint32_t num);
+// Frames are drawn in parallel on host cores
+int DrawBatchCpu(CnedkOsdBatchItem *items, uint32_t num);
+// Labels are alpha blended, cached memory must be synchronized for cpu before
+int DrawTextCpu(CnedkBufSurface *surf, OsdFont *font, CnedkOsdTextParams *params, uint32_t num);
+
+}  // namespace cnedk
+
+#endif  // CNEDK_OSD_CPU_HPP_
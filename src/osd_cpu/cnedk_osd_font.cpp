@@ -0,0 +1,200 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include "cnedk_osd_font.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace cnedk {
+
+namespace {
+
+constexpr int kAtlasWidth = 1024;
+constexpr uint32_t kDefaultCacheSize = 256;
+
+// Decodes one utf-8 code point and advances *pos, malformed sequences are decoded as '?'
+uint32_t NextCodePoint(const std::string &text, size_t *pos) {
+  const unsigned char *s = reinterpret_cast<const unsigned char *>(text.data());
+  size_t i = *pos;
+  uint32_t c = s[i];
+  int extra = c < 0x80 ? 0 : c >= 0xf8 ? -1 : c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : c >= 0xc0 ? 1 : -1;
+  if (extra <= 0) {
+    *pos = i + 1;
+    return extra ? '?' : c;
+  }
+  c &= 0x3f >> extra;
+  for (int k = 1; k <= extra; ++k) {
+    if (i + k >= text.size() || (s[i + k] & 0xc0) != 0x80) {
+      *pos = i + k;
+      return '?';
+    }
+    c = (c << 6) | (s[i + k] & 0x3f);
+  }
+  *pos = i + 1 + extra;
+  return c;
+}
+
+}  // namespace
+
+OsdFont::OsdFont(const CnedkOsdFontCreateParams &params) : params_(params) {}
+
+int OsdFont::Init() {
+  if (!params_.glyphs || !params_.num_glyphs || params_.line_height <= 0) {
+    LOG(ERROR) << "[EasyDK] [OsdFont] Init(): glyphs or line_height is invalid";
+    return -1;
+  }
+
+  // shelf packing, glyphs are put from left to right and a new shelf is started when the current one is full
+  int atlas_w = kAtlasWidth;
+  for (uint32_t i = 0; i < params_.num_glyphs; ++i) atlas_w = std::max(atlas_w, params_.glyphs[i].w);
+  std::vector<Glyph> packed(params_.num_glyphs);
+  int shelf_x = 0, shelf_y = 0, shelf_h = 0;
+  for (uint32_t i = 0; i < params_.num_glyphs; ++i) {
+    const CnedkOsdGlyph &src = params_.glyphs[i];
+    if (src.w < 0 || src.h < 0 || (src.w && src.h && !src.alpha) || src.pitch < static_cast<uint32_t>(src.w)) {
+      LOG(ERROR) << "[EasyDK] [OsdFont] Init(): glyph " << src.code << " is invalid";
+      return -1;
+    }
+    if (shelf_x + src.w > atlas_w) {
+      shelf_x = 0;
+      shelf_y += shelf_h;
+      shelf_h = 0;
+    }
+    Glyph &glyph = packed[i];
+    glyph.valid = true;
+    glyph.x = shelf_x;
+    glyph.y = shelf_y;
+    glyph.w = src.w;
+    glyph.h = src.h;
+    glyph.bearing_x = src.bearing_x;
+    glyph.bearing_y = src.bearing_y;
+    glyph.advance = src.advance;
+    shelf_x += src.w;
+    shelf_h = std::max(shelf_h, src.h);
+  }
+  atlas_w_ = atlas_w;
+  atlas_h_ = shelf_y + shelf_h;
+  atlas_.assign(static_cast<size_t>(atlas_w_) * atlas_h_, 0);
+
+  for (uint32_t i = 0; i < params_.num_glyphs; ++i) {
+    const CnedkOsdGlyph &src = params_.glyphs[i];
+    const Glyph &glyph = packed[i];
+    for (int row = 0; row < glyph.h; ++row) {
+      memcpy(&atlas_[(glyph.y + row) * atlas_w_ + glyph.x], src.alpha + row * src.pitch, glyph.w);
+    }
+    if (src.code < 128) {
+      ascii_[src.code] = glyph;
+    } else {
+      glyphs_[src.code] = glyph;
+    }
+  }
+  if (ascii_['?'].valid) fallback_ = &ascii_['?'];
+
+  cache_size_ = params_.cache_size ? params_.cache_size : kDefaultCacheSize;
+  // the glyphs are owned by the caller and not valid any more after creating
+  params_.glyphs = nullptr;
+  params_.num_glyphs = 0;
+  VLOG(3) << "[EasyDK] [OsdFont] Init(): atlas size " << atlas_w_ << "x" << atlas_h_;
+  return 0;
+}
+
+const OsdFont::Glyph *OsdFont::FindGlyph(uint32_t code) const {
+  if (code < 128) return ascii_[code].valid ? &ascii_[code] : fallback_;
+  auto it = glyphs_.find(code);
+  return it != glyphs_.end() ? &it->second : fallback_;
+}
+
+void OsdFont::Layout(const std::string &text, std::vector<std::pair<const Glyph *, int>> *glyphs, int *left,
+                     int *right) const {
+  int pen = 0;
+  *left = 0;
+  *right = 0;
+  size_t pos = 0;
+  while (pos < text.size()) {
+    const Glyph *glyph = FindGlyph(NextCodePoint(text, &pos));
+    if (!glyph) continue;
+    if (glyph->w > 0) {
+      *left = std::min(*left, pen + glyph->bearing_x);
+      *right = std::max(*right, pen + glyph->bearing_x + glyph->w);
+    }
+    if (glyphs) glyphs->emplace_back(glyph, pen);
+    pen += glyph->advance;
+  }
+  *right = std::max(*right, pen);
+}
+
+void OsdFont::GetTextSize(const std::string &text, int *w, int *h) const {
+  int left, right;
+  Layout(text, nullptr, &left, &right);
+  *w = right - left;
+  *h = params_.line_height;
+}
+
+std::shared_ptr<OsdLabel> OsdFont::Render(const std::string &text) const {
+  std::vector<std::pair<const Glyph *, int>> glyphs;
+  int left, right;
+  Layout(text, &glyphs, &left, &right);
+
+  std::shared_ptr<OsdLabel> label = std::make_shared<OsdLabel>();
+  label->w = right - left;
+  label->h = params_.line_height;
+  label->alpha.assign(static_cast<size_t>(label->w) * label->h, 0);
+  for (auto &it : glyphs) {
+    const Glyph *glyph = it.first;
+    int x0 = it.second + glyph->bearing_x - left;
+    int y0 = params_.ascent - glyph->bearing_y;
+    for (int row = std::max(0, -y0); row < glyph->h && y0 + row < label->h; ++row) {
+      const uint8_t *src = &atlas_[(glyph->y + row) * atlas_w_ + glyph->x];
+      uint8_t *dst = &label->alpha[(y0 + row) * label->w + x0];
+      // neighbouring glyphs may overlap
+      for (int col = 0; col < glyph->w; ++col) dst[col] = std::max(dst[col], src[col]);
+    }
+  }
+  return label;
+}
+
+std::shared_ptr<const OsdLabel> OsdFont::GetLabel(const std::string &text) {
+  {
+    std::unique_lock<std::mutex> lk(cache_mutex_);
+    auto it = cache_.find(text);
+    if (it != cache_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return it->second->second;
+    }
+  }
+
+  std::shared_ptr<const OsdLabel> label = Render(text);
+  std::unique_lock<std::mutex> lk(cache_mutex_);
+  if (cache_.count(text)) return label;  // rendered by another thread meanwhile
+  lru_.emplace_front(text, label);
+  cache_[text] = lru_.begin();
+  if (lru_.size() > cache_size_) {
+    cache_.erase(lru_.back().first);
+    lru_.pop_back();
+  }
+  return label;
+}
+
+}  // namespace cnedk
@@ -0,0 +1,90 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#ifndef CNEDK_OSD_FONT_HPP_
+#define CNEDK_OSD_FONT_HPP_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cnedk_osd.h"
+
+namespace cnedk {
+
+// A line of text rendered from the glyph atlas, alpha-8
+struct OsdLabel {
+  int w = 0;
+  int h = 0;
+  std::vector<uint8_t> alpha;  // w * h
+};
+
+// Glyphs are packed into one alpha-8 atlas when the font is created. Labels are composed from the atlas and the
+// most recently used ones are cached, so recurring class names and track ids are rendered only once.
+class OsdFont {
+ public:
+  explicit OsdFont(const CnedkOsdFontCreateParams &params);
+  ~OsdFont() = default;
+
+  int Init();
+  std::shared_ptr<const OsdLabel> GetLabel(const std::string &text);
+  void GetTextSize(const std::string &text, int *w, int *h) const;
+
+ private:
+  OsdFont(const OsdFont &) = delete;
+  OsdFont &operator=(const OsdFont &) = delete;
+
+  struct Glyph {
+    bool valid = false;
+    int x = 0, y = 0;  // position in the atlas
+    int w = 0, h = 0;
+    int bearing_x = 0, bearing_y = 0;
+    int advance = 0;
+  };
+
+  const Glyph *FindGlyph(uint32_t code) const;
+  // Returns the pen positions of the glyphs and the horizontal extent [*left, *right) of the text
+  void Layout(const std::string &text, std::vector<std::pair<const Glyph *, int>> *glyphs, int *left,
+              int *right) const;
+  std::shared_ptr<OsdLabel> Render(const std::string &text) const;
+
+ private:
+  CnedkOsdFontCreateParams params_;
+  int atlas_w_ = 0;
+  int atlas_h_ = 0;
+  std::vector<uint8_t> atlas_;
+  Glyph ascii_[128];
+  std::unordered_map<uint32_t, Glyph> glyphs_;  // non-ascii glyphs
+  const Glyph *fallback_ = nullptr;             // used for missing glyphs, '?' if present
+
+  std::mutex cache_mutex_;
+  size_t cache_size_ = 0;
+  std::list<std::pair<std::string, std::shared_ptr<const OsdLabel>>> lru_;
+  std::unordered_map<std::string, decltype(lru_)::iterator> cache_;
+};
+
+}  // namespace cnedk
+
+#endif  // CNEDK_OSD_FONT_HPP_
@@ -20,6 +20,7 @@
 
 #include "cnedk_transform_cncv.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <cstring>
 #include <map>
@@ -29,6 +30,7 @@
 
 #include "glog/logging.h"
 #include "cncv.h"
+#include "../cnedk_transform_impl.hpp"
 #include "../common/utils.hpp"
 
 namespace cnedk {
@@ -56,25 +58,113 @@ static int GetChannelNumFromColor(const CnedkBufSurfaceColorFormat &corlor_forma
   return -1;
 }
 
+int CncvContext::Sync(CnedkTransformParams *transform_params) {
+  if (transform_params->transform_flag & CNEDK_TRANSFORM_ASYNC) return 0;
+  CNRT_SAFECALL(cnrtQueueSync(params_.cnrt_queue), "[CncvContext] Sync(): failed", -1);
+  return 0;
+}
+
+CncvPointerTable::~CncvPointerTable() {
+  for (auto &slot : slots_) {
+    if (slot.pending) cnrtWaitNotifier(slot.notifier);
+    if (slot.notifier) cnrtNotifierDestroy(slot.notifier);
+    if (slot.host) cnrtFreeHost(slot.host);
+    if (slot.dev) cnrtFree(slot.dev);
+  }
+}
+
+int CncvPointerTable::Reserve(size_t count) {
+  // Acquire() walks through the slots, so cur_ is back to where it was after all slots are visited
+  for (int i = 0; i < kSlotNum; ++i) {
+    if (!Acquire(count)) return -1;
+  }
+  return 0;
+}
+
+void **CncvPointerTable::Acquire(size_t count) {
+  cur_ = (cur_ + 1) % kSlotNum;
+  Slot &slot = slots_[cur_];
+  if (slot.pending) {
+    CNRT_SAFECALL(cnrtWaitNotifier(slot.notifier), "[CncvPointerTable] Acquire(): wait notifier failed.", nullptr);
+    slot.pending = false;
+  }
+  if (!slot.notifier) {
+    CNRT_SAFECALL(cnrtNotifierCreate(&slot.notifier), "[CncvPointerTable] Acquire(): create notifier failed.",
+                  nullptr);
+  }
+  if (slot.capacity < count) {
+    if (slot.host) cnrtFreeHost(slot.host);
+    if (slot.dev) cnrtFree(slot.dev);
+    slot.host = nullptr;
+    slot.dev = nullptr;
+    slot.capacity = 0;
+    CNRT_SAFECALL(cnrtHostMalloc(reinterpret_cast<void **>(&slot.host), count * sizeof(void *)),
+                  "[CncvPointerTable] Acquire(): malloc host pointers failed.", nullptr);
+    CNRT_SAFECALL(cnrtMalloc(reinterpret_cast<void **>(&slot.dev), count * sizeof(void *)),
+                  "[CncvPointerTable] Acquire(): malloc mlu pointers failed.", nullptr);
+    slot.capacity = count;
+  }
+  return slot.host;
+}
+
+int CncvPointerTable::Upload(size_t count, cnrtQueue_t queue) {
+  Slot &slot = slots_[cur_];
+  CNRT_SAFECALL(cnrtMemcpyAsync(slot.dev, slot.host, count * sizeof(void *), queue, CNRT_MEM_TRANS_DIR_HOST2DEV),
+                "[CncvPointerTable] Upload(): Copy pointers H2D failed.", -1);
+  return 0;
+}
+
+int CncvPointerTable::Record(cnrtQueue_t queue) {
+  Slot &slot = slots_[cur_];
+  CNRT_SAFECALL(cnrtPlaceNotifier(slot.notifier, queue), "[CncvPointerTable] Record(): place notifier failed.", -1);
+  slot.pending = true;
+  return 0;
+}
+
+CncvWorkspace::~CncvWorkspace() {
+  if (workspace_) cnrtFree(workspace_);
+}
+
+int CncvWorkspace::Get(const std::vector<uint32_t> &key, const std::function<int(size_t *)> &query,
+                       cnrtQueue_t queue, void **workspace, size_t *size) {
+  auto iter = sizes_.find(key);
+  if (iter == sizes_.end()) {
+    size_t required_size = 0;
+    if (query(&required_size) < 0) return -1;
+    if (sizes_.size() >= kMaxCachedKeys) sizes_.clear();
+    iter = sizes_.emplace(key, required_size).first;
+  }
+  *size = iter->second;
+
+  if (capacity_ < *size) {
+    if (workspace_) {
+      CNRT_SAFECALL(cnrtQueueSync(queue), "[CncvWorkspace] Get(): queue sync failed.", -1);
+      cnrtFree(workspace_);
+      workspace_ = nullptr;
+      capacity_ = 0;
+    }
+    CNRT_SAFECALL(cnrtMalloc(&workspace_, *size), "[CncvWorkspace] Get(): malloc workspace failed.", -1);
+    capacity_ = *size;
+  }
+  *workspace = workspace_;
+  return 0;
+}
+
 int YuvResizeCncvCtx::Process(const CnedkBufSurface &src, CnedkBufSurface *dst,
                                CnedkTransformParams *transform_params) {
   size_t batch_size = src.batch_size;
-  if (batch_size_ < batch_size) {
-    batch_size_ = batch_size;
-    if (mlu_input_) cnrtFree(mlu_input_);
-    CNRT_SAFECALL(cnrtMalloc(reinterpret_cast<void **>(&mlu_input_), plane_number_ * batch_size * sizeof(void *)),
-                  "[YuvResizeCncvCtx] Process(): malloc mlu input pointers failed.", -1);
-    if (mlu_output_) cnrtFree(mlu_output_);
-    CNRT_SAFECALL(cnrtMalloc(reinterpret_cast<void **>(&mlu_output_), plane_number_ * batch_size * sizeof(void *)),
-                  "[YuvResizeCncvCtx] Process(): malloc mlu output pointers failed.", -1);
-
-    cpu_input_.resize(batch_size * plane_number_);
-    cpu_output_.resize(batch_size * plane_number_);
-    src_rois_.resize(batch_size);
-    src_descs_.resize(batch_size);
-    dst_descs_.resize(batch_size);
-    dst_rois_.resize(batch_size);
+  // inputs and outputs share one table: [input planes of the batch, output planes of the batch]
+  void **cpu_input = pointers_.Acquire(2 * plane_number_ * batch_size);
+  if (!cpu_input) {
+    LOG(ERROR) << "[EasyDK] [YuvResizeCncvCtx] Process(): Acquire pointer table failed";
+    return -1;
   }
+  void **cpu_output = cpu_input + plane_number_ * batch_size;
+  src_rois_.resize(batch_size);
+  src_descs_.resize(batch_size);
+  dst_descs_.resize(batch_size);
+  dst_rois_.resize(batch_size);
+  workspace_key_.assign(1, batch_size);
 
   for (size_t batch_idx = 0; batch_idx < batch_size; ++batch_idx) {
     // configure src desc
@@ -132,69 +222,67 @@ int YuvResizeCncvCtx::Process(const CnedkBufSurface &src, CnedkBufSurface *dst,
       dst_roi.h = dst->surface_list[batch_idx].height;
     }
     dst_rois_[batch_idx] = dst_roi;
+    CncvWorkspace::AppendKey(&workspace_key_, src_desc, src_roi);
+    CncvWorkspace::AppendKey(&workspace_key_, dst_desc, dst_roi);
 
     // copy one input frame addr to device
-    cpu_input_[plane_number_ * batch_idx] =
+    cpu_input[plane_number_ * batch_idx] =
         reinterpret_cast<void **>(reinterpret_cast<uint64_t>(src.surface_list[batch_idx].data_ptr) +
                                   src.surface_list[batch_idx].plane_params.offset[0]);
-    cpu_input_[plane_number_ * batch_idx + 1] =
+    cpu_input[plane_number_ * batch_idx + 1] =
         reinterpret_cast<void **>(reinterpret_cast<uint64_t>(src.surface_list[batch_idx].data_ptr) +
                                   src.surface_list[batch_idx].plane_params.offset[1]);
-    cpu_output_[plane_number_ * batch_idx] =
+    cpu_output[plane_number_ * batch_idx] =
         reinterpret_cast<void **>(reinterpret_cast<uint64_t>(dst->surface_list[batch_idx].data_ptr) +
                                   dst->surface_list[batch_idx].plane_params.offset[0]);
-    cpu_output_[plane_number_ * batch_idx + 1] =
+    cpu_output[plane_number_ * batch_idx + 1] =
         reinterpret_cast<void **>(reinterpret_cast<uint64_t>(dst->surface_list[batch_idx].data_ptr) +
                                   dst->surface_list[batch_idx].plane_params.offset[1]);
   }
 
-  CNRT_SAFECALL(cnrtMemcpy(mlu_input_, cpu_input_.data(), sizeof(void *) * batch_size * plane_number_,
-                           CNRT_MEM_TRANS_DIR_HOST2DEV),
-                "[YuvResizeCncvCtx] Process(): Copy input pointers H2D failed.", -1);
-  CNRT_SAFECALL(cnrtMemcpy(mlu_output_, cpu_output_.data(), sizeof(void *) * batch_size * plane_number_,
-                           CNRT_MEM_TRANS_DIR_HOST2DEV),
-                "[YuvResizeCncvCtx] Process(): Copy output pointers H2D failed.", -1);
-
-  size_t required_workspace_size = 0;
-  CNCV_SAFECALL(cncvGetResizeYuvWorkspaceSize(batch_size, src_descs_.data(), src_rois_.data(), dst_descs_.data(),
-                                              dst_rois_.data(), &required_workspace_size),
-                "[YuvResizeCncvCtx] Process(): failed", -1);
+  if (pointers_.Upload(2 * plane_number_ * batch_size, params_.cnrt_queue) < 0) {
+    LOG(ERROR) << "[EasyDK] [YuvResizeCncvCtx] Process(): Upload pointer table failed";
+    return -1;
+  }
 
-  if (required_workspace_size != workspace_size_) {
-    workspace_size_ = required_workspace_size;
-    if (workspace_) cnrtFree(workspace_);
-    CNRT_SAFECALL(cnrtMalloc(&(workspace_), required_workspace_size),
-                  "[YuvResizeCncvCtx] Process(): malloc workspace failed.", -1);
+  void *workspace = nullptr;
+  size_t workspace_size = 0;
+  auto query = [&](size_t *size) -> int {
+    CNCV_SAFECALL(cncvGetResizeYuvWorkspaceSize(batch_size, src_descs_.data(), src_rois_.data(), dst_descs_.data(),
+                                                dst_rois_.data(), size),
+                  "[YuvResizeCncvCtx] Process(): failed", -1);
+    return 0;
+  };
+  if (workspace_.Get(workspace_key_, query, params_.cnrt_queue, &workspace, &workspace_size) < 0) {
+    LOG(ERROR) << "[EasyDK] [YuvResizeCncvCtx] Process(): Get workspace failed";
+    return -1;
   }
 
-  CNCV_SAFECALL(cncvResizeYuv_AdvancedROI(handle_, batch_size, src_descs_.data(), src_rois_.data(), mlu_input_,
-                                          dst_descs_.data(), dst_rois_.data(), mlu_output_, required_workspace_size,
-                                          workspace_, CNCV_INTER_BILINEAR),
+  void **mlu_input = pointers_.GetDevicePtr();
+  void **mlu_output = mlu_input + plane_number_ * batch_size;
+  CNCV_SAFECALL(cncvResizeYuv_AdvancedROI(handle_, batch_size, src_descs_.data(), src_rois_.data(), mlu_input,
+                                          dst_descs_.data(), dst_rois_.data(), mlu_output, workspace_size,
+                                          workspace, CNCV_INTER_BILINEAR),
                 "[YuvResizeCncvCtx] Process():", -1);
-  CNRT_SAFECALL(cnrtQueueSync(params_.cnrt_queue),
-                "[YuvResizeCncvCtx] Process(): cncvResizeYuv_AdvancedROI failed.", -1);
-  return 0;
+  if (pointers_.Record(params_.cnrt_queue) < 0) return -1;
+  return Sync(transform_params);
 }
 
 int Yuv2RgbxResizeCncvCtx::Process(const CnedkBufSurface &src, CnedkBufSurface *dst,
                                    CnedkTransformParams *transform_params) {
   size_t batch_size = src.batch_size;
-  if (batch_size_ < batch_size) {
-    batch_size_ = batch_size;
-    if (mlu_input_) cnrtFree(mlu_input_);
-    CNRT_SAFECALL(cnrtMalloc(reinterpret_cast<void **>(&mlu_input_), plane_number_ * batch_size * sizeof(void *)),
-                  "[Yuv2RgbxResizeCncvCtx] Process(): malloc mlu input pointers failed.", -1);
-    if (mlu_output_) cnrtFree(mlu_output_);
-    CNRT_SAFECALL(cnrtMalloc(reinterpret_cast<void **>(&mlu_output_), batch_size * sizeof(void *)),
-                  "[Yuv2RgbxResizeCncvCtx] Process(): malloc mlu output pointers failed.", -1);
-
-    cpu_input_.resize(plane_number_ * batch_size);
-    cpu_output_.resize(batch_size);
-    src_rois_.resize(batch_size);
-    src_descs_.resize(batch_size);
-    dst_descs_.resize(batch_size);
-    dst_rois_.resize(batch_size);
+  // inputs and outputs share one table: [input planes of the batch, outputs of the batch]
+  void **cpu_input = pointers_.Acquire((plane_number_ + 1) * batch_size);
+  if (!cpu_input) {
+    LOG(ERROR) << "[EasyDK] [Yuv2RgbxResizeCncvCtx] Process(): Acquire pointer table failed";
+    return -1;
   }
+  void **cpu_output = cpu_input + plane_number_ * batch_size;
+  src_rois_.resize(batch_size);
+  src_descs_.resize(batch_size);
+  dst_descs_.resize(batch_size);
+  dst_rois_.resize(batch_size);
+  workspace_key_.assign(1, batch_size);
 
   for (size_t batch_idx = 0; batch_idx < batch_size; ++batch_idx) {
     // configure src desc
@@ -252,42 +340,44 @@ int Yuv2RgbxResizeCncvCtx::Process(const CnedkBufSurface &src, CnedkBufSurface *
       dst_roi.h = dst->surface_list[batch_idx].height;
     }
     dst_rois_[batch_idx] = dst_roi;
+    CncvWorkspace::AppendKey(&workspace_key_, src_desc, src_roi);
+    CncvWorkspace::AppendKey(&workspace_key_, dst_desc, dst_roi);
 
     // copy one input frame addr to device
-    cpu_input_[plane_number_ * batch_idx] =
+    cpu_input[plane_number_ * batch_idx] =
         reinterpret_cast<void **>(reinterpret_cast<uint64_t>(src.surface_list[batch_idx].data_ptr) +
                                   src.surface_list[batch_idx].plane_params.offset[0]);
-    cpu_input_[plane_number_ * batch_idx + 1] =
+    cpu_input[plane_number_ * batch_idx + 1] =
         reinterpret_cast<void **>(reinterpret_cast<uint64_t>(src.surface_list[batch_idx].data_ptr) +
                                   src.surface_list[batch_idx].plane_params.offset[1]);
-    cpu_output_[batch_idx] = reinterpret_cast<void **>(dst->surface_list[batch_idx].data_ptr);
+    cpu_output[batch_idx] = reinterpret_cast<void **>(dst->surface_list[batch_idx].data_ptr);
   }
 
-  CNRT_SAFECALL(cnrtMemcpy(mlu_input_, cpu_input_.data(), sizeof(void *) * batch_size * plane_number_,
-                           CNRT_MEM_TRANS_DIR_HOST2DEV),
-                "[Yuv2RgbxResizeCncvCtx] Process(): Copy input pointers H2D failed.", -1);
-  CNRT_SAFECALL(cnrtMemcpy(mlu_output_, cpu_output_.data(), sizeof(void *) * batch_size, CNRT_MEM_TRANS_DIR_HOST2DEV),
-                "[Yuv2RgbxResizeCncvCtx] Process(): Copy output pointers H2D failed.", -1);
-
-  size_t required_workspace_size = 0;
-  CNCV_SAFECALL(cncvGetResizeConvertWorkspaceSize(batch_size, src_descs_.data(), src_rois_.data(), dst_descs_.data(),
-                                                  dst_rois_.data(), &required_workspace_size),
-                "[Yuv2RgbxResizeCncvCtx] Process():", -1);
+  if (pointers_.Upload((plane_number_ + 1) * batch_size, params_.cnrt_queue) < 0) {
+    LOG(ERROR) << "[EasyDK] [Yuv2RgbxResizeCncvCtx] Process(): Upload pointer table failed";
+    return -1;
+  }
 
-  if (required_workspace_size != workspace_size_) {
-    workspace_size_ = required_workspace_size;
-    if (workspace_) cnrtFree(workspace_);
-    CNRT_SAFECALL(cnrtMalloc(&workspace_, required_workspace_size),
-                  "[Yuv2RgbxResizeCncvCtx] Process(): malloc workspace failed.", -1);
+  void *workspace = nullptr;
+  size_t workspace_size = 0;
+  auto query = [&](size_t *size) -> int {
+    CNCV_SAFECALL(cncvGetResizeConvertWorkspaceSize(batch_size, src_descs_.data(), src_rois_.data(),
+                                                    dst_descs_.data(), dst_rois_.data(), size),
+                  "[Yuv2RgbxResizeCncvCtx] Process():", -1);
+    return 0;
+  };
+  if (workspace_.Get(workspace_key_, query, params_.cnrt_queue, &workspace, &workspace_size) < 0) {
+    LOG(ERROR) << "[EasyDK] [Yuv2RgbxResizeCncvCtx] Process(): Get workspace failed";
+    return -1;
   }
 
-  CNCV_SAFECALL(cncvResizeConvert_AdvancedROI(handle_, batch_size, src_descs_.data(), src_rois_.data(), mlu_input_,
-                dst_descs_.data(), dst_rois_.data(), mlu_output_, workspace_size_, workspace_, CNCV_INTER_BILINEAR),
+  void **mlu_input = pointers_.GetDevicePtr();
+  void **mlu_output = mlu_input + plane_number_ * batch_size;
+  CNCV_SAFECALL(cncvResizeConvert_AdvancedROI(handle_, batch_size, src_descs_.data(), src_rois_.data(), mlu_input,
+                dst_descs_.data(), dst_rois_.data(), mlu_output, workspace_size, workspace, CNCV_INTER_BILINEAR),
                 "[Yuv2RgbxResizeCncvCtx] Process(): failed", -1);
-
-  CNRT_SAFECALL(cnrtQueueSync(params_.cnrt_queue),
-                "[Yuv2RgbxResizeCncvCtx] Process(): cncvResizeConvert_AdvancedROI failed.", -1);
-  return 0;
+  if (pointers_.Record(params_.cnrt_queue) < 0) return -1;
+  return Sync(transform_params);
 }
 
 int RgbxToYuvCncvCtx::Process(const CnedkBufSurface &src, CnedkBufSurface *dst,
@@ -329,10 +419,8 @@ int RgbxToYuvCncvCtx::Process(const CnedkBufSurface &src, CnedkBufSurface *dst,
                                            reinterpret_cast<char *>(dst->surface_list[i].data_ptr) +
                                            dst->surface_list[i].plane_params.offset[1]),
                   "[RgbxToYuvCncvCtx] Process(): failed", -1);
-    CNRT_SAFECALL(cnrtQueueSync(params_.cnrt_queue),
-                  "[RgbxToYuvCncvCtx] Process(): cncvRgbxToYuv_BasicROIP2 failed.", -1);
   }
-  return 0;
+  return Sync(transform_params);
 }
 
 int MeanStdCncvCtx::Process(const CnedkBufSurface &src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) {
@@ -391,47 +479,43 @@ int MeanStdCncvCtx::Process(const CnedkBufSurface &src, CnedkBufSurface *dst, Cn
   dst_desc_.stride[0] = dst->surface_list[0].width * channel_num * depth;
 
   size_t batch_size = src.batch_size;
-  if (batch_size_ < batch_size) {
-    batch_size_ = batch_size;
-    if (mlu_input_) cnrtFree(mlu_input_);
-    CNRT_SAFECALL(cnrtMalloc(reinterpret_cast<void **>(&mlu_input_), batch_size * sizeof(void *)),
-                  "[MeanStdCncvCtx] Process(): malloc mlu input pointers failed.", -1);
-    if (mlu_output_) cnrtFree(mlu_output_);
-    CNRT_SAFECALL(cnrtMalloc(reinterpret_cast<void **>(&mlu_output_), batch_size * sizeof(void *)),
-                  "[MeanStdCncvCtx] Process(): malloc mlu output pointers failed.", -1);
-
-    cpu_input_.resize(batch_size);
-    cpu_output_.resize(batch_size);
+  void **cpu_input = pointers_.Acquire(2 * batch_size);
+  if (!cpu_input) {
+    LOG(ERROR) << "[EasyDK] [MeanStdCncvCtx] Process(): Acquire pointer table failed";
+    return -1;
   }
+  void **cpu_output = cpu_input + batch_size;
 
   for (size_t batch_idx = 0; batch_idx < batch_size; ++batch_idx) {
     // copy one input frame addr to device
-    cpu_input_[batch_idx] = reinterpret_cast<void **>(src.surface_list[batch_idx].data_ptr);
-    cpu_output_[batch_idx] = reinterpret_cast<void **>(dst->surface_list[batch_idx].data_ptr);
+    cpu_input[batch_idx] = reinterpret_cast<void **>(src.surface_list[batch_idx].data_ptr);
+    cpu_output[batch_idx] = reinterpret_cast<void **>(dst->surface_list[batch_idx].data_ptr);
   }
 
-  CNRT_SAFECALL(cnrtMemcpy(mlu_input_, cpu_input_.data(), sizeof(void *) * batch_size, CNRT_MEM_TRANS_DIR_HOST2DEV),
-                "[MeanStdCncvCtx] Process(): Copy input pointers H2D failed.", -1);
-  CNRT_SAFECALL(cnrtMemcpy(mlu_output_, cpu_output_.data(), sizeof(void *) * batch_size, CNRT_MEM_TRANS_DIR_HOST2DEV),
-                "[MeanStdCncvCtx] Process(): Copy output pointers H2D failed.", -1);
-
-  size_t required_workspace_size = 0;
+  if (pointers_.Upload(2 * batch_size, params_.cnrt_queue) < 0) {
+    LOG(ERROR) << "[EasyDK] [MeanStdCncvCtx] Process(): Upload pointer table failed";
+    return -1;
+  }
 
-  CNCV_SAFECALL(cncvGetMeanStdWorkspaceSize(channel_num, &required_workspace_size),
-                "[MeanStdCncvCtx] Process(): failed", -1);
-  if (required_workspace_size != workspace_size_) {
-    workspace_size_ = required_workspace_size;
-    if (workspace_) cnrtFree(workspace_);
-    CNRT_SAFECALL(cnrtMalloc(&workspace_, required_workspace_size),
-                  "[EasyDK] [MeanStdCncvCtx] Process(): malloc workspace failed.", -1);
+  void *workspace = nullptr;
+  size_t workspace_size = 0;
+  auto query = [&](size_t *size) -> int {
+    CNCV_SAFECALL(cncvGetMeanStdWorkspaceSize(channel_num, size), "[MeanStdCncvCtx] Process(): failed", -1);
+    return 0;
+  };
+  if (workspace_.Get({static_cast<uint32_t>(channel_num)}, query, params_.cnrt_queue, &workspace,
+                     &workspace_size) < 0) {
+    LOG(ERROR) << "[EasyDK] [MeanStdCncvCtx] Process(): Get workspace failed";
+    return -1;
   }
 
-  CNCV_SAFECALL(cncvMeanStd(handle_, batch_size, src_desc_, mlu_input_, mean_, std_, dst_desc_, mlu_output_,
-                            required_workspace_size, workspace_),
+  void **mlu_input = pointers_.GetDevicePtr();
+  void **mlu_output = mlu_input + batch_size;
+  CNCV_SAFECALL(cncvMeanStd(handle_, batch_size, src_desc_, mlu_input, mean_, std_, dst_desc_, mlu_output,
+                            workspace_size, workspace),
                 "[MeanStdCncvCtx] Process(): failed", -1);
-  CNRT_SAFECALL(cnrtQueueSync(params_.cnrt_queue),
-                "[MeanStdCncvCtx] Process(): queue sync failed.", -1);
-  return true;
+  if (pointers_.Record(params_.cnrt_queue) < 0) return -1;
+  return Sync(transform_params);
 }
 
 int Yuv2RgbxResizeWithMeanStdCncv::Process(const CnedkBufSurface &src, CnedkBufSurface *dst,
@@ -462,6 +546,9 @@ int Yuv2RgbxResizeWithMeanStdCncv::Process(const CnedkBufSurface &src, CnedkBufS
 
   if (mlu_ptr_ == nullptr || mlu_size_ < data_size) {
     if (mlu_ptr_) {
+      // the buffer may still be used by the transforms in flight
+      CNRT_SAFECALL(cnrtQueueSync(resize_convert_->GetQueue()),
+                    "[Yuv2RgbxResizeWithMeanStdCncv] Process(): queue sync failed.", -1);
       cnrtFree(mlu_ptr_);
     }
     CNRT_SAFECALL(cnrtMalloc(&mlu_ptr_, data_size),
@@ -513,7 +600,9 @@ int Rgbx2YuvResizeAndConvert::Process(const CnedkBufSurface& src,
     // alloc source src yuv mlu addr
     size_t yuv_size = src.surface_list[0].width * src.surface_list[0].height * 3 / 2;
     if (src_yuv_size_ < yuv_size) {
-      if (src_yuv_mlu_) {  // realloc
+      if (src_yuv_mlu_) {  // realloc, the buffer may still be used by the transforms in flight
+        CNRT_SAFECALL(cnrtQueueSync(rgbx_yuv_->GetQueue()),
+                      "[Rgbx2YuvResizeAndConvert] Process(): queue sync failed.", -1);
         cnrtFree(src_yuv_mlu_);
       }
 
@@ -547,6 +636,7 @@ int Rgbx2YuvResizeAndConvert::Process(const CnedkBufSurface& src,
     transform_dst.mem_type = CNEDK_BUF_MEM_DEVICE;
     CnedkTransformParams temp_transform_params;
     memset(&temp_transform_params, 0, sizeof(temp_transform_params));
+    temp_transform_params.transform_flag = transform_params->transform_flag & CNEDK_TRANSFORM_ASYNC;
     if (rgbx_yuv_->Process(src, &transform_dst, &temp_transform_params) < 0) {
       LOG(ERROR) << "[EasyDK] [Rgbx2YuvResizeAndConvert] Process(): rgb2yuv failed";
       return -1;
@@ -601,47 +691,218 @@ bool IsRgbx(CnedkBufSurfaceColorFormat fmt) {
   return false;
 }
 
-int DoCncvTransform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) {
-  if (src->surface_list[0].color_format == CNEDK_BUF_COLOR_FORMAT_TENSOR) {
-    LOG(ERROR) << "[EasyDK] DoCncvTransform(): The type of src is not supported as tensor";
+int RoiResizeConvertCncvCtx::Process(const CnedkBufSurface &src, CnedkBufSurface *dst,
+                                     CnedkTransformRoiParams *roi_params) {
+  if (!IsYuv420sp(src.surface_list[0].color_format)) {
+    LOG(ERROR) << "[EasyDK] [RoiResizeConvertCncvCtx] Process(): Unsupported src color format: "
+               << static_cast<int>(src.surface_list[0].color_format);
+    return -1;
+  }
+  if (roi_params->layout != CNEDK_TRANSFORM_LAYOUT_NHWC) {
+    LOG(ERROR) << "[EasyDK] [RoiResizeConvertCncvCtx] Process(): Only NHWC layout is supported";
+    return -1;
+  }
+  CnedkTransformTensorDesc *dst_desc = roi_params->dst_desc;
+  CnedkBufSurfaceColorFormat color_format = GetColorFormatFromTensor(dst_desc->color_format);
+  int channel_num = GetChannelNumFromColor(color_format);
+  if (channel_num < 0 || dst_desc->shape.c != static_cast<uint32_t>(channel_num)) {
+    LOG(ERROR) << "[EasyDK] [RoiResizeConvertCncvCtx] Process(): Unsupported dst color format: "
+               << static_cast<int>(dst_desc->color_format) << ", channel: " << dst_desc->shape.c;
+    return -1;
+  }
+  bool mean_std = roi_params->mean_std_params != nullptr;
+  size_t depth = 1;
+  if (mean_std && dst_desc->data_type == CNEDK_TRANSFORM_FLOAT16) {
+    depth = 2;
+  } else if (mean_std && dst_desc->data_type == CNEDK_TRANSFORM_FLOAT32) {
+    depth = 4;
+  } else if (mean_std || dst_desc->data_type != CNEDK_TRANSFORM_UINT8) {
+    LOG(ERROR) << "[EasyDK] [RoiResizeConvertCncvCtx] Process(): Unsupported data type : "
+               << static_cast<int>(dst_desc->data_type);
     return -1;
   }
-  CnedkBufSurface* dst_buf = dst;
-  std::unique_ptr<CnedkBufSurface> dst_buf_for_tensor = nullptr;
-  std::vector<CnedkBufSurfaceParams> dst_params_for_tensor;
 
-  if (dst->surface_list[0].color_format == CNEDK_BUF_COLOR_FORMAT_TENSOR) {
-    if (transform_params->transform_flag & CNEDK_TRANSFORM_MEAN_STD) {
-      auto dst_fmt = GetColorFormatFromTensor(transform_params->dst_desc->color_format);
-      if (IsYuv420sp(src->surface_list[0].color_format) && IsRgbx(dst_fmt)) {
-        static thread_local std::shared_ptr<Yuv2RgbxResizeWithMeanStdCncv> resize_meanstd_ctx = nullptr;
-        if (!resize_meanstd_ctx) {
-          int dev_id = 0;
-          cnrtGetDevice(&dev_id);
-          resize_meanstd_ctx = std::make_shared<Yuv2RgbxResizeWithMeanStdCncv>(dev_id);
-        }
-        if (resize_meanstd_ctx->Process(*src, dst, transform_params) < 0) {
-          LOG(ERROR) << "[EasyDK] DoCncvTransform(): Yuv2RgbxResizeWithMeanStd failed";
-          return -1;
-        }
-      } else if (src->surface_list[0].color_format == dst_fmt) {
-        static thread_local std::shared_ptr<CncvContext> cncv_ctx = nullptr;
-        if (!cncv_ctx) {
-          int dev_id = 0;
-          cnrtGetDevice(&dev_id);
-          cncv_ctx = std::make_shared<MeanStdCncvCtx>(dev_id);
-        }
-        if (cncv_ctx->Process(*src, dst, transform_params) < 0) {
-          LOG(ERROR) << "[EasyDK] DoCncvTransform(): MeanStd failed";
-          return -1;
-        }
-      } else {
-        LOG(ERROR) << "[EasyDK] DoCncvTransform(): Unsupported transform type";
-        return -1;
+  uint32_t num_rois = roi_params->num_rois;
+  uint32_t dst_w = dst_desc->shape.w, dst_h = dst_desc->shape.h;
+  size_t image_size = static_cast<size_t>(dst_w) * dst_h * channel_num;
+  for (uint32_t i = 0; i < num_rois; ++i) {
+    if (dst->surface_list[i].data_size < image_size * depth) {
+      LOG(ERROR) << "[EasyDK] [RoiResizeConvertCncvCtx] Process(): The dst tensor is larger than the buffer, roi: "
+                 << i;
+      return -1;
+    }
+  }
+
+  if (mean_std && (mlu_ptr_ == nullptr || mlu_size_ < image_size * num_rois)) {
+    if (mlu_ptr_) {
+      // the buffer may still be used by the transforms in flight
+      CNRT_SAFECALL(cnrtQueueSync(resize_convert_->GetQueue()),
+                    "[RoiResizeConvertCncvCtx] Process(): queue sync failed.", -1);
+      cnrtFree(mlu_ptr_);
+    }
+    mlu_ptr_ = nullptr;
+    mlu_size_ = 0;
+    CNRT_SAFECALL(cnrtMalloc(&mlu_ptr_, image_size * num_rois),
+                  "[RoiResizeConvertCncvCtx] Process(): malloc mlu temp pointers failed.", -1);
+    mlu_size_ = image_size * num_rois;
+  }
+
+  // one batch item for each region, items of the same image share the planes
+  src_params_.resize(num_rois);
+  dst_params_.resize(num_rois);
+  src_rects_.resize(num_rois);
+  dst_rects_.resize(num_rois);
+  for (uint32_t i = 0; i < num_rois; ++i) {
+    const CnedkTransformRoi &roi = roi_params->rois[i];
+    const CnedkBufSurfaceParams &params = src.surface_list[roi.src_index];
+    src_params_[i] = params;
+
+    CnedkTransformRect &src_rect = src_rects_[i];
+    src_rect.left = roi.rect.left >= params.width ? 0 : roi.rect.left & ~1u;
+    src_rect.top = roi.rect.top >= params.height ? 0 : roi.rect.top & ~1u;
+    src_rect.width = roi.rect.width == 0 ? params.width - src_rect.left : roi.rect.width;
+    src_rect.height = roi.rect.height == 0 ? params.height - src_rect.top : roi.rect.height;
+    src_rect.width = std::min(src_rect.width, params.width - src_rect.left) & ~1u;
+    src_rect.height = std::min(src_rect.height, params.height - src_rect.top) & ~1u;
+    if (!src_rect.width || !src_rect.height) {
+      LOG(ERROR) << "[EasyDK] [RoiResizeConvertCncvCtx] Process(): The roi is empty, roi: " << i;
+      return -1;
+    }
+
+    if (roi_params->keep_aspect_ratio) {
+      dst_rects_[i] = GetLetterboxRect(src_rect.width, src_rect.height, dst_w, dst_h);
+    } else {
+      dst_rects_[i] = CnedkTransformRect{0, 0, dst_w, dst_h};
+    }
+
+    CnedkBufSurfaceParams &dst_params = dst_params_[i];
+    memset(&dst_params, 0, sizeof(dst_params));
+    dst_params.width = dst_w;
+    dst_params.height = dst_h;
+    dst_params.pitch = dst_w * channel_num;
+    dst_params.color_format = color_format;
+    dst_params.data_size = image_size;
+    dst_params.data_ptr =
+        mean_std ? reinterpret_cast<char *>(mlu_ptr_) + image_size * i : dst->surface_list[i].data_ptr;
+  }
+
+  if (roi_params->keep_aspect_ratio) {
+    if (mean_std) {
+      CNRT_SAFECALL(cnrtMemset(mlu_ptr_, roi_params->pad_value, image_size * num_rois),
+                    "[RoiResizeConvertCncvCtx] Process(): memset failed.", -1);
+    } else {
+      for (uint32_t i = 0; i < num_rois; ++i) {
+        CNRT_SAFECALL(cnrtMemset(dst->surface_list[i].data_ptr, roi_params->pad_value, image_size),
+                      "[RoiResizeConvertCncvCtx] Process(): memset failed.", -1);
+      }
+    }
+  }
+
+  CnedkBufSurface roi_src, roi_dst;
+  memset(&roi_src, 0, sizeof(roi_src));
+  roi_src.batch_size = num_rois;
+  roi_src.num_filled = num_rois;
+  roi_src.device_id = src.device_id;
+  roi_src.mem_type = src.mem_type;
+  roi_src.surface_list = src_params_.data();
+  roi_dst = roi_src;
+  roi_dst.mem_type = dst->mem_type;
+  roi_dst.surface_list = dst_params_.data();
+
+  CnedkTransformParams transform_params;
+  memset(&transform_params, 0, sizeof(transform_params));
+  transform_params.transform_flag = CNEDK_TRANSFORM_CROP_SRC | CNEDK_TRANSFORM_CROP_DST;
+  transform_params.src_rect = src_rects_.data();
+  transform_params.dst_rect = dst_rects_.data();
+  if (resize_convert_->Process(roi_src, &roi_dst, &transform_params) < 0) {
+    LOG(ERROR) << "[EasyDK] [RoiResizeConvertCncvCtx] Process(): resize convert failed";
+    return -1;
+  }
+  if (!mean_std) return 0;
+
+  // MeanStdCncvCtx gets the shape of the tensor from the surface
+  std::vector<CnedkBufSurfaceParams> tensor_params(dst->surface_list, dst->surface_list + num_rois);
+  for (auto &params : tensor_params) {
+    params.width = dst_w;
+    params.height = dst_h;
+  }
+  CnedkBufSurface tensor_dst = *dst;
+  tensor_dst.batch_size = num_rois;
+  tensor_dst.num_filled = num_rois;
+  tensor_dst.surface_list = tensor_params.data();
+
+  memset(&transform_params, 0, sizeof(transform_params));
+  transform_params.transform_flag = CNEDK_TRANSFORM_MEAN_STD;
+  transform_params.mean_std_params = roi_params->mean_std_params;
+  transform_params.dst_desc = dst_desc;
+  if (mean_std_->Process(roi_dst, &tensor_dst, &transform_params) < 0) {
+    LOG(ERROR) << "[EasyDK] [RoiResizeConvertCncvCtx] Process(): mean std failed";
+    return -1;
+  }
+  return 0;
+}
+
+static int GetCncvOp(CnedkBufSurfaceColorFormat src_fmt, CnedkBufSurfaceColorFormat dst_fmt,
+                     const CnedkTransformTensorDesc *dst_desc, uint32_t transform_flag, CncvOp *op) {
+  if (src_fmt == CNEDK_BUF_COLOR_FORMAT_TENSOR) {
+    LOG(ERROR) << "[EasyDK] GetCncvOp(): The type of src is not supported as tensor";
+    return -1;
+  }
+  if (dst_fmt == CNEDK_BUF_COLOR_FORMAT_TENSOR) {
+    if (!dst_desc) {
+      LOG(ERROR) << "[EasyDK] GetCncvOp(): dst_desc is needed when dst is tensor";
+      return -1;
+    }
+    dst_fmt = GetColorFormatFromTensor(dst_desc->color_format);
+    if (transform_flag & CNEDK_TRANSFORM_MEAN_STD) {
+      if (IsYuv420sp(src_fmt) && IsRgbx(dst_fmt)) {
+        *op = CncvOp::YUV_TO_RGBX_MEAN_STD;
+        return 0;
+      } else if (src_fmt == dst_fmt) {
+        *op = CncvOp::MEAN_STD;
+        return 0;
       }
-      return 0;
+      LOG(ERROR) << "[EasyDK] GetCncvOp(): Unsupported transform type";
+      return -1;
     }
+  }
+
+  if (IsRgbx(src_fmt) && IsYuv420sp(dst_fmt)) {
+    *op = CncvOp::RGBX_TO_YUV;
+  } else if (IsYuv420sp(src_fmt) && IsRgbx(dst_fmt)) {
+    *op = CncvOp::YUV_TO_RGBX;
+  } else if (IsYuv420sp(src_fmt) && src_fmt == dst_fmt) {
+    *op = CncvOp::YUV_RESIZE;
+  } else {
+    LOG(ERROR) << "[EasyDK] GetCncvOp(): Unsupported transform type src: " << static_cast<int>(src_fmt)
+               << ", dst: " << static_cast<int>(dst_fmt);
+    return -1;
+  }
+  return 0;
+}
 
+static const char *GetCncvOpName(CncvOp op) {
+  switch (op) {
+    case CncvOp::YUV_RESIZE: return "YuvResize";
+    case CncvOp::YUV_TO_RGBX: return "YuvToRgbxResize";
+    case CncvOp::RGBX_TO_YUV: return "RgbxToYuv";
+    case CncvOp::MEAN_STD: return "MeanStd";
+    case CncvOp::YUV_TO_RGBX_MEAN_STD: return "Yuv2RgbxResizeWithMeanStd";
+  }
+  return "Unknown";
+}
+
+// Runs the operator with a context bound to the session queue. The destination of a tensor is described by a
+// BufSurface for the operators that do not take the tensor descriptor.
+template <typename Ctx>
+static int ProcessWithContext(Ctx *ctx, CncvOp op, CnedkBufSurface *src, CnedkBufSurface *dst,
+                              CnedkTransformParams *transform_params) {
+  CnedkBufSurface* dst_buf = dst;
+  std::unique_ptr<CnedkBufSurface> dst_buf_for_tensor = nullptr;
+  std::vector<CnedkBufSurfaceParams> dst_params_for_tensor;
+
+  if (op != CncvOp::MEAN_STD && op != CncvOp::YUV_TO_RGBX_MEAN_STD &&
+      dst->surface_list[0].color_format == CNEDK_BUF_COLOR_FORMAT_TENSOR) {
     dst_buf_for_tensor.reset(new CnedkBufSurface());
     memset(dst_buf_for_tensor.get(), 0, sizeof(CnedkBufSurface));
 
@@ -650,59 +911,152 @@ int DoCncvTransform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformPa
     dst_buf_for_tensor->surface_list = dst_params_for_tensor.data();
 
     if (GetBufSurfaceFromTensor(dst, dst_buf_for_tensor.get(), transform_params->dst_desc) < 0) {
-      LOG(ERROR) << "[EasyDK] DoCncvTransform(): Get BufSurface according to tensor failed";
+      LOG(ERROR) << "[EasyDK] ProcessWithContext(): Get BufSurface according to tensor failed";
       return -1;
     }
     dst_buf = dst_buf_for_tensor.get();
   }
 
-  if (IsRgbx(src->surface_list[0].color_format) &&
-      IsYuv420sp(dst_buf->surface_list[0].color_format)) {
-    static thread_local std::shared_ptr<Rgbx2YuvResizeAndConvert> cncv_ctx = nullptr;
-    if (!cncv_ctx) {
-      int dev_id = 0;
-      cnrtGetDevice(&dev_id);
-      cncv_ctx = std::make_shared<Rgbx2YuvResizeAndConvert>(dev_id);
-    }
-    if (cncv_ctx->Process(*src, dst_buf, transform_params) < 0) {
-      LOG(ERROR) << "[EasyDK] DoCncvTransform(): RgbxToYuv failed";
-      return -1;
-    }
-  } else if (IsYuv420sp(src->surface_list[0].color_format) &&
-             IsRgbx(dst_buf->surface_list[0].color_format)) {
-    static thread_local std::shared_ptr<CncvContext> cncv_ctx = nullptr;
-    if (!cncv_ctx) {
-      int dev_id = 0;
-      cnrtGetDevice(&dev_id);
-      cncv_ctx = std::make_shared<Yuv2RgbxResizeCncvCtx>(dev_id);
-    }
-    if (cncv_ctx->Process(*src, dst_buf, transform_params) < 0) {
-      LOG(ERROR) << "[EasyDK] DoCncvTransform(): RgbxToYuvResize failed";
-      return -1;
-    }
-  } else if (IsYuv420sp(src->surface_list[0].color_format) &&
-             src->surface_list[0].color_format == dst_buf->surface_list[0].color_format) {
-    static thread_local std::shared_ptr<CncvContext> cncv_ctx = nullptr;
-    if (!cncv_ctx) {
-      int dev_id = 0;
-      cnrtGetDevice(&dev_id);
-      cncv_ctx = std::make_shared<YuvResizeCncvCtx>(dev_id);
-    }
-    if (cncv_ctx->Process(*src, dst_buf, transform_params) < 0) {
-      LOG(ERROR) << "[EasyDK] DoCncvTransform(): YuvResize failed";
-      return -1;
-    }
-  } else {
-    LOG(ERROR) << "[EasyDK] DoCncvTransform(): Unsupported transform type src: "
-               << static_cast<int>(src->surface_list[0].color_format)
-               << ", dst: " << static_cast<int>(dst->surface_list[0].color_format);
+  if (ctx->Process(*src, dst_buf, transform_params) < 0) {
+    LOG(ERROR) << "[EasyDK] ProcessWithContext(): " << GetCncvOpName(op) << " failed";
     return -1;
   }
   return 0;
 }
 
+// Runs the transform with a context from the pool, on the session queue of the calling thread
+template <typename Ctx>
+static int ProcessWithPool(CncvOp op, CnedkBufSurface *src, CnedkBufSurface *dst,
+                           CnedkTransformParams *transform_params) {
+  CnedkTransformConfigParams config;
+  if (CnedkTransformGetSessionParams(&config) < 0) return -1;
+  int dev_id = 0;
+  CNRT_SAFECALL(cnrtGetDevice(&dev_id), "[EasyDK] ProcessWithPool(): get device failed.", -1);
+  auto ctx = CncvContextPool<Ctx>::Instance().Acquire(dev_id, config.cnrt_queue);
+  if (!ctx) return -1;
+  return ProcessWithContext(ctx.get(), op, src, dst, transform_params);
+}
+
+static int RunCncvOp(CncvOp op, CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) {
+  switch (op) {
+    case CncvOp::YUV_RESIZE: return ProcessWithPool<YuvResizeCncvCtx>(op, src, dst, transform_params);
+    case CncvOp::YUV_TO_RGBX: return ProcessWithPool<Yuv2RgbxResizeCncvCtx>(op, src, dst, transform_params);
+    case CncvOp::RGBX_TO_YUV: return ProcessWithPool<Rgbx2YuvResizeAndConvert>(op, src, dst, transform_params);
+    case CncvOp::MEAN_STD: return ProcessWithPool<MeanStdCncvCtx>(op, src, dst, transform_params);
+    case CncvOp::YUV_TO_RGBX_MEAN_STD:
+      return ProcessWithPool<Yuv2RgbxResizeWithMeanStdCncv>(op, src, dst, transform_params);
+  }
+  LOG(ERROR) << "[EasyDK] RunCncvOp(): Unsupported operator";
+  return -1;
+}
+
+int DoCncvTransform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) {
+  CncvOp op;
+  if (GetCncvOp(src->surface_list[0].color_format, dst->surface_list[0].color_format, transform_params->dst_desc,
+                transform_params->transform_flag, &op) < 0) {
+    return -1;
+  }
+  return RunCncvOp(op, src, dst, transform_params);
+}
+
 int CncvTransform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) {
   return DoCncvTransform(src, dst, transform_params);
 }
 
+int CncvTransformRoi(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformRoiParams *roi_params) {
+  CnedkTransformConfigParams config;
+  if (CnedkTransformGetSessionParams(&config) < 0) return -1;
+  int dev_id = 0;
+  CNRT_SAFECALL(cnrtGetDevice(&dev_id), "[EasyDK] CncvTransformRoi(): get device failed.", -1);
+  auto ctx = CncvContextPool<RoiResizeConvertCncvCtx>::Instance().Acquire(dev_id, config.cnrt_queue);
+  if (!ctx) return -1;
+  if (ctx->Process(*src, dst, roi_params) < 0) {
+    LOG(ERROR) << "[EasyDK] CncvTransformRoi(): RoiResizeConvert failed";
+    return -1;
+  }
+  return 0;
+}
+
+// The operator is selected once, and the plan owns a context whose pointer tables are reserved for the batch size.
+// The workspace is sized on the first execution since it depends on the rectangles of each call.
+// Plans are shared by the callers with the same parameters. A run that finds the context busy takes one from the pool
+// instead of waiting for the other caller.
+// A notifier is placed after each run. It is waited for before the context moves to another queue and before the
+// context is destroyed, as the operators may still be queued with CNEDK_TRANSFORM_ASYNC.
+template <typename Ctx>
+class CncvTransformPlan : public ITransformPlan {
+ public:
+  CncvTransformPlan(CncvOp op, const CnedkTransformPlanParams &params, std::unique_ptr<Ctx> ctx)
+      : ITransformPlan(params), op_(op), ctx_(std::move(ctx)) {}
+  ~CncvTransformPlan() override {
+    if (pending_) cnrtWaitNotifier(notifier_);
+    if (notifier_) cnrtNotifierDestroy(notifier_);
+  }
+
+ protected:
+  int Run(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) override {
+    if (src->mem_type != CNEDK_BUF_MEM_DEVICE || dst->mem_type != CNEDK_BUF_MEM_DEVICE) {
+      LOG(ERROR) << "[EasyDK] [CncvTransformPlan] Run(): The src and dst mem_type must be CNEDK_BUF_MEM_DEVICE";
+      return -1;
+    }
+    std::unique_lock<std::mutex> lk(mutex_, std::try_to_lock);
+    if (!lk.owns_lock()) return ProcessWithPool<Ctx>(op_, src, dst, transform_params);
+
+    CnedkTransformConfigParams config;
+    if (CnedkTransformGetSessionParams(&config) < 0) return -1;
+    if (config.cnrt_queue != queue_) {
+      if (pending_) {
+        CNRT_SAFECALL(cnrtWaitNotifier(notifier_), "[EasyDK] [CncvTransformPlan] Run(): wait notifier failed.", -1);
+        pending_ = false;
+      }
+      ctx_->Bind(config.cnrt_queue);
+      queue_ = config.cnrt_queue;
+    }
+    if (!notifier_) {
+      CNRT_SAFECALL(cnrtNotifierCreate(&notifier_), "[EasyDK] [CncvTransformPlan] Run(): create notifier failed.",
+                    -1);
+    }
+    int ret = ProcessWithContext(ctx_.get(), op_, src, dst, transform_params);
+    CNRT_SAFECALL(cnrtPlaceNotifier(notifier_, queue_), "[EasyDK] [CncvTransformPlan] Run(): place notifier failed.",
+                  -1);
+    pending_ = true;
+    return ret;
+  }
+
+ private:
+  CncvOp op_;
+  std::unique_ptr<Ctx> ctx_;
+  std::mutex mutex_;
+  cnrtQueue_t queue_ = nullptr;
+  cnrtNotifier_t notifier_ = nullptr;
+  bool pending_ = false;
+};
+
+template <typename Ctx>
+static ITransformPlan *CreatePlanWithContext(CncvOp op, const CnedkTransformPlanParams &params) {
+  int dev_id = 0;
+  CNRT_SAFECALL(cnrtGetDevice(&dev_id), "[EasyDK] CreateCncvTransformPlan(): get device failed.", nullptr);
+  std::unique_ptr<Ctx> ctx(new Ctx(dev_id));
+  if (ctx->Reserve(params.batch_size) < 0) {
+    LOG(ERROR) << "[EasyDK] CreateCncvTransformPlan(): Reserve resources failed";
+    return nullptr;
+  }
+  return new CncvTransformPlan<Ctx>(op, params, std::move(ctx));
+}
+
+ITransformPlan *CreateCncvTransformPlan(const CnedkTransformPlanParams &params) {
+  CncvOp op;
+  if (GetCncvOp(params.src_format, params.dst_format, params.dst_desc, params.transform_flag, &op) < 0) {
+    return nullptr;
+  }
+  switch (op) {
+    case CncvOp::YUV_RESIZE: return CreatePlanWithContext<YuvResizeCncvCtx>(op, params);
+    case CncvOp::YUV_TO_RGBX: return CreatePlanWithContext<Yuv2RgbxResizeCncvCtx>(op, params);
+    case CncvOp::RGBX_TO_YUV: return CreatePlanWithContext<Rgbx2YuvResizeAndConvert>(op, params);
+    case CncvOp::MEAN_STD: return CreatePlanWithContext<MeanStdCncvCtx>(op, params);
+    case CncvOp::YUV_TO_RGBX_MEAN_STD: return CreatePlanWithContext<Yuv2RgbxResizeWithMeanStdCncv>(op, params);
+  }
+  return nullptr;
+}
+
 }  // namespace cnedk
@@ -21,17 +21,83 @@
 #ifndef CNEDK_TRANSFORM_CNCV_HPP_
 #define CNEDK_TRANSFORM_CNCV_HPP_
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "cncv.h"
 
 #include "cnedk_buf_surface.h"
 #include "cnedk_transform.h"
+#include "../cnedk_transform_impl.hpp"
 
 namespace cnedk {
 
+// Holds the plane pointer arrays passed to the batched cncv operators. The host copy is pinned so that it is uploaded
+// asynchronously on the session queue. Slots are used in turn, and a slot is rewritten only after the operator
+// reading it has finished, which is tracked by a notifier placed after the operator.
+class CncvPointerTable {
+ public:
+  CncvPointerTable() = default;
+  ~CncvPointerTable();
+
+  // Allocates all slots with room for `count` pointers
+  int Reserve(size_t count);
+  // Switches to the next slot and returns its host table with room for at least `count` pointers
+  void** Acquire(size_t count);
+  // Copies the first `count` pointers of the current slot to device
+  int Upload(size_t count, cnrtQueue_t queue);
+  // Marks the end of the work on the queue that reads the current slot
+  int Record(cnrtQueue_t queue);
+  void** GetDevicePtr() const { return slots_[cur_].dev; }
+
+ private:
+  CncvPointerTable(const CncvPointerTable&) = delete;
+  CncvPointerTable& operator=(const CncvPointerTable&) = delete;
+
+  struct Slot {
+    void** host = nullptr;
+    void** dev = nullptr;
+    size_t capacity = 0;
+    cnrtNotifier_t notifier = nullptr;
+    bool pending = false;
+  };
+  static constexpr int kSlotNum = 4;
+  Slot slots_[kSlotNum];
+  int cur_ = 0;
+};  // class CncvPointerTable
+
+// Caches the workspace size of a cncv operator by (batch, shapes), so the size is queried only once for each shape
+// combination. The workspace memory keeps the largest size requested, changing batch sizes do not reallocate it.
+class CncvWorkspace {
+ public:
+  CncvWorkspace() = default;
+  ~CncvWorkspace();
+
+  // Gets the workspace for `key`, `query` is called to get the required size on cache miss.
+  // `queue` is synchronized before the old workspace is released, as it may still be used by pending operators.
+  int Get(const std::vector<uint32_t>& key, const std::function<int(size_t*)>& query, cnrtQueue_t queue,
+          void** workspace, size_t* size);
+
+  static void AppendKey(std::vector<uint32_t>* key, const cncvImageDescriptor& desc, const cncvRect& roi) {
+    key->insert(key->end(), {desc.width, desc.height, static_cast<uint32_t>(desc.pixel_fmt), desc.stride[0],
+                             desc.stride[1], roi.w, roi.h});
+  }
+
+ private:
+  CncvWorkspace(const CncvWorkspace&) = delete;
+  CncvWorkspace& operator=(const CncvWorkspace&) = delete;
+
+  static constexpr size_t kMaxCachedKeys = 1024;
+  std::map<std::vector<uint32_t>, size_t> sizes_;
+  void* workspace_ = nullptr;
+  size_t capacity_ = 0;
+};  // class CncvWorkspace
+
 class CncvContext {
  public:
   explicit CncvContext(int dev_id) {
@@ -49,19 +115,30 @@ class CncvContext {
     cnrtSetDeviceFlag(1);
 #endif
 
-    CnedkTransformGetSessionParams(&params_);
+    memset(&params_, 0, sizeof(params_));
+    params_.device_id = dev_id;
     cncvCreate(&handle_);
-    cncvSetQueue(handle_, params_.cnrt_queue);
   }
 
   virtual int Process(const CnedkBufSurface& src, CnedkBufSurface* dst, CnedkTransformParams* transform_params) = 0;
+  // Preallocates the resources for batches up to batch_size
+  virtual int Reserve(size_t batch_size) { return 0; }
   int GetDeviceId() { return device_id_; }
+  cnrtQueue_t GetQueue() { return params_.cnrt_queue; }
+  // Sets the queue to run on. Contexts are pooled and shared by threads, so the queue is set on each use.
+  void Bind(cnrtQueue_t queue) {
+    if (params_.cnrt_queue == queue) return;
+    params_.cnrt_queue = queue;
+    cncvSetQueue(handle_, queue);
+  }
 
   virtual ~CncvContext() {
     if (handle_) cncvDestroy(handle_);
-    CnedkTransformSetSessionParams(&params_);
   }
 
+  // Synchronizes the queue unless CNEDK_TRANSFORM_ASYNC is set
+  int Sync(CnedkTransformParams* transform_params);
+
   static cncvPixelFormat GetPixFormat(CnedkBufSurfaceColorFormat format) {
     static std::map<CnedkBufSurfaceColorFormat, cncvPixelFormat> color_map{
         {CNEDK_BUF_COLOR_FORMAT_YUV420, CNCV_PIX_FMT_I420}, {CNEDK_BUF_COLOR_FORMAT_NV12, CNCV_PIX_FMT_NV12},
@@ -84,27 +161,19 @@ class YuvResizeCncvCtx : public CncvContext {
   explicit YuvResizeCncvCtx(int dev_id) : CncvContext(dev_id) {}
 
   int Process(const CnedkBufSurface& src, CnedkBufSurface* dst, CnedkTransformParams* transform_params) override;
-  ~YuvResizeCncvCtx() override {
-    if (mlu_input_) cnrtFree(mlu_input_);
-    if (mlu_output_) cnrtFree(mlu_output_);
-    if (workspace_) cnrtFree(workspace_);
-  };
+  int Reserve(size_t batch_size) override { return pointers_.Reserve(2 * plane_number_ * batch_size); }
+  ~YuvResizeCncvCtx() override {}
 
  private:
-  std::vector<void**> cpu_input_;
-  std::vector<void**> cpu_output_;
-
-  void** mlu_input_ = nullptr;
-  void** mlu_output_ = nullptr;
+  CncvPointerTable pointers_;
+  CncvWorkspace workspace_;
 
   std::vector<cncvImageDescriptor> src_descs_;
   std::vector<cncvImageDescriptor> dst_descs_;
   std::vector<cncvRect> src_rois_;
   std::vector<cncvRect> dst_rois_;
+  std::vector<uint32_t> workspace_key_;
 
-  void* workspace_ = nullptr;
-  size_t workspace_size_ = 0;
-  size_t batch_size_ = 0;
   const int plane_number_ = 2;
 };  // class YuvResizeCncvCtx
 
@@ -113,28 +182,20 @@ class Yuv2RgbxResizeCncvCtx : public CncvContext {
   explicit Yuv2RgbxResizeCncvCtx(int dev_id) : CncvContext(dev_id) {}
 
   int Process(const CnedkBufSurface& src, CnedkBufSurface* dst, CnedkTransformParams* transform_params) override;
-  ~Yuv2RgbxResizeCncvCtx() override {
-    if (mlu_input_) cnrtFree(mlu_input_);
-    if (mlu_output_) cnrtFree(mlu_output_);
-    if (workspace_) cnrtFree(workspace_);
-  }
+  int Reserve(size_t batch_size) override { return pointers_.Reserve((plane_number_ + 1) * batch_size); }
+  ~Yuv2RgbxResizeCncvCtx() override {}
 
  private:
-  std::vector<void**> cpu_input_;
-  std::vector<void**> cpu_output_;
-
-  void** mlu_input_ = nullptr;
-  void** mlu_output_ = nullptr;
+  CncvPointerTable pointers_;
+  CncvWorkspace workspace_;
 
   std::vector<cncvImageDescriptor> src_descs_;
   std::vector<cncvImageDescriptor> dst_descs_;
   std::vector<cncvRect> src_rois_;
   std::vector<cncvRect> dst_rois_;
+  std::vector<uint32_t> workspace_key_;
   bool keep_aspect_ratio_;
   uint8_t pad_value_ = 0;
-  void* workspace_ = nullptr;
-  size_t workspace_size_ = 0;
-  size_t batch_size_ = 0;
   const int plane_number_ = 2;
 };
 
@@ -155,25 +216,16 @@ class MeanStdCncvCtx : public CncvContext {
   explicit MeanStdCncvCtx(int dev_id) : CncvContext(dev_id) {}
 
   int Process(const CnedkBufSurface& src, CnedkBufSurface* dst, CnedkTransformParams* transform_params) override;
-  ~MeanStdCncvCtx() override {
-    if (mlu_input_) cnrtFree(mlu_input_);
-    if (mlu_output_) cnrtFree(mlu_output_);
-    if (workspace_) cnrtFree(workspace_);
-  }
+  int Reserve(size_t batch_size) override { return pointers_.Reserve(2 * batch_size); }
+  ~MeanStdCncvCtx() override {}
 
  private:
-  std::vector<void**> cpu_input_;
-  std::vector<void**> cpu_output_;
-
-  void** mlu_input_ = nullptr;
-  void** mlu_output_ = nullptr;
+  CncvPointerTable pointers_;
+  CncvWorkspace workspace_;
 
   cncvImageDescriptor src_desc_;
   cncvImageDescriptor dst_desc_;
 
-  void* workspace_ = nullptr;
-  size_t workspace_size_ = 0;
-  size_t batch_size_ = 0;
   float* mean_;
   float* std_;
 };
@@ -189,6 +241,12 @@ class Rgbx2YuvResizeAndConvert {
     if (src_yuv_mlu_)  cnrtFree(src_yuv_mlu_);
   }
   int Process(const CnedkBufSurface& src, CnedkBufSurface* dst, CnedkTransformParams* transform_params);
+  int Reserve(size_t batch_size) { return yuv_resize_->Reserve(batch_size); }
+  void Bind(cnrtQueue_t queue) {
+    rgbx_yuv_->Bind(queue);
+    yuv_resize_->Bind(queue);
+  }
+
  private:
   int dev_id_;
   std::shared_ptr<RgbxToYuvCncvCtx> rgbx_yuv_;
@@ -206,6 +264,14 @@ class Yuv2RgbxResizeWithMeanStdCncv {
   }
 
   int Process(const CnedkBufSurface& src, CnedkBufSurface* dst, CnedkTransformParams* transform_params);
+  int Reserve(size_t batch_size) {
+    if (mean_std_->Reserve(batch_size) < 0) return -1;
+    return resize_convert_->Reserve(batch_size);
+  }
+  void Bind(cnrtQueue_t queue) {
+    mean_std_->Bind(queue);
+    resize_convert_->Bind(queue);
+  }
   ~Yuv2RgbxResizeWithMeanStdCncv() {
     if (mlu_ptr_) cnrtFree(mlu_ptr_);
   }
@@ -218,8 +284,129 @@ class Yuv2RgbxResizeWithMeanStdCncv {
   size_t mlu_size_ = 0;
 };
 
+// Crops, resizes and converts regions of YUV420sp images into a batch of RGB family images in one launch, the
+// regions may come from the same image. Normalization is done by one more launch of MeanStdCncvCtx.
+class RoiResizeConvertCncvCtx {
+ public:
+  explicit RoiResizeConvertCncvCtx(int dev_id) {
+    resize_convert_ = std::make_shared<Yuv2RgbxResizeCncvCtx>(dev_id);
+    mean_std_ = std::make_shared<MeanStdCncvCtx>(dev_id);
+  }
+  ~RoiResizeConvertCncvCtx() {
+    if (mlu_ptr_) cnrtFree(mlu_ptr_);
+  }
+
+  int Process(const CnedkBufSurface& src, CnedkBufSurface* dst, CnedkTransformRoiParams* roi_params);
+  void Bind(cnrtQueue_t queue) {
+    resize_convert_->Bind(queue);
+    mean_std_->Bind(queue);
+  }
+
+ private:
+  std::shared_ptr<Yuv2RgbxResizeCncvCtx> resize_convert_;
+  std::shared_ptr<MeanStdCncvCtx> mean_std_;
+
+  // the src and dst of the regions, as batches of Yuv2RgbxResizeCncvCtx
+  std::vector<CnedkBufSurfaceParams> src_params_;
+  std::vector<CnedkBufSurfaceParams> dst_params_;
+  std::vector<CnedkTransformRect> src_rects_;
+  std::vector<CnedkTransformRect> dst_rects_;
+
+  void* mlu_ptr_ = nullptr;  // 8-bit images before normalization
+  size_t mlu_size_ = 0;
+};
+
+// Idle contexts of one type, shared by all threads. A context is used by one caller at a time, so the number of
+// contexts is the peak concurrency rather than the number of threads.
+// With CNEDK_TRANSFORM_ASYNC a context is released while its operators are still queued, and they keep using its
+// workspace and buffers. A notifier is placed on the queue when the context is released, it is waited for before the
+// context is bound to another queue. Reusing a context on the same queue needs no wait as the queue runs in order, so
+// contexts last used on the requested queue are preferred.
+template <typename Ctx>
+class CncvContextPool {
+ public:
+  using CtxPtr = std::unique_ptr<Ctx, std::function<void(Ctx*)>>;
+
+  static CncvContextPool& Instance() {
+    static CncvContextPool pool;
+    return pool;
+  }
+
+  // Gets an idle context of the device or creates one, the context goes back to the pool when the pointer is reset.
+  // Returns nullptr if the pending work of the context on its last queue cannot be waited for.
+  CtxPtr Acquire(int dev_id, cnrtQueue_t queue) {
+    std::unique_ptr<Entry> entry;
+    {
+      std::lock_guard<std::mutex> lk(mutex_);
+      auto& idle = idle_[dev_id];
+      if (!idle.empty()) {
+        auto iter = std::find_if(idle.rbegin(), idle.rend(),
+                                 [queue](const std::unique_ptr<Entry>& e) { return e->queue == queue; });
+        auto pos = iter == idle.rend() ? idle.end() - 1 : std::next(iter).base();
+        entry = std::move(*pos);
+        idle.erase(pos);
+      }
+    }
+    if (!entry) {
+      entry.reset(new Entry);
+      entry->ctx.reset(new Ctx(dev_id));
+    } else if (entry->pending && entry->queue != queue) {
+      CNRT_SAFECALL(cnrtWaitNotifier(entry->notifier), "[EasyDK] [CncvContextPool] Acquire(): wait notifier failed.",
+                    CtxPtr(nullptr, [](Ctx*) {}));
+    }
+    entry->pending = false;
+    entry->queue = queue;
+    entry->ctx->Bind(queue);
+    Entry* e = entry.release();
+    return CtxPtr(e->ctx.get(), [this, dev_id, e](Ctx*) { Release(dev_id, e); });
+  }
+
+ private:
+  struct Entry {
+    ~Entry() {
+      if (pending) cnrtWaitNotifier(notifier);
+      if (notifier) cnrtNotifierDestroy(notifier);
+    }
+    std::unique_ptr<Ctx> ctx;
+    cnrtQueue_t queue = nullptr;
+    cnrtNotifier_t notifier = nullptr;
+    bool pending = false;
+  };
+
+  CncvContextPool() = default;
+  CncvContextPool(const CncvContextPool&) = delete;
+  CncvContextPool& operator=(const CncvContextPool&) = delete;
+
+  void Release(int dev_id, Entry* e) {
+    std::unique_ptr<Entry> entry(e);
+    if (!entry->notifier && cnrtNotifierCreate(&entry->notifier) != cnrtSuccess) entry->notifier = nullptr;
+    if (entry->notifier && cnrtPlaceNotifier(entry->notifier, entry->queue) == cnrtSuccess) {
+      entry->pending = true;
+    } else if (cnrtQueueSync(entry->queue) != cnrtSuccess) {
+      LOG(ERROR) << "[EasyDK] [CncvContextPool] Release(): queue sync failed, the context is not reused";
+      return;
+    }
+    std::lock_guard<std::mutex> lk(mutex_);
+    idle_[dev_id].push_back(std::move(entry));
+  }
+
+  std::mutex mutex_;
+  std::map<int, std::vector<std::unique_ptr<Entry>>> idle_;
+};  // class CncvContextPool
+
+// The cncv operators that CnedkTransform dispatches to
+enum class CncvOp {
+  YUV_RESIZE,
+  YUV_TO_RGBX,
+  RGBX_TO_YUV,
+  MEAN_STD,
+  YUV_TO_RGBX_MEAN_STD,
+};
+
 int GetBufSurfaceFromTensor(CnedkBufSurface* src, CnedkBufSurface* dst, CnedkTransformTensorDesc* tensor_desc);
 int CncvTransform(CnedkBufSurface* src, CnedkBufSurface* dst, CnedkTransformParams* transform_params);
+int CncvTransformRoi(CnedkBufSurface* src, CnedkBufSurface* dst, CnedkTransformRoiParams* roi_params);
+ITransformPlan* CreateCncvTransformPlan(const CnedkTransformPlanParams& params);
 
 }  // namespace cnedk
 
@@ -0,0 +1,663 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include "cnedk_transform_cpu.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "glog/logging.h"
+
+#include "../common/utils.hpp"
+#include "cnedk_transform_cpu_kernels.hpp"
+
+namespace cnedk {
+
+namespace {
+
+struct ChannelOrder {
+  int r, g, b, a;  // index of each channel in a pixel, a is -1 if there is no alpha channel
+  int channels;
+};
+
+bool GetChannelOrder(CnedkBufSurfaceColorFormat fmt, ChannelOrder *order) {
+  static const std::map<CnedkBufSurfaceColorFormat, ChannelOrder> order_map{
+      {CNEDK_BUF_COLOR_FORMAT_RGB, {0, 1, 2, -1, 3}},  {CNEDK_BUF_COLOR_FORMAT_BGR, {2, 1, 0, -1, 3}},
+      {CNEDK_BUF_COLOR_FORMAT_RGBA, {0, 1, 2, 3, 4}},  {CNEDK_BUF_COLOR_FORMAT_BGRA, {2, 1, 0, 3, 4}},
+      {CNEDK_BUF_COLOR_FORMAT_ARGB, {1, 2, 3, 0, 4}},  {CNEDK_BUF_COLOR_FORMAT_ABGR, {3, 2, 1, 0, 4}},
+  };
+  auto iter = order_map.find(fmt);
+  if (iter == order_map.end()) return false;
+  *order = iter->second;
+  return true;
+}
+
+CnedkBufSurfaceColorFormat GetColorFormatFromTensor(CnedkTransformColorFormat format) {
+  static const std::map<CnedkTransformColorFormat, CnedkBufSurfaceColorFormat> color_map{
+      {CNEDK_TRANSFORM_COLOR_FORMAT_BGR, CNEDK_BUF_COLOR_FORMAT_BGR},
+      {CNEDK_TRANSFORM_COLOR_FORMAT_RGB, CNEDK_BUF_COLOR_FORMAT_RGB},
+      {CNEDK_TRANSFORM_COLOR_FORMAT_BGRA, CNEDK_BUF_COLOR_FORMAT_BGRA},
+      {CNEDK_TRANSFORM_COLOR_FORMAT_RGBA, CNEDK_BUF_COLOR_FORMAT_RGBA},
+      {CNEDK_TRANSFORM_COLOR_FORMAT_ABGR, CNEDK_BUF_COLOR_FORMAT_ABGR},
+      {CNEDK_TRANSFORM_COLOR_FORMAT_ARGB, CNEDK_BUF_COLOR_FORMAT_ARGB},
+  };
+  auto iter = color_map.find(format);
+  if (iter != color_map.end()) return iter->second;
+  return CNEDK_BUF_COLOR_FORMAT_LAST;
+}
+
+bool IsYuv420sp(CnedkBufSurfaceColorFormat fmt) {
+  return fmt == CNEDK_BUF_COLOR_FORMAT_NV12 || fmt == CNEDK_BUF_COLOR_FORMAT_NV21;
+}
+
+bool IsHostAccessible(CnedkBufSurfaceMemType mem_type) {
+  return mem_type == CNEDK_BUF_MEM_SYSTEM || mem_type == CNEDK_BUF_MEM_PINNED ||
+         mem_type == CNEDK_BUF_MEM_UNIFIED || mem_type == CNEDK_BUF_MEM_UNIFIED_CACHED ||
+         mem_type == CNEDK_BUF_MEM_VB || mem_type == CNEDK_BUF_MEM_VB_CACHED;
+}
+
+bool IsCached(CnedkBufSurfaceMemType mem_type) {
+  return mem_type == CNEDK_BUF_MEM_UNIFIED_CACHED || mem_type == CNEDK_BUF_MEM_VB_CACHED;
+}
+
+uint8_t *GetHostPtr(const CnedkBufSurface &surf, uint32_t idx) {
+  if (surf.mem_type == CNEDK_BUF_MEM_SYSTEM || surf.mem_type == CNEDK_BUF_MEM_PINNED) {
+    return static_cast<uint8_t *>(surf.surface_list[idx].data_ptr);
+  }
+  return static_cast<uint8_t *>(surf.surface_list[idx].mapped_data_ptr);
+}
+
+uint32_t GetPlanePitch(const CnedkBufSurfaceParams &params, uint32_t plane) {
+  if (params.plane_params.pitch[plane]) return params.plane_params.pitch[plane];
+  return params.pitch;
+}
+
+struct Rect {
+  uint32_t x, y, w, h;
+};
+
+Rect GetRoi(const CnedkTransformRect *rect, uint32_t width, uint32_t height) {
+  Rect roi{0, 0, width, height};
+  if (rect) {
+    roi.x = rect->left >= width ? 0 : rect->left;
+    roi.y = rect->top >= height ? 0 : rect->top;
+    roi.w = rect->width == 0 ? (width - roi.x) : rect->width;
+    roi.h = rect->height == 0 ? (height - roi.y) : rect->height;
+    roi.w = std::min(roi.w, width - roi.x);
+    roi.h = std::min(roi.h, height - roi.y);
+  }
+  return roi;
+}
+
+// Bilinear resizer with half-pixel centers, produces one destination row at a time.
+// Horizontally interpolated source rows are cached, so each source row is read once for down-scaling.
+class RowResizer {
+ public:
+  void Init(const uint8_t *src, uint32_t stride, int src_w, int src_h, int channels, int dst_w, int dst_h) {
+    src_ = src;
+    stride_ = stride;
+    src_h_ = src_h;
+    dst_h_ = dst_h;
+    // per element rather than per pixel, so the kernel needs not know the channels
+    xofs0_.resize(dst_w * channels);
+    xofs1_.resize(dst_w * channels);
+    xalpha_.resize(dst_w * channels);
+    n_wide_ = 0;
+    float scale = static_cast<float>(src_w) / dst_w;
+    for (int dx = 0; dx < dst_w; ++dx) {
+      float fx = (dx + 0.5f) * scale - 0.5f;
+      int x0 = static_cast<int>(std::floor(fx));
+      float a = fx - x0;
+      if (x0 < 0) x0 = 0, a = 0.f;
+      int x1 = x0 + 1;
+      if (x1 >= src_w) x0 = x1 = src_w - 1, a = 0.f;
+      for (int c = 0; c < channels; ++c) {
+        int i = dx * channels + c;
+        xofs0_[i] = x0 * channels + c;
+        xofs1_[i] = x1 * channels + c;
+        xalpha_[i] = a;
+        // offsets only grow, the elements reading 32 bits within the row come first
+        if (xofs1_[i] + 4 <= src_w * channels) n_wide_ = i + 1;
+      }
+    }
+    for (int i = 0; i < 2; ++i) {
+      rows_[i].resize(dst_w * channels);
+      row_idx_[i] = -1;
+    }
+    out_.resize(dst_w * channels);
+  }
+
+  const float *Row(int dy) {
+    float fy = (dy + 0.5f) * src_h_ / dst_h_ - 0.5f;
+    int y0 = static_cast<int>(std::floor(fy));
+    float b = fy - y0;
+    if (y0 < 0) y0 = 0, b = 0.f;
+    int y1 = y0 + 1;
+    if (y1 >= src_h_) y0 = y1 = src_h_ - 1, b = 0.f;
+    const float *r0 = GetHorizontalRow(y0, y1);
+    if (b == 0.f) return r0;
+    const float *r1 = GetHorizontalRow(y1, y0);
+    cpu_kernel::BlendRows(r0, r1, b, out_.data(), static_cast<int>(out_.size()));
+    return out_.data();
+  }
+
+ private:
+  const float *GetHorizontalRow(int sy, int keep) {
+    for (int i = 0; i < 2; ++i) {
+      if (row_idx_[i] == sy) return rows_[i].data();
+    }
+    int slot = row_idx_[0] == keep ? 1 : 0;
+    const uint8_t *s = src_ + static_cast<size_t>(sy) * stride_;
+    cpu_kernel::LerpGather(s, xofs0_.data(), xofs1_.data(), xalpha_.data(), rows_[slot].data(),
+                           static_cast<int>(xalpha_.size()), n_wide_);
+    row_idx_[slot] = sy;
+    return rows_[slot].data();
+  }
+
+ private:
+  const uint8_t *src_ = nullptr;
+  uint32_t stride_ = 0;
+  int src_h_ = 0;
+  int dst_h_ = 0;
+  int n_wide_ = 0;
+  std::vector<int> xofs0_, xofs1_;
+  std::vector<float> xalpha_;
+  std::vector<float> rows_[2];
+  int row_idx_[2];
+  std::vector<float> out_;
+};
+
+inline void RgbToYuv(float r, float g, float b, float *y, float *u, float *v) {
+  *y = 0.257f * r + 0.504f * g + 0.098f * b + 16.f;
+  *u = -0.148f * r - 0.291f * g + 0.439f * b + 128.f;
+  *v = 0.439f * r - 0.368f * g - 0.071f * b + 128.f;
+}
+
+size_t GetDataTypeSize(CnedkTransformDataType data_type) {
+  switch (data_type) {
+    case CNEDK_TRANSFORM_UINT8:
+      return 1;
+    case CNEDK_TRANSFORM_FLOAT16:
+      return 2;
+    case CNEDK_TRANSFORM_FLOAT32:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+// Everything needed to transform one item of the batch
+struct CpuTransformItem {
+  CnedkBufSurfaceColorFormat src_fmt;
+  const uint8_t *src_planes[2];
+  uint32_t src_pitch[2];
+  Rect src_roi;
+
+  CnedkBufSurfaceColorFormat dst_fmt;
+  uint8_t *dst_planes[2];
+  uint32_t dst_pitch[2];
+  Rect dst_roi;
+  CnedkTransformDataType data_type;
+  bool mean_std;
+  float mean[CNEDK_TRANSFORM_MAX_CHNS];
+  float std[CNEDK_TRANSFORM_MAX_CHNS];
+
+  // only for tensors of batched roi transform
+  bool nchw = false;  // dst_pitch[0] is the pitch of one channel plane
+  bool pad = false;   // fills the whole dst_w x dst_h tensor with pad_value first
+  uint8_t pad_value = 0;
+  uint32_t dst_w = 0, dst_h = 0;
+};
+
+void WriteRow(const float *src, int n, CnedkTransformDataType data_type, uint8_t *dst) {
+  switch (data_type) {
+    case CNEDK_TRANSFORM_FLOAT32:
+      memcpy(dst, src, n * sizeof(float));
+      break;
+    case CNEDK_TRANSFORM_FLOAT16:
+      cpu_kernel::FloatToHalf(src, reinterpret_cast<uint16_t *>(dst), n);
+      break;
+    default:
+      cpu_kernel::FloatToU8(src, dst, n);
+      break;
+  }
+}
+
+// Writes one interleaved row of dc channels, at (x, y) of dst
+void WriteTensorRow(const CpuTransformItem &item, const float *pix, int n, int dc, uint32_t x, uint32_t y,
+                    std::vector<float> *channel) {
+  const size_t elem_size = GetDataTypeSize(item.data_type);
+  if (!item.nchw) {
+    WriteRow(pix, n * dc, item.data_type, item.dst_planes[0] + y * item.dst_pitch[0] + x * dc * elem_size);
+    return;
+  }
+  const size_t plane_size = static_cast<size_t>(item.dst_pitch[0]) * item.dst_h;
+  channel->resize(n);
+  for (int c = 0; c < dc; ++c) {
+    for (int i = 0; i < n; ++i) (*channel)[i] = pix[i * dc + c];
+    WriteRow(channel->data(), n, item.data_type,
+             item.dst_planes[0] + c * plane_size + y * item.dst_pitch[0] + x * elem_size);
+  }
+}
+
+void FillPad(const CpuTransformItem &item, int dc) {
+  std::vector<float> row(item.dst_w * dc), channel;
+  for (uint32_t i = 0; i < row.size(); ++i) {
+    int c = i % dc;
+    row[i] = item.mean_std ? (item.pad_value - item.mean[c]) / item.std[c] : item.pad_value;
+  }
+  for (uint32_t y = 0; y < item.dst_h; ++y) {
+    WriteTensorRow(item, row.data(), item.dst_w, dc, 0, y, &channel);
+  }
+}
+
+int ProcessToRgbx(const CpuTransformItem &item) {
+  ChannelOrder dst_order;
+  GetChannelOrder(item.dst_fmt, &dst_order);
+  const int dw = item.dst_roi.w, dh = item.dst_roi.h, dc = dst_order.channels;
+  const Rect &sr = item.src_roi;
+
+  bool src_yuv = IsYuv420sp(item.src_fmt);
+  ChannelOrder src_order;
+  RowResizer resizer, uv_resizer;
+  if (src_yuv) {
+    resizer.Init(item.src_planes[0] + sr.y * item.src_pitch[0] + sr.x, item.src_pitch[0], sr.w, sr.h, 1, dw, dh);
+    uv_resizer.Init(item.src_planes[1] + (sr.y / 2) * item.src_pitch[1] + (sr.x / 2) * 2, item.src_pitch[1],
+                    std::max(sr.w / 2, 1u), std::max(sr.h / 2, 1u), 2, dw, dh);
+  } else {
+    GetChannelOrder(item.src_fmt, &src_order);
+    resizer.Init(item.src_planes[0] + sr.y * item.src_pitch[0] + sr.x * src_order.channels, item.src_pitch[0],
+                 sr.w, sr.h, src_order.channels, dw, dh);
+  }
+  const int u_idx = item.src_fmt == CNEDK_BUF_COLOR_FORMAT_NV21 ? 1 : 0;
+  std::vector<float> rgb[3];
+  if (src_yuv) {
+    for (auto &plane : rgb) plane.resize(dw);
+  }
+
+  std::vector<float> pix(dw * dc);
+  std::vector<float> scale, bias;
+  if (item.mean_std) {
+    scale.resize(pix.size());
+    bias.resize(pix.size());
+    for (int i = 0; i < dw * dc; ++i) {
+      int c = i % dc;
+      scale[i] = 1.f / item.std[c];
+      bias[i] = -item.mean[c] / item.std[c];
+    }
+  }
+
+  if (item.pad) FillPad(item, dc);
+
+  std::vector<float> channel;
+  for (int dy = 0; dy < dh; ++dy) {
+    float *p = pix.data();
+    if (src_yuv) {
+      const float *y_row = resizer.Row(dy);
+      const float *uv_row = uv_resizer.Row(dy);
+      cpu_kernel::YuvToRgbRow(y_row, uv_row, u_idx, rgb[0].data(), rgb[1].data(), rgb[2].data(), dw);
+      for (int dx = 0; dx < dw; ++dx, p += dc) {
+        p[dst_order.r] = rgb[0][dx];
+        p[dst_order.g] = rgb[1][dx];
+        p[dst_order.b] = rgb[2][dx];
+        if (dst_order.a >= 0) p[dst_order.a] = 255.f;
+      }
+    } else {
+      const float *s = resizer.Row(dy);
+      const int sc = src_order.channels;
+      for (int dx = 0; dx < dw; ++dx, p += dc, s += sc) {
+        p[dst_order.r] = s[src_order.r];
+        p[dst_order.g] = s[src_order.g];
+        p[dst_order.b] = s[src_order.b];
+        if (dst_order.a >= 0) p[dst_order.a] = src_order.a >= 0 ? s[src_order.a] : 255.f;
+      }
+    }
+
+    if (item.mean_std) {
+      // keep consistent with the mlu implementation, which normalizes the 8-bit image
+      for (auto &v : pix) v = std::nearbyint(v);
+      cpu_kernel::ScaleBias(pix.data(), scale.data(), bias.data(), pix.data(), dw * dc);
+    }
+
+    WriteTensorRow(item, pix.data(), dw, dc, item.dst_roi.x, item.dst_roi.y + dy, &channel);
+  }
+  return 0;
+}
+
+int ProcessToYuv(const CpuTransformItem &item) {
+  const int dw = item.dst_roi.w, dh = item.dst_roi.h;
+  const Rect &sr = item.src_roi;
+  uint8_t *dst_y = item.dst_planes[0] + item.dst_roi.y * item.dst_pitch[0] + item.dst_roi.x;
+  uint8_t *dst_uv = item.dst_planes[1] + (item.dst_roi.y / 2) * item.dst_pitch[1] + item.dst_roi.x;
+  const bool dst_nv21 = item.dst_fmt == CNEDK_BUF_COLOR_FORMAT_NV21;
+
+  if (IsYuv420sp(item.src_fmt)) {
+    RowResizer resizer, uv_resizer;
+    resizer.Init(item.src_planes[0] + sr.y * item.src_pitch[0] + sr.x, item.src_pitch[0], sr.w, sr.h, 1, dw, dh);
+    uv_resizer.Init(item.src_planes[1] + (sr.y / 2) * item.src_pitch[1] + (sr.x / 2) * 2, item.src_pitch[1],
+                    std::max(sr.w / 2, 1u), std::max(sr.h / 2, 1u), 2, dw / 2, dh / 2);
+    const bool swap_uv = item.src_fmt != item.dst_fmt;
+    std::vector<float> uv(dw);
+    for (int dy = 0; dy < dh; ++dy) {
+      cpu_kernel::FloatToU8(resizer.Row(dy), dst_y + dy * item.dst_pitch[0], dw);
+    }
+    for (int dy = 0; dy < dh / 2; ++dy) {
+      const float *uv_row = uv_resizer.Row(dy);
+      if (swap_uv) {
+        for (int i = 0; i < dw; i += 2) uv[i] = uv_row[i + 1], uv[i + 1] = uv_row[i];
+        uv_row = uv.data();
+      }
+      cpu_kernel::FloatToU8(uv_row, dst_uv + dy * item.dst_pitch[1], dw);
+    }
+    return 0;
+  }
+
+  ChannelOrder src_order;
+  GetChannelOrder(item.src_fmt, &src_order);
+  RowResizer resizer;
+  const int sc = src_order.channels;
+  resizer.Init(item.src_planes[0] + sr.y * item.src_pitch[0] + sr.x * sc, item.src_pitch[0], sr.w, sr.h, sc, dw,
+               dh);
+  std::vector<float> y(dw), uv(dw);
+  for (int dy = 0; dy < dh; ++dy) {
+    const float *s = resizer.Row(dy);
+    for (int dx = 0; dx < dw; dx += 2) {
+      float u0, v0, u1, v1;
+      const float *s0 = s + dx * sc, *s1 = s0 + sc;
+      RgbToYuv(s0[src_order.r], s0[src_order.g], s0[src_order.b], &y[dx], &u0, &v0);
+      RgbToYuv(s1[src_order.r], s1[src_order.g], s1[src_order.b], &y[dx + 1], &u1, &v1);
+      // chroma is sampled from the even rows
+      if (!(dy & 1)) {
+        uv[dx + (dst_nv21 ? 1 : 0)] = (u0 + u1) * 0.5f;
+        uv[dx + (dst_nv21 ? 0 : 1)] = (v0 + v1) * 0.5f;
+      }
+    }
+    cpu_kernel::FloatToU8(y.data(), dst_y + dy * item.dst_pitch[0], dw);
+    if (!(dy & 1)) cpu_kernel::FloatToU8(uv.data(), dst_uv + (dy / 2) * item.dst_pitch[1], dw);
+  }
+  return 0;
+}
+
+int ProcessItem(const CpuTransformItem &item) {
+  if (IsYuv420sp(item.dst_fmt)) return ProcessToYuv(item);
+  return ProcessToRgbx(item);
+}
+
+}  // namespace
+
+int TransformerCpu::Transform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) {
+  if (src->num_filled > dst->batch_size) {
+    LOG(ERROR) << "[EasyDK] [TransformerCpu] Transform(): The number of inputs exceeds batch size: "
+               << src->num_filled << " v.s. " << dst->batch_size;
+    return -1;
+  }
+
+  if (!IsHostAccessible(src->mem_type) || !IsHostAccessible(dst->mem_type)) {
+    LOG(ERROR) << "[EasyDK] [TransformerCpu] Transform(): The src and dst memory must be accessible by cpu. "
+               << "src mem_type: " << src->mem_type << ", dst_mem_type: " << dst->mem_type;
+    return -1;
+  }
+
+  if (src->surface_list[0].data_size == 0) {
+    LOG(ERROR) << "[EasyDK] [TransformerCpu] Transform(): Input data size is 0";
+    return -1;
+  }
+
+  return CpuTransform(src, dst, transform_params);
+}
+
+int CpuTransform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) {
+  CnedkBufSurfaceColorFormat src_fmt = src->surface_list[0].color_format;
+  ChannelOrder order;
+  if (!IsYuv420sp(src_fmt) && !GetChannelOrder(src_fmt, &order)) {
+    LOG(ERROR) << "[EasyDK] CpuTransform(): Unsupported src color format: " << src_fmt;
+    return -1;
+  }
+
+  const bool dst_tensor = dst->surface_list[0].color_format == CNEDK_BUF_COLOR_FORMAT_TENSOR;
+  if (dst_tensor && !transform_params->dst_desc) {
+    LOG(ERROR) << "[EasyDK] CpuTransform(): Tensor description of dst is not set";
+    return -1;
+  }
+  CnedkBufSurfaceColorFormat dst_fmt = dst_tensor ? GetColorFormatFromTensor(transform_params->dst_desc->color_format)
+                                                  : dst->surface_list[0].color_format;
+  if (!IsYuv420sp(dst_fmt) && !GetChannelOrder(dst_fmt, &order)) {
+    LOG(ERROR) << "[EasyDK] CpuTransform(): Unsupported dst color format: " << dst_fmt;
+    return -1;
+  }
+  if (IsYuv420sp(dst_fmt) && dst_tensor) {
+    LOG(ERROR) << "[EasyDK] CpuTransform(): Tensor of YUV420sp is not supported";
+    return -1;
+  }
+
+  CnedkTransformDataType data_type = CNEDK_TRANSFORM_UINT8;
+  bool mean_std = false;
+  if (dst_tensor) {
+    data_type = transform_params->dst_desc->data_type;
+    mean_std = transform_params->transform_flag & CNEDK_TRANSFORM_MEAN_STD;
+    if (mean_std && !transform_params->mean_std_params) {
+      LOG(ERROR) << "[EasyDK] CpuTransform(): Mean std parameter is not set";
+      return -1;
+    }
+    if (!GetDataTypeSize(data_type) || (!mean_std && data_type != CNEDK_TRANSFORM_UINT8)) {
+      LOG(ERROR) << "[EasyDK] CpuTransform(): Unsupported data type: " << static_cast<int>(data_type);
+      return -1;
+    }
+    if (transform_params->dst_desc->shape.c != static_cast<uint32_t>(order.channels)) {
+      LOG(ERROR) << "[EasyDK] CpuTransform(): The channel of dst tensor mismatches the color format, "
+                 << transform_params->dst_desc->shape.c << " v.s. " << order.channels;
+      return -1;
+    }
+  }
+
+  uint32_t batch_size = src->batch_size;
+  std::vector<CpuTransformItem> items(batch_size);
+  for (uint32_t i = 0; i < batch_size; ++i) {
+    CpuTransformItem &item = items[i];
+    const CnedkBufSurfaceParams &src_params = src->surface_list[i];
+    const CnedkBufSurfaceParams &dst_params = dst->surface_list[i];
+    const uint8_t *src_ptr = GetHostPtr(*src, i);
+    uint8_t *dst_ptr = GetHostPtr(*dst, i);
+    if (!src_ptr || !dst_ptr) {
+      LOG(ERROR) << "[EasyDK] CpuTransform(): The src or dst is not mapped, batch index: " << i;
+      return -1;
+    }
+    if (src_params.color_format != src_fmt) {
+      LOG(ERROR) << "[EasyDK] CpuTransform(): The src color formats in the batch are different";
+      return -1;
+    }
+
+    item.src_fmt = src_fmt;
+    for (uint32_t p = 0; p < 2; ++p) {
+      item.src_planes[p] = src_ptr + src_params.plane_params.offset[p];
+      item.src_pitch[p] = GetPlanePitch(src_params, p);
+    }
+    bool crop_src = transform_params->transform_flag & CNEDK_TRANSFORM_CROP_SRC;
+    item.src_roi = GetRoi(crop_src ? &transform_params->src_rect[i] : nullptr, src_params.width, src_params.height);
+
+    item.dst_fmt = dst_fmt;
+    item.data_type = data_type;
+    item.mean_std = mean_std;
+    uint32_t dst_w = dst_params.width, dst_h = dst_params.height;
+    if (dst_tensor) {
+      const CnedkTransformShape &shape = transform_params->dst_desc->shape;
+      dst_w = shape.w;
+      dst_h = shape.h;
+      item.dst_planes[0] = item.dst_planes[1] = dst_ptr;
+      item.dst_pitch[0] = item.dst_pitch[1] = shape.w * shape.c * GetDataTypeSize(data_type);
+      if (static_cast<size_t>(item.dst_pitch[0]) * dst_h > dst_params.data_size) {
+        LOG(ERROR) << "[EasyDK] CpuTransform(): The dst tensor is larger than the buffer, batch index: " << i;
+        return -1;
+      }
+    } else {
+      for (uint32_t p = 0; p < 2; ++p) {
+        item.dst_planes[p] = dst_ptr + dst_params.plane_params.offset[p];
+        item.dst_pitch[p] = GetPlanePitch(dst_params, p);
+      }
+    }
+    bool crop_dst = transform_params->transform_flag & CNEDK_TRANSFORM_CROP_DST;
+    item.dst_roi = GetRoi(crop_dst ? &transform_params->dst_rect[i] : nullptr, dst_w, dst_h);
+
+    if (IsYuv420sp(src_fmt) || IsYuv420sp(dst_fmt)) {
+      // 4:2:0 chroma needs even coordinates
+      for (Rect *roi : {&item.src_roi, &item.dst_roi}) {
+        roi->x &= ~1u, roi->y &= ~1u, roi->w &= ~1u, roi->h &= ~1u;
+      }
+    }
+    if (!item.src_roi.w || !item.src_roi.h || !item.dst_roi.w || !item.dst_roi.h) {
+      LOG(ERROR) << "[EasyDK] CpuTransform(): The roi is empty, batch index: " << i;
+      return -1;
+    }
+    if (mean_std) {
+      memcpy(item.mean, transform_params->mean_std_params->mean, sizeof(item.mean));
+      memcpy(item.std, transform_params->mean_std_params->std, sizeof(item.std));
+    }
+  }
+
+  if (IsCached(src->mem_type)) CnedkBufSurfaceSyncForCpu(src, -1, -1);
+
+  std::vector<int> rets(batch_size, 0);
+  ParallelFor(batch_size, [&](uint32_t i) { rets[i] = ProcessItem(items[i]); });
+
+  if (IsCached(dst->mem_type)) CnedkBufSurfaceSyncForDevice(dst, -1, -1);
+
+  for (uint32_t i = 0; i < batch_size; ++i) {
+    if (rets[i] < 0) {
+      LOG(ERROR) << "[EasyDK] CpuTransform(): Transform failed, batch index: " << i;
+      return -1;
+    }
+  }
+  VLOG(5) << "[EasyDK] CpuTransform(): Done, batch size: " << batch_size << ", simd: " << cpu_kernel::SimdName();
+  return 0;
+}
+
+int TransformerCpu::TransformRoi(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformRoiParams *roi_params) {
+  if (!IsHostAccessible(src->mem_type) || !IsHostAccessible(dst->mem_type)) {
+    LOG(ERROR) << "[EasyDK] [TransformerCpu] TransformRoi(): The src and dst memory must be accessible by cpu. "
+               << "src mem_type: " << src->mem_type << ", dst_mem_type: " << dst->mem_type;
+    return -1;
+  }
+  return CpuTransformRoi(src, dst, roi_params);
+}
+
+int CpuTransformRoi(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformRoiParams *roi_params) {
+  CnedkBufSurfaceColorFormat src_fmt = src->surface_list[0].color_format;
+  ChannelOrder order;
+  if (!IsYuv420sp(src_fmt) && !GetChannelOrder(src_fmt, &order)) {
+    LOG(ERROR) << "[EasyDK] CpuTransformRoi(): Unsupported src color format: " << src_fmt;
+    return -1;
+  }
+  const CnedkTransformTensorDesc &desc = *roi_params->dst_desc;
+  CnedkBufSurfaceColorFormat dst_fmt = GetColorFormatFromTensor(desc.color_format);
+  if (!GetChannelOrder(dst_fmt, &order) || desc.shape.c != static_cast<uint32_t>(order.channels)) {
+    LOG(ERROR) << "[EasyDK] CpuTransformRoi(): Unsupported dst color format: " << desc.color_format
+               << ", channel: " << desc.shape.c;
+    return -1;
+  }
+  bool mean_std = roi_params->mean_std_params != nullptr;
+  if (!GetDataTypeSize(desc.data_type) || (!mean_std && desc.data_type != CNEDK_TRANSFORM_UINT8)) {
+    LOG(ERROR) << "[EasyDK] CpuTransformRoi(): Unsupported data type: " << static_cast<int>(desc.data_type);
+    return -1;
+  }
+  if (roi_params->layout != CNEDK_TRANSFORM_LAYOUT_NHWC && roi_params->layout != CNEDK_TRANSFORM_LAYOUT_NCHW) {
+    LOG(ERROR) << "[EasyDK] CpuTransformRoi(): Unsupported layout: " << static_cast<int>(roi_params->layout);
+    return -1;
+  }
+  const bool nchw = roi_params->layout == CNEDK_TRANSFORM_LAYOUT_NCHW;
+  const size_t elem_size = GetDataTypeSize(desc.data_type);
+  const size_t tensor_size = static_cast<size_t>(desc.shape.w) * desc.shape.h * desc.shape.c * elem_size;
+
+  uint32_t num_rois = roi_params->num_rois;
+  std::vector<CpuTransformItem> items(num_rois);
+  for (uint32_t i = 0; i < num_rois; ++i) {
+    CpuTransformItem &item = items[i];
+    const CnedkTransformRoi &roi = roi_params->rois[i];
+    const CnedkBufSurfaceParams &src_params = src->surface_list[roi.src_index];
+    const uint8_t *src_ptr = GetHostPtr(*src, roi.src_index);
+    uint8_t *dst_ptr = GetHostPtr(*dst, i);
+    if (!src_ptr || !dst_ptr) {
+      LOG(ERROR) << "[EasyDK] CpuTransformRoi(): The src or dst is not mapped, roi index: " << i;
+      return -1;
+    }
+    if (src_params.color_format != src_fmt) {
+      LOG(ERROR) << "[EasyDK] CpuTransformRoi(): The src color formats in the batch are different";
+      return -1;
+    }
+    if (dst->surface_list[i].data_size < tensor_size) {
+      LOG(ERROR) << "[EasyDK] CpuTransformRoi(): The dst tensor is larger than the buffer, roi index: " << i;
+      return -1;
+    }
+
+    item.src_fmt = src_fmt;
+    for (uint32_t p = 0; p < 2; ++p) {
+      item.src_planes[p] = src_ptr + src_params.plane_params.offset[p];
+      item.src_pitch[p] = GetPlanePitch(src_params, p);
+    }
+    item.src_roi = GetRoi(&roi.rect, src_params.width, src_params.height);
+    if (IsYuv420sp(src_fmt)) {
+      item.src_roi.x &= ~1u, item.src_roi.y &= ~1u, item.src_roi.w &= ~1u, item.src_roi.h &= ~1u;
+    }
+    if (!item.src_roi.w || !item.src_roi.h) {
+      LOG(ERROR) << "[EasyDK] CpuTransformRoi(): The roi is empty, roi index: " << i;
+      return -1;
+    }
+
+    item.dst_fmt = dst_fmt;
+    item.data_type = desc.data_type;
+    item.mean_std = mean_std;
+    item.nchw = nchw;
+    item.dst_w = desc.shape.w;
+    item.dst_h = desc.shape.h;
+    item.dst_planes[0] = item.dst_planes[1] = dst_ptr;
+    item.dst_pitch[0] = item.dst_pitch[1] = desc.shape.w * (nchw ? 1 : desc.shape.c) * elem_size;
+    item.dst_roi = Rect{0, 0, desc.shape.w, desc.shape.h};
+    if (roi_params->keep_aspect_ratio) {
+      CnedkTransformRect rect = GetLetterboxRect(item.src_roi.w, item.src_roi.h, desc.shape.w, desc.shape.h);
+      item.dst_roi = Rect{rect.left, rect.top, rect.width, rect.height};
+      item.pad = true;
+      item.pad_value = roi_params->pad_value;
+    }
+    if (mean_std) {
+      memcpy(item.mean, roi_params->mean_std_params->mean, sizeof(item.mean));
+      memcpy(item.std, roi_params->mean_std_params->std, sizeof(item.std));
+    }
+  }
+
+  if (IsCached(src->mem_type)) CnedkBufSurfaceSyncForCpu(src, -1, -1);
+
+  std::vector<int> rets(num_rois, 0);
+  ParallelFor(num_rois, [&](uint32_t i) { rets[i] = ProcessToRgbx(items[i]); });
+
+  if (IsCached(dst->mem_type)) CnedkBufSurfaceSyncForDevice(dst, -1, -1);
+
+  for (uint32_t i = 0; i < num_rois; ++i) {
+    if (rets[i] < 0) {
+      LOG(ERROR) << "[EasyDK] CpuTransformRoi(): Transform failed, roi index: " << i;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+}  // namespace cnedk
@@ -0,0 +1,45 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#ifndef CNEDK_TRANSFORM_CPU_HPP_
+#define CNEDK_TRANSFORM_CPU_HPP_
+
+#include "../cnedk_transform_impl.hpp"
+#include "cnedk_buf_surface.h"
+#include "cnedk_transform.h"
+
+namespace cnedk {
+
+// Reference implementation on host cores, valid for memory accessible by cpu, i.e. CNEDK_BUF_MEM_SYSTEM,
+// CNEDK_BUF_MEM_PINNED, CNEDK_BUF_MEM_UNIFIED* and CNEDK_BUF_MEM_VB*.
+class TransformerCpu : public ITransformer {
+ public:
+  TransformerCpu() = default;
+  ~TransformerCpu() = default;
+  int Transform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params) override;
+  int TransformRoi(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformRoiParams *roi_params) override;
+};
+
+int CpuTransform(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformParams *transform_params);
+int CpuTransformRoi(CnedkBufSurface *src, CnedkBufSurface *dst, CnedkTransformRoiParams *roi_params);
+
+}  // namespace cnedk
+
+#endif  // CNEDK_TRANSFORM_CPU_HPP_
@@ -0,0 +1,278 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include "cnedk_transform_cpu_kernels.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace cnedk {
+
+namespace cpu_kernel {
+
+const char *SimdName() {
+#if defined(__AVX2__)
+  return "avx2";
+#elif defined(__SSE2__)
+  return "sse2";
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  return "neon";
+#else
+  return "c";
+#endif
+}
+
+void BlendRows(const float *r0, const float *r1, float beta, float *dst, int n) {
+  int i = 0;
+#if defined(__AVX2__)
+  __m256 b = _mm256_set1_ps(beta);
+  for (; i + 8 <= n; i += 8) {
+    __m256 v0 = _mm256_loadu_ps(r0 + i);
+    __m256 v1 = _mm256_loadu_ps(r1 + i);
+    _mm256_storeu_ps(dst + i, _mm256_add_ps(v0, _mm256_mul_ps(_mm256_sub_ps(v1, v0), b)));
+  }
+#elif defined(__SSE2__)
+  __m128 b = _mm_set1_ps(beta);
+  for (; i + 4 <= n; i += 4) {
+    __m128 v0 = _mm_loadu_ps(r0 + i);
+    __m128 v1 = _mm_loadu_ps(r1 + i);
+    _mm_storeu_ps(dst + i, _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(v1, v0), b)));
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  float32x4_t b = vdupq_n_f32(beta);
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t v0 = vld1q_f32(r0 + i);
+    float32x4_t v1 = vld1q_f32(r1 + i);
+    vst1q_f32(dst + i, vmlaq_f32(v0, vsubq_f32(v1, v0), b));
+  }
+#endif
+  for (; i < n; ++i) dst[i] = r0[i] + (r1[i] - r0[i]) * beta;
+}
+
+void ScaleBias(const float *src, const float *scale, const float *bias, float *dst, int n) {
+  int i = 0;
+#if defined(__AVX2__)
+  for (; i + 8 <= n; i += 8) {
+    __m256 v = _mm256_mul_ps(_mm256_loadu_ps(src + i), _mm256_loadu_ps(scale + i));
+    _mm256_storeu_ps(dst + i, _mm256_add_ps(v, _mm256_loadu_ps(bias + i)));
+  }
+#elif defined(__SSE2__)
+  for (; i + 4 <= n; i += 4) {
+    __m128 v = _mm_mul_ps(_mm_loadu_ps(src + i), _mm_loadu_ps(scale + i));
+    _mm_storeu_ps(dst + i, _mm_add_ps(v, _mm_loadu_ps(bias + i)));
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(dst + i, vmlaq_f32(vld1q_f32(bias + i), vld1q_f32(src + i), vld1q_f32(scale + i)));
+  }
+#endif
+  for (; i < n; ++i) dst[i] = src[i] * scale[i] + bias[i];
+}
+
+void LerpGather(const uint8_t *s, const int *ofs0, const int *ofs1, const float *alpha, float *dst, int n,
+                int n_wide) {
+  int i = 0;
+#if defined(__AVX2__)
+  const __m256i mask = _mm256_set1_epi32(0xff);
+  const int *base = reinterpret_cast<const int *>(s);
+  for (; i + 8 <= n_wide; i += 8) {
+    __m256i i0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ofs0 + i));
+    __m256i i1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ofs1 + i));
+    __m256 v0 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_i32gather_epi32(base, i0, 1), mask));
+    __m256 v1 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_i32gather_epi32(base, i1, 1), mask));
+    _mm256_storeu_ps(dst + i, _mm256_add_ps(v0, _mm256_mul_ps(_mm256_sub_ps(v1, v0), _mm256_loadu_ps(alpha + i))));
+  }
+#elif defined(__SSE2__)
+  (void)n_wide;
+  for (; i + 4 <= n; i += 4) {
+    __m128 v0 = _mm_setr_ps(s[ofs0[i]], s[ofs0[i + 1]], s[ofs0[i + 2]], s[ofs0[i + 3]]);
+    __m128 v1 = _mm_setr_ps(s[ofs1[i]], s[ofs1[i + 1]], s[ofs1[i + 2]], s[ofs1[i + 3]]);
+    _mm_storeu_ps(dst + i, _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(v1, v0), _mm_loadu_ps(alpha + i))));
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  (void)n_wide;
+  float p0[4], p1[4];
+  for (; i + 4 <= n; i += 4) {
+    for (int k = 0; k < 4; ++k) p0[k] = s[ofs0[i + k]], p1[k] = s[ofs1[i + k]];
+    float32x4_t v0 = vld1q_f32(p0);
+    float32x4_t v1 = vld1q_f32(p1);
+    vst1q_f32(dst + i, vmlaq_f32(v0, vsubq_f32(v1, v0), vld1q_f32(alpha + i)));
+  }
+#else
+  (void)n_wide;
+#endif
+  for (; i < n; ++i) dst[i] = s[ofs0[i]] + (s[ofs1[i]] - s[ofs0[i]]) * alpha[i];
+}
+
+static inline float Clamp255(float v) { return v < 0.f ? 0.f : (v > 255.f ? 255.f : v); }
+
+void YuvToRgbRow(const float *y, const float *uv, int u_idx, float *r, float *g, float *b, int n) {
+  int i = 0;
+#if defined(__AVX2__)
+  const __m256 c16 = _mm256_set1_ps(16.f), c128 = _mm256_set1_ps(128.f);
+  const __m256 zero = _mm256_setzero_ps(), c255 = _mm256_set1_ps(255.f);
+  for (; i + 8 <= n; i += 8) {
+    __m256 a = _mm256_loadu_ps(uv + 2 * i);
+    __m256 c = _mm256_loadu_ps(uv + 2 * i + 8);
+    // shuffles work on 128-bit lanes, restore the order afterwards
+    __m256 even = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, c, 0x88)), 0xD8));
+    __m256 odd = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, c, 0xDD)), 0xD8));
+    __m256 vu = _mm256_sub_ps(u_idx ? odd : even, c128);
+    __m256 vv = _mm256_sub_ps(u_idx ? even : odd, c128);
+    __m256 vy = _mm256_mul_ps(_mm256_set1_ps(1.164f), _mm256_sub_ps(_mm256_loadu_ps(y + i), c16));
+    __m256 vr = _mm256_add_ps(vy, _mm256_mul_ps(_mm256_set1_ps(1.596f), vv));
+    __m256 vg = _mm256_sub_ps(vy, _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(0.813f), vv),
+                                                _mm256_mul_ps(_mm256_set1_ps(0.391f), vu)));
+    __m256 vb = _mm256_add_ps(vy, _mm256_mul_ps(_mm256_set1_ps(2.018f), vu));
+    _mm256_storeu_ps(r + i, _mm256_min_ps(_mm256_max_ps(vr, zero), c255));
+    _mm256_storeu_ps(g + i, _mm256_min_ps(_mm256_max_ps(vg, zero), c255));
+    _mm256_storeu_ps(b + i, _mm256_min_ps(_mm256_max_ps(vb, zero), c255));
+  }
+#elif defined(__SSE2__)
+  const __m128 c16 = _mm_set1_ps(16.f), c128 = _mm_set1_ps(128.f);
+  const __m128 zero = _mm_setzero_ps(), c255 = _mm_set1_ps(255.f);
+  for (; i + 4 <= n; i += 4) {
+    __m128 a = _mm_loadu_ps(uv + 2 * i);
+    __m128 c = _mm_loadu_ps(uv + 2 * i + 4);
+    __m128 even = _mm_shuffle_ps(a, c, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 odd = _mm_shuffle_ps(a, c, _MM_SHUFFLE(3, 1, 3, 1));
+    __m128 vu = _mm_sub_ps(u_idx ? odd : even, c128);
+    __m128 vv = _mm_sub_ps(u_idx ? even : odd, c128);
+    __m128 vy = _mm_mul_ps(_mm_set1_ps(1.164f), _mm_sub_ps(_mm_loadu_ps(y + i), c16));
+    __m128 vr = _mm_add_ps(vy, _mm_mul_ps(_mm_set1_ps(1.596f), vv));
+    __m128 vg = _mm_sub_ps(vy, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.813f), vv), _mm_mul_ps(_mm_set1_ps(0.391f), vu)));
+    __m128 vb = _mm_add_ps(vy, _mm_mul_ps(_mm_set1_ps(2.018f), vu));
+    _mm_storeu_ps(r + i, _mm_min_ps(_mm_max_ps(vr, zero), c255));
+    _mm_storeu_ps(g + i, _mm_min_ps(_mm_max_ps(vg, zero), c255));
+    _mm_storeu_ps(b + i, _mm_min_ps(_mm_max_ps(vb, zero), c255));
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  const float32x4_t c16 = vdupq_n_f32(16.f), c128 = vdupq_n_f32(128.f);
+  const float32x4_t zero = vdupq_n_f32(0.f), c255 = vdupq_n_f32(255.f);
+  for (; i + 4 <= n; i += 4) {
+    float32x4x2_t vuv = vld2q_f32(uv + 2 * i);
+    float32x4_t vu = vsubq_f32(vuv.val[u_idx], c128);
+    float32x4_t vv = vsubq_f32(vuv.val[1 - u_idx], c128);
+    float32x4_t vy = vmulq_n_f32(vsubq_f32(vld1q_f32(y + i), c16), 1.164f);
+    float32x4_t vr = vmlaq_n_f32(vy, vv, 1.596f);
+    float32x4_t vg = vmlsq_n_f32(vmlsq_n_f32(vy, vv, 0.813f), vu, 0.391f);
+    float32x4_t vb = vmlaq_n_f32(vy, vu, 2.018f);
+    vst1q_f32(r + i, vminq_f32(vmaxq_f32(vr, zero), c255));
+    vst1q_f32(g + i, vminq_f32(vmaxq_f32(vg, zero), c255));
+    vst1q_f32(b + i, vminq_f32(vmaxq_f32(vb, zero), c255));
+  }
+#endif
+  for (; i < n; ++i) {
+    float vy = 1.164f * (y[i] - 16.f);
+    float vu = uv[2 * i + u_idx] - 128.f;
+    float vv = uv[2 * i + 1 - u_idx] - 128.f;
+    r[i] = Clamp255(vy + 1.596f * vv);
+    g[i] = Clamp255(vy - 0.813f * vv - 0.391f * vu);
+    b[i] = Clamp255(vy + 2.018f * vu);
+  }
+}
+
+static inline uint8_t SaturateU8(float v) {
+  int iv = static_cast<int>(std::lrintf(v));
+  return static_cast<uint8_t>(iv < 0 ? 0 : (iv > 255 ? 255 : iv));
+}
+
+void FloatToU8(const float *src, uint8_t *dst, int n) {
+  int i = 0;
+#if defined(__AVX2__)
+  for (; i + 16 <= n; i += 16) {
+    __m256i a = _mm256_cvtps_epi32(_mm256_loadu_ps(src + i));
+    __m256i b = _mm256_cvtps_epi32(_mm256_loadu_ps(src + i + 8));
+    // packs work on 128-bit lanes, restore the order afterwards
+    __m256i s16 = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+    __m128i u8 = _mm_packus_epi16(_mm256_castsi256_si128(s16), _mm256_extracti128_si256(s16, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), u8);
+  }
+#elif defined(__SSE2__)
+  for (; i + 8 <= n; i += 8) {
+    __m128i a = _mm_cvtps_epi32(_mm_loadu_ps(src + i));
+    __m128i b = _mm_cvtps_epi32(_mm_loadu_ps(src + i + 4));
+    __m128i u8 = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_setzero_si128());
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), u8);
+  }
+#elif defined(__aarch64__) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+  for (; i + 8 <= n; i += 8) {
+    int32x4_t a = vcvtnq_s32_f32(vld1q_f32(src + i));
+    int32x4_t b = vcvtnq_s32_f32(vld1q_f32(src + i + 4));
+    int16x8_t s16 = vcombine_s16(vqmovn_s32(a), vqmovn_s32(b));
+    vst1_u8(dst + i, vqmovun_s16(s16));
+  }
+#endif
+  for (; i < n; ++i) dst[i] = SaturateU8(src[i]);
+}
+
+static inline uint16_t HalfFromFloat(float f) {
+  uint32_t x;
+  memcpy(&x, &f, sizeof(x));
+  uint32_t sign = (x >> 16) & 0x8000;
+  int32_t exp = static_cast<int32_t>((x >> 23) & 0xff) - 127 + 15;
+  uint32_t mant = x & 0x7fffff;
+  if (((x >> 23) & 0xff) == 0xff) {  // inf or nan
+    return static_cast<uint16_t>(sign | 0x7c00 | (mant ? 0x200 : 0));
+  }
+  if (exp >= 31) return static_cast<uint16_t>(sign | 0x7c00);  // overflow
+  if (exp <= 0) {  // subnormal or zero
+    if (exp < -10) return static_cast<uint16_t>(sign);
+    mant |= 0x800000;
+    uint32_t shift = static_cast<uint32_t>(14 - exp);
+    uint32_t half = mant >> shift;
+    uint32_t rem = mant & ((1u << shift) - 1);
+    uint32_t mid = 1u << (shift - 1);
+    if (rem > mid || (rem == mid && (half & 1))) ++half;
+    return static_cast<uint16_t>(sign | half);
+  }
+  uint32_t half = sign | (static_cast<uint32_t>(exp) << 10) | (mant >> 13);
+  uint32_t rem = mant & 0x1fff;
+  // round to nearest even, a carry into the exponent is still correct
+  if (rem > 0x1000 || (rem == 0x1000 && (half & 1))) ++half;
+  return static_cast<uint16_t>(half);
+}
+
+void FloatToHalf(const float *src, uint16_t *dst, int n) {
+  int i = 0;
+#if defined(__AVX2__) && defined(__F16C__)
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), h);
+  }
+#elif defined(__aarch64__) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+  for (; i + 4 <= n; i += 4) {
+    vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+  }
+#endif
+  for (; i < n; ++i) dst[i] = HalfFromFloat(src[i]);
+}
+
+}  // namespace cpu_kernel
+
+}  // namespace cnedk
@@ -0,0 +1,58 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#ifndef CNEDK_TRANSFORM_CPU_KERNELS_HPP_
+#define CNEDK_TRANSFORM_CPU_KERNELS_HPP_
+
+#include <cstdint>
+
+namespace cnedk {
+
+namespace cpu_kernel {
+
+// Name of the instruction set the kernels are built with, "avx2", "sse2", "neon" or "c".
+const char *SimdName();
+
+// dst[i] = r0[i] + (r1[i] - r0[i]) * beta
+void BlendRows(const float *r0, const float *r1, float beta, float *dst, int n);
+
+// dst[i] = src[i] * scale[i] + bias[i], dst can be the same as src
+void ScaleBias(const float *src, const float *scale, const float *bias, float *dst, int n);
+
+// dst[i] = s[ofs0[i]] + (s[ofs1[i]] - s[ofs0[i]]) * alpha[i]. 4 bytes from s + ofs1[i] must be readable for
+// i < n_wide, which lets the kernel load 32 bits per offset.
+void LerpGather(const uint8_t *s, const int *ofs0, const int *ofs1, const float *alpha, float *dst, int n,
+                int n_wide);
+
+// BT.601 limited range, the same as CNCV_COLOR_SPACE_BT_601. uv is interleaved, u at uv[2 * i + u_idx] and v at
+// uv[2 * i + 1 - u_idx]. Outputs planar r, g, b clamped to [0, 255].
+void YuvToRgbRow(const float *y, const float *uv, int u_idx, float *r, float *g, float *b, int n);
+
+// Rounds and saturates to uint8
+void FloatToU8(const float *src, uint8_t *dst, int n);
+
+// Converts to IEEE 754 half precision
+void FloatToHalf(const float *src, uint16_t *dst, int n);
+
+}  // namespace cpu_kernel
+
+}  // namespace cnedk
+
+#endif  // CNEDK_TRANSFORM_CPU_KERNELS_HPP_
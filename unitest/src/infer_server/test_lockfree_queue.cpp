@@ -0,0 +1,178 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util/lockfree_queue.h"
+#include "util/threadsafe_queue.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// adapts ThreadSafeQueue to the bounded queues, so one benchmark runs on all of them
+template <typename T>
+class UnboundedQueue : public infer_server::TSQueue<T> {
+ public:
+  explicit UnboundedQueue(size_t) {}
+};
+
+// returns pushed items per second
+template <typename Queue>
+double RunThroughput(int producer_num, int item_num, size_t capacity) {
+  Queue q(capacity);
+  std::vector<std::thread> producers;
+  auto start = Clock::now();
+  for (int p = 0; p < producer_num; ++p) {
+    producers.emplace_back([&q, p, producer_num, item_num] {
+      for (int i = p; i < item_num; i += producer_num) q.Push(i);
+    });
+  }
+  int64_t sum = 0;
+  int value;
+  for (int i = 0; i < item_num; ++i) {
+    if (!q.WaitAndTryPop(value, std::chrono::seconds(5))) break;
+    sum += value;
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  for (auto& it : producers) it.join();
+  EXPECT_EQ(static_cast<int64_t>(item_num) * (item_num - 1) / 2, sum);
+  return item_num / seconds;
+}
+
+}  // namespace
+
+TEST(InferServerUtil, SpscQueue) {
+  infer_server::SpscQueue<std::unique_ptr<int>> q(3);
+  EXPECT_EQ(4u, q.Capacity());
+  EXPECT_TRUE(q.Empty());
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(q.TryPush(std::unique_ptr<int>(new int(i))));
+  }
+  std::unique_ptr<int> extra(new int(4));
+  EXPECT_FALSE(q.TryPush(std::move(extra)));
+  // not moved from when it fails
+  ASSERT_TRUE(extra);
+  EXPECT_EQ(4u, q.Size());
+
+  std::unique_ptr<int> value;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(q.TryPop(value));
+    EXPECT_EQ(i, *value);
+  }
+  EXPECT_FALSE(q.TryPop(value));
+  EXPECT_TRUE(q.Empty());
+
+  auto start = Clock::now();
+  EXPECT_FALSE(q.WaitAndTryPop(value, std::chrono::milliseconds(20)));
+  EXPECT_GE(Clock::now() - start, std::chrono::milliseconds(20));
+
+  // wraps around
+  for (int i = 0; i < 10; ++i) {
+    q.Push(std::unique_ptr<int>(new int(i)));
+    ASSERT_TRUE(q.WaitAndTryPop(value, std::chrono::microseconds(0)));
+    EXPECT_EQ(i, *value);
+  }
+}
+
+TEST(InferServerUtil, SpscQueueBlocking) {
+  infer_server::SpscQueue<int> q(2);
+  std::atomic<bool> pushed{false};
+  q.Push(0);
+  q.Push(1);
+  std::thread producer([&] {
+    q.Push(2);  // full, wait for the pop
+    pushed = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(pushed);
+  int value;
+  ASSERT_TRUE(q.TryPop(value));
+  producer.join();
+  EXPECT_TRUE(pushed);
+
+  // the consumer sleeps until the producer pushes
+  std::thread late_producer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    q.Push(3);
+  });
+  for (int i = 1; i <= 3; ++i) {
+    ASSERT_TRUE(q.WaitAndTryPop(value, std::chrono::seconds(1)));
+    EXPECT_EQ(i, value);
+  }
+  late_producer.join();
+}
+
+TEST(InferServerUtil, MpscQueue) {
+  constexpr int kProducerNum = 4;
+  constexpr int kItemNum = 10000;
+  infer_server::MpscQueue<std::pair<int, int>> q(16);
+  EXPECT_EQ(16u, q.Capacity());
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducerNum; ++p) {
+    producers.emplace_back([&q, p] {
+      for (int i = 0; i < kItemNum; ++i) {
+        if (i % 2) {
+          q.Push(std::make_pair(p, i));
+        } else {
+          while (!q.TryPush(std::make_pair(p, i))) std::this_thread::yield();
+        }
+      }
+    });
+  }
+  std::vector<int> next(kProducerNum, 0);
+  std::pair<int, int> value;
+  for (int i = 0; i < kProducerNum * kItemNum; ++i) {
+    ASSERT_TRUE(q.WaitAndTryPop(value, std::chrono::seconds(5)));
+    // in order for each producer
+    EXPECT_EQ(next[value.first]++, value.second);
+  }
+  for (auto& it : producers) it.join();
+  EXPECT_FALSE(q.TryPop(value));
+  EXPECT_TRUE(q.Empty());
+}
+
+// a benchmark rather than a check, run it with --gtest_also_run_disabled_tests
+TEST(InferServerUtil, DISABLED_QueueThroughput) {
+  constexpr int kItemNum = 200000;
+  // large enough that the producers seldom wait for room, which the unbounded queue never does
+  constexpr size_t kCapacity = 65536;
+  double tsq = RunThroughput<UnboundedQueue<int>>(1, kItemNum, kCapacity);
+  double spsc = RunThroughput<infer_server::SpscQueue<int>>(1, kItemNum, kCapacity);
+  LOG(INFO) << "[EasyDK Tests] [InferServer] 1 producer, TSQueue: " << tsq << " items/s, SpscQueue: " << spsc
+            << " items/s";
+  tsq = RunThroughput<UnboundedQueue<int>>(4, kItemNum, kCapacity);
+  double mpsc = RunThroughput<infer_server::MpscQueue<int>>(4, kItemNum, kCapacity);
+  LOG(INFO) << "[EasyDK Tests] [InferServer] 4 producers, TSQueue: " << tsq << " items/s, MpscQueue: " << mpsc
+            << " items/s";
+  // the producers wait for room all the time
+  spsc = RunThroughput<infer_server::SpscQueue<int>>(1, kItemNum, 64);
+  mpsc = RunThroughput<infer_server::MpscQueue<int>>(4, kItemNum, 64);
+  LOG(INFO) << "[EasyDK Tests] [InferServer] capacity 64, SpscQueue: " << spsc << " items/s, MpscQueue: " << mpsc
+            << " items/s";
+}
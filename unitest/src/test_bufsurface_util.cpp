@@ -142,6 +142,50 @@ TEST(BufSurfaceWrapper, Function) {
   pool = nullptr;
 }
 
+TEST(BufSurfaceWrapper, PinnedStagingRing) {
+  PinnedStagingRing &ring = PinnedStagingRing::Instance();
+  size_t capacity = ring.GetCapacity();
+  ASSERT_EQ(ring.SetCapacity(1024), 0);
+
+  void *a = ring.Acquire(512);
+  void *b = ring.Acquire(512);
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  EXPECT_EQ(ring.Acquire(64), nullptr);
+  EXPECT_EQ(ring.SetCapacity(2048), -1);
+
+  ring.Release(a);
+  void *c = ring.Acquire(256);
+  EXPECT_EQ(c, a);
+  ring.Release(b);
+  ring.Release(c);
+  EXPECT_EQ(ring.Acquire(2048), nullptr);
+
+  if (!cnedk::IsEdgePlatform(g_device_id)) {
+    void* pool = nullptr;
+    CnedkBufSurface* surf;
+    ASSERT_EQ(CreateSurfacePool(&pool, 1920, 1080, CNEDK_BUF_COLOR_FORMAT_NV12, true), 0);
+    ASSERT_EQ(CnedkBufSurfaceCreateFromPool(&surf, pool), 0);
+    {
+      // the ring is too small, falls back to pageable memory
+      BufSurfaceWrapper surf_wrapper(surf, false);
+      EXPECT_NE(surf_wrapper.GetHostData(0, 0), nullptr);
+    }
+    ASSERT_EQ(ring.SetCapacity(16 << 20), 0);
+    {
+      BufSurfaceWrapper surf_wrapper(surf, false);
+      uint8_t *data = static_cast<uint8_t*>(surf_wrapper.GetHostData(0, 0));
+      EXPECT_NE(data, nullptr);
+      EXPECT_EQ(static_cast<uint8_t*>(surf_wrapper.GetHostData(0, 0)), data);
+      EXPECT_EQ(ring.SetCapacity(1024), -1);
+    }
+    EXPECT_EQ(surf->surface_list[0].mapped_data_ptr, nullptr);
+    EXPECT_EQ(CnedkBufSurfaceDestroy(surf), 0);
+    EXPECT_EQ(CnedkBufPoolDestroy(pool), 0);
+  }
+  EXPECT_EQ(ring.SetCapacity(capacity), 0);
+}
+
 TEST(PlatformJudge, PlatformJudge) {
   EXPECT_NE(IsEdgePlatform(g_device_id), IsCloudPlatform(g_device_id));
 
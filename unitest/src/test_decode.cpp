@@ -19,6 +19,7 @@
  *************************************************************************/
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <memory>
@@ -53,6 +54,10 @@ static const size_t g_device_id = 0;
 
 static uint8_t* g_data_buffer;
 static void* g_surf_pool = nullptr;
+static bool g_zero_copy = false;
+static CnedkVdecMode g_mode = CNEDK_VDEC_MODE_ALL;
+static uint32_t g_output_interval = 0;
+static std::atomic<int> g_frame_count{0};
 
 bool SendData(void* vdec, CnedkVdecType type, std::string file, bool test_crush = false) {
   if (file == "") {
@@ -173,8 +178,8 @@ int GetBufSurface(CnedkBufSurface** surf, int width, int height, CnedkBufSurface
     memset(&create_params, 0, sizeof(create_params));
     create_params.batch_size = 1;
     create_params.device_id = g_device_id;
-    create_params.width = 1920;
-    create_params.height = 1080;
+    create_params.width = width;
+    create_params.height = height;
     create_params.color_format = fmt;
 
     if (is_edge_platform) {
@@ -192,6 +197,7 @@ int GetBufSurface(CnedkBufSurface** surf, int width, int height, CnedkBufSurface
 }
 
 int OnFrame(CnedkBufSurface* surf, void* user_data) {
+  ++g_frame_count;
   surf->surface_list[0].width -= surf->surface_list[0].width & 1;
   surf->surface_list[0].height -= surf->surface_list[0].height & 1;
   surf->surface_list[0].plane_params.width[0] -= surf->surface_list[0].plane_params.width[0] & 1;
@@ -264,6 +270,9 @@ bool Create(void** vdec, CnedkVdecType type, uint32_t frame_w, uint32_t frame_h,
   create_params.OnError = OnError;
   create_params.type = type;
   create_params.color_format = fmt;
+  create_params.zero_copy = g_zero_copy;
+  create_params.mode = g_mode;
+  create_params.output_interval = g_output_interval;
 
   int ret = CnedkVdecCreate(vdec, &create_params);
   if (ret) {
@@ -420,6 +429,272 @@ TEST(Decode, H265) {
   }
 }
 
+TEST(Decode, ZeroCopy) {
+  if (!cnedk::IsCloudPlatform(g_device_id)) return;
+  // the frames are released by CnedkBufSurfaceDestroy() in OnFrame
+  g_zero_copy = true;
+  EXPECT_EQ(TestDecode(h264_file, CNEDK_VDEC_TYPE_H264, 1920, 1080, CNEDK_BUF_COLOR_FORMAT_NV12), 0);
+  EXPECT_EQ(TestDecode(jpeg_file, CNEDK_VDEC_TYPE_JPEG, 1920, 1080), 0);
+  g_zero_copy = false;
+}
+
+TEST(Decode, FrameType) {
+  CnedkVdecFrameType type;
+  // SPS + PPS + IDR
+  uint8_t idr[] = {0, 0, 0, 1, 0x67, 1, 2, 3, 0, 0, 0, 1, 0x68, 1, 0, 0, 1, 0x65, 0x88, 0x84};
+  EXPECT_EQ(CnedkVdecGetFrameType(CNEDK_VDEC_TYPE_H264, idr, sizeof(idr), &type), 0);
+  EXPECT_EQ(type, CNEDK_VDEC_FRAME_KEY);
+  // referenced P slice
+  uint8_t p_slice[] = {0, 0, 0, 1, 0x41, 0x98, 0x00};
+  EXPECT_EQ(CnedkVdecGetFrameType(CNEDK_VDEC_TYPE_H264, p_slice, sizeof(p_slice), &type), 0);
+  EXPECT_EQ(type, CNEDK_VDEC_FRAME_REF);
+  // non-referenced B slice
+  uint8_t b_slice[] = {0, 0, 0, 1, 0x01, 0x9C, 0x00};
+  EXPECT_EQ(CnedkVdecGetFrameType(CNEDK_VDEC_TYPE_H264, b_slice, sizeof(b_slice), &type), 0);
+  EXPECT_EQ(type, CNEDK_VDEC_FRAME_NON_REF);
+  // H.265 IDR_W_RADL, TRAIL_N and TRAIL_R
+  uint8_t hevc_idr[] = {0, 0, 0, 1, 0x26, 0x01, 0xaf};
+  uint8_t hevc_trail_n[] = {0, 0, 0, 1, 0x00, 0x01, 0xaf};
+  uint8_t hevc_trail_r[] = {0, 0, 0, 1, 0x02, 0x01, 0xaf};
+  EXPECT_EQ(CnedkVdecGetFrameType(CNEDK_VDEC_TYPE_H265, hevc_idr, sizeof(hevc_idr), &type), 0);
+  EXPECT_EQ(type, CNEDK_VDEC_FRAME_KEY);
+  EXPECT_EQ(CnedkVdecGetFrameType(CNEDK_VDEC_TYPE_H265, hevc_trail_n, sizeof(hevc_trail_n), &type), 0);
+  EXPECT_EQ(type, CNEDK_VDEC_FRAME_NON_REF);
+  EXPECT_EQ(CnedkVdecGetFrameType(CNEDK_VDEC_TYPE_H265, hevc_trail_r, sizeof(hevc_trail_r), &type), 0);
+  EXPECT_EQ(type, CNEDK_VDEC_FRAME_REF);
+
+  EXPECT_NE(CnedkVdecGetFrameType(CNEDK_VDEC_TYPE_H264, nullptr, 0, &type), 0);
+  EXPECT_NE(CnedkVdecGetFrameType(CNEDK_VDEC_TYPE_H264, idr, sizeof(idr), nullptr), 0);
+}
+
+TEST(Decode, Mode) {
+  g_frame_count = 0;
+  EXPECT_EQ(TestDecode(h264_file, CNEDK_VDEC_TYPE_H264, 1920, 1080), 0);
+  int all_frames = g_frame_count;
+  ASSERT_GT(all_frames, 1);
+
+  g_mode = CNEDK_VDEC_MODE_KEY_ONLY;
+  g_frame_count = 0;
+  EXPECT_EQ(TestDecode(h264_file, CNEDK_VDEC_TYPE_H264, 1920, 1080), 0);
+  EXPECT_GT(g_frame_count, 0);
+  EXPECT_LT(g_frame_count, all_frames);
+
+  g_mode = CNEDK_VDEC_MODE_REF_ONLY;
+  g_output_interval = 2;
+  g_frame_count = 0;
+  EXPECT_EQ(TestDecode(h264_file, CNEDK_VDEC_TYPE_H264, 1920, 1080), 0);
+  EXPECT_GT(g_frame_count, 0);
+  EXPECT_LE(g_frame_count, (all_frames + 1) / 2);
+
+  g_mode = CNEDK_VDEC_MODE_ALL;
+  g_output_interval = 0;
+}
+
+TEST(Decode, OutputSpecs) {
+  if (!cnedk::IsCloudPlatform(g_device_id)) return;
+  static std::atomic<int> frames{0};
+  frames = 0;
+  CnedkVdecOutputSpec specs[2];
+  memset(specs, 0, sizeof(specs));
+  specs[0].width = 416;
+  specs[0].height = 416;
+  specs[0].color_format = CNEDK_BUF_COLOR_FORMAT_RGB;
+  specs[1].width = 640;
+  specs[1].height = 360;
+  specs[1].color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  specs[1].roi = {100, 100, 640, 360};
+
+  cnrtSetDevice(g_device_id);
+  CnedkVdecCreateParams create_params;
+  memset(&create_params, 0, sizeof(create_params));
+  create_params.device_id = g_device_id;
+  create_params.type = CNEDK_VDEC_TYPE_H264;
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  create_params.max_width = 1920;
+  create_params.max_height = 1080;
+  create_params.surf_timeout_ms = 5000;
+  create_params.GetBufSurf = GetBufSurface;
+  create_params.OnEos = OnEos;
+  create_params.OnError = OnError;
+  create_params.output_specs = specs;
+  create_params.num_output_specs = 2;
+  create_params.OnFrameOutputs = [](CnedkBufSurface** surfs, uint32_t num_surfs, void*) -> int {
+    EXPECT_EQ(num_surfs, 3u);
+    EXPECT_EQ(surfs[1]->surface_list[0].width, 416u);
+    EXPECT_EQ(surfs[2]->surface_list[0].color_format, CNEDK_BUF_COLOR_FORMAT_NV12);
+    for (uint32_t i = 0; i < num_surfs; ++i) CnedkBufSurfaceDestroy(surfs[i]);
+    ++frames;
+    return 0;
+  };
+
+  std::unique_ptr<uint8_t[]> buffer = std::unique_ptr<uint8_t[]>{new uint8_t[MAX_INPUT_DATA_SIZE]};
+  g_data_buffer = buffer.get();
+  decode_done = false;
+  void* vdec = nullptr;
+  ASSERT_EQ(CnedkVdecCreate(&vdec, &create_params), 0);
+  EXPECT_TRUE(SendData(vdec, CNEDK_VDEC_TYPE_H264, h264_file));
+  EXPECT_TRUE(SendData(vdec, CNEDK_VDEC_TYPE_H264, ""));
+  {
+    std::unique_lock<std::mutex> lk(mut);
+    cond.wait(lk, []() -> bool { return decode_done; });
+  }
+  EXPECT_EQ(CnedkVdecDestroy(vdec), 0);
+  EXPECT_GT(frames, 0);
+
+  specs[0].width = 0;
+  EXPECT_NE(CnedkVdecCreate(&vdec, &create_params), 0);
+}
+
+static std::atomic<int> g_service_frames{0};
+static std::atomic<int> g_service_eos{0};
+
+TEST(Decode, Service) {
+  if (!cnedk::IsCloudPlatform(g_device_id)) return;
+  constexpr int kStreamNum = 4;
+  g_service_frames = 0;
+  g_service_eos = 0;
+
+  CnedkVdecServiceCreateParams service_params;
+  memset(&service_params, 0, sizeof(service_params));
+  service_params.io_thread_num = 2;
+  service_params.max_queued_packets = 8;
+  void* service = nullptr;
+  ASSERT_EQ(CnedkVdecServiceCreate(&service, &service_params), 0);
+
+  cnrtSetDevice(g_device_id);
+  CnedkVdecCreateParams create_params;
+  memset(&create_params, 0, sizeof(create_params));
+  create_params.device_id = g_device_id;
+  create_params.type = CNEDK_VDEC_TYPE_H264;
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  create_params.max_width = 1920;
+  create_params.max_height = 1080;
+  create_params.surf_timeout_ms = 5000;
+  create_params.zero_copy = true;
+  create_params.OnFrame = [](CnedkBufSurface* surf, void*) -> int {
+    ++g_service_frames;
+    return CnedkBufSurfaceDestroy(surf);
+  };
+  create_params.OnEos = [](void*) -> int {
+    ++g_service_eos;
+    return 0;
+  };
+  create_params.OnError = OnError;
+  for (int i = 0; i < kStreamNum; ++i) {
+    ASSERT_EQ(CnedkVdecServiceAddStream(service, i, &create_params), 0);
+  }
+  EXPECT_NE(CnedkVdecServiceAddStream(service, 0, &create_params), 0);
+
+  // one thread feeds all streams
+  std::string test_path = GetExePath() + h264_file;
+  std::vector<std::unique_ptr<FFmpegDemuxer>> demuxers;
+  for (int i = 0; i < kStreamNum; ++i) demuxers.emplace_back(new FFmpegDemuxer(test_path.c_str()));
+  int packets = 0;
+  for (bool done = false; !done;) {
+    done = true;
+    for (int i = 0; i < kStreamNum; ++i) {
+      uint8_t* data = nullptr;
+      int data_len = 0;
+      if (!demuxers[i]->ReadFrame(&data, &data_len)) continue;
+      done = false;
+      CnedkVdecStream stream;
+      memset(&stream, 0, sizeof(stream));
+      stream.bits = data;
+      stream.len = data_len;
+      stream.pts = packets++;
+      int ret;
+      while ((ret = CnedkVdecServiceSubmit(service, i, &stream)) == -2) {
+        CnedkVdecServiceStreamStatus status;
+        EXPECT_EQ(CnedkVdecServiceGetStreamStatus(service, i, &status), 0);
+        EXPECT_TRUE(status.backpressure);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      EXPECT_EQ(ret, 0);
+    }
+  }
+  CnedkVdecStream eos;
+  memset(&eos, 0, sizeof(eos));
+  EXPECT_EQ(CnedkVdecServiceSubmit(service, 0, &eos), 0);
+  EXPECT_NE(CnedkVdecServiceSubmit(service, 0, &eos), 0);
+  EXPECT_NE(CnedkVdecServiceSubmit(service, kStreamNum, &eos), 0);
+
+  EXPECT_EQ(CnedkVdecServiceRemoveStream(service, 0), 0);
+  EXPECT_NE(CnedkVdecServiceRemoveStream(service, 0), 0);
+  // the other streams are removed by destroy
+  EXPECT_EQ(CnedkVdecServiceDestroy(service), 0);
+  EXPECT_EQ(g_service_eos, kStreamNum);
+  EXPECT_GT(g_service_frames, 0);
+}
+
+static std::vector<uint8_t> ReadFile(const std::string& file) {
+  std::vector<uint8_t> data;
+  FILE* fid = fopen((GetExePath() + file).c_str(), "rb");
+  if (!fid) return data;
+  fseek(fid, 0, SEEK_END);
+  data.resize(ftell(fid));
+  fseek(fid, 0, SEEK_SET);
+  if (fread(data.data(), 1, data.size(), fid) != data.size()) data.clear();
+  fclose(fid);
+  return data;
+}
+
+TEST(Decode, JpegImageSize) {
+  std::vector<uint8_t> data = ReadFile(corrupt_jpeg_file);
+  ASSERT_FALSE(data.empty());
+  uint32_t width = 0, height = 0;
+  EXPECT_EQ(CnedkJpegGetImageSize(data.data(), data.size(), &width, &height), 0);
+  EXPECT_EQ(width, 6000u);
+  EXPECT_EQ(height, 3374u);
+  // truncated before the frame header
+  EXPECT_NE(CnedkJpegGetImageSize(data.data(), 4, &width, &height), 0);
+  data[1] = 0;
+  EXPECT_NE(CnedkJpegGetImageSize(data.data(), data.size(), &width, &height), 0);
+}
+
+TEST(Decode, JpegService) {
+  static std::atomic<int> decoded{0};
+  static std::atomic<int> failed{0};
+  decoded = 0;
+  failed = 0;
+  CnedkJpegDecServiceCreateParams params;
+  memset(&params, 0, sizeof(params));
+  params.device_id = g_device_id;
+  params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  params.max_width = 3840;
+  params.max_height = 2160;
+  params.max_queued_images = 16;
+  params.OnImage = [](CnedkBufSurface* surf, uint64_t tag, int status, void*) -> int {
+    if (status) {
+      ++failed;
+      return 0;
+    }
+    // even tags are 1080p, odd tags are 352x288
+    EXPECT_EQ(surf->surface_list[0].width, tag % 2 ? 352u : 1920u);
+    ++decoded;
+    return CnedkBufSurfaceDestroy(surf);
+  };
+  void* service = nullptr;
+  ASSERT_EQ(CnedkJpegDecServiceCreate(&service, &params), 0);
+
+  constexpr int kImageNum = 64;
+  std::vector<uint8_t> images[2] = {ReadFile(jpeg_file), ReadFile("../../unitest/data/352x288.jpg")};
+  for (int i = 0; i < kImageNum; ++i) {
+    const std::vector<uint8_t>& image = images[i % 2];
+    int ret;
+    while ((ret = CnedkJpegDecServiceSubmit(service, image.data(), image.size(), i)) == -2) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(ret, 0);
+  }
+  // larger than the max size
+  std::vector<uint8_t> large = ReadFile(corrupt_jpeg_file);
+  EXPECT_NE(CnedkJpegDecServiceSubmit(service, large.data(), large.size(), kImageNum), 0);
+
+  EXPECT_EQ(CnedkJpegDecServiceDestroy(service), 0);
+  EXPECT_EQ(decoded, kImageNum);
+  EXPECT_EQ(failed, 0);
+}
+
 TEST(Decode, CreatDestory) {
   void* vdec = nullptr;
   EXPECT_NE(CnedkVdecCreate(&vdec, nullptr), 0);
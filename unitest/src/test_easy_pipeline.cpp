@@ -0,0 +1,516 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "easy_pipeline.hpp"
+#include "executor.hpp"
+#include "frame_batcher.hpp"
+#include "frame_queue.hpp"
+
+namespace {
+
+std::shared_ptr<EdkFrame> MakeFrame(uint64_t frame_idx, bool is_key_frame = false, bool is_eos = false) {
+  std::shared_ptr<EdkFrame> frame = std::make_shared<EdkFrame>();
+  frame->stream_id = 0;
+  frame->frame_idx = frame_idx;
+  frame->is_eos = is_eos;
+  frame->is_key_frame = is_key_frame;
+  return frame;
+}
+
+// pops all the queued frames, returns their frame_idx in order
+std::vector<uint64_t> PopAll(FrameQueue* queue) {
+  std::vector<uint64_t> frame_idxs;
+  std::shared_ptr<EdkFrame> frame;
+  while (queue->WaitAndTryPop(frame, std::chrono::microseconds(0))) frame_idxs.push_back(frame->frame_idx);
+  return frame_idxs;
+}
+
+LinkConfig MakeConfig(size_t capacity, OverflowPolicy policy) {
+  LinkConfig config;
+  config.capacity = capacity;
+  config.policy = policy;
+  return config;
+}
+
+bool WaitFor(const std::function<bool()> &cond, int timeout_ms = 5000) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (!cond()) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+// Logs the opens and closes of all the modules of a pipeline
+class ModuleLog {
+ public:
+  void Add(const std::string &entry) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    entries_.push_back(entry);
+  }
+  // the position of entry, or -1 if it is not logged
+  int Find(const std::string &entry) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto iter = std::find(entries_.begin(), entries_.end(), entry);
+    return iter == entries_.end() ? -1 : static_cast<int>(iter - entries_.begin());
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::string> entries_;
+};
+
+// Sends frame_num frames and then eos for each of stream_num streams, the streams interleaved frame by frame
+class TestSource : public EasyModule {
+ public:
+  TestSource(int stream_num, uint64_t frame_num)
+      : EasyModule("source", 1), stream_num_(stream_num), frame_num_(frame_num) {}
+  int Open() override { return 0; }
+  int Close() override { return 0; }
+  int Process(std::shared_ptr<EdkFrame> frame) override {
+    if (frame_idx_ > frame_num_) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      return 0;
+    }
+    for (int stream_id = 0; stream_id < stream_num_; ++stream_id) {
+      std::shared_ptr<EdkFrame> new_frame = std::make_shared<EdkFrame>();
+      new_frame->stream_id = stream_id;
+      new_frame->frame_idx = frame_idx_;
+      new_frame->is_eos = frame_idx_ == frame_num_;
+      Transmit(new_frame);
+    }
+    ++frame_idx_;
+    return 0;
+  }
+
+ private:
+  int stream_num_;
+  uint64_t frame_num_;
+  uint64_t frame_idx_ = 0;
+};
+
+// Records the frames it processes and passes them on, unless drop says so
+class TestModule : public EasyModule {
+ public:
+  TestModule(const std::string &name, ModuleLog *log, int parallelism = 1) : EasyModule(name, parallelism), log_(log) {}
+  int Open() override {
+    log_->Add("open " + GetModuleName());
+    return 0;
+  }
+  int Close() override {
+    log_->Add("close " + GetModuleName());
+    return 0;
+  }
+  int Process(std::shared_ptr<EdkFrame> frame) override {
+    if (process_) process_(*frame);
+    {
+      std::lock_guard<std::mutex> lk(mutex_);
+      if (frame->is_eos) {
+        ++eos_num_;
+      } else {
+        frames_[frame->stream_id].push_back(frame->frame_idx);
+      }
+    }
+    if (drop_ && drop_(*frame)) return 0;
+    return Transmit(frame);
+  }
+
+  // called at the beginning of Process()
+  void SetProcess(std::function<void(const EdkFrame &)> process) { process_ = process; }
+  // the frames for which drop returns true are not passed on
+  void SetDrop(std::function<bool(const EdkFrame &)> drop) { drop_ = drop; }
+  int GetEosNum() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return eos_num_;
+  }
+  std::vector<uint64_t> GetFrames(int stream_id) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return frames_[stream_id];
+  }
+
+ private:
+  ModuleLog *log_;
+  std::function<void(const EdkFrame &)> process_;
+  std::function<bool(const EdkFrame &)> drop_;
+  std::mutex mutex_;
+  int eos_num_ = 0;
+  std::map<int, std::vector<uint64_t>> frames_;
+};
+
+// Collects the frame_idx of the frames of each flushed batch
+class BatchLog {
+ public:
+  FrameBatcher::FlushFunc GetFlush() {
+    return [this](FrameBatcher::Batch batch) {
+      std::vector<uint64_t> frame_idxs;
+      for (const auto &frame : batch) frame_idxs.push_back(frame->frame_idx);
+      std::lock_guard<std::mutex> lk(mutex_);
+      batches_.push_back(frame_idxs);
+    };
+  }
+  std::vector<std::vector<uint64_t>> GetBatches() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return batches_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::vector<uint64_t>> batches_;
+};
+
+std::vector<uint64_t> Range(uint64_t begin, uint64_t end, uint64_t step = 1) {
+  std::vector<uint64_t> values;
+  for (uint64_t i = begin; i < end; i += step) values.push_back(i);
+  return values;
+}
+
+}  // namespace
+
+TEST(FrameQueue, DropNewest) {
+  FrameQueue queue(MakeConfig(2, OverflowPolicy::kDropNewest));
+  EXPECT_TRUE(queue.Push(MakeFrame(0)));
+  EXPECT_TRUE(queue.Push(MakeFrame(1)));
+  EXPECT_FALSE(queue.Push(MakeFrame(2)));
+  EXPECT_EQ(2u, queue.Size());
+  FrameQueueStats stats = queue.GetStats();
+  EXPECT_EQ(2u, stats.pushed);
+  EXPECT_EQ(1u, stats.dropped);
+  EXPECT_EQ(2u, stats.max_depth);
+  EXPECT_EQ(std::vector<uint64_t>({0, 1}), PopAll(&queue));
+  EXPECT_EQ(2u, queue.GetStats().popped);
+}
+
+TEST(FrameQueue, DropOldest) {
+  FrameQueue queue(MakeConfig(2, OverflowPolicy::kDropOldest));
+  for (uint64_t i = 0; i < 4; ++i) EXPECT_TRUE(queue.Push(MakeFrame(i)));
+  EXPECT_EQ(2u, queue.GetStats().dropped);
+  EXPECT_EQ(std::vector<uint64_t>({2, 3}), PopAll(&queue));
+}
+
+TEST(FrameQueue, KeyFramePreserving) {
+  FrameQueue queue(MakeConfig(2, OverflowPolicy::kKeyFramePreserving));
+  EXPECT_TRUE(queue.Push(MakeFrame(0, true)));
+  EXPECT_TRUE(queue.Push(MakeFrame(1)));
+  // the queued non-key frame makes room
+  EXPECT_TRUE(queue.Push(MakeFrame(2, true)));
+  // only key frames are queued, the incoming non-key frame is dropped
+  EXPECT_FALSE(queue.Push(MakeFrame(3)));
+  // a new key frame supersedes the oldest one
+  EXPECT_TRUE(queue.Push(MakeFrame(4, true)));
+  EXPECT_EQ(3u, queue.GetStats().dropped);
+  EXPECT_EQ(std::vector<uint64_t>({2, 4}), PopAll(&queue));
+}
+
+TEST(FrameQueue, NeverDropEos) {
+  for (OverflowPolicy policy : {OverflowPolicy::kDropOldest, OverflowPolicy::kDropNewest,
+                                OverflowPolicy::kKeyFramePreserving, OverflowPolicy::kBlock}) {
+    FrameQueue queue(MakeConfig(1, policy));
+    EXPECT_TRUE(queue.Push(MakeFrame(0, true)));
+    // let in over capacity, even by kBlock, which would wait otherwise
+    EXPECT_TRUE(queue.Push(MakeFrame(1, false, true)));
+    EXPECT_EQ(2u, queue.Size());
+    if (policy != OverflowPolicy::kBlock) {
+      // eos is not dropped to make room either
+      queue.Push(MakeFrame(2, true));
+      std::vector<uint64_t> frame_idxs = PopAll(&queue);
+      EXPECT_NE(frame_idxs.end(), std::find(frame_idxs.begin(), frame_idxs.end(), 1u));
+    }
+  }
+}
+
+TEST(FrameQueue, Block) {
+  FrameQueue queue(MakeConfig(1, OverflowPolicy::kBlock));
+  ASSERT_TRUE(queue.Push(MakeFrame(0)));
+  // callers which must not block bound the queue themselves
+  EXPECT_TRUE(queue.Push(MakeFrame(1), false));
+  EXPECT_EQ(2u, queue.Size());
+  EXPECT_EQ(std::vector<uint64_t>({0, 1}), PopAll(&queue));
+
+  ASSERT_TRUE(queue.Push(MakeFrame(2)));
+  std::atomic<bool> pushed{false};
+  std::thread pusher([&] {
+    EXPECT_TRUE(queue.Push(MakeFrame(3)));
+    pushed = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(pushed);
+  std::shared_ptr<EdkFrame> frame;
+  ASSERT_TRUE(queue.WaitAndTryPop(frame, std::chrono::microseconds(0)));
+  EXPECT_EQ(2u, frame->frame_idx);
+  pusher.join();
+  EXPECT_TRUE(pushed);
+  EXPECT_EQ(0u, queue.GetStats().dropped);
+
+  // shutdown fails the blocked pushers and all the later ones
+  pushed = false;
+  std::thread blocked([&] {
+    EXPECT_FALSE(queue.Push(MakeFrame(4)));
+    pushed = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(pushed);
+  queue.Shutdown();
+  blocked.join();
+  EXPECT_FALSE(queue.Push(MakeFrame(5, false, true)));
+  EXPECT_EQ(2u, queue.GetStats().dropped);
+  EXPECT_EQ(std::vector<uint64_t>({3}), PopAll(&queue));
+}
+
+TEST(FrameQueue, SetConfig) {
+  FrameQueue queue(MakeConfig(1, OverflowPolicy::kBlock));
+  ASSERT_TRUE(queue.Push(MakeFrame(0)));
+  std::thread pusher([&] { EXPECT_TRUE(queue.Push(MakeFrame(1))); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  // growing the capacity releases the blocked pusher
+  queue.SetConfig(MakeConfig(2, OverflowPolicy::kBlock));
+  pusher.join();
+  EXPECT_EQ(std::vector<uint64_t>({0, 1}), PopAll(&queue));
+}
+
+TEST(EasyPipeline, RejectCycle) {
+  ModuleLog log;
+  EasyPipeline pipeline(1);
+  ASSERT_EQ(0, pipeline.AddSource(std::make_shared<TestSource>(1, 1)));
+  ASSERT_EQ(0, pipeline.AddModule(std::make_shared<TestModule>("a", &log)));
+  ASSERT_EQ(0, pipeline.AddModule(std::make_shared<TestModule>("b", &log)));
+  EXPECT_EQ(-1, pipeline.AddModule(std::make_shared<TestModule>("b", &log)));
+  EXPECT_EQ(0, pipeline.AddLink("source", "a"));
+  EXPECT_EQ(0, pipeline.AddLink("a", "b"));
+  EXPECT_EQ(-1, pipeline.AddLink("b", "a"));
+  EXPECT_EQ(-1, pipeline.AddLink("a", "a"));
+  EXPECT_EQ(-1, pipeline.AddLink("a", "none"));
+}
+
+// source -> a -> {b, c} -> d
+TEST(EasyPipeline, JoinBranches) {
+  constexpr uint64_t kFrameNum = 20;
+  ModuleLog log;
+  auto a = std::make_shared<TestModule>("a", &log);
+  auto b = std::make_shared<TestModule>("b", &log);
+  auto c = std::make_shared<TestModule>("c", &log);
+  auto d = std::make_shared<TestModule>("d", &log);
+  {
+    EasyPipeline pipeline(2);
+    ASSERT_EQ(0, pipeline.AddSource(std::make_shared<TestSource>(2, kFrameNum)));
+    for (auto module : {a, b, c, d}) ASSERT_EQ(0, pipeline.AddModule(module));
+    ASSERT_EQ(0, pipeline.AddLink("source", "a"));
+    ASSERT_EQ(0, pipeline.AddLink("a", "b"));
+    ASSERT_EQ(0, pipeline.AddLink("a", "c"));
+    ASSERT_EQ(0, pipeline.AddLink("b", "d"));
+    ASSERT_EQ(0, pipeline.AddLink("c", "d"));
+    ASSERT_EQ(0, pipeline.Start());
+    // eos is joined like the other frames, it reaches d once per stream
+    ASSERT_TRUE(WaitFor([&] { return d->GetEosNum() == 2; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(2, d->GetEosNum());
+    for (int stream_id = 0; stream_id < 2; ++stream_id) {
+      EXPECT_EQ(Range(0, kFrameNum), b->GetFrames(stream_id));
+      EXPECT_EQ(Range(0, kFrameNum), c->GetFrames(stream_id));
+      // a frame is processed once, after it has arrived from both branches
+      EXPECT_EQ(Range(0, kFrameNum), d->GetFrames(stream_id));
+    }
+  }
+
+  // modules are opened in reverse topological order and closed in topological order
+  EXPECT_LT(log.Find("open d"), log.Find("open b"));
+  EXPECT_LT(log.Find("open d"), log.Find("open c"));
+  EXPECT_LT(log.Find("open b"), log.Find("open a"));
+  EXPECT_LT(log.Find("open c"), log.Find("open a"));
+  EXPECT_LT(log.Find("close a"), log.Find("close b"));
+  EXPECT_LT(log.Find("close a"), log.Find("close c"));
+  EXPECT_LT(log.Find("close b"), log.Find("close d"));
+  EXPECT_LT(log.Find("close c"), log.Find("close d"));
+  EXPECT_LE(0, log.Find("open a"));
+  EXPECT_LE(0, log.Find("close d"));
+}
+
+// source -> {a, b} -> c, a drops the odd frames
+TEST(EasyPipeline, JoinDroppedBranch) {
+  constexpr uint64_t kFrameNum = 20;
+  ModuleLog log;
+  auto a = std::make_shared<TestModule>("a", &log);
+  auto b = std::make_shared<TestModule>("b", &log);
+  auto c = std::make_shared<TestModule>("c", &log);
+  a->SetDrop([](const EdkFrame &frame) { return !frame.is_eos && frame.frame_idx % 2; });
+  EasyPipeline pipeline(2);
+  ASSERT_EQ(0, pipeline.AddSource(std::make_shared<TestSource>(1, kFrameNum)));
+  for (auto module : {a, b, c}) ASSERT_EQ(0, pipeline.AddModule(module));
+  ASSERT_EQ(0, pipeline.AddLink("source", "a"));
+  ASSERT_EQ(0, pipeline.AddLink("source", "b"));
+  ASSERT_EQ(0, pipeline.AddLink("a", "c"));
+  ASSERT_EQ(0, pipeline.AddLink("b", "c"));
+  ASSERT_EQ(0, pipeline.Start());
+  ASSERT_TRUE(WaitFor([&] { return c->GetEosNum() == 1; }));
+  // the frames dropped by a never complete, c gets only the frames both branches passed on
+  EXPECT_EQ(Range(0, kFrameNum), b->GetFrames(0));
+  EXPECT_EQ(Range(0, kFrameNum, 2), c->GetFrames(0));
+}
+
+TEST(Executor, RunTasks) {
+  constexpr int kTaskNum = 1000;
+  Executor executor(4);
+  EXPECT_EQ(4, executor.GetWorkerNum());
+  executor.Start();
+  EXPECT_FALSE(executor.InWorker());
+  std::atomic<int> done{0};
+  std::atomic<int> in_worker{0};
+  for (int i = 0; i < kTaskNum; ++i) {
+    executor.Submit([&] {
+      if (executor.InWorker()) ++in_worker;
+      ++done;
+    });
+  }
+  EXPECT_TRUE(WaitFor([&] { return done == kTaskNum; }));
+  EXPECT_EQ(kTaskNum, in_worker);
+  executor.Stop();
+}
+
+TEST(Executor, Steal) {
+  constexpr int kTaskNum = 16;
+  Executor executor(4);
+  executor.Start();
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  std::atomic<int> done{0};
+  // all the tasks go to the deque of the submitting worker, the idle workers must steal them
+  executor.Submit([&] {
+    for (int i = 0; i < kTaskNum; ++i) {
+      executor.Submit([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        {
+          std::lock_guard<std::mutex> lk(mutex);
+          threads.insert(std::this_thread::get_id());
+        }
+        ++done;
+      });
+    }
+  });
+  EXPECT_TRUE(WaitFor([&] { return done == kTaskNum; }));
+  executor.Stop();
+  EXPECT_GT(threads.size(), 1u);
+}
+
+// source -> a -> b, several streams of a and b are processed at the same time on shared workers, b is slow and
+// its input queues are bounded, so a is held back by CanSend() and resumed by Unblock() all the time
+TEST(EasyPipeline, StreamOrder) {
+  constexpr int kStreamNum = 4;
+  constexpr uint64_t kFrameNum = 50;
+  ModuleLog log;
+  auto a = std::make_shared<TestModule>("a", &log, kStreamNum);
+  auto b = std::make_shared<TestModule>("b", &log, 2);
+  std::mutex mutex;
+  std::set<std::pair<std::string, int>> busy_streams;
+  std::atomic<int> overlaps{0};
+  auto check_serial = [&](const std::string &name, const EdkFrame &frame, int sleep_ms) {
+    auto key = std::make_pair(name, frame.stream_id);
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      if (!busy_streams.insert(key).second) ++overlaps;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+    std::lock_guard<std::mutex> lk(mutex);
+    busy_streams.erase(key);
+  };
+  a->SetProcess([&](const EdkFrame &frame) { check_serial("a", frame, 0); });
+  b->SetProcess([&](const EdkFrame &frame) { check_serial("b", frame, 1); });
+
+  EasyPipeline pipeline(4);
+  ASSERT_EQ(0, pipeline.AddSource(std::make_shared<TestSource>(kStreamNum, kFrameNum)));
+  ASSERT_EQ(0, pipeline.AddModule(a));
+  ASSERT_EQ(0, pipeline.AddModule(b));
+  ASSERT_EQ(0, pipeline.AddLink("source", "a", MakeConfig(2, OverflowPolicy::kBlock)));
+  ASSERT_EQ(0, pipeline.AddLink("a", "b", MakeConfig(1, OverflowPolicy::kBlock)));
+  ASSERT_EQ(0, pipeline.Start());
+  ASSERT_TRUE(WaitFor([&] { return b->GetEosNum() == kStreamNum; }, 10000));
+
+  // frames of a stream are processed one by one in order, nothing is dropped by kBlock
+  EXPECT_EQ(0, overlaps);
+  for (int stream_id = 0; stream_id < kStreamNum; ++stream_id) {
+    EXPECT_EQ(Range(0, kFrameNum), a->GetFrames(stream_id));
+    EXPECT_EQ(Range(0, kFrameNum), b->GetFrames(stream_id));
+  }
+  // workers never wait for room, a must have been held back instead
+  for (const auto &link : pipeline.GetLinkStats()) {
+    EXPECT_EQ(0u, link.stats.dropped) << link.name;
+    if (link.name.compare(0, 3, "a->") == 0) {
+      EXPECT_LE(link.stats.max_depth, 1u) << link.name;
+    }
+  }
+}
+
+TEST(FrameBatcher, FlushFullBatch) {
+  BatchLog log;
+  {
+    FrameBatcher batcher(4, 10000, log.GetFlush());
+    // a full batch is flushed by the Add() completing it, without waiting for the deadline
+    for (uint64_t i = 0; i < 9; ++i) batcher.Add(MakeFrame(i));
+    EXPECT_EQ(std::vector<std::vector<uint64_t>>({Range(0, 4), Range(4, 8)}), log.GetBatches());
+  }
+  // the frames left are flushed on destruction
+  EXPECT_EQ(std::vector<std::vector<uint64_t>>({Range(0, 4), Range(4, 8), Range(8, 9)}), log.GetBatches());
+}
+
+TEST(FrameBatcher, FlushAtDeadline) {
+  constexpr int kTimeoutMs = 50;
+  BatchLog log;
+  FrameBatcher batcher(4, kTimeoutMs, log.GetFlush());
+  auto start = std::chrono::steady_clock::now();
+  batcher.Add(MakeFrame(0));
+  batcher.Add(MakeFrame(1));
+  EXPECT_TRUE(log.GetBatches().empty());
+  ASSERT_TRUE(WaitFor([&] { return !log.GetBatches().empty(); }));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(kTimeoutMs));
+  EXPECT_EQ(std::vector<std::vector<uint64_t>>({Range(0, 2)}), log.GetBatches());
+
+  // the deadline starts over with the first frame of the next batch
+  batcher.Add(MakeFrame(2));
+  ASSERT_TRUE(WaitFor([&] { return log.GetBatches().size() == 2; }));
+  EXPECT_EQ(std::vector<std::vector<uint64_t>>({Range(0, 2), Range(2, 3)}), log.GetBatches());
+}
+
+TEST(FrameBatcher, FlushBeforeEos) {
+  BatchLog log;
+  FrameBatcher batcher(4, 10000, log.GetFlush());
+  batcher.Add(MakeFrame(0));
+  batcher.Add(MakeFrame(1));
+  batcher.Add(MakeFrame(2));
+  // a module flushes the pending frames before passing eos on, so they are not held until the deadline
+  batcher.Flush();
+  EXPECT_EQ(std::vector<std::vector<uint64_t>>({Range(0, 3)}), log.GetBatches());
+  // nothing is pending, no empty batch is flushed
+  batcher.Flush();
+  EXPECT_EQ(1u, log.GetBatches().size());
+}
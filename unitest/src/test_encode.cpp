@@ -18,6 +18,7 @@
  * THE SOFTWARE.
  *************************************************************************/
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <memory>
@@ -87,6 +88,7 @@ class TestEncode {
 
 TestEncode::TestEncode(int dev_id, uint32_t frame_w, uint32_t frame_h, CnedkVencType type,
                        CnedkBufSurfaceColorFormat color_format) {
+  memset(&params_, 0, sizeof(params_));
   params_.type = type;
   params_.device_id = dev_id;
   params_.width = frame_w;
@@ -431,12 +433,135 @@ TEST(Encode, Jpeg) {
                           500, 500), 0);
 }
 
+TEST(Encode, ZeroCopy) {
+  CnedkPlatformInfo platform_info;
+  CnedkPlatformGetInfo(device_id, &platform_info);
+  if (std::string(platform_info.name) != "MLU370") return;
+  static std::atomic<int> frames{0};
+  static std::atomic<bool> eos{false};
+  frames = 0;
+  eos = false;
+
+  CnedkVencCreateParams params;
+  memset(&params, 0, sizeof(params));
+  params.type = CNEDK_VENC_TYPE_H264;
+  params.device_id = device_id;
+  params.width = 1920;
+  params.height = 1080;
+  params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  params.input_buf_num = 3;
+  params.gop_size = 30;
+  params.bitrate = 0x4000000;
+  params.zero_copy = true;
+  params.OnFrameBits = [](CnedkVEncFrameBits *framebits, void *) -> int {
+    if (framebits->pkt_type != CNEDK_VENC_PACKAGE_TYPE_SPS_PPS) ++frames;
+    return 0;
+  };
+  params.OnEos = [](void *) -> int {
+    eos = true;
+    return 0;
+  };
+  params.OnError = TestEncode::OnError_;
+  void *venc = nullptr;
+  ASSERT_EQ(CnedkVencCreate(&venc, &params), 0);
+
+  // NV12 frames are imported, BGR frames are converted into the input buffers of the encoder
+  constexpr int kFrameNum = 16;
+  for (int i = 0; i < kFrameNum; ++i) {
+    CnedkBufSurfaceCreateParams create_params;
+    memset(&create_params, 0, sizeof(create_params));
+    create_params.device_id = device_id;
+    create_params.batch_size = 1;
+    create_params.width = 1920;
+    create_params.height = 1080;
+    create_params.color_format = i % 2 ? CNEDK_BUF_COLOR_FORMAT_BGR : CNEDK_BUF_COLOR_FORMAT_NV12;
+    create_params.mem_type = CNEDK_BUF_MEM_DEVICE;
+    CnedkBufSurface *surf = nullptr;
+    ASSERT_EQ(CnedkBufSurfaceCreate(&surf, &create_params), 0);
+    CnedkBufSurfaceMemSet(surf, -1, -1, 128);
+    surf->pts = i;
+    // the encoder destroys the BufSurface
+    EXPECT_EQ(CnedkVencSendFrame(venc, surf, 5000), 0);
+  }
+  EXPECT_EQ(CnedkVencSendFrame(venc, nullptr, 5000), 0);
+  EXPECT_EQ(CnedkVencDestroy(venc), 0);
+  EXPECT_TRUE(eos);
+  EXPECT_EQ(frames, kFrameNum);
+}
+
+TEST(Encode, Ring) {
+  CnedkPlatformInfo platform_info;
+  CnedkPlatformGetInfo(device_id, &platform_info);
+  std::string platform_name(platform_info.name);
+  if (!cnedk::IsCloudPlatform(device_id) || platform_name.rfind("MLU5", 0) == 0) return;
+
+  CnedkVencCreateParams params;
+  memset(&params, 0, sizeof(params));
+  params.type = CNEDK_VENC_TYPE_H264;
+  params.device_id = device_id;
+  params.width = 1920;
+  params.height = 1080;
+  params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  params.input_buf_num = 3;
+  params.gop_size = 30;
+  params.bitrate = 0x4000000;
+  params.ring_size = 4 << 20;
+  params.OnEos = [](void *) -> int { return 0; };
+  params.OnError = TestEncode::OnError_;
+  void *venc = nullptr;
+  ASSERT_EQ(CnedkVencCreate(&venc, &params), 0);
+
+  const uint8_t *buffer = nullptr;
+  uint32_t size = 0;
+  ASSERT_EQ(CnedkVencRingGetBuffer(venc, &buffer, &size), 0);
+  EXPECT_EQ(size, params.ring_size);
+  int reader = -1;
+  ASSERT_EQ(CnedkVencRingAddReader(venc, &reader), 0);
+  int packets = 0;
+  std::thread read_thread([&] {
+    CnedkVencRingPacket packet;
+    while (CnedkVencRingRead(venc, reader, &packet, -1) == 0 && !packet.eos) {
+      EXPECT_LE(packet.offset + packet.len, size);
+      EXPECT_EQ(packet.dropped, 0u);
+      ++packets;
+      EXPECT_EQ(CnedkVencRingRelease(venc, reader, &packet), 0);
+    }
+  });
+
+  CnedkBufSurfaceCreateParams create_params;
+  memset(&create_params, 0, sizeof(create_params));
+  create_params.device_id = device_id;
+  create_params.batch_size = 1;
+  create_params.width = 1920;
+  create_params.height = 1080;
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  create_params.mem_type = CNEDK_BUF_MEM_DEVICE;
+  CnedkBufSurface *surf = nullptr;
+  ASSERT_EQ(CnedkBufSurfaceCreate(&surf, &create_params), 0);
+  CnedkBufSurfaceMemSet(surf, -1, -1, 128);
+  for (int i = 0; i < 30; ++i) {
+    surf->pts = i;
+    int ret;
+    while ((ret = CnedkVencSendFrame(venc, surf, 5000)) == -2) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(ret, 0);
+  }
+  EXPECT_EQ(CnedkVencSendFrame(venc, nullptr, 5000), 0);
+  read_thread.join();
+  EXPECT_GT(packets, 0);
+  EXPECT_EQ(CnedkVencRingRemoveReader(venc, reader), 0);
+  EXPECT_EQ(CnedkVencDestroy(venc), 0);
+  EXPECT_EQ(CnedkBufSurfaceDestroy(surf), 0);
+}
+
 TEST(Encode, CreateDestory) {
   bool is_edge_platform = cnedk::IsEdgePlatform(device_id);
   void* venc = nullptr;
   EXPECT_NE(CnedkVencCreate(&venc, nullptr), 0);
 
   CnedkVencCreateParams params;
+  memset(&params, 0, sizeof(params));
   params.type = CNEDK_VENC_TYPE_H264;
   params.device_id = device_id;
   params.width = 1920;
@@ -0,0 +1,173 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include <gtest/gtest.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "fd_reactor.hpp"
+
+namespace {
+
+// An eventfd stands for a codec channel: each write queues one output, each read reaps one.
+class FakeChannel {
+ public:
+  FakeChannel() { fd_ = eventfd(0, EFD_NONBLOCK | EFD_SEMAPHORE); }
+  ~FakeChannel() { close(fd_); }
+  int fd() const { return fd_; }
+  void Produce(uint64_t n = 1) { ASSERT_EQ(sizeof(n), static_cast<size_t>(write(fd_, &n, sizeof(n)))); }
+  bool Reap() {
+    uint64_t value;
+    return read(fd_, &value, sizeof(value)) == sizeof(value);
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+bool WaitFor(const std::function<bool()> &cond, int timeout_ms = 2000) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (!cond()) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(FdReactor, StartStop) {
+  cnedk::FdReactor reactor;
+  FakeChannel chn;
+  EXPECT_EQ(-1, reactor.Add(chn.fd(), [] {}));
+  ASSERT_EQ(0, reactor.Start());
+  EXPECT_EQ(0, reactor.Start());
+  EXPECT_EQ(-1, reactor.Add(-1, [] {}));
+  EXPECT_EQ(-1, reactor.Add(chn.fd(), nullptr));
+  EXPECT_EQ(0, reactor.Add(chn.fd(), [] {}));
+  EXPECT_EQ(-1, reactor.Add(chn.fd(), [] {}));
+  EXPECT_EQ(0, reactor.Remove(chn.fd()));
+  EXPECT_EQ(-1, reactor.Remove(chn.fd()));
+  reactor.Stop();
+  reactor.Stop();
+}
+
+TEST(FdReactor, DeliverOutputs) {
+  constexpr int kChnNum = 4;
+  constexpr int kOutputNum = 100;
+  cnedk::FdReactor reactor;
+  ASSERT_EQ(0, reactor.Start());
+  FakeChannel chns[kChnNum];
+  std::atomic<int> reaped[kChnNum];
+  for (int i = 0; i < kChnNum; ++i) {
+    reaped[i] = 0;
+    ASSERT_EQ(0, reactor.Add(chns[i].fd(), [&, i] {
+      EXPECT_TRUE(reactor.InReactorThread());
+      if (chns[i].Reap()) ++reaped[i];
+    }));
+  }
+  EXPECT_FALSE(reactor.InReactorThread());
+  // outputs become available while the sender keeps going, nobody polls
+  for (int n = 0; n < kOutputNum; ++n) {
+    for (int i = 0; i < kChnNum; ++i) chns[i].Produce();
+  }
+  for (int i = 0; i < kChnNum; ++i) {
+    EXPECT_TRUE(WaitFor([&] { return reaped[i] == kOutputNum; }));
+    EXPECT_EQ(0, reactor.Remove(chns[i].fd()));
+  }
+  reactor.Stop();
+}
+
+TEST(FdReactor, RemoveWaitsForHandler) {
+  cnedk::FdReactor reactor;
+  ASSERT_EQ(0, reactor.Start());
+  FakeChannel chn;
+  std::atomic<bool> in_handler{false};
+  std::atomic<bool> handler_done{false};
+  ASSERT_EQ(0, reactor.Add(chn.fd(), [&] {
+    chn.Reap();
+    in_handler = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    handler_done = true;
+  }));
+  chn.Produce();
+  ASSERT_TRUE(WaitFor([&] { return in_handler.load(); }));
+  EXPECT_EQ(0, reactor.Remove(chn.fd()));
+  EXPECT_TRUE(handler_done);
+  // no more callbacks once removed
+  handler_done = false;
+  chn.Produce();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(handler_done);
+  reactor.Stop();
+}
+
+TEST(FdReactor, RemoveInHandler) {
+  cnedk::FdReactor reactor;
+  ASSERT_EQ(0, reactor.Start());
+  FakeChannel chn;
+  std::atomic<int> calls{0};
+  // like a channel reporting EOS, the handler unregisters itself and leaves the fd readable
+  ASSERT_EQ(0, reactor.Add(chn.fd(), [&] {
+    ++calls;
+    EXPECT_EQ(0, reactor.Remove(chn.fd()));
+  }));
+  chn.Produce();
+  ASSERT_TRUE(WaitFor([&] { return calls > 0; }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(1, calls);
+  reactor.Stop();
+}
+
+TEST(FdReactor, SlowHandlerDoesNotStallOthers) {
+  cnedk::FdReactor reactor;
+  ASSERT_EQ(0, reactor.Start(2));
+  FakeChannel slow, fast;
+  std::atomic<bool> release{false};
+  std::atomic<int> slow_running{0};
+  std::atomic<int> max_slow_running{0};
+  std::atomic<int> fast_reaped{0};
+  // like a consumer blocking in OnFrame, the handler of one channel does not return for a while
+  ASSERT_EQ(0, reactor.Add(slow.fd(), [&] {
+    int running = ++slow_running;
+    if (running > max_slow_running) max_slow_running = running;
+    slow.Reap();
+    while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    --slow_running;
+  }));
+  ASSERT_EQ(0, reactor.Add(fast.fd(), [&] {
+    if (fast.Reap()) ++fast_reaped;
+  }));
+  slow.Produce(3);
+  ASSERT_TRUE(WaitFor([&] { return slow_running > 0; }));
+  fast.Produce(10);
+  EXPECT_TRUE(WaitFor([&] { return fast_reaped == 10; }));
+  release = true;
+  EXPECT_EQ(0, reactor.Remove(slow.fd()));
+  EXPECT_EQ(0, reactor.Remove(fast.fd()));
+  // the handler of a channel never runs concurrently with itself
+  EXPECT_EQ(1, max_slow_running);
+  reactor.Stop();
+}
@@ -0,0 +1,229 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+#include <gtest/gtest.h>
+#include "glog/logging.h"
+
+#include <cstring>
+#include <vector>
+
+#include "cnedk_buf_surface.h"
+#include "cnedk_osd.h"
+
+#include "test_base.h"
+
+static const int g_device_id = 0;
+
+TEST(Osd, Cpu) {
+  CnedkBufSurfaceCreateParams create_params;
+  memset(&create_params, 0, sizeof(create_params));
+  create_params.batch_size = 1;
+  create_params.width = 64;
+  create_params.height = 32;
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  create_params.mem_type = CNEDK_BUF_MEM_SYSTEM;
+  create_params.device_id = g_device_id;
+  CnedkBufSurface* surf = nullptr;
+  ASSERT_EQ(CnedkBufSurfaceCreate(&surf, &create_params), 0);
+  surf->num_filled = 1;
+  ASSERT_EQ(CnedkBufSurfaceMemSet(surf, -1, -1, 0), 0);
+
+  CnedkBufSurfaceParams* params = &surf->surface_list[0];
+  uint8_t* y_plane = static_cast<uint8_t*>(params->data_ptr) + params->plane_params.offset[0];
+  uint8_t* uv_plane = static_cast<uint8_t*>(params->data_ptr) + params->plane_params.offset[1];
+  uint32_t y_pitch = params->plane_params.pitch[0];
+  uint32_t uv_pitch = params->plane_params.pitch[1];
+
+  {  // filled rectangle, red
+    CnedkOsdRectParams rect = {4, 4, 8, 8, 0x00ff0000, 0};
+    EXPECT_EQ(CnedkFillRect(surf, &rect, 1), 0);
+    EXPECT_EQ(y_plane[4 * y_pitch + 4], 82);
+    EXPECT_EQ(y_plane[11 * y_pitch + 11], 82);
+    EXPECT_EQ(y_plane[12 * y_pitch + 12], 0);
+    EXPECT_EQ(y_plane[3 * y_pitch + 4], 0);
+    EXPECT_EQ(uv_plane[2 * uv_pitch + 4], 90);
+    EXPECT_EQ(uv_plane[2 * uv_pitch + 5], 240);
+    EXPECT_EQ(uv_plane[6 * uv_pitch + 12], 0);
+  }
+
+  {  // box, the inside is untouched
+    CnedkOsdRectParams rect = {20, 4, 20, 20, 0x00ffffff, 2};
+    EXPECT_EQ(CnedkDrawRect(surf, &rect, 1), 0);
+    EXPECT_EQ(y_plane[4 * y_pitch + 20], 235);
+    EXPECT_EQ(y_plane[23 * y_pitch + 39], 235);
+    EXPECT_EQ(y_plane[10 * y_pitch + 21], 235);
+    EXPECT_EQ(y_plane[10 * y_pitch + 30], 0);
+    EXPECT_EQ(uv_plane[2 * uv_pitch + 20], 128);
+    EXPECT_EQ(uv_plane[6 * uv_pitch + 30], 0);
+  }
+
+  {  // bitmap, only the pixels with alpha bit are drawn
+    std::vector<uint16_t> bitmap(4 * 2, 0);
+    bitmap[0] = 0xffff;  // white
+    bitmap[5] = 0xffff;
+    CnedkOsdBitmapParams bitmap_params;
+    memset(&bitmap_params, 0, sizeof(bitmap_params));
+    bitmap_params.x = 48;
+    bitmap_params.y = 26;
+    bitmap_params.w = 4;
+    bitmap_params.h = 2;
+    bitmap_params.pitch = 4 * sizeof(uint16_t);
+    bitmap_params.bitmap_argb1555 = bitmap.data();
+    EXPECT_EQ(CnedkDrawBitmap(surf, &bitmap_params, 1), 0);
+    EXPECT_EQ(y_plane[26 * y_pitch + 48], 235);
+    EXPECT_EQ(y_plane[26 * y_pitch + 49], 0);
+    EXPECT_EQ(y_plane[27 * y_pitch + 49], 235);
+    EXPECT_EQ(uv_plane[13 * uv_pitch + 48], 128);
+    EXPECT_EQ(uv_plane[13 * uv_pitch + 50], 0);
+  }
+
+  {  // out of frame
+    CnedkOsdRectParams rect = {-8, 28, 100, 100, 0x00ffffff, 0};
+    EXPECT_EQ(CnedkFillRect(surf, &rect, 1), 0);
+    EXPECT_EQ(y_plane[31 * y_pitch + 63], 235);
+    EXPECT_EQ(y_plane[27 * y_pitch], 0);
+  }
+  EXPECT_EQ(CnedkBufSurfaceDestroy(surf), 0);
+
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_BGR;
+  ASSERT_EQ(CnedkBufSurfaceCreate(&surf, &create_params), 0);
+  CnedkOsdRectParams rect = {0, 0, 8, 8, 0x00ffffff, 0};
+  EXPECT_NE(CnedkFillRect(surf, &rect, 1), 0);
+  EXPECT_NE(CnedkFillRect(nullptr, &rect, 1), 0);
+  EXPECT_EQ(CnedkBufSurfaceDestroy(surf), 0);
+}
+
+TEST(Osd, CpuBatch) {
+  CnedkBufSurfaceCreateParams create_params;
+  memset(&create_params, 0, sizeof(create_params));
+  create_params.batch_size = 4;
+  create_params.width = 64;
+  create_params.height = 32;
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_NV21;
+  create_params.mem_type = CNEDK_BUF_MEM_SYSTEM;
+  create_params.device_id = g_device_id;
+  CnedkBufSurface* surf = nullptr;
+  ASSERT_EQ(CnedkBufSurfaceCreate(&surf, &create_params), 0);
+  surf->num_filled = 4;
+  ASSERT_EQ(CnedkBufSurfaceMemSet(surf, -1, -1, 0), 0);
+
+  CnedkOsdRectParams fill = {0, 0, 16, 16, 0x00ff0000, 0};
+  CnedkOsdRectParams box = {0, 0, 16, 16, 0x00ffffff, 2};
+  std::vector<CnedkOsdBatchItem> items(5);
+  for (uint32_t i = 0; i < 4; ++i) {
+    memset(&items[i], 0, sizeof(CnedkOsdBatchItem));
+    items[i].surf = surf;
+    items[i].batch_idx = i;
+    items[i].fill_rects = &fill;
+    items[i].num_fill_rects = 1;
+  }
+  // a second item on buffer 3
+  memset(&items[4], 0, sizeof(CnedkOsdBatchItem));
+  items[4].surf = surf;
+  items[4].batch_idx = 3;
+  items[4].rects = &box;
+  items[4].num_rects = 1;
+  EXPECT_EQ(CnedkOsdDrawBatch(items.data(), items.size()), 0);
+
+  for (uint32_t i = 0; i < 4; ++i) {
+    CnedkBufSurfaceParams* params = &surf->surface_list[i];
+    uint8_t* y_plane = static_cast<uint8_t*>(params->data_ptr) + params->plane_params.offset[0];
+    uint8_t* uv_plane = static_cast<uint8_t*>(params->data_ptr) + params->plane_params.offset[1];
+    EXPECT_EQ(y_plane[8 * params->plane_params.pitch[0] + 8], 82);
+    EXPECT_EQ(y_plane[16 * params->plane_params.pitch[0] + 16], 0);
+    EXPECT_EQ(uv_plane[4 * params->plane_params.pitch[1] + 8], 240);  // V first for NV21
+    EXPECT_EQ(y_plane[0], i == 3 ? 235 : 82);
+  }
+
+  items[4].batch_idx = 4;
+  EXPECT_NE(CnedkOsdDrawBatch(items.data(), items.size()), 0);
+  items[4].surf = nullptr;
+  EXPECT_NE(CnedkOsdDrawBatch(items.data(), items.size()), 0);
+  EXPECT_EQ(CnedkOsdDrawBatch(nullptr, 0), 0);
+  EXPECT_EQ(CnedkBufSurfaceDestroy(surf), 0);
+}
+
+TEST(Osd, Text) {
+  // 'A' is an opaque 4x4 block, 'B' is a half transparent 4x4 block, ' ' has no bitmap
+  std::vector<uint8_t> opaque(4 * 4, 255), half(4 * 4, 128);
+  CnedkOsdGlyph glyphs[3] = {{'A', 4, 4, 0, 4, 6, opaque.data(), 4},
+                             {'B', 4, 4, 0, 4, 6, half.data(), 4},
+                             {' ', 0, 0, 0, 0, 4, nullptr, 0}};
+  CnedkOsdFontCreateParams font_params;
+  memset(&font_params, 0, sizeof(font_params));
+  font_params.glyphs = glyphs;
+  font_params.num_glyphs = 3;
+  font_params.ascent = 6;
+  font_params.line_height = 8;
+  void* font = nullptr;
+  ASSERT_EQ(CnedkOsdFontCreate(&font, &font_params), 0);
+
+  int w = 0, h = 0;
+  EXPECT_EQ(CnedkOsdGetTextSize(font, "AB A", &w, &h), 0);
+  EXPECT_EQ(w, 22);
+  EXPECT_EQ(h, 8);
+
+  CnedkBufSurfaceCreateParams create_params;
+  memset(&create_params, 0, sizeof(create_params));
+  create_params.batch_size = 1;
+  create_params.width = 64;
+  create_params.height = 32;
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  create_params.mem_type = CNEDK_BUF_MEM_SYSTEM;
+  create_params.device_id = g_device_id;
+  CnedkBufSurface* surf = nullptr;
+  ASSERT_EQ(CnedkBufSurfaceCreate(&surf, &create_params), 0);
+  surf->num_filled = 1;
+  ASSERT_EQ(CnedkBufSurfaceMemSet(surf, -1, -1, 0), 0);
+  CnedkBufSurfaceParams* params = &surf->surface_list[0];
+  uint8_t* y_plane = static_cast<uint8_t*>(params->data_ptr) + params->plane_params.offset[0];
+  uint8_t* uv_plane = static_cast<uint8_t*>(params->data_ptr) + params->plane_params.offset[1];
+  uint32_t y_pitch = params->plane_params.pitch[0];
+  uint32_t uv_pitch = params->plane_params.pitch[1];
+
+  CnedkOsdTextParams text_params[2];
+  memset(text_params, 0, sizeof(text_params));
+  text_params[0].x = 2;
+  text_params[0].y = 4;
+  text_params[0].text = "AB";
+  text_params[0].color = 0x00ffffff;
+  text_params[1] = text_params[0];
+  text_params[1].y = 20;
+  text_params[1].draw_bg = true;
+  text_params[1].bg_color = 0x00ff0000;
+  // the same label is drawn twice, the second one comes from the cache
+  for (int i = 0; i < 2; ++i) EXPECT_EQ(CnedkDrawText(surf, font, text_params, 2), 0);
+
+  // glyphs are at rows [2, 6) of the label
+  EXPECT_EQ(y_plane[5 * y_pitch + 2], 0);
+  EXPECT_EQ(y_plane[6 * y_pitch + 2], 235);
+  EXPECT_EQ(y_plane[9 * y_pitch + 5], 235);
+  EXPECT_EQ(y_plane[10 * y_pitch + 5], 0);
+  EXPECT_EQ(uv_plane[3 * uv_pitch + 2], 128);
+  // half transparent, blended twice
+  EXPECT_EQ(y_plane[6 * y_pitch + 8], 177);
+  // background under the transparent part of the label
+  EXPECT_EQ(y_plane[20 * y_pitch + 2], 82);
+  EXPECT_EQ(y_plane[22 * y_pitch + 2], 235);
+  EXPECT_EQ(y_plane[26 * y_pitch + 2], 82);
+
+  EXPECT_NE(CnedkDrawText(surf, nullptr, text_params, 1), 0);
+  EXPECT_EQ(CnedkBufSurfaceDestroy(surf), 0);
+  EXPECT_EQ(CnedkOsdFontDestroy(font), 0);
+}
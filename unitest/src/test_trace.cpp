@@ -0,0 +1,151 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cnedk_trace.h"
+
+namespace {
+
+std::string ReadExported() {
+  char path[] = "/tmp/cnedk_trace_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) return "";
+  close(fd);
+  std::string content;
+  if (CnedkTraceExport(path) == 0) {
+    std::ifstream ifs(path);
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    content = ss.str();
+  }
+  unlink(path);
+  return content;
+}
+
+size_t Count(const std::string &str, const std::string &sub) {
+  size_t num = 0;
+  for (size_t pos = str.find(sub); pos != std::string::npos; pos = str.find(sub, pos + sub.size())) ++num;
+  return num;
+}
+
+}  // namespace
+
+TEST(Trace, Sampling) {
+  CnedkTraceParams params;
+  params.sample_interval = 4;
+  params.ring_size = 0;
+  ASSERT_EQ(-1, CnedkTraceStart(nullptr));
+  ASSERT_EQ(0, CnedkTraceStart(&params));
+  int traced = 0;
+  for (int i = 0; i < 100; ++i) {
+    uint64_t id = CnedkTraceNewId();
+    if (id) {
+      ++traced;
+      uint64_t now = CnedkTraceNow();
+      EXPECT_EQ(0, CnedkTraceRecord(id, "decode", now, now + 1000));
+    }
+  }
+  EXPECT_EQ(25, traced);
+  EXPECT_EQ(0, CnedkTraceRecord(0, "decode", 0, 1));
+  EXPECT_EQ(-1, CnedkTraceRecord(1, nullptr, 0, 1));
+  std::string json = ReadExported();
+  EXPECT_EQ(25u, Count(json, "\"ph\":\"b\""));
+  EXPECT_EQ(25u, Count(json, "\"ph\":\"e\""));
+
+  EXPECT_EQ(0, CnedkTraceStop());
+  EXPECT_EQ(0u, CnedkTraceNewId());
+  EXPECT_EQ(0, CnedkTraceRecord(1, "decode", 0, 1));
+  // spans are kept after stopped
+  EXPECT_EQ(25u, Count(ReadExported(), "\"ph\":\"b\""));
+}
+
+TEST(Trace, ExportSpans) {
+  CnedkTraceParams params;
+  params.sample_interval = 1;
+  params.ring_size = 16;
+  ASSERT_EQ(0, CnedkTraceStart(&params));
+  EXPECT_EQ(0u, Count(ReadExported(), "\"ph\":\"b\""));
+  uint64_t id = CnedkTraceNewId();
+  ASSERT_NE(0u, id);
+  EXPECT_EQ(0, CnedkTraceRecord(id, "preprocess", 1000, 3000));
+  EXPECT_EQ(0, CnedkTraceRecord(id, "a \"quoted\" name", 3000, 5000));
+  std::string json = ReadExported();
+  EXPECT_EQ(0u, json.find("{\"traceEvents\":["));
+  EXPECT_NE(std::string::npos, json.find("\"name\":\"preprocess\",\"cat\":\"frame\",\"ph\":\"b\""));
+  EXPECT_NE(std::string::npos, json.find("\"ts\":2.000}"));
+  EXPECT_NE(std::string::npos, json.find("a \\\"quoted\\\" name"));
+  EXPECT_EQ(-1, CnedkTraceExport(nullptr));
+  CnedkTraceStop();
+}
+
+TEST(Trace, RingOverwrite) {
+  CnedkTraceParams params;
+  params.sample_interval = 1;
+  params.ring_size = 8;
+  ASSERT_EQ(0, CnedkTraceStart(&params));
+  for (uint64_t i = 0; i < 20; ++i) {
+    EXPECT_EQ(0, CnedkTraceRecord(CnedkTraceNewId(), "infer", i * 10, i * 10 + 5));
+  }
+  std::string json = ReadExported();
+  // the newest 8 spans are kept
+  EXPECT_EQ(8u, Count(json, "\"ph\":\"b\""));
+  EXPECT_EQ(std::string::npos, json.find("\"id\":\"0xc\""));
+  EXPECT_NE(std::string::npos, json.find("\"id\":\"0xd\""));
+  EXPECT_NE(std::string::npos, json.find("\"id\":\"0x14\""));
+  CnedkTraceStop();
+}
+
+TEST(Trace, MultiThreads) {
+  constexpr int kThreadNum = 4;
+  constexpr int kSpanNum = 100;
+  CnedkTraceParams params;
+  params.sample_interval = 1;
+  params.ring_size = kSpanNum;
+  ASSERT_EQ(0, CnedkTraceStart(&params));
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreadNum; ++t) {
+    threads.emplace_back([] {
+      for (int i = 0; i < kSpanNum; ++i) {
+        uint64_t begin = CnedkTraceNow();
+        CnedkTraceRecord(CnedkTraceNewId(), "osd", begin, CnedkTraceNow());
+      }
+    });
+  }
+  // exporting while recording
+  ReadExported();
+  for (auto &it : threads) it.join();
+  std::string json = ReadExported();
+  EXPECT_EQ(static_cast<size_t>(kThreadNum * kSpanNum), Count(json, "\"ph\":\"b\""));
+  for (int t = 0; t < kThreadNum; ++t) {
+    EXPECT_NE(std::string::npos, json.find("\"tid\":" + std::to_string(t) + ","));
+  }
+  // rings are reset by the next start
+  ASSERT_EQ(0, CnedkTraceStart(&params));
+  EXPECT_EQ(0u, Count(ReadExported(), "\"ph\":\"b\""));
+  CnedkTraceStop();
+}
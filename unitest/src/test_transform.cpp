@@ -20,6 +20,8 @@
 #include <gtest/gtest.h>
 #include "glog/logging.h"
 
+#include "cnrt.h"
+
 #include "cnedk_platform.h"
 #include "cnedk_buf_surface.h"
 #include "cnedk_transform.h"
@@ -385,3 +387,290 @@ TEST(Transform, KeepAspectRatio) {
     EXPECT_NE(TestFun(CNEDK_BUF_COLOR_FORMAT_NV21, CNEDK_BUF_COLOR_FORMAT_NV12, 1920, 1080, 224, 224, &params), 0);
   }
 }
+
+TEST(Transform, Async) {
+  if (cnedk::IsEdgePlatform(g_device_id)) return;
+
+  CnedkBufSurfaceCreateParams create_params;
+  memset(&create_params, 0, sizeof(create_params));
+  create_params.batch_size = 4;
+  create_params.width = 1280;
+  create_params.height = 720;
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  create_params.mem_type = CNEDK_BUF_MEM_DEVICE;
+  create_params.device_id = g_device_id;
+  CnedkBufSurface* src_surf = nullptr;
+  ASSERT_EQ(CnedkBufSurfaceCreate(&src_surf, &create_params), 0);
+
+  create_params.width = 416;
+  create_params.height = 416;
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_BGR;
+  CnedkBufSurface* dst_surf = nullptr;
+  ASSERT_EQ(CnedkBufSurfaceCreate(&dst_surf, &create_params), 0);
+
+  CnedkTransformParams params;
+  memset(&params, 0, sizeof(params));
+  params.transform_flag = CNEDK_TRANSFORM_ASYNC;
+  // batch size changes between calls, the workspace and pointer tables are reused
+  for (uint32_t i = 0; i < 16; ++i) {
+    src_surf->batch_size = i % 4 + 1;
+    src_surf->num_filled = src_surf->batch_size;
+    EXPECT_EQ(CnedkTransform(src_surf, dst_surf, &params), 0);
+  }
+  src_surf->batch_size = 4;
+
+  CnedkTransformConfigParams config;
+  memset(&config, 0, sizeof(config));
+  EXPECT_EQ(CnedkTransformGetSessionParams(&config), 0);
+  EXPECT_EQ(cnrtQueueSync(config.cnrt_queue), cnrtSuccess);
+
+  EXPECT_EQ(CnedkBufSurfaceDestroy(dst_surf), 0);
+  EXPECT_EQ(CnedkBufSurfaceDestroy(src_surf), 0);
+}
+
+TEST(Transform, Plan) {
+  if (cnedk::IsEdgePlatform(g_device_id)) return;
+
+  CnedkBufSurfaceCreateParams create_params;
+  memset(&create_params, 0, sizeof(create_params));
+  create_params.batch_size = 4;
+  create_params.width = 1920;
+  create_params.height = 1080;
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  create_params.mem_type = CNEDK_BUF_MEM_DEVICE;
+  create_params.device_id = g_device_id;
+  CnedkBufSurface* src_surf = nullptr;
+  ASSERT_EQ(CnedkBufSurfaceCreate(&src_surf, &create_params), 0);
+  src_surf->num_filled = 4;
+
+  create_params.width = 640;
+  create_params.height = 640;
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_RGB;
+  CnedkBufSurface* dst_surf = nullptr;
+  ASSERT_EQ(CnedkBufSurfaceCreate(&dst_surf, &create_params), 0);
+
+  CnedkTransformPlanParams plan_params;
+  memset(&plan_params, 0, sizeof(plan_params));
+  plan_params.src_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  plan_params.dst_format = CNEDK_BUF_COLOR_FORMAT_RGB;
+  plan_params.batch_size = 4;
+  plan_params.dst_width = 640;
+  plan_params.dst_height = 640;
+  // the second plan shares the resources of the first one
+  void* plan = nullptr;
+  void* plan_shared = nullptr;
+  ASSERT_EQ(CnedkTransformPlanCreate(&plan, &plan_params), 0);
+  ASSERT_EQ(CnedkTransformPlanCreate(&plan_shared, &plan_params), 0);
+
+  CnedkTransformParams params;
+  memset(&params, 0, sizeof(params));
+  for (uint32_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(CnedkTransformPlanExecute(i % 2 ? plan : plan_shared, src_surf, dst_surf, &params), 0);
+  }
+  EXPECT_EQ(CnedkTransformPlanDestroy(plan), 0);
+  EXPECT_EQ(CnedkTransformPlanExecute(plan_shared, src_surf, dst_surf, &params), 0);
+
+  // the buffers do not match the plan
+  params.transform_flag = CNEDK_TRANSFORM_MEAN_STD;
+  EXPECT_NE(CnedkTransformPlanExecute(plan_shared, src_surf, dst_surf, &params), 0);
+  params.transform_flag = 0;
+  EXPECT_NE(CnedkTransformPlanExecute(plan_shared, dst_surf, dst_surf, &params), 0);
+  EXPECT_NE(CnedkTransformPlanExecute(plan_shared, src_surf, src_surf, &params), 0);
+  EXPECT_EQ(CnedkTransformPlanDestroy(plan_shared), 0);
+
+  plan_params.src_format = CNEDK_BUF_COLOR_FORMAT_TENSOR;
+  EXPECT_NE(CnedkTransformPlanCreate(&plan, &plan_params), 0);
+  plan_params.src_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  plan_params.batch_size = 0;
+  EXPECT_NE(CnedkTransformPlanCreate(&plan, &plan_params), 0);
+  EXPECT_NE(CnedkTransformPlanExecute(nullptr, src_surf, dst_surf, &params), 0);
+
+  EXPECT_EQ(CnedkBufSurfaceDestroy(dst_surf), 0);
+  EXPECT_EQ(CnedkBufSurfaceDestroy(src_surf), 0);
+}
+
+TEST(Transform, RoiBatch) {
+  bool is_edge_platform = cnedk::IsEdgePlatform(g_device_id);
+  CnedkBufSurfaceCreateParams create_params;
+  memset(&create_params, 0, sizeof(create_params));
+  create_params.batch_size = 2;
+  create_params.width = 1920;
+  create_params.height = 1080;
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  create_params.mem_type = is_edge_platform ? CNEDK_BUF_MEM_VB_CACHED : CNEDK_BUF_MEM_DEVICE;
+  create_params.device_id = g_device_id;
+  CnedkBufSurface* src_surf = nullptr;
+  ASSERT_EQ(CnedkBufSurfaceCreate(&src_surf, &create_params), 0);
+  src_surf->num_filled = 2;
+
+  CnedkTransformTensorDesc dst_desc;
+  dst_desc.color_format = CNEDK_TRANSFORM_COLOR_FORMAT_RGB;
+  dst_desc.data_type = CNEDK_TRANSFORM_FLOAT32;
+  dst_desc.shape.n = 4;
+  dst_desc.shape.c = 3;
+  dst_desc.shape.h = 224;
+  dst_desc.shape.w = 224;
+  create_params.batch_size = 4;
+  create_params.size = 224 * 224 * 3 * sizeof(float);
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_TENSOR;
+  CnedkBufSurface* dst_surf = nullptr;
+  ASSERT_EQ(CnedkBufSurfaceCreate(&dst_surf, &create_params), 0);
+
+  // several rois on the same frame
+  CnedkTransformRoi rois[4] = {{0, {0, 0, 0, 0}}, {0, {100, 200, 300, 600}}, {1, {500, 500, 64, 32}},
+                               {1, {1000, 1800, 0, 0}}};
+  CnedkTransformMeanStdParams mean_std_params;
+  for (uint32_t c_i = 0; c_i < 3; c_i++) {
+    mean_std_params.mean[c_i] = 127.5;
+    mean_std_params.std[c_i] = 127.5;
+  }
+  CnedkTransformRoiParams roi_params;
+  memset(&roi_params, 0, sizeof(roi_params));
+  roi_params.rois = rois;
+  roi_params.num_rois = 4;
+  roi_params.dst_desc = &dst_desc;
+  roi_params.layout = CNEDK_TRANSFORM_LAYOUT_NHWC;
+  roi_params.mean_std_params = &mean_std_params;
+  roi_params.keep_aspect_ratio = 1;
+  roi_params.pad_value = 128;
+  EXPECT_EQ(CnedkTransformRoiBatch(src_surf, dst_surf, &roi_params), 0);
+
+  roi_params.keep_aspect_ratio = 0;
+  roi_params.num_rois = 3;
+  EXPECT_EQ(CnedkTransformRoiBatch(src_surf, dst_surf, &roi_params), 0);
+
+  EXPECT_NE(CnedkTransformRoiBatch(src_surf, dst_surf, nullptr), 0);
+  roi_params.num_rois = 5;
+  EXPECT_NE(CnedkTransformRoiBatch(src_surf, dst_surf, &roi_params), 0);
+  roi_params.num_rois = 4;
+  rois[3].src_index = 2;
+  EXPECT_NE(CnedkTransformRoiBatch(src_surf, dst_surf, &roi_params), 0);
+  rois[3].src_index = 1;
+  roi_params.mean_std_params = nullptr;
+  EXPECT_NE(CnedkTransformRoiBatch(src_surf, dst_surf, &roi_params), 0);
+
+  EXPECT_EQ(CnedkBufSurfaceDestroy(dst_surf), 0);
+  EXPECT_EQ(CnedkBufSurfaceDestroy(src_surf), 0);
+}
+
+TEST(Transform, Cpu) {
+  CnedkTransformConfigParams config;
+  memset(&config, 0, sizeof(config));
+  ASSERT_EQ(CnedkTransformGetSessionParams(&config), 0);
+  CnedkTransformComputeMode mode = config.compute_mode;
+  config.compute_mode = CNEDK_TRANSFORM_COMPUTE_CPU;
+  ASSERT_EQ(CnedkTransformSetSessionParams(&config), 0);
+
+  CnedkBufSurfaceCreateParams create_params;
+  memset(&create_params, 0, sizeof(create_params));
+  create_params.batch_size = 2;
+  create_params.width = 64;
+  create_params.height = 32;
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  create_params.mem_type = CNEDK_BUF_MEM_SYSTEM;
+  create_params.device_id = g_device_id;
+  CnedkBufSurface* src_surf = nullptr;
+  ASSERT_EQ(CnedkBufSurfaceCreate(&src_surf, &create_params), 0);
+  src_surf->num_filled = 2;
+  EXPECT_EQ(CnedkBufSurfaceMemSet(src_surf, -1, -1, 128), 0);
+
+  {  // NV12 to BGR, gray stays gray
+    create_params.width = 32;
+    create_params.height = 16;
+    create_params.color_format = CNEDK_BUF_COLOR_FORMAT_BGR;
+    CnedkBufSurface* dst_surf = nullptr;
+    ASSERT_EQ(CnedkBufSurfaceCreate(&dst_surf, &create_params), 0);
+    CnedkTransformParams params;
+    memset(&params, 0, sizeof(params));
+    EXPECT_EQ(CnedkTransform(src_surf, dst_surf, &params), 0);
+    for (uint32_t i = 0; i < dst_surf->batch_size; ++i) {
+      uint8_t* dst = static_cast<uint8_t*>(dst_surf->surface_list[i].data_ptr);
+      EXPECT_EQ(dst[0], 130);
+      EXPECT_EQ(dst[31 * 3 + 2], 130);
+    }
+    EXPECT_EQ(CnedkBufSurfaceDestroy(dst_surf), 0);
+  }
+
+  {  // NV12 to float32 tensor with mean std
+    CnedkTransformTensorDesc dst_desc;
+    dst_desc.color_format = CNEDK_TRANSFORM_COLOR_FORMAT_RGB;
+    dst_desc.data_type = CNEDK_TRANSFORM_FLOAT32;
+    dst_desc.shape.n = 1;
+    dst_desc.shape.c = 3;
+    dst_desc.shape.h = 16;
+    dst_desc.shape.w = 16;
+    CnedkTransformMeanStdParams mean_std_params;
+    for (uint32_t c_i = 0; c_i < 3; c_i++) {
+      mean_std_params.mean[c_i] = 130;
+      mean_std_params.std[c_i] = 2;
+    }
+    CnedkTransformParams params;
+    memset(&params, 0, sizeof(params));
+    params.transform_flag = CNEDK_TRANSFORM_MEAN_STD;
+    params.mean_std_params = &mean_std_params;
+    params.dst_desc = &dst_desc;
+
+    create_params.size = 16 * 16 * 3 * sizeof(float);
+    create_params.color_format = CNEDK_BUF_COLOR_FORMAT_TENSOR;
+    CnedkBufSurface* dst_surf = nullptr;
+    ASSERT_EQ(CnedkBufSurfaceCreate(&dst_surf, &create_params), 0);
+    EXPECT_EQ(CnedkTransform(src_surf, dst_surf, &params), 0);
+    float* dst = static_cast<float*>(dst_surf->surface_list[1].data_ptr);
+    EXPECT_FLOAT_EQ(dst[0], 0.f);
+    EXPECT_FLOAT_EQ(dst[16 * 16 * 3 - 1], 0.f);
+
+    params.mean_std_params = nullptr;
+    EXPECT_NE(CnedkTransform(src_surf, dst_surf, &params), 0);
+    EXPECT_EQ(CnedkBufSurfaceDestroy(dst_surf), 0);
+  }
+
+  {  // rois to NCHW tensor with letterbox
+    CnedkTransformTensorDesc dst_desc;
+    dst_desc.color_format = CNEDK_TRANSFORM_COLOR_FORMAT_BGR;
+    dst_desc.data_type = CNEDK_TRANSFORM_UINT8;
+    dst_desc.shape.n = 2;
+    dst_desc.shape.c = 3;
+    dst_desc.shape.h = 8;
+    dst_desc.shape.w = 8;
+    CnedkTransformRoi rois[2] = {{1, {0, 0, 32, 32}}, {1, {0, 0, 32, 16}}};
+    CnedkTransformRoiParams roi_params;
+    memset(&roi_params, 0, sizeof(roi_params));
+    roi_params.rois = rois;
+    roi_params.num_rois = 2;
+    roi_params.dst_desc = &dst_desc;
+    roi_params.layout = CNEDK_TRANSFORM_LAYOUT_NCHW;
+    roi_params.keep_aspect_ratio = 1;
+    roi_params.pad_value = 0;
+
+    create_params.size = 8 * 8 * 3;
+    create_params.color_format = CNEDK_BUF_COLOR_FORMAT_TENSOR;
+    CnedkBufSurface* dst_surf = nullptr;
+    ASSERT_EQ(CnedkBufSurfaceCreate(&dst_surf, &create_params), 0);
+    EXPECT_EQ(CnedkTransformRoiBatch(src_surf, dst_surf, &roi_params), 0);
+    uint8_t* dst = static_cast<uint8_t*>(dst_surf->surface_list[0].data_ptr);
+    EXPECT_EQ(dst[0], 130);
+    EXPECT_EQ(dst[8 * 8 * 3 - 1], 130);
+    // 32x16 is scaled to 8x4 in the middle
+    dst = static_cast<uint8_t*>(dst_surf->surface_list[1].data_ptr);
+    EXPECT_EQ(dst[0], 0);
+    EXPECT_EQ(dst[2 * 8], 130);
+    EXPECT_EQ(dst[6 * 8], 0);
+    EXPECT_EQ(CnedkBufSurfaceDestroy(dst_surf), 0);
+  }
+
+  {  // device memory is not supported
+    create_params.size = 0;
+    create_params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+    create_params.mem_type = CNEDK_BUF_MEM_DEVICE;
+    CnedkBufSurface* dst_surf = nullptr;
+    ASSERT_EQ(CnedkBufSurfaceCreate(&dst_surf, &create_params), 0);
+    CnedkTransformParams params;
+    memset(&params, 0, sizeof(params));
+    EXPECT_NE(CnedkTransform(src_surf, dst_surf, &params), 0);
+    EXPECT_EQ(CnedkBufSurfaceDestroy(dst_surf), 0);
+  }
+
+  EXPECT_EQ(CnedkBufSurfaceDestroy(src_surf), 0);
+  config.compute_mode = mode;
+  EXPECT_EQ(CnedkTransformSetSessionParams(&config), 0);
+}
@@ -0,0 +1,74 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "cnedk_buf_surface.h"
+#include "cnedk_vin_capture.h"
+
+namespace {
+
+int OnFrames(CnedkBufSurface *surf, void *userdata) {
+  CnedkBufSurfaceDestroy(surf);
+  return 0;
+}
+
+int OnError(int errcode, void *userdata) { return 0; }
+
+int GetBufSurf(CnedkBufSurface **surf, int timeout_ms, void *userdata) { return -1; }
+
+CnedkVinCaptureGroupCreateParams MakeParams(int *sensor_ids, int num_sensors) {
+  CnedkVinCaptureGroupCreateParams params;
+  memset(&params, 0, sizeof(params));
+  params.num_sensors = num_sensors;
+  params.sensor_ids = sensor_ids;
+  params.OnFrames = OnFrames;
+  params.OnError = OnError;
+  params.GetBufSurf = GetBufSurf;
+  params.surf_timeout_ms = 100;
+  return params;
+}
+
+}  // namespace
+
+// capturing needs the VI sensors of a CE3226 board, only the checks done before the sensors are touched are tested
+TEST(VinCaptureGroup, InvalidParams) {
+  int sensor_ids[2] = {0, 1};
+  CnedkVinCaptureGroupCreateParams params = MakeParams(sensor_ids, 2);
+  void *group = nullptr;
+  EXPECT_NE(CnedkVinCaptureGroupCreate(nullptr, &params), 0);
+  EXPECT_NE(CnedkVinCaptureGroupCreate(&group, nullptr), 0);
+
+  params.OnError = nullptr;
+  EXPECT_NE(CnedkVinCaptureGroupCreate(&group, &params), 0);
+  params = MakeParams(sensor_ids, 0);
+  EXPECT_NE(CnedkVinCaptureGroupCreate(&group, &params), 0);
+  params = MakeParams(nullptr, 2);
+  EXPECT_NE(CnedkVinCaptureGroupCreate(&group, &params), 0);
+  sensor_ids[1] = 0;
+  params = MakeParams(sensor_ids, 2);
+  EXPECT_NE(CnedkVinCaptureGroupCreate(&group, &params), 0);
+  EXPECT_EQ(nullptr, group);
+
+  EXPECT_NE(CnedkVinCaptureGroupDestroy(nullptr), 0);
+  EXPECT_NE(CnedkVinCaptureGroupCapture(nullptr, 100), 0);
+}
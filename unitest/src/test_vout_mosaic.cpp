@@ -0,0 +1,177 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cnedk_buf_surface.h"
+#include "cnedk_vout_display.h"
+
+#include "test_base.h"
+
+namespace {
+
+constexpr int kDeviceId = 0;
+constexpr uint32_t kTileSize = 128;
+
+CnedkBufSurfaceMemType MemType() {
+  return cnedk::IsEdgePlatform(kDeviceId) ? CNEDK_BUF_MEM_VB_CACHED : CNEDK_BUF_MEM_DEVICE;
+}
+
+CnedkBufSurface *CreateFrame(uint8_t luma) {
+  CnedkBufSurfaceCreateParams create_params;
+  memset(&create_params, 0, sizeof(create_params));
+  create_params.mem_type = MemType();
+  create_params.device_id = kDeviceId;
+  create_params.width = kTileSize;
+  create_params.height = kTileSize;
+  create_params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  create_params.batch_size = 1;
+  CnedkBufSurface *surf = nullptr;
+  if (CnedkBufSurfaceCreate(&surf, &create_params) < 0) return nullptr;
+  surf->num_filled = 1;
+  CnedkBufSurfaceMemSet(surf, 0, 0, luma);
+  CnedkBufSurfaceMemSet(surf, 0, 1, 128);
+  return surf;
+}
+
+// Reads the luma at the center of each tile, then wipes the composite so that tiles which are not redrawn show up
+struct CompositeProbe {
+  std::mutex mutex;
+  std::vector<std::vector<uint8_t>> lumas;
+  std::atomic<int> count{0};
+
+  static int OnComposite(CnedkBufSurface *surf, void *userdata) {
+    CompositeProbe *probe = static_cast<CompositeProbe *>(userdata);
+    CnedkBufSurfaceCreateParams create_params;
+    memset(&create_params, 0, sizeof(create_params));
+    create_params.mem_type = CNEDK_BUF_MEM_SYSTEM;
+    create_params.width = surf->surface_list[0].width;
+    create_params.height = surf->surface_list[0].height;
+    create_params.color_format = surf->surface_list[0].color_format;
+    create_params.batch_size = 1;
+    CnedkBufSurface *host = nullptr;
+    if (CnedkBufSurfaceCreate(&host, &create_params) < 0) return -1;
+    CnedkBufSurfaceCopy(surf, host);
+    const uint8_t *y = static_cast<const uint8_t *>(host->surface_list[0].data_ptr);
+    uint32_t pitch = host->surface_list[0].pitch;
+    std::vector<uint8_t> lumas;
+    for (uint32_t x = kTileSize / 2; x < create_params.width; x += kTileSize) {
+      lumas.push_back(y[kTileSize / 2 * pitch + x]);
+    }
+    CnedkBufSurfaceDestroy(host);
+    CnedkBufSurfaceMemSet(surf, 0, 0, 0);
+    std::unique_lock<std::mutex> lk(probe->mutex);
+    probe->lumas.push_back(lumas);
+    ++probe->count;
+    return 0;
+  }
+
+  bool WaitCount(int n) {
+    for (int i = 0; i < 1000 && count < n; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return count >= n;
+  }
+};
+
+CnedkVoutMosaicParams MakeParams(CompositeProbe *probe) {
+  CnedkVoutMosaicParams params;
+  memset(&params, 0, sizeof(params));
+  params.device_id = kDeviceId;
+  params.width = 2 * kTileSize;
+  params.height = kTileSize;
+  params.color_format = CNEDK_BUF_COLOR_FORMAT_NV12;
+  params.mem_type = MemType();
+  params.compute_mode = CNEDK_TRANSFORM_COMPUTE_DEFAULT;
+  params.num_inputs = 2;
+  params.grid_cols = 2;
+  params.frame_rate = 50;
+  params.num_buffers = 1;
+  params.OnComposite = &CompositeProbe::OnComposite;
+  params.userdata = probe;
+  return params;
+}
+
+}  // namespace
+
+TEST(VoutMosaic, InvalidParams) {
+  CompositeProbe probe;
+  CnedkVoutMosaicParams params = MakeParams(&probe);
+  void *mosaic = nullptr;
+  EXPECT_NE(CnedkVoutMosaicCreate(nullptr, &params), 0);
+  EXPECT_NE(CnedkVoutMosaicCreate(&mosaic, nullptr), 0);
+  params.color_format = CNEDK_BUF_COLOR_FORMAT_BGR;
+  EXPECT_NE(CnedkVoutMosaicCreate(&mosaic, &params), 0);
+  params = MakeParams(&probe);
+  CnedkTransformRect rects[2] = {{0, 0, kTileSize, kTileSize}, {0, kTileSize + 2, kTileSize, kTileSize}};
+  params.rects = rects;
+  EXPECT_NE(CnedkVoutMosaicCreate(&mosaic, &params), 0);
+  EXPECT_NE(CnedkVoutMosaicDestroy(nullptr), 0);
+  EXPECT_NE(CnedkVoutMosaicSendFrame(nullptr, 0, nullptr), 0);
+
+  params = MakeParams(&probe);
+  ASSERT_EQ(CnedkVoutMosaicCreate(&mosaic, &params), 0);
+  CnedkBufSurface *surf = CreateFrame(50);
+  ASSERT_TRUE(surf);
+  EXPECT_NE(CnedkVoutMosaicSendFrame(mosaic, 2, surf), 0);
+  EXPECT_NE(CnedkVoutMosaicSendFrame(mosaic, 0, nullptr), 0);
+  CnedkBufSurfaceDestroy(surf);
+  EXPECT_EQ(CnedkVoutMosaicDestroy(mosaic), 0);
+}
+
+TEST(VoutMosaic, RedrawChangedTiles) {
+  CompositeProbe probe;
+  CnedkVoutMosaicParams params = MakeParams(&probe);
+  void *mosaic = nullptr;
+  ASSERT_EQ(CnedkVoutMosaicCreate(&mosaic, &params), 0);
+
+  ASSERT_EQ(CnedkVoutMosaicSendFrame(mosaic, 0, CreateFrame(50)), 0);
+  ASSERT_EQ(CnedkVoutMosaicSendFrame(mosaic, 1, CreateFrame(100)), 0);
+  ASSERT_TRUE(probe.WaitCount(1));
+  // both sent between two composites, or the first one alone
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  {
+    std::unique_lock<std::mutex> lk(probe.mutex);
+    ASSERT_GE(probe.lumas.size(), 1u);
+    EXPECT_EQ(50, probe.lumas.front()[0]);
+    EXPECT_EQ(100, probe.lumas.back()[1]);
+  }
+
+  int count = probe.count;
+  ASSERT_EQ(CnedkVoutMosaicSendFrame(mosaic, 1, CreateFrame(200)), 0);
+  ASSERT_TRUE(probe.WaitCount(count + 1));
+  {
+    std::unique_lock<std::mutex> lk(probe.mutex);
+    // the composite was wiped after the last output, only the changed tile is drawn again
+    EXPECT_EQ(0, probe.lumas.back()[0]);
+    EXPECT_EQ(200, probe.lumas.back()[1]);
+  }
+
+  // nothing is produced without new frames
+  count = probe.count;
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(count, probe.count);
+  EXPECT_EQ(CnedkVoutMosaicDestroy(mosaic), 0);
+}
@@ -0,0 +1,181 @@
+/*************************************************************************
+ * Copyright (C) [2022] by Cambricon, Inc. All rights reserved
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cnedk_vout_display.h"
+#include "frame_presenter.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Records what a display would see, surfaces are never really destroyed
+class FakeDisplay {
+ public:
+  FakeDisplay() {
+    memset(surfs_, 0, sizeof(surfs_));
+    presenter_.reset(new cnedk::FramePresenter(
+        [this](CnedkBufSurface *surf) {
+          std::unique_lock<std::mutex> lk(mutex_);
+          presented_.push_back(surf->pts);
+          present_time_.push_back(Clock::now());
+          return 0;
+        },
+        [this](CnedkBufSurface *surf) {
+          std::unique_lock<std::mutex> lk(mutex_);
+          ++released_;
+        }));
+  }
+  CnedkBufSurface *Surf(uint64_t pts) {
+    CnedkBufSurface *surf = &surfs_[next_++ % kSurfNum];
+    surf->pts = pts;
+    return surf;
+  }
+  cnedk::FramePresenter *presenter() { return presenter_.get(); }
+  std::vector<uint64_t> presented() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    return presented_;
+  }
+  std::vector<Clock::time_point> present_time() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    return present_time_;
+  }
+  int released() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    return released_;
+  }
+  CnedkVoutRenderStats Stats() {
+    CnedkVoutRenderStats stats;
+    presenter_->GetStats(&stats);
+    return stats;
+  }
+
+ private:
+  static constexpr int kSurfNum = 32;
+  CnedkBufSurface surfs_[kSurfNum];
+  int next_ = 0;
+  std::mutex mutex_;
+  std::vector<uint64_t> presented_;
+  std::vector<Clock::time_point> present_time_;
+  int released_ = 0;
+  std::unique_ptr<cnedk::FramePresenter> presenter_;
+};
+
+CnedkVoutRenderParams MakeParams(uint32_t refresh_rate, uint32_t queue_depth, uint32_t max_late_ms = 0) {
+  CnedkVoutRenderParams params;
+  memset(&params, 0, sizeof(params));
+  params.refresh_rate = refresh_rate;
+  params.queue_depth = queue_depth;
+  params.max_late_ms = max_late_ms;
+  return params;
+}
+
+}  // namespace
+
+TEST(VoutRender, QueueInvalid) {
+  FakeDisplay display;
+  EXPECT_EQ(-1, display.presenter()->Queue(display.Surf(0)));
+  ASSERT_EQ(0, display.presenter()->Start(MakeParams(100, 2)));
+  EXPECT_EQ(-1, display.presenter()->Start(MakeParams(100, 2)));
+  EXPECT_EQ(-1, display.presenter()->Queue(nullptr));
+  display.presenter()->Stop();
+  EXPECT_EQ(0u, display.Stats().queued);
+}
+
+TEST(VoutRender, PacedByPts) {
+  FakeDisplay display;
+  ASSERT_EQ(0, display.presenter()->Start(MakeParams(100, 8)));
+  // all frames arrive at once, they are presented 40ms apart following their timestamps
+  for (uint64_t pts = 0; pts < 200; pts += 40) {
+    ASSERT_EQ(0, display.presenter()->Queue(display.Surf(pts)));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  display.presenter()->Stop();
+
+  EXPECT_EQ(std::vector<uint64_t>({0, 40, 80, 120, 160}), display.presented());
+  auto times = display.present_time();
+  ASSERT_EQ(5u, times.size());
+  for (size_t i = 1; i < times.size(); ++i) {
+    EXPECT_GE(times[i] - times[i - 1], std::chrono::milliseconds(20));
+  }
+  EXPECT_GE(times.back() - times.front(), std::chrono::milliseconds(140));
+  CnedkVoutRenderStats stats = display.Stats();
+  EXPECT_EQ(5u, stats.queued);
+  EXPECT_EQ(5u, stats.rendered);
+  EXPECT_EQ(0u, stats.dropped);
+  EXPECT_GT(stats.repeated, 0u);
+  EXPECT_EQ(5, display.released());
+}
+
+TEST(VoutRender, MostRecentWins) {
+  FakeDisplay display;
+  // 10Hz, the frames below are all queued before the first refresh
+  ASSERT_EQ(0, display.presenter()->Start(MakeParams(10, 2)));
+  for (uint64_t pts = 0; pts < 10; ++pts) {
+    ASSERT_EQ(0, display.presenter()->Queue(display.Surf(pts)));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  CnedkVoutRenderStats stats = display.Stats();
+  EXPECT_EQ(std::vector<uint64_t>({9}), display.presented());
+  EXPECT_EQ(10u, stats.queued);
+  EXPECT_EQ(1u, stats.rendered);
+  EXPECT_EQ(9u, stats.dropped);
+  EXPECT_EQ(9, display.released());
+  display.presenter()->Stop();
+  EXPECT_EQ(10, display.released());
+}
+
+TEST(VoutRender, LateFrameResync) {
+  FakeDisplay display;
+  ASSERT_EQ(0, display.presenter()->Start(MakeParams(100, 4, 20)));
+  ASSERT_EQ(0, display.presenter()->Queue(display.Surf(0)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  // due 10ms after the first frame, but arrives 60ms after it
+  ASSERT_EQ(0, display.presenter()->Queue(display.Surf(10)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  // the clock is resynchronized to the late frame, so a frame 30ms after it in the stream is on time now
+  ASSERT_EQ(0, display.presenter()->Queue(display.Surf(40)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  display.presenter()->Stop();
+
+  EXPECT_EQ(std::vector<uint64_t>({0, 10, 40}), display.presented());
+  CnedkVoutRenderStats stats = display.Stats();
+  EXPECT_EQ(1u, stats.late);
+  EXPECT_EQ(0u, stats.dropped);
+}
+
+TEST(VoutRender, StopDropsPending) {
+  FakeDisplay display;
+  ASSERT_EQ(0, display.presenter()->Start(MakeParams(100, 4)));
+  ASSERT_EQ(0, display.presenter()->Queue(display.Surf(0)));
+  ASSERT_EQ(0, display.presenter()->Queue(display.Surf(500)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  display.presenter()->Stop();
+  EXPECT_EQ(std::vector<uint64_t>({0}), display.presented());
+  EXPECT_EQ(1u, display.Stats().dropped);
+  EXPECT_EQ(2, display.released());
+}